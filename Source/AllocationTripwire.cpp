@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    AllocationTripwire.cpp
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    グローバルな確保関数をフックして、禁止区間内の呼び出しで abort する。
+    - glibc: malloc 系を __libc_* に転送する形で差し替え（operator new も
+      内部で malloc を呼ぶので、AudioBuffer の HeapBlock も含めて全部捕まる）
+    - それ以外: operator new / delete を差し替え（align_val_t 版も含む。malloc 直呼びは対象外）
+
+  ==============================================================================
+*/
+
+#include "AllocationTripwire.h"
+
+#if SAROS_ALLOCATION_TRIPWIRE
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+ #include <io.h>
+ #include <malloc.h>
+#else
+ #include <unistd.h>
+#endif
+
+#if defined(__GNUC__)
+ #define SAROS_TRIPWIRE_TLS __attribute__((tls_model("initial-exec")))
+#else
+ #define SAROS_TRIPWIRE_TLS
+#endif
+
+namespace
+{
+	// malloc の中から触るので、動的初期化も確保も起こさない TLS だけを使う
+	thread_local int audioThreadDepth SAROS_TRIPWIRE_TLS = 0;
+	thread_local int allowDepth SAROS_TRIPWIRE_TLS = 0;
+
+	void writeStderr(const char* text) noexcept
+	{
+	   #if defined(_WIN32)
+		_write(2, text, (unsigned int)std::strlen(text));
+	   #else
+		ssize_t ignored = ::write(2, text, std::strlen(text));
+		(void)ignored;
+	   #endif
+	}
+
+	inline void check(const char* what) noexcept
+	{
+		if (audioThreadDepth > 0 && allowDepth == 0)
+		{
+			// 報告中の確保で再帰しないよう、先に罠を外す
+			audioThreadDepth = 0;
+
+			writeStderr("\n🚨 Allocation tripwire: ");
+			writeStderr(what);
+			writeStderr(" called on the audio thread\n");
+			std::abort();
+		}
+	}
+}
+
+namespace allocation_tripwire
+{
+	ScopedAudioThread::ScopedAudioThread() noexcept      { ++audioThreadDepth; }
+	ScopedAudioThread::~ScopedAudioThread() noexcept     { --audioThreadDepth; }
+
+	ScopedAllowAllocation::ScopedAllowAllocation() noexcept  { ++allowDepth; }
+	ScopedAllowAllocation::~ScopedAllowAllocation() noexcept { --allowDepth; }
+}
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+	void* __libc_malloc(std::size_t) noexcept;
+	void* __libc_calloc(std::size_t, std::size_t) noexcept;
+	void* __libc_realloc(void*, std::size_t) noexcept;
+	void* __libc_memalign(std::size_t, std::size_t) noexcept;
+	void  __libc_free(void*) noexcept;
+
+	void* malloc(std::size_t size) noexcept
+	{
+		check("malloc");
+		return __libc_malloc(size);
+	}
+
+	void* calloc(std::size_t count, std::size_t size) noexcept
+	{
+		check("calloc");
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* ptr, std::size_t size) noexcept
+	{
+		check("realloc");
+		return __libc_realloc(ptr, size);
+	}
+
+	void* memalign(std::size_t alignment, std::size_t size) noexcept
+	{
+		check("memalign");
+		return __libc_memalign(alignment, size);
+	}
+
+	void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+	{
+		check("aligned_alloc");
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void** result, std::size_t alignment, std::size_t size) noexcept
+	{
+		check("posix_memalign");
+		*result = __libc_memalign(alignment, size);
+		return *result != nullptr ? 0 : 12; // ENOMEM
+	}
+
+	void free(void* ptr) noexcept
+	{
+		if (ptr != nullptr)
+			check("free");
+		__libc_free(ptr);
+	}
+}
+
+#else
+
+void* operator new(std::size_t size)
+{
+	check("operator new");
+	if (auto* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	check("operator new[]");
+	if (auto* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	check("operator new");
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	check("operator new[]");
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	if (ptr != nullptr)
+		check("operator delete");
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	if (ptr != nullptr)
+		check("operator delete[]");
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept   { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete[](ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept   { operator delete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { operator delete[](ptr); }
+
+// over-aligned 型（SIMDRegister を持つ状態など）は C++17 の align_val_t 版を通る
+namespace
+{
+	void* alignedAllocate(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		const auto align = (std::size_t)alignment < sizeof(void*) ? sizeof(void*) : (std::size_t)alignment;
+		size = size == 0 ? 1 : size;
+	   #if defined(_WIN32)
+		return _aligned_malloc(size, align);
+	   #else
+		void* p = nullptr;
+		return posix_memalign(&p, align, size) == 0 ? p : nullptr;
+	   #endif
+	}
+
+	void alignedFree(void* ptr) noexcept
+	{
+	   #if defined(_WIN32)
+		_aligned_free(ptr);
+	   #else
+		std::free(ptr);
+	   #endif
+	}
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	check("operator new (aligned)");
+	if (auto* p = alignedAllocate(size, alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	check("operator new[] (aligned)");
+	if (auto* p = alignedAllocate(size, alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	check("operator new (aligned)");
+	return alignedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	check("operator new[] (aligned)");
+	return alignedAllocate(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	if (ptr != nullptr)
+		check("operator delete (aligned)");
+	alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	if (ptr != nullptr)
+		check("operator delete[] (aligned)");
+	alignedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept   { operator delete(ptr, alignment); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept { operator delete[](ptr, alignment); }
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept   { operator delete(ptr, alignment); }
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { operator delete[](ptr, alignment); }
+
+#endif
+
+#endif // SAROS_ALLOCATION_TRIPWIRE
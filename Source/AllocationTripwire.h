@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    AllocationTripwire.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    オーディオスレッド上のヒープ確保・解放を検出するデバッグ/テスト用の罠
+    SAROS_ALLOCATION_TRIPWIRE=1 でビルドしたときだけ有効（通常ビルドでは空）
+
+    使い方: コールバック先頭に ScopedAudioThread を置くだけ。
+    区間内で malloc / operator new / free が呼ばれたら stderr に出して abort する。
+
+    ※ DBG() は文字列を確保するので、オーディオスレッドの経路（processBlock から呼ばれる apply* /
+      レンダリング / 入力の解析、レンダリングのワーカー）には置かない。Debug 構成でもそのまま使える。
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef SAROS_ALLOCATION_TRIPWIRE
+ #define SAROS_ALLOCATION_TRIPWIRE 0
+#endif
+
+namespace allocation_tripwire
+{
+#if SAROS_ALLOCATION_TRIPWIRE
+	// このスレッドでの確保を禁止する区間（ネスト可）
+	struct ScopedAudioThread
+	{
+		ScopedAudioThread() noexcept;
+		~ScopedAudioThread() noexcept;
+
+		ScopedAudioThread(const ScopedAudioThread&) = delete;
+		ScopedAudioThread& operator=(const ScopedAudioThread&) = delete;
+	};
+
+	// 禁止区間の中で、意図的に確保を許す区間（ネスト可）
+	struct ScopedAllowAllocation
+	{
+		ScopedAllowAllocation() noexcept;
+		~ScopedAllowAllocation() noexcept;
+
+		ScopedAllowAllocation(const ScopedAllowAllocation&) = delete;
+		ScopedAllowAllocation& operator=(const ScopedAllowAllocation&) = delete;
+	};
+#else
+	struct ScopedAudioThread     { ScopedAudioThread() noexcept {} };
+	struct ScopedAllowAllocation { ScopedAllowAllocation() noexcept {} };
+#endif
+}
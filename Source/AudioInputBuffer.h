@@ -10,191 +10,198 @@
 
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
-#include <vector>
-#include <atomic>
+#include <array>
 
+// 入力の先読みリングバッファ（入力ペア1組 = maxChannels チャンネル分。InputManager が入力ペアごとに持つ）
+// 位置は絶対サンプル位置（InputManager::analyze に渡されるブロック先頭からの通し番号）で扱う
+// 容量は2のべき乗にして、位置 → 添字はマスクだけで出す。書き込み・読み出しは折り返しで最大2区間のブロックコピー
 class AudioInputBuffer
 {
 public:
+    static constexpr int maxChannels = 2; // LoopPagePool::numChannels と同じ（トラックは入力ペアを1組録音する）
+
+    // 先読み（プリロール）をコピーせずに見るためのビュー
+    // リングの中を直接指すので、次の write まで（= 同じオーディオコールバックの中）だけ有効
+    struct LookbackView
+    {
+        struct Span
+        {
+            std::array<const float*, maxChannels> channels {};
+            int numSamples = 0;
+        };
+
+        std::array<Span, 2> spans {}; // 折り返す前 / 折り返した後
+        int numSpans = 0;
+        int numChannels = 0;          // 書かれていた入力のチャンネル数（モノラル入力なら 1）
+        int numSamples = 0;           // 全区間の合計
+
+        bool isEmpty() const noexcept { return numSamples <= 0; }
+    };
+
     AudioInputBuffer() = default;
-    
+
+    // メッセージスレッド（確保する）。容量は seconds 以上の2のべき乗
     void prepare(double sampleRate, int bufferSizeSeconds)
     {
-        bufferSize = (int)(sampleRate * bufferSizeSeconds);
-        ringBuffer.resize(bufferSize, 0.0f);
-        writePos = 0;
-        // Reset state
-        potentialStartIndex = -1;
-        lastTriggerIndexInBlock = -1;
-        inPreRoll = false;
-        silenceCounter = 0;
-        this->sampleRate = sampleRate;
+        bufferSize = juce::nextPowerOfTwo(juce::jmax(1, (int)(sampleRate * bufferSizeSeconds)));
+        mask = bufferSize - 1;
+        ring.setSize(maxChannels, bufferSize);
+        ring.clear();
+        writeAbs = 0;
+        validFromAbs = 0;
+        lookbackStartAbs = -1;
+        lastWrittenBlockSize = 0;
+        writtenChannels = 0;
+    }
+
+    // 入力の先頭 maxChannels 個を書く
+    void write(const juce::AudioBuffer<float>& input, int numSamples, juce::int64 blockStartAbs)
+    {
+        write(input.getArrayOfReadPointers(), input.getNumChannels(), numSamples, blockStartAbs);
     }
-    
-    // Write new input samples to the ring buffer
-    void write(const float* input, int numSamples)
+
+    // channels の先頭 maxChannels 個を書く（入力ペアごとのリングは、そのペアのチャンネルを指して渡す）
+    // blockStartAbs が前のブロックの続きでなければ（クロックが飛んだ）、それより前の中身は使わない
+    void write(const float* const* channels, int numInputChannels, int numSamples, juce::int64 blockStartAbs)
     {
         if (bufferSize == 0) return;
-        
-        for (int i = 0; i < numSamples; ++i)
+
+        if (blockStartAbs != writeAbs)
         {
-            ringBuffer[writePos] = input[i];
-            
-            // Advance write position
-            writePos = (writePos + 1) % bufferSize;
+            writeAbs = blockStartAbs;
+            validFromAbs = blockStartAbs;
         }
-        
-        // 現在のブロックサイズを記録（getLookbackData で除外するため）
+
+        const int numChannels = juce::jmin(numInputChannels, maxChannels);
+        if (numChannels != writtenChannels)
+        {
+            // チャンネル数が変わったら、前の中身は混ぜない
+            writtenChannels = numChannels;
+            validFromAbs = writeAbs;
+        }
+
+        // リングより長いブロックは最後の bufferSize 分だけ
+        const int count = juce::jmin(numSamples, bufferSize);
+        const int offset = numSamples - count;
+        const int pos = index(writeAbs + offset);
+        const int first = juce::jmin(count, bufferSize - pos);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* src = channels[ch] + offset;
+            float* dst = ring.getWritePointer(ch);
+            juce::FloatVectorOperations::copy(dst + pos, src, first);
+            if (first < count)
+                juce::FloatVectorOperations::copy(dst, src + first, count - first);
+        }
+        writeAbs += numSamples;
+
+        // 現在のブロックサイズを記録（getLookback で除外するため）
         lastWrittenBlockSize = numSamples;
     }
-    
-    // Check triggers and return true if high threshold detected
-    // Updates internal state for low threshold tracking
-    bool processTriggers(const float* input, int numSamples, float lowThresh, float highThresh)
+
+    // 読める範囲は [getOldestAbs(), getWriteAbs())
+    juce::int64 getWriteAbs() const { return writeAbs; }
+    juce::int64 getOldestAbs() const { return juce::jmax(validFromAbs, writeAbs - bufferSize); }
+    int getNumChannels() const { return writtenChannels; }
+
+    float getSample(int channel, juce::int64 absIndex) const
+    {
+        jassert(absIndex >= getOldestAbs() && absIndex < writeAbs);
+        jassert(juce::isPositiveAndBelow(channel, writtenChannels));
+        return ring.getSample(channel, index(absIndex));
+    }
+
+    // 全チャンネルの |x| の最大（トリガーからの遡りはこれで見る）
+    float getMagnitude(juce::int64 absIndex) const
+    {
+        float m = 0.0f;
+        for (int ch = 0; ch < writtenChannels; ++ch)
+            m = juce::jmax(m, std::abs(getSample(ch, absIndex)));
+        return m;
+    }
+
+    // [fromAbs, fromAbs + numSamples) の全チャンネルの |x| の最大
+    // リングの折り返しで2区間に分け、それぞれ FloatVectorOperations::findMinAndMax でまとめて見る
+    float getMagnitude(juce::int64 fromAbs, int numSamples) const
     {
-        if (bufferSize == 0) return false;
-        
-        // We iterate through the input block again to check levels
-        // Note: 'write' has already advanced writePos. We need to look at what we just wrote,
-        // or just process the input buffer directly.
-        // It's safer to process input directly and map to ring buffer index if needed.
-        
-        // But we need to know the *exact index in the ring buffer* where trigger happened.
-        // So we can re-calculate the ring buffer index for the current sample.
-        
-        int currentWritePos = writePos.load();
-        // The start of this block in the ring buffer was (currentWritePos - numSamples + bufferSize) % bufferSize
-        
-        for (int i = 0; i < numSamples; ++i)
+        jassert(fromAbs >= getOldestAbs() && fromAbs + numSamples <= writeAbs);
+        if (numSamples <= 0) return 0.0f;
+
+        const int pos = index(fromAbs);
+        const int first = juce::jmin(numSamples, bufferSize - pos);
+        float m = 0.0f;
+        for (int ch = 0; ch < writtenChannels; ++ch)
         {
-            float absSample = std::abs(input[i]);
-            
-            // 1. Low Threshold Check (Potential Start)
-            if (absSample > lowThresh)
-            {
-                if (!inPreRoll)
-                {
-                    // Found a new potential start after silence
-                    inPreRoll = true;
-                    // Calculate index in ring buffer for this sample
-                    // We need to trace back from current writePos
-                    // sample i corresponds to writePos - (numSamples - i)
-                    int distFromEnd = numSamples - i;
-                    int index = (currentWritePos - distFromEnd + bufferSize) % bufferSize;
-                    potentialStartIndex = index;
-                    silenceCounter = 0;
-                }
-            }
-            else
+            const float* data = ring.getReadPointer(ch);
+            auto range = juce::FloatVectorOperations::findMinAndMax(data + pos, first);
+            m = juce::jmax(m, -range.getStart(), range.getEnd());
+            if (first < numSamples)
             {
-                if (inPreRoll)
-                {
-                    silenceCounter++;
-                    // If silence persists for e.g. 500ms, reset
-                    if (silenceCounter > (int)(sampleRate * 0.5)) 
-                    {
-                        inPreRoll = false;
-                        potentialStartIndex = -1;
-                        silenceCounter = 0;
-                    }
-                }
-            }
-            
-            // 2. High Threshold Check (Confirm Trigger)
-            if (absSample > highThresh && inPreRoll)
-            {
-                // Trigger confirmed!
-                lastTriggerIndexInBlock = i;
-                return true;
+                range = juce::FloatVectorOperations::findMinAndMax(data, numSamples - first);
+                m = juce::jmax(m, -range.getStart(), range.getEnd());
             }
         }
-        
-        lastTriggerIndexInBlock = -1;
-        return false;
+        return m;
     }
-    
-    // Get audio data from potentialStartIndex (Low Trigger) up to current WritePos
-    // This forms the "attack" part that was buffered.
-    void getLookbackData(juce::AudioBuffer<float>& dest)
+
+    // 次の getLookback をこの絶対位置から始める（トリガーのアタック開始位置）
+    void setLookbackStart(juce::int64 absIndex) { lookbackStartAbs = absIndex; }
+
+    // 先読みの開始位置から現在のブロックの手前までをビューで返す（コピーしない）
+    // 開始位置は使ったら消す（次のトリガーで設定し直す）
+    LookbackView getLookback()
     {
-        if (potentialStartIndex < 0 || bufferSize == 0) return;
-        
-        int currentWritePos = writePos.load();
-        
-        // まず総サンプル数を計算（元のロジック）
-        int totalAvailable = 0;
-        if (currentWritePos >= potentialStartIndex)
-            totalAvailable = currentWritePos - potentialStartIndex;
-        else
-            totalAvailable = (bufferSize - potentialStartIndex) + currentWritePos;
-        
+        LookbackView view;
+        if (lookbackStartAbs < 0 || bufferSize == 0) return view;
+
         // 現在のブロックを除外（二重記録防止）
         // recordIntoTracks() で同じブロックが再度記録されるため
-        int availableSamples = totalAvailable - lastWrittenBlockSize;
-            
-        // Safety cap
-        if (availableSamples > bufferSize) availableSamples = bufferSize;
-        if (availableSamples <= 0) return; // 現在ブロックを除外すると何も残らない場合
-        
-        dest.setSize(1, availableSamples);
-        
-        // Copy 1: potentialStart -> end of buffer (or writePos if no wrap)
-        int samplesFirstPart = juce::jmin(availableSamples, bufferSize - potentialStartIndex);
-        
-        // Using float* for raw access
-        const float* src = ringBuffer.data();
-        float* dst = dest.getWritePointer(0);
-        
-        for (int i = 0; i < samplesFirstPart; ++i)
-            dst[i] = src[potentialStartIndex + i];
-            
-        // Copy 2: If wrapped, start of buffer -> writePos
-        if (samplesFirstPart < availableSamples)
-        {
-            int samplesSecondPart = availableSamples - samplesFirstPart;
-            for (int i = 0; i < samplesSecondPart; ++i)
-                dst[samplesFirstPart + i] = src[i];
-        }
-        
-        // Reset state after retrieval
-        // We do NOT reset inPreRoll here, to prevent re-triggering during the same phrase.
-        // We only invalidate the start index since we consumed the buffer.
-        potentialStartIndex = -1; 
-        
-        // inPreRoll remains true until silence timeout resets it in processTriggers.
-        // silenceCounter remains valid.
-    }
-    
-    bool isInPreRoll() const { return inPreRoll; }
-    
-    // 明示的にPreRoll状態をリセット（トリガー再設定）
-    void resetPreRoll()
-    {
-        inPreRoll = false;
-        potentialStartIndex = -1;
-        lastTriggerIndexInBlock = -1;
-        silenceCounter = 0;
+        const juce::int64 endAbs = writeAbs - lastWrittenBlockSize;
+        const juce::int64 startAbs = juce::jmax(lookbackStartAbs, getOldestAbs());
+        lookbackStartAbs = -1;
+
+        const int available = (int)juce::jlimit<juce::int64>(0, bufferSize, endAbs - startAbs);
+        if (available <= 0) return view; // 現在ブロックを除外すると何も残らない場合
+
+        // 1: 開始位置 → リングの終わり、2: 折り返してリングの先頭から
+        const int startPos = index(startAbs);
+        const int first = juce::jmin(available, bufferSize - startPos);
+        view.numChannels = writtenChannels;
+        view.numSamples = available;
+        addSpan(view, startPos, first);
+        if (first < available)
+            addSpan(view, 0, available - first);
+        return view;
     }
-    
-    int getLastTriggerIndexInBlock() const { return lastTriggerIndexInBlock; }
-    
+
+    int getCapacity() const { return bufferSize; }
+
     // Helper to clear buffer
     void clear()
     {
-        std::fill(ringBuffer.begin(), ringBuffer.end(), 0.0f);
-        potentialStartIndex = -1;
-        inPreRoll = false;
+        ring.clear();
+        validFromAbs = writeAbs;
+        lookbackStartAbs = -1;
     }
 
 private:
-    std::vector<float> ringBuffer;
-    std::atomic<int> writePos {0};
-    int bufferSize = 0;
-    double sampleRate = 48000.0;
-    
-    int potentialStartIndex = -1; // The ring buffer index where Low Threshold was crossed
-    int lastTriggerIndexInBlock = -1; // The sample index within the processing block where High Threshold was crossed
-    bool inPreRoll = false;       // Are we tracking a potential sound?
-    int silenceCounter = 0;       // Buffer counters for silence logic
-    int lastWrittenBlockSize = 0; // 最後に書き込まれたブロックサイズ（二重記録防止用）
+    int index(juce::int64 absIndex) const noexcept { return (int)(absIndex & mask); }
+
+    void addSpan(LookbackView& view, int start, int numSamples) const
+    {
+        auto& span = view.spans[(size_t)view.numSpans++];
+        for (int ch = 0; ch < view.numChannels; ++ch)
+            span.channels[(size_t)ch] = ring.getReadPointer(ch, start);
+        span.numSamples = numSamples;
+    }
+
+    juce::AudioBuffer<float> ring;     // maxChannels × bufferSize
+    int bufferSize = 0;                // 2のべき乗
+    juce::int64 mask = 0;
+
+    juce::int64 writeAbs = 0;          // 次に書く絶対位置
+    juce::int64 validFromAbs = 0;      // これより前はリングに入っていない（クロックが飛んだ / 消した / チャンネル数が変わった）
+    juce::int64 lookbackStartAbs = -1; // getLookback の開始位置（-1 = なし）
+    int lastWrittenBlockSize = 0;      // 最後に書き込まれたブロックサイズ（二重記録防止用）
+    int writtenChannels = 0;           // 最後に書いた入力のチャンネル数
 };
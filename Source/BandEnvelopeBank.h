@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    BandEnvelopeBank.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    帯域トリガー用の包絡（最大 MAX_CHANNELS × NUM_BANDS、オーディオスレッド専用）
+    - 各帯域は中心周波数の1ビンだけの sliding DFT を指数窓にしたもの（y = x + r·e^{jω}·y）を2段
+      1サンプルあたり複素乗算2回で、遅延線を持たない
+    - 状態は帯域ごとに 16 レーン固定長の配列で持ち、使っている帯域だけ全レーンまとめて進める
+      （TriggerDetector と同じく、レーン方向にベクトル化される）
+    - 帯域幅は中心の半分（定 Q）。2段なので帯域外は 12dB/oct で落ちる
+      （例: 1.6kHz の帯域でキックの 60Hz は約 -23dB）
+    - 出力は |y| を正規化した包絡で、帯域の中心のサイン波なら振幅とほぼ同じ値になる
+      全帯域の閾値と同じ感覚で比べられる
+    - 包絡は立ち上がりに帯域幅の逆数くらい遅れる（低い帯域ほど遅い）。先読みの遡りは入力そのもので見るので影響しない
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ChannelTriggerSettings.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+class BandEnvelopeBank
+{
+public:
+	static constexpr int numLanes = MAX_CHANNELS;
+	static constexpr int numBands = ChannelTriggerSettings::NUM_BANDS;
+
+	static const char* getBandName(int band) noexcept
+	{
+		static const char* names[numBands] = { "Low", "Low-Mid", "Hi-Mid", "High" };
+		return juce::isPositiveAndBelow(band, numBands) ? names[band] : "Full";
+	}
+
+	static float getBandCentreHz(int band) noexcept
+	{
+		static constexpr float centres[numBands] = { 100.0f, 400.0f, 1600.0f, 6000.0f };
+		return centres[juce::jlimit(0, numBands - 1, band)];
+	}
+
+	// メッセージスレッド
+	void prepare(double sampleRate)
+	{
+		for (int b = 0; b < numBands; ++b)
+		{
+			const double centre = juce::jmin((double)getBandCentreHz(b), sampleRate * 0.45);
+			const double bandwidth = centre * 0.5;
+			const double r = std::exp(-juce::MathConstants<double>::pi * bandwidth / sampleRate);
+			const double w = juce::MathConstants<double>::twoPi * centre / sampleRate;
+			auto& c = coeffs[(size_t)b];
+			c.re = (float)(r * std::cos(w));
+			c.im = (float)(r * std::sin(w));
+			c.norm = (float)(2.0 * (1.0 - r) * (1.0 - r)); // 2段の中心での利得 1/(1-r)^2、実信号の正の周波数は半分
+		}
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		for (auto& band : state)
+			band = {};
+	}
+
+	void resetLane(int lane) noexcept
+	{
+		for (auto& band : state)
+			band.re1[(size_t)lane] = band.im1[(size_t)lane] = band.re2[(size_t)lane] = band.im2[(size_t)lane] = 0.0f;
+	}
+
+	// laneBands[lane] の帯域の包絡を output[lane] に numSamples 個（-1 のレーンは書かない）
+	// 使っている帯域ごとに 16 レーンまとめて進める（レーン方向にベクトル化される）
+	void process(const float* const* input, float* const* output, int numChannels, int numSamples,
+	             const int* laneBands) noexcept
+	{
+		numChannels = juce::jmin(numChannels, numLanes);
+		for (int b = 0; b < numBands; ++b)
+		{
+			bool used = false;
+			for (int lane = 0; lane < numChannels; ++lane)
+				used = used || laneBands[lane] == b;
+			if (!used)
+				continue;
+
+			run(b, input, numChannels, numSamples, [&](int i)
+			{
+				for (int lane = 0; lane < numChannels; ++lane)
+					if (laneBands[lane] == b)
+						output[lane][i] = coeffs[(size_t)b].norm * std::sqrt(magnitude[(size_t)lane]);
+			});
+		}
+	}
+
+	// キャリブレーション用: 全帯域を進めて、帯域ごとの包絡の最大を peaks[lane][band] に入れる（上書き）
+	void measure(const float* const* input, int numChannels, int numSamples,
+	             std::array<std::array<float, numBands>, numLanes>& peaks) noexcept
+	{
+		numChannels = juce::jmin(numChannels, numLanes);
+		for (int b = 0; b < numBands; ++b)
+		{
+			std::array<float, numLanes> peakSquared {};
+			run(b, input, numChannels, numSamples, [&](int)
+			{
+				for (size_t l = 0; l < (size_t)numLanes; ++l)
+					peakSquared[l] = juce::jmax(peakSquared[l], magnitude[l]);
+			});
+			for (size_t l = 0; l < (size_t)numLanes; ++l)
+				peaks[l][(size_t)b] = coeffs[(size_t)b].norm * std::sqrt(peakSquared[l]);
+		}
+	}
+
+private:
+	struct Coeffs
+	{
+		float re = 0.0f, im = 0.0f; // r·e^{jω}
+		float norm = 0.0f;
+	};
+
+	// 帯域1つ分の 16 レーンの状態（レーン順）
+	struct LaneStates
+	{
+		std::array<float, numLanes> re1 {}, im1 {}, re2 {}, im2 {};
+	};
+
+	// 帯域 b を numSamples 進める。1サンプルごとに |y|^2 を magnitude に入れて perSample(i) を呼ぶ
+	template <typename Fn>
+	void run(int b, const float* const* input, int numChannels, int numSamples, Fn&& perSample) noexcept
+	{
+		auto& s = state[(size_t)b];
+		const auto c = coeffs[(size_t)b];
+		std::fill(x.begin() + numChannels, x.end(), 0.0f);
+		for (int i = 0; i < numSamples; ++i)
+		{
+			for (int lane = 0; lane < numChannels; ++lane)
+				x[(size_t)lane] = input[lane][i];
+
+			for (size_t l = 0; l < (size_t)numLanes; ++l)
+			{
+				const float r1 = x[l] + c.re * s.re1[l] - c.im * s.im1[l];
+				const float i1 = c.re * s.im1[l] + c.im * s.re1[l];
+				const float r2 = r1 + c.re * s.re2[l] - c.im * s.im2[l];
+				const float i2 = i1 + c.re * s.im2[l] + c.im * s.re2[l];
+				s.re1[l] = r1;
+				s.im1[l] = i1;
+				s.re2[l] = r2;
+				s.im2[l] = i2;
+				magnitude[l] = r2 * r2 + i2 * i2;
+			}
+			perSample(i);
+		}
+	}
+
+	std::array<Coeffs, numBands> coeffs {};
+	std::array<LaneStates, numBands> state {};
+
+	// 作業用（レーン順。入力にないレーンは 0）
+	std::array<float, numLanes> x {};
+	std::array<float, numLanes> magnitude {};
+};
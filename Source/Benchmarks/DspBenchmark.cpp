@@ -0,0 +1,427 @@
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../LooperAudio.h"
+
+// DSP ベンチマーク
+// 1. FX 単体: 1トラック（テストクリック再生）に FX を1つだけかけ、FX なしとの差を測る
+// 2. Autotune を 8 トラックにかけたときの 64 サンプルブロック
+// 3. Filter を 8 トラックにかけたとき: トラックごとの SVF とトラック横断レーン（setCrossTrackLanes）
+// 4. Convolution Reverb を 8 トラックにかけたとき: IR の長さ別、不均一の尾部と一様分割
+// 5. Delay カーネル: 以前の1サンプルずつの DelayLine + tanh と BlockDelay を同じ入力で比べる
+// 6. processBlock 全体: トラック数 x ブロックサイズ (32-2048) x サンプルレート (44.1k-192k)
+// 出力: ns/sample と リアルタイム予算に対する割合。--json <file> で同じ内容を JSON に書く
+// (バージョン間の比較用。--quick で計測時間を短くする)
+
+namespace
+{
+	struct Result
+	{
+		std::string group;  // "fx" / "kernel" / "processBlock"
+		std::string name;
+		int numTracks = 0;
+		int blockSize = 0;
+		double sampleRate = 0.0;
+		double nsPerSample = 0.0;
+		double budgetPercent = 0.0;
+		double deltaNsPerSample = 0.0; // FX: FX なしとの差
+	};
+
+	using Setup = std::function<void(LooperAudio&, int trackId)>;
+
+	struct FxCase
+	{
+		const char* name;
+		Setup enable;
+	};
+
+	const std::vector<FxCase> fxCases =
+	{
+		{ "filter",     [](LooperAudio& l, int id) { l.setTrackFilterEnabled(id, true); l.setTrackFilterCutoff(id, 1000.0f); } },
+		{ "flanger",    [](LooperAudio& l, int id) { l.setTrackFlangerEnabled(id, true); } },
+		{ "chorus",     [](LooperAudio& l, int id) { l.setTrackChorusEnabled(id, true); } },
+		{ "tremolo",    [](LooperAudio& l, int id) { l.setTrackTremoloEnabled(id, true); } },
+		{ "slicer",     [](LooperAudio& l, int id) { l.setTrackSlicerEnabled(id, true); } },
+		{ "bitcrusher", [](LooperAudio& l, int id) { l.setTrackBitcrusherEnabled(id, true); l.setTrackBitcrusherDepth(id, 0.5f); l.setTrackBitcrusherRate(id, 0.2f); } },
+		{ "compressor", [](LooperAudio& l, int id) { l.setTrackCompressorEnabled(id, true); l.setTrackCompressor(id, -20.0f, 4.0f); } },
+		{ "compressor lookahead", [](LooperAudio& l, int id) { l.setTrackCompressorEnabled(id, true); l.setTrackCompressor(id, -20.0f, 4.0f); l.setTrackCompressorLookahead(id, true); } },
+		{ "delay",      [](LooperAudio& l, int id) { l.setTrackDelayEnabled(id, true); l.setTrackDelayMix(id, 0.5f, 0.25f); l.setTrackDelayFeedback(id, 0.4f); } },
+		{ "reverb",     [](LooperAudio& l, int id) { l.setTrackReverbEnabled(id, true); l.setTrackReverbMix(id, 0.3f); } },
+		{ "granular",   [](LooperAudio& l, int id) { l.setTrackGranularEnabled(id, true); l.setTrackGranularDensity(id, 0.8f); } },
+		{ "autotune",   [](LooperAudio& l, int id) { l.setTrackAutotuneEnabled(id, true); } },
+		{ "beatrepeat", [](LooperAudio& l, int id) { l.setTrackBeatRepeatActive(id, true); } },
+	};
+
+	// numTracks 本にテストクリックを入れて再生し、audioSeconds 分の processBlock を測る
+	Result measure(int numTracks, int blockSize, double sampleRate, double audioSeconds, const Setup& setup,
+	               bool crossTrackLanes = false, bool convolutionNonUniformTail = true)
+	{
+		// テストクリックは 2 秒なので、全トラック分が収まるだけのループ用メモリを確保
+		auto looper = std::make_unique<LooperAudio>(sampleRate, numTracks * ((int)(sampleRate * 2.0) + LoopPagePool::defaultPageSize));
+		for (int id = 1; id <= numTracks; ++id)
+			looper->addTrack(id);
+		looper->setCrossTrackLanes(crossTrackLanes);
+		looper->setConvolutionNonUniformTail(convolutionNonUniformTail);
+		looper->prepareToPlay(blockSize, sampleRate);
+
+		for (int id = 1; id <= numTracks; ++id)
+		{
+			looper->generateTestClick(id);
+			if (setup)
+				setup(*looper, id);
+		}
+
+		juce::AudioBuffer<float> input(2, blockSize);
+		juce::AudioBuffer<float> output(2, blockSize);
+		input.clear();
+
+		// ウォームアップ（コマンド適用・キャッシュ）
+		const int warmupBlocks = juce::jmax(8, (int)(0.1 * sampleRate) / blockSize);
+		for (int i = 0; i < warmupBlocks; ++i)
+			looper->processBlock(output, input);
+
+		const int numBlocks = juce::jmax(16, (int)(audioSeconds * sampleRate) / blockSize);
+		const auto start = juce::Time::getHighResolutionTicks();
+		for (int i = 0; i < numBlocks; ++i)
+			looper->processBlock(output, input);
+		const auto end = juce::Time::getHighResolutionTicks();
+
+		const double seconds = juce::Time::highResolutionTicksToSeconds(end - start);
+		const double numSamples = (double)numBlocks * blockSize;
+
+		Result r;
+		r.numTracks = numTracks;
+		r.blockSize = blockSize;
+		r.sampleRate = sampleRate;
+		r.nsPerSample = seconds * 1.0e9 / numSamples;
+		r.budgetPercent = 100.0 * seconds / (numSamples / sampleRate);
+		return r;
+	}
+
+	// 以前の Delay（renderTrack にあった1サンプルずつの処理）をそのまま残したもの
+	struct PerSampleDelay
+	{
+		juce::dsp::DelayLine<float> delay { 96000 };
+
+		void prepare(double sampleRate, int blockSize, float delaySamples)
+		{
+			delay.prepare({ sampleRate, (juce::uint32)blockSize, 2 });
+			delay.setMaximumDelayInSamples((int)(sampleRate * 2.0));
+			delay.setDelay(delaySamples);
+		}
+
+		void process(juce::AudioBuffer<float>& buffer, int numSamples, float mix, float feedback)
+		{
+			auto* left = buffer.getWritePointer(0);
+			auto* right = buffer.getWritePointer(1);
+
+			for (int i = 0; i < numSamples; ++i)
+			{
+				const float inL = left[i];
+				const float inR = right[i];
+				const float wetL = delay.popSample(0);
+				const float wetR = delay.popSample(1);
+
+				left[i] = inL * (1.0f - mix) + wetL * mix;
+				right[i] = inR * (1.0f - mix) + wetR * mix;
+
+				delay.pushSample(0, std::tanh(inL + wetL * feedback));
+				delay.pushSample(1, std::tanh(inR + wetR * feedback));
+			}
+		}
+	};
+
+	// process(buffer) を audioSeconds 分まわして ns/sample を返す（入力は毎ブロック書き直す）
+	template <typename Fn>
+	Result measureKernel(int blockSize, double sampleRate, double audioSeconds, Fn&& process)
+	{
+		juce::AudioBuffer<float> buffer(2, blockSize);
+		juce::Random random(1234);
+
+		auto fill = [&]
+		{
+			for (int ch = 0; ch < 2; ++ch)
+				for (int i = 0; i < blockSize; ++i)
+					buffer.setSample(ch, i, random.nextFloat() * 0.5f - 0.25f);
+		};
+
+		const int numBlocks = juce::jmax(16, (int)(audioSeconds * sampleRate) / blockSize);
+		for (int i = 0; i < 32; ++i) { fill(); process(buffer); }
+
+		double seconds = 0.0;
+		for (int i = 0; i < numBlocks; ++i)
+		{
+			fill();
+			const auto start = juce::Time::getHighResolutionTicks();
+			process(buffer);
+			seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+		}
+
+		const double numSamples = (double)numBlocks * blockSize;
+
+		Result r;
+		r.group = "kernel";
+		r.numTracks = 1;
+		r.blockSize = blockSize;
+		r.sampleRate = sampleRate;
+		r.nsPerSample = seconds * 1.0e9 / numSamples;
+		r.budgetPercent = 100.0 * seconds / (numSamples / sampleRate);
+		return r;
+	}
+
+	void print(const Result& r)
+	{
+		std::cout << "  " << r.name
+		          << "  tracks=" << r.numTracks << "  block=" << r.blockSize << "  sr=" << r.sampleRate
+		          << "  " << r.nsPerSample << " ns/sample  " << r.budgetPercent << " % of budget";
+		if (r.group == "fx")
+			std::cout << "  (fx +" << r.deltaNsPerSample << " ns/sample)";
+		std::cout << std::endl;
+	}
+
+	bool writeJson(const std::string& path, const std::vector<Result>& results)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+
+		out << "{\n  \"benchmark\": \"DspBenchmark\",\n  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const auto& r = results[i];
+			out << "    { \"group\": \"" << r.group << "\", \"name\": \"" << r.name << "\""
+			    << ", \"tracks\": " << r.numTracks << ", \"blockSize\": " << r.blockSize
+			    << ", \"sampleRate\": " << r.sampleRate
+			    << ", \"nsPerSample\": " << r.nsPerSample
+			    << ", \"budgetPercent\": " << r.budgetPercent;
+			if (r.group == "fx")
+				out << ", \"fxNsPerSample\": " << r.deltaNsPerSample;
+			out << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string jsonPath;
+	bool quick = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+		else if (arg == "--quick")           quick = true;
+		else
+		{
+			std::cerr << "usage: DspBenchmark [--json <file>] [--quick]" << std::endl;
+			return 2;
+		}
+	}
+
+	const double fxSeconds = quick ? 0.5 : 4.0;
+	const double blockSeconds = quick ? 0.25 : 2.0;
+
+	std::vector<Result> results;
+
+	// ===== 1. FX 単体 =====
+	{
+		constexpr int blockSize = 256;
+		constexpr double sampleRate = 48000.0;
+		std::cout << "DspBenchmark: FX in isolation (1 track, " << blockSize << " samples @ " << sampleRate << " Hz)" << std::endl;
+
+		auto dry = measure(1, blockSize, sampleRate, fxSeconds, nullptr);
+		dry.group = "fx";
+		dry.name = "dry";
+		print(dry);
+		results.push_back(dry);
+
+		for (const auto& fx : fxCases)
+		{
+			auto r = measure(1, blockSize, sampleRate, fxSeconds, fx.enable);
+			r.group = "fx";
+			r.name = fx.name;
+			r.deltaNsPerSample = r.nsPerSample - dry.nsPerSample;
+			print(r);
+			results.push_back(r);
+		}
+	}
+
+	// ===== 2. Autotune 8トラック @ 64 サンプル（ピッチ検出はホップごと、トラックごとに位相をずらす） =====
+	{
+		constexpr int blockSize = 64;
+		constexpr double sampleRate = 48000.0;
+		std::cout << "DspBenchmark: 8 autotuned tracks (" << blockSize << " samples @ " << sampleRate << " Hz)" << std::endl;
+
+		auto r = measure(8, blockSize, sampleRate, fxSeconds, [](LooperAudio& l, int id) { l.setTrackAutotuneEnabled(id, true); });
+		r.group = "processBlock";
+		r.name = "autotune x8";
+		print(r);
+		results.push_back(r);
+	}
+
+	// ===== 3. Filter 8トラック（トラックごとに cutoff と type を変える） =====
+	{
+		constexpr double sampleRate = 48000.0;
+		std::cout << "DspBenchmark: 8 filtered tracks, per-track SVF vs cross-track lanes" << std::endl;
+
+		const Setup filterSetup = [](LooperAudio& l, int id)
+		{
+			l.setTrackFilterEnabled(id, true);
+			l.setTrackFilterCutoff(id, 250.0f * (float)id);
+			l.setTrackFilterType(id, id % 2);
+		};
+
+		for (int blockSize : { 64, 256 })
+		{
+			for (bool lanes : { false, true })
+			{
+				auto r = measure(8, blockSize, sampleRate, fxSeconds, filterSetup, lanes);
+				r.group = "processBlock";
+				r.name = lanes ? "filter x8 lanes" : "filter x8";
+				print(r);
+				results.push_back(r);
+			}
+		}
+	}
+
+	// ===== 4. Convolution Reverb 8トラック（減衰するステレオのノイズ IR、トラックごとに別の IR） =====
+	{
+		constexpr double sampleRate = 48000.0;
+		std::cout << "DspBenchmark: 8 tracks with convolution reverb, non-uniform tail vs uniform partitions" << std::endl;
+
+		for (double impulseSeconds : { 1.0, 3.0 })
+		{
+			const Setup convolutionSetup = [impulseSeconds](LooperAudio& l, int id)
+			{
+				juce::Random random(id);
+				juce::AudioBuffer<float> impulse(2, (int)(impulseSeconds * sampleRate));
+				for (int ch = 0; ch < 2; ++ch)
+					for (int i = 0; i < impulse.getNumSamples(); ++i)
+						impulse.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f)
+						                         * std::exp(-6.9f * (float)i / (float)impulse.getNumSamples()));
+
+				l.setTrackReverbImpulse(id, impulse, sampleRate);
+				l.setTrackReverbEnabled(id, true);
+				l.setTrackReverbMix(id, 0.3f);
+			};
+
+			for (int blockSize : { 64, 256 })
+			{
+				// 一様分割は長い IR でリアルタイムに収まらないので、1 秒の IR だけ比べる
+				for (bool nonUniformTail : { true, false })
+				{
+					if (!nonUniformTail && impulseSeconds > 1.0)
+						continue;
+
+					auto r = measure(8, blockSize, sampleRate, fxSeconds, convolutionSetup, false, nonUniformTail);
+					r.group = "processBlock";
+					r.name = "convolution " + std::to_string((int)impulseSeconds) + "s x8" + (nonUniformTail ? "" : " uniform");
+					print(r);
+					results.push_back(r);
+				}
+			}
+		}
+	}
+
+	// ===== 5. Reverb + Delay 8トラック: トラックごとのインサート vs 共有の Send バス =====
+	{
+		constexpr double sampleRate = 48000.0;
+		std::cout << "DspBenchmark: 8 tracks with reverb + delay, per-track inserts vs shared send buses" << std::endl;
+
+		const Setup insertSetup = [](LooperAudio& l, int id)
+		{
+			l.setTrackReverbEnabled(id, true);
+			l.setTrackReverbMix(id, 0.3f);
+			l.setTrackDelayEnabled(id, true);
+			l.setTrackDelayMix(id, 0.3f, 0.25f);
+		};
+		const Setup sendSetup = [](LooperAudio& l, int id)
+		{
+			l.setTrackReverbSend(id, 0.3f);
+			l.setTrackDelaySend(id, 0.3f);
+			l.setBusDelayTime(0.25f);
+		};
+
+		for (int blockSize : { 64, 256 })
+		{
+			for (bool sends : { false, true })
+			{
+				auto r = measure(8, blockSize, sampleRate, fxSeconds, sends ? sendSetup : insertSetup);
+				r.group = "processBlock";
+				r.name = sends ? "reverb+delay x8 send bus" : "reverb+delay x8 insert";
+				print(r);
+				results.push_back(r);
+			}
+		}
+	}
+
+	// ===== 6. Delay カーネル（250ms, feedback 0.4, mix 0.5） =====
+	{
+		constexpr double sampleRate = 48000.0;
+		constexpr float delaySamples = (float)(sampleRate * 0.25);
+		std::cout << "DspBenchmark: delay kernel, per-sample DelayLine + tanh vs BlockDelay" << std::endl;
+
+		for (int blockSize : { 64, 256, 1024 })
+		{
+			PerSampleDelay before;
+			before.prepare(sampleRate, blockSize, delaySamples);
+			auto r = measureKernel(blockSize, sampleRate, fxSeconds, [&](juce::AudioBuffer<float>& b) { before.process(b, blockSize, 0.5f, 0.4f); });
+			r.name = "delay per-sample";
+			print(r);
+			results.push_back(r);
+
+			BlockDelay after;
+			after.prepare(sampleRate, blockSize);
+			BlockDelay::Params params;
+			params.delaySamples = delaySamples;
+			params.feedback = 0.4f;
+			params.mix = 0.5f;
+			r = measureKernel(blockSize, sampleRate, fxSeconds, [&](juce::AudioBuffer<float>& b) { after.process(b, blockSize, params); });
+			r.name = "delay block";
+			print(r);
+			results.push_back(r);
+
+			params.pingPong = true;
+			r = measureKernel(blockSize, sampleRate, fxSeconds, [&](juce::AudioBuffer<float>& b) { after.process(b, blockSize, params); });
+			r.name = "delay block ping-pong";
+			print(r);
+			results.push_back(r);
+		}
+	}
+
+	// ===== 7. processBlock 全体 =====
+	std::cout << "DspBenchmark: processBlock end to end (playback only)" << std::endl;
+	for (double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+	{
+		for (int numTracks : { 1, 8, 32 })
+		{
+			for (int blockSize : { 32, 64, 128, 256, 512, 1024, 2048 })
+			{
+				auto r = measure(numTracks, blockSize, sampleRate, blockSeconds, nullptr);
+				r.group = "processBlock";
+				r.name = "playback";
+				print(r);
+				results.push_back(r);
+			}
+		}
+	}
+
+	if (!jsonPath.empty())
+	{
+		if (!writeJson(jsonPath, results))
+		{
+			std::cerr << "cannot write " << jsonPath << std::endl;
+			return 1;
+		}
+		std::cout << "JSON written to " << jsonPath << std::endl;
+	}
+
+	return 0;
+}
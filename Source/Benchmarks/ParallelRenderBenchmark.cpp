@@ -0,0 +1,142 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <iterator>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../LooperAudio.h"
+
+// 並列トラックレンダリングの計測
+// 8 / 16 トラックに Granular + Autotune + Reverb をかけ、64 サンプルブロックで
+// シリアル経路と 4 / 8 / 16 コア（ワーカー 3 / 7 / 15 + オーディオスレッド）を比べる。
+// あわせて、並列経路の出力がシリアル経路とビット単位で一致することを確認する。
+// 最後にシリアル比の速度向上を表（Markdown）でまとめて出す。コア数が足りずに抑えられた列は * 付き
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 64;
+	constexpr int warmupBlocks = 256;
+	constexpr int measuredBlocks = 8000;
+	constexpr int compareBlocks = 2000;
+
+	struct Rig
+	{
+		Rig(int numTracks, int numCores)
+			: looper(sampleRate, numTracks * ((int)(sampleRate * 2.0) + LoopPagePool::defaultPageSize))
+		{
+			// numCores = オーディオスレッド + ワーカー
+			looper.setRenderThreadCount(numCores - 1);
+
+			for (int id = 1; id <= numTracks; ++id)
+				looper.addTrack(id);
+
+			looper.prepareToPlay(blockSize, sampleRate);
+
+			for (int id = 1; id <= numTracks; ++id)
+			{
+				looper.generateTestClick(id);
+				looper.setTrackGranularEnabled(id, true);
+				looper.setTrackGranularDensity(id, 0.8f);
+				looper.setTrackAutotuneEnabled(id, true);
+				looper.setTrackReverbEnabled(id, true);
+				looper.setTrackReverbMix(id, 0.3f);
+			}
+
+			input.clear();
+		}
+
+		void process() { looper.processBlock(output, input); }
+		int activeCores() const { return looper.getActiveRenderThreadCount() + 1; }
+
+		LooperAudio looper;
+		juce::AudioBuffer<float> input { 2, blockSize };
+		juce::AudioBuffer<float> output { 2, blockSize };
+	};
+
+	double runCase(int numTracks, int numCores, int& activeCores)
+	{
+		Rig rig(numTracks, numCores);
+		activeCores = rig.activeCores();
+
+		for (int i = 0; i < warmupBlocks; ++i)
+			rig.process();
+
+		const auto start = juce::Time::getHighResolutionTicks();
+		for (int i = 0; i < measuredBlocks; ++i)
+			rig.process();
+		const auto end = juce::Time::getHighResolutionTicks();
+
+		const double seconds = juce::Time::highResolutionTicksToSeconds(end - start);
+		return seconds * 1.0e6 / measuredBlocks;
+	}
+
+	bool outputMatchesSerial(int numTracks, int numCores)
+	{
+		Rig serial(numTracks, 1);
+		Rig parallel(numTracks, numCores);
+
+		for (int i = 0; i < compareBlocks; ++i)
+		{
+			serial.process();
+			parallel.process();
+
+			for (int ch = 0; ch < 2; ++ch)
+				if (std::memcmp(serial.output.getReadPointer(ch), parallel.output.getReadPointer(ch),
+								sizeof(float) * (size_t)blockSize) != 0)
+					return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	const double budgetUs = blockSize / sampleRate * 1.0e6;
+	const int numCpus = juce::SystemStats::getNumCpus();
+
+	std::cout << "ParallelRenderBenchmark: " << blockSize << " samples @ " << sampleRate
+	          << " Hz (budget " << budgetUs << " us/block), " << numCpus << " CPUs available" << std::endl;
+	std::cout << "  FX per track: granular + autotune + reverb" << std::endl;
+
+	constexpr int trackCounts[] = { 8, 16 };
+	constexpr int coreCounts[] = { 4, 8, 16 };
+	std::string speedups[std::size(trackCounts)][std::size(coreCounts)];
+
+	for (size_t t = 0; t < std::size(trackCounts); ++t)
+	{
+		const int numTracks = trackCounts[t];
+		int activeCores = 1;
+		const double serialUs = runCase(numTracks, 1, activeCores);
+		std::cout << "  tracks=" << numTracks << "  cores=1 (serial)  "
+		          << serialUs << " us/block  " << (100.0 * serialUs / budgetUs) << " % of budget" << std::endl;
+
+		for (size_t c = 0; c < std::size(coreCounts); ++c)
+		{
+			const int numCores = coreCounts[c];
+			const double us = runCase(numTracks, numCores, activeCores);
+			const bool identical = outputMatchesSerial(numTracks, numCores);
+
+			std::cout << "  tracks=" << numTracks << "  cores=" << numCores
+			          << "  " << us << " us/block"
+			          << "  " << (100.0 * us / budgetUs) << " % of budget"
+			          << "  speedup x" << (serialUs / us)
+			          << "  output " << (identical ? "identical" : "DIFFERS")
+			          << (activeCores < numCores ? "  (capped to " + std::to_string(activeCores) + " cores)" : std::string()) << std::endl;
+
+			if (!identical)
+				return 1;
+
+			speedups[t][c] = juce::String(serialUs / us, 2).toStdString() + (activeCores < numCores ? "*" : "");
+		}
+	}
+
+	std::cout << std::endl << "| tracks | 1 core | 4 cores | 8 cores | 16 cores |" << std::endl
+	          << "|---|---|---|---|---|" << std::endl;
+	for (size_t t = 0; t < std::size(trackCounts); ++t)
+		std::cout << "| " << trackCounts[t] << " | x1.00 | x" << speedups[t][0] << " | x" << speedups[t][1]
+		          << " | x" << speedups[t][2] << " |" << std::endl;
+	std::cout << "(* = capped to the CPUs available, " << numCpus << ")" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../LooperAudio.h"
+
+// トラックストアのスケーリング計測
+// N トラック (8 / 32 / 64) を全て再生中にして processBlock の所要時間を測る。
+// 出力: 1ブロックあたりの平均 µs と、リアルタイム予算に対する割合
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 256;
+	constexpr int warmupBlocks = 64;
+	constexpr int measuredBlocks = 2000;
+
+	double runCase(int numTracks)
+	{
+		// テストクリックは 2 秒なので、全トラック分が収まるだけのループ用メモリを確保
+		LooperAudio looper(sampleRate, numTracks * ((int)(sampleRate * 2.0) + LoopPagePool::defaultPageSize));
+		looper.prepareToPlay(blockSize, sampleRate);
+
+		for (int id = 1; id <= numTracks; ++id)
+		{
+			looper.addTrack(id);
+			looper.generateTestClick(id);
+		}
+
+		juce::AudioBuffer<float> input(2, blockSize);
+		juce::AudioBuffer<float> output(2, blockSize);
+		input.clear();
+
+		for (int i = 0; i < warmupBlocks; ++i)
+			looper.processBlock(output, input);
+
+		const auto start = juce::Time::getHighResolutionTicks();
+		for (int i = 0; i < measuredBlocks; ++i)
+			looper.processBlock(output, input);
+		const auto end = juce::Time::getHighResolutionTicks();
+
+		const double seconds = juce::Time::highResolutionTicksToSeconds(end - start);
+		return seconds * 1.0e6 / measuredBlocks;
+	}
+}
+
+int main()
+{
+	const double budgetUs = blockSize / sampleRate * 1.0e6;
+
+	std::cout << "TrackStoreBenchmark: " << blockSize << " samples @ " << sampleRate
+	          << " Hz (budget " << budgetUs << " us/block)" << std::endl;
+
+	for (int numTracks : { 8, 32, 64 })
+	{
+		const double us = runCase(numTracks);
+		std::cout << "  tracks=" << numTracks
+		          << "  " << us << " us/block"
+		          << "  " << (us / numTracks) << " us/track"
+		          << "  " << (100.0 * us / budgetUs) << " % of budget" << std::endl;
+	}
+
+	return 0;
+}
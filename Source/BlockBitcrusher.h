@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    BlockBitcrusher.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX の Bitcrusher（ステレオ、オーディオスレッド専用）
+    - 量子化: レベル数 2^(bits - 1) に丸める。丸めは int 変換で、分岐なしでベクトル化される
+      （フルスケールを超えた分は ADC と同じく頭打ち）
+    - デシメーション: holdLength サンプルずつ同じ値を保持する。保持区間ごとに fill するだけ
+      で、区間はブロックをまたいで続く
+    - bits = 24 - depth * 20、holdLength = 1 + rate * 40（FXPanel の表示と同じ）
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+
+class BlockBitcrusher
+{
+public:
+	struct Params
+	{
+		float depth = 0.0f; // 0.0 (24bit) - 1.0 (4bit)
+		float rate = 0.0f;  // 0.0 (1/1) - 1.0 (1/41)
+	};
+
+	static float getBits(float depth) noexcept        { return 24.0f - juce::jlimit(0.0f, 1.0f, depth) * 20.0f; }
+	static int   getHoldLength(float rate) noexcept   { return 1 + (int)(juce::jlimit(0.0f, 1.0f, rate) * 40.0f); }
+
+	void reset() noexcept
+	{
+		held = {};
+		holdPosition = 0;
+	}
+
+	// buffer の先頭 numSamples（最大2ch）をその場で置き換える
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const Params& params) noexcept
+	{
+		const int numChannels = juce::jmin(2, buffer.getNumChannels());
+		const float bits = getBits(params.depth);
+		const int holdLength = getHoldLength(params.rate);
+
+		// --- 1. 量子化（23.5bit 以上は float の仮数とほぼ同じなので素通し） ---
+		if (bits < 23.5f)
+		{
+			const float levels = std::exp2(bits - 1.0f);
+			for (int ch = 0; ch < numChannels; ++ch)
+				quantize(buffer.getWritePointer(ch), numSamples, levels);
+		}
+
+		// --- 2. サンプル & ホールド（量子化してから保持しても結果は同じ） ---
+		if (holdLength > 1)
+		{
+			const int start = holdPosition % holdLength;
+			for (int ch = 0; ch < numChannels; ++ch)
+				hold(buffer.getWritePointer(ch), numSamples, held[(size_t)ch], start, holdLength);
+			holdPosition = (start + numSamples) % holdLength;
+		}
+		else
+		{
+			holdPosition = 0;
+		}
+	}
+
+	static void quantize(float* data, int numSamples, float levels) noexcept
+	{
+		const float inverse = 1.0f / levels;
+		for (int i = 0; i < numSamples; ++i)
+		{
+			const float v = juce::jlimit(-levels, levels, data[i] * levels);
+			// ±0.5 してから 0 方向に切り捨て = 四捨五入
+			data[i] = (float)(int)(v + (v < 0.0f ? -0.5f : 0.5f)) * inverse;
+		}
+	}
+
+private:
+	static void hold(float* data, int numSamples, float& last, int position, int holdLength) noexcept
+	{
+		for (int offset = 0; offset < numSamples;)
+		{
+			if (position == 0)
+				last = data[offset];
+
+			const int run = juce::jmin(holdLength - position, numSamples - offset);
+			juce::FloatVectorOperations::fill(data + offset, last, run);
+			position = (position + run) % holdLength;
+			offset += run;
+		}
+	}
+
+	std::array<float, 2> held {};  // 保持中の値（L / R）
+	int holdPosition = 0;          // 保持区間の中の位置（次のブロックへ持ち越す）
+};
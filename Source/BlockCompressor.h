@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    BlockCompressor.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX の Compressor（ステレオリンク、オーディオスレッド専用）
+    - 検出は detectorStep サンプルごと: 区間のピーク（L / R の絶対値の最大）を findMinAndMax で取り、
+      エンベロープ（アタック / リリースの一次遅れ）と dB 計算は区間に1回だけ
+    - ゲインは区間の中を直線でつなぎ（ランプ表 × 差分 + 前の値）、FloatVectorOperations でまとめて掛ける
+    - ルックアヘッド（任意）: 音声だけを lookaheadMs 遅らせ、検出は遅らせない入力で行う。
+      ゲインが立ち上がりより先に下がるので、アタックの頭が抜けにくい（その分トラックが遅れる）
+    - ゲインリダクション（直前ブロックの最大、dB）はどのスレッドから読んでもよい
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+class BlockCompressor
+{
+public:
+	static constexpr float lookaheadMs = 5.0f;
+
+	struct Params
+	{
+		float thresholdDb = 0.0f;
+		float ratio = 1.0f;        // 1.0 = 素通し
+		float attackMs = 1.0f;
+		float releaseMs = 100.0f;
+		bool lookahead = false;
+	};
+
+	// メッセージスレッドで呼ぶ（確保する）
+	void prepare(double newSampleRate, int maxBlockSize)
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		lookaheadSamples = juce::jmax(1, (int)std::round(sampleRate * lookaheadMs * 0.001));
+
+		int size = 1;
+		while (size < lookaheadSamples + juce::jmax(1, maxBlockSize))
+			size <<= 1;
+		ringMask = size - 1;
+		ring.setSize(2, size);
+
+		for (int i = 0; i < detectorStep; ++i)
+			ramp[(size_t)i] = (float)(i + 1) / (float)detectorStep;
+
+		reset();
+	}
+
+	// 確保済みバッファの中身だけ消す（オーディオスレッドから呼んでよい）
+	void reset() noexcept
+	{
+		ring.clear();
+		writePos = 0;
+		envelope = 0.0f;
+		currentGain = 1.0f;
+		gainReductionDb.store(0.0f, std::memory_order_relaxed);
+	}
+
+	int getLookaheadSamples() const noexcept { return lookaheadSamples; }
+	float getGainReductionDb() const noexcept { return gainReductionDb.load(std::memory_order_relaxed); }
+
+	// buffer の先頭 numSamples（最大2ch）をその場で置き換える
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const Params& params) noexcept
+	{
+		const int numChannels = juce::jmin(2, buffer.getNumChannels());
+		if (numSamples <= 0 || numChannels == 0)
+			return;
+
+		// ルックアヘッドの ON / OFF で遅延が変わるので、切り替えたときはリングを空にする
+		if (params.lookahead != lookaheadActive)
+		{
+			ring.clear();
+			lookaheadActive = params.lookahead;
+		}
+
+		const float slope = 1.0f - 1.0f / juce::jmax(1.0f, params.ratio);
+		const float attack = coefficient(params.attackMs, detectorStep);
+		const float release = coefficient(params.releaseMs, detectorStep);
+		float minGain = 1.0f;
+
+		for (int offset = 0; offset < numSamples; offset += chunkSize)
+		{
+			const int n = juce::jmin(chunkSize, numSamples - offset);
+
+			// --- 1. ゲイン（遅らせない入力から） ---
+			for (int step = 0; step < n; step += detectorStep)
+			{
+				const int m = juce::jmin(detectorStep, n - step);
+
+				float peak = 0.0f;
+				for (int ch = 0; ch < numChannels; ++ch)
+				{
+					const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(ch, offset + step), m);
+					peak = juce::jmax(peak, range.getEnd(), -range.getStart());
+				}
+
+				const float k = m == detectorStep ? (peak > envelope ? attack : release)
+				                                  : coefficient(peak > envelope ? params.attackMs : params.releaseMs, m);
+				envelope = peak + (envelope - peak) * k;
+
+				float target = 1.0f;
+				if (slope > 0.0f && envelope > 1.0e-6f)
+				{
+					const float overDb = juce::Decibels::gainToDecibels(envelope) - params.thresholdDb;
+					if (overDb > 0.0f)
+						target = juce::Decibels::decibelsToGain(-overDb * slope);
+				}
+
+				// 区間の中は currentGain → target の直線
+				float* g = gains.data() + step;
+				if (m == detectorStep)
+				{
+					juce::FloatVectorOperations::copyWithMultiply(g, ramp.data(), target - currentGain, m);
+					juce::FloatVectorOperations::add(g, currentGain, m);
+				}
+				else
+				{
+					for (int i = 0; i < m; ++i)
+						g[i] = currentGain + (target - currentGain) * (float)(i + 1) / (float)m;
+				}
+
+				currentGain = target;
+				minGain = juce::jmin(minGain, target);
+			}
+
+			// --- 2. ルックアヘッド: 入力をリングに書いて、lookaheadSamples 前を読み戻す ---
+			if (lookaheadActive)
+			{
+				for (int ch = 0; ch < numChannels; ++ch)
+				{
+					float* data = buffer.getWritePointer(ch, offset);
+					copyRing(ring.getWritePointer(ch), writePos, data, n, true);
+					copyRing(ring.getWritePointer(ch), writePos - lookaheadSamples, data, n, false);
+				}
+				writePos += n;
+			}
+
+			// --- 3. 適用 ---
+			for (int ch = 0; ch < numChannels; ++ch)
+				juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch, offset), gains.data(), n);
+		}
+
+		gainReductionDb.store(-juce::Decibels::gainToDecibels(minGain, -120.0f), std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr int detectorStep = 16;   // エンベロープを更新する間隔（サンプル）
+	static constexpr int chunkSize = 512;     // スタック上のゲイン領域（detectorStep の倍数）
+	static_assert(chunkSize % detectorStep == 0, "gain chunks hold whole detector steps");
+
+	// numSamples 進んだときの一次遅れの係数
+	float coefficient(float timeMs, int numSamples) const noexcept
+	{
+		const double seconds = juce::jmax(0.01, (double)timeMs) * 0.001;
+		return (float)std::exp(-(double)numSamples / (seconds * sampleRate));
+	}
+
+	// toRing = true: data → リング、false: リング → data
+	void copyRing(float* ringData, juce::int64 start, float* data, int n, bool toRing) const noexcept
+	{
+		const int idx = (int)(start & ringMask);
+		const int first = juce::jmin(n, ringMask + 1 - idx);
+		if (toRing)
+		{
+			juce::FloatVectorOperations::copy(ringData + idx, data, first);
+			juce::FloatVectorOperations::copy(ringData, data + first, n - first);
+		}
+		else
+		{
+			juce::FloatVectorOperations::copy(data, ringData + idx, first);
+			juce::FloatVectorOperations::copy(data + first, ringData, n - first);
+		}
+	}
+
+	double sampleRate = 44100.0;
+	int lookaheadSamples = 1;
+	bool lookaheadActive = false;
+
+	float envelope = 0.0f;
+	float currentGain = 1.0f;
+	std::atomic<float> gainReductionDb { 0.0f };
+
+	std::array<float, chunkSize> gains {};
+	std::array<float, detectorStep> ramp {};
+
+	juce::AudioBuffer<float> ring; // L / R のリング（長さは2のべき）
+	juce::int64 writePos = 0;
+	int ringMask = 0;
+};
@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    BlockDelay.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX の Delay（ステレオ、オーディオスレッド専用）
+    - リングバッファへの読み書きはブロック単位。ディレイ時間がブロックより短いときは
+      「読む位置がまだ書いていない所に届かない長さ」に区切って処理する
+    - ディレイ時間は目標値へ一次遅れで寄せ、ブロック内は直線で動かす（時間を回しても
+      プチッと言わず、テープ風にピッチが揺れる）。読み出しは小数位置の線形補間
+    - フィードバックのサチュレーションは tanh ではなく有理式の近似（分岐なし、ベクトル化される）
+    - 同期: マスターループを 4/4 の1小節とみなした音符の長さ（getSyncedDelaySamples）
+    - ピンポン: 入力はモノラルにして左だけに入れ、フィードバックを L / R 交差させる
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+
+class BlockDelay
+{
+public:
+	static constexpr int numDivisions = 8;
+
+	struct Params
+	{
+		float delaySamples = 22050.0f; // 目標のディレイ時間（サンプル、小数可）
+		float feedback = 0.0f;         // 0.0-0.95
+		float mix = 0.0f;              // 0.0-1.0
+		bool pingPong = false;
+	};
+
+	// マスターループ（= 1小節）に対する長さ
+	static float getDivisionFraction(int index) noexcept
+	{
+		static constexpr float fractions[numDivisions] =
+		{
+			1.0f / 2.0f,  // 1/2
+			1.0f / 4.0f,  // 1/4
+			3.0f / 16.0f, // 1/8.
+			1.0f / 6.0f,  // 1/4T
+			1.0f / 8.0f,  // 1/8
+			3.0f / 32.0f, // 1/16.
+			1.0f / 12.0f, // 1/8T
+			1.0f / 16.0f  // 1/16
+		};
+		return fractions[juce::jlimit(0, numDivisions - 1, index)];
+	}
+
+	static const char* getDivisionName(int index) noexcept
+	{
+		static const char* const names[numDivisions] = { "1/2", "1/4", "1/8.", "1/4T", "1/8", "1/16.", "1/8T", "1/16" };
+		return names[juce::jlimit(0, numDivisions - 1, index)];
+	}
+
+	// 最大ディレイに収まらなければ半分ずつにする（拍には乗ったまま）
+	static float getSyncedDelaySamples(int loopLength, int divisionIndex, float maxDelaySamples) noexcept
+	{
+		float samples = (float)loopLength * getDivisionFraction(divisionIndex);
+		while (samples > maxDelaySamples)
+			samples *= 0.5f;
+		return juce::jmax(1.0f, samples);
+	}
+
+	// メッセージスレッドで呼ぶ（確保する）
+	void prepare(double newSampleRate, int maxBlockSize, double maxDelaySeconds = 2.0)
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		maxDelay = (float)(sampleRate * maxDelaySeconds);
+
+		int size = 1;
+		while (size < (int)maxDelay + juce::jmax(1, maxBlockSize) + chunkSize + 2)
+			size <<= 1;
+		ringMask = size - 1;
+		ring.setSize(2, size);
+
+		glideCoefficient = (float)std::exp(-1.0 / (glideSeconds * sampleRate));
+		reset();
+	}
+
+	// 確保済みバッファの中身だけ消す（オーディオスレッドから呼んでよい）
+	void reset() noexcept
+	{
+		ring.clear();
+		writePos = 0;
+		currentDelay = -1.0f; // 次の process で目標値にそのまま合わせる
+	}
+
+	float getMaxDelaySamples() const noexcept { return maxDelay; }
+	float getCurrentDelaySamples() const noexcept { return currentDelay; }
+
+	// buffer の先頭 numSamples（L / R）を置き換える
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const Params& params) noexcept
+	{
+		if (numSamples <= 0 || ring.getNumSamples() == 0)
+			return;
+
+		float* left = buffer.getWritePointer(0);
+		float* right = buffer.getWritePointer(buffer.getNumChannels() > 1 ? 1 : 0);
+
+		// --- ディレイ時間: 目標へ一次遅れで寄せ、ブロック内は直線 ---
+		const float target = juce::jlimit(1.0f, maxDelay, params.delaySamples);
+		if (currentDelay < 0.0f)
+			currentDelay = target;
+
+		float endDelay = target + (currentDelay - target) * std::pow(glideCoefficient, (float)numSamples);
+		if (std::abs(endDelay - target) < 0.01f)
+			endDelay = target;
+
+		const float slope = (endDelay - currentDelay) / (float)numSamples;
+		const float minDelay = juce::jmin(currentDelay, endDelay);
+
+		// 読む位置（小数）の次のサンプルが、まだ書いていない所に届かない長さで区切る
+		const int span = juce::jlimit(1, chunkSize, (int)minDelay - 1);
+		const float feedback = juce::jlimit(0.0f, 0.95f, params.feedback);
+
+		std::array<float, chunkSize> wetL, wetR, feedL, feedR;
+
+		for (int offset = 0; offset < numSamples;)
+		{
+			const int n = juce::jmin(span, numSamples - offset);
+			const float delayAtStart = currentDelay + slope * (float)offset;
+
+			// --- 1. 読み出し ---
+			if (slope == 0.0f)
+				readConstant(delayAtStart, n, wetL.data(), wetR.data());
+			else
+				readGliding(delayAtStart, slope, n, wetL.data(), wetR.data());
+
+			// --- 2. フィードバック（入力 + 戻り）をサチュレーションして書き込む ---
+			if (params.pingPong)
+			{
+				// 左 = モノラル入力 + 右の戻り、右 = 左の戻り
+				juce::FloatVectorOperations::add(feedL.data(), left + offset, right + offset, n);
+				juce::FloatVectorOperations::multiply(feedL.data(), 0.5f, n);
+				juce::FloatVectorOperations::addWithMultiply(feedL.data(), wetR.data(), feedback, n);
+				juce::FloatVectorOperations::copyWithMultiply(feedR.data(), wetL.data(), feedback, n);
+			}
+			else
+			{
+				juce::FloatVectorOperations::copy(feedL.data(), left + offset, n);
+				juce::FloatVectorOperations::copy(feedR.data(), right + offset, n);
+				juce::FloatVectorOperations::addWithMultiply(feedL.data(), wetL.data(), feedback, n);
+				juce::FloatVectorOperations::addWithMultiply(feedR.data(), wetR.data(), feedback, n);
+			}
+
+			softClip(feedL.data(), n);
+			softClip(feedR.data(), n);
+			writeRing(0, feedL.data(), n);
+			writeRing(1, feedR.data(), n);
+			writePos += n;
+
+			// --- 3. ドライ / ウェット ---
+			juce::FloatVectorOperations::multiply(left + offset, 1.0f - params.mix, n);
+			juce::FloatVectorOperations::addWithMultiply(left + offset, wetL.data(), params.mix, n);
+			if (right != left)
+			{
+				juce::FloatVectorOperations::multiply(right + offset, 1.0f - params.mix, n);
+				juce::FloatVectorOperations::addWithMultiply(right + offset, wetR.data(), params.mix, n);
+			}
+
+			offset += n;
+		}
+
+		currentDelay = endDelay;
+	}
+
+	// 有理式による tanh の近似。|x| ≥ 3 で ±1、それ以下は滑らか（分岐なしでベクトル化される）
+	static void softClip(float* data, int numSamples) noexcept
+	{
+		for (int i = 0; i < numSamples; ++i)
+		{
+			const float x = juce::jlimit(-3.0f, 3.0f, data[i]);
+			const float x2 = x * x;
+			data[i] = x * (27.0f + x2) / (27.0f + 9.0f * x2);
+		}
+	}
+
+private:
+	static constexpr int chunkSize = 256;          // スタック上の作業領域（サンプル数）
+	static constexpr double glideSeconds = 0.08;    // ディレイ時間の追従（時定数）
+
+	// ディレイ時間が一定: 2本の連続した読み出しを補間するだけ
+	void readConstant(float delay, int n, float* outL, float* outR) noexcept
+	{
+		const double position = (double)writePos - (double)delay;
+		const auto index = (juce::int64)std::floor(position);
+		const float frac = (float)(position - (double)index);
+
+		std::array<float, chunkSize> next;
+		for (int ch = 0; ch < 2; ++ch)
+		{
+			float* out = ch == 0 ? outL : outR;
+			readRing(ch, index, out, n);
+			if (frac > 0.0f)
+			{
+				readRing(ch, index + 1, next.data(), n);
+				juce::FloatVectorOperations::subtract(next.data(), out, n);
+				juce::FloatVectorOperations::addWithMultiply(out, next.data(), frac, n);
+			}
+		}
+	}
+
+	// ディレイ時間が動いている: 1サンプルずつ位置を進めて補間
+	void readGliding(float delay, float slope, int n, float* outL, float* outR) noexcept
+	{
+		const float* ringL = ring.getReadPointer(0);
+		const float* ringR = ring.getReadPointer(1);
+
+		for (int i = 0; i < n; ++i)
+		{
+			const double position = (double)(writePos + i) - (double)(delay + slope * (float)i);
+			const auto index = (juce::int64)std::floor(position);
+			const float frac = (float)(position - (double)index);
+			const int i0 = (int)(index & ringMask);
+			const int i1 = (int)((index + 1) & ringMask);
+
+			outL[i] = ringL[i0] + frac * (ringL[i1] - ringL[i0]);
+			outR[i] = ringR[i0] + frac * (ringR[i1] - ringR[i0]);
+		}
+	}
+
+	void readRing(int ch, juce::int64 start, float* dest, int n) const noexcept
+	{
+		const float* src = ring.getReadPointer(ch);
+		const int idx = (int)(start & ringMask);
+		const int first = juce::jmin(n, ringMask + 1 - idx);
+		juce::FloatVectorOperations::copy(dest, src + idx, first);
+		juce::FloatVectorOperations::copy(dest + first, src, n - first);
+	}
+
+	void writeRing(int ch, const float* src, int n) noexcept
+	{
+		float* dest = ring.getWritePointer(ch);
+		const int idx = (int)(writePos & ringMask);
+		const int first = juce::jmin(n, ringMask + 1 - idx);
+		juce::FloatVectorOperations::copy(dest + idx, src, first);
+		juce::FloatVectorOperations::copy(dest, src + first, n - first);
+	}
+
+	double sampleRate = 44100.0;
+	float maxDelay = 88200.0f;
+	float glideCoefficient = 0.0f;
+	float currentDelay = -1.0f;
+	juce::int64 writePos = 0;
+	int ringMask = 0;
+	juce::AudioBuffer<float> ring; // L / R のリング（長さは2のべき）
+};
@@ -12,6 +12,7 @@
 
 #pragma once
 #include <juce_core/juce_core.h>
+#include <array>
 
 #define MAX_CHANNELS 16
 
@@ -25,10 +26,21 @@ struct ChannelTriggerSettings
     bool isActive = true;               // チャンネルの有効/無効
     bool isCalibrationEnabled = true;   // キャリブレーションを使用するか
     float calibratedNoiseFloor = 0.0f;  // キャリブレーションで測定されたノイズフロア
+    bool isAdaptiveFloorEnabled = true; // ノイズフロアを常に追従する（NoiseFloorTracker）。OFF ならキャリブレーションの値
+    
+    // 帯域トリガー（BandEnvelopeBank）。-1 = 全帯域（従来どおり）、0..NUM_BANDS-1 = その帯域の包絡だけで検出
+    static constexpr int NUM_BANDS = 4;
+    int triggerBand = -1;
+    std::array<float, NUM_BANDS> calibratedBandFloor {};  // 帯域ごとのノイズフロア（キャリブレーションで測定）
+    
+    bool isBandTrigger() const { return juce::isPositiveAndBelow(triggerBand, NUM_BANDS); }
     
     // モノラルモード時のゲインブースト（dB）
     static constexpr float MONO_GAIN_BOOST_DB = 3.0f;
     
+    // 測ったピークにかけるマージン（キャリブレーション・追従とも）
+    static constexpr float NOISE_FLOOR_MARGIN = 1.5f;
+    
     // キャリブレーションOFF時の最低閾値（事実上ゲート開放）
     static constexpr float MIN_THRESHOLD = 0.0001f;  // -80dB相当
     
@@ -39,14 +51,22 @@ struct ChannelTriggerSettings
     }
     
     // 有効な閾値を取得（キャリブレーションOFFなら最低値）
-    float getEffectiveThreshold() const
+    // adaptiveFloor: 追従中のノイズフロア（マージン込み、0 = まだ）。オーディオスレッドの NoiseFloorTracker から渡す
+    // （設定はメッセージスレッドと共有なので、毎ブロック変わる値はここに置かない）
+    float getEffectiveThreshold(float adaptiveFloor) const
     {
         if (!isCalibrationEnabled)
             return MIN_THRESHOLD;
         
         // キャリブレーション済みなら、ノイズフロア + ユーザー設定の閾値
-        if (calibratedNoiseFloor > 0.0f)
-            return calibratedNoiseFloor + threshold;
+        // 追従中のフロアがあればそれを優先（検出している信号 = 帯域トリガーならその帯域のフロア）
+        // なければ帯域トリガーはその帯域の、全帯域は全帯域のキャリブレーションの値
+        float noiseFloor = isBandTrigger() ? calibratedBandFloor[static_cast<size_t>(triggerBand)]
+                                           : calibratedNoiseFloor;
+        if (isAdaptiveFloorEnabled && adaptiveFloor > 0.0f)
+            noiseFloor = adaptiveFloor;
+        if (noiseFloor > 0.0f)
+            return noiseFloor + threshold;
         
         return threshold;
     }
@@ -60,6 +80,12 @@ struct ChannelTriggerSettings
         obj->setProperty("isActive", isActive);
         obj->setProperty("isCalibrationEnabled", isCalibrationEnabled);
         obj->setProperty("calibratedNoiseFloor", calibratedNoiseFloor);
+        obj->setProperty("isAdaptiveFloorEnabled", isAdaptiveFloorEnabled);
+        obj->setProperty("triggerBand", triggerBand);
+        juce::Array<juce::var> bandFloors;
+        for (float f : calibratedBandFloor)
+            bandFloors.add(f);
+        obj->setProperty("calibratedBandFloor", bandFloors);
         return juce::var(obj);
     }
     
@@ -79,6 +105,13 @@ struct ChannelTriggerSettings
                 settings.isCalibrationEnabled = (bool)obj->getProperty("isCalibrationEnabled");
             if (obj->hasProperty("calibratedNoiseFloor"))
                 settings.calibratedNoiseFloor = (float)obj->getProperty("calibratedNoiseFloor");
+            if (obj->hasProperty("isAdaptiveFloorEnabled"))
+                settings.isAdaptiveFloorEnabled = (bool)obj->getProperty("isAdaptiveFloorEnabled");
+            if (obj->hasProperty("triggerBand"))
+                settings.triggerBand = juce::jlimit(-1, NUM_BANDS - 1, (int)obj->getProperty("triggerBand"));
+            if (auto* bandFloors = obj->getProperty("calibratedBandFloor").getArray())
+                for (int b = 0; b < juce::jmin(NUM_BANDS, bandFloors->size()); ++b)
+                    settings.calibratedBandFloor[static_cast<size_t>(b)] = (float)bandFloors->getReference(b);
         }
         return settings;
     }
@@ -141,6 +174,19 @@ public:
         return channelSettings[0].isCalibrationEnabled;
     }
     
+    // 全チャンネルにノイズフロア追従の有効設定を適用
+    void setAdaptiveFloorEnabled(bool enabled)
+    {
+        for (auto& settings : channelSettings)
+            settings.isAdaptiveFloorEnabled = enabled;
+    }
+    
+    bool isAdaptiveFloorEnabled() const
+    {
+        if (channelSettings.empty()) return true;
+        return channelSettings[0].isAdaptiveFloorEnabled;
+    }
+    
     // 全チャンネルの閾値を設定
     void setGlobalThreshold(float thresh)
     {
@@ -43,7 +43,7 @@ public:
     // masterStartGlobal: マスターのループ開始時のグローバル絶対位置
     void addWaveform(int trackId, const juce::AudioBuffer<float>& buffer, 
                      int trackLengthSamples, int masterLengthSamples, 
-                     int recordStartGlobal = 0, int masterStartGlobal = 0)
+                     juce::int64 recordStartGlobal = 0, juce::int64 masterStartGlobal = 0)
     {
         // 実際のバッファサイズを使用（渡されたtrackLengthSamplesと異なる可能性あり）
         const int actualBufferSize = buffer.getNumSamples();
@@ -868,8 +868,8 @@ private:
         juce::AudioBuffer<float> originalBuffer; // 元の波形データ（再計算用）
         int originalTrackLength = 0;
         int originalMasterLength = 0;
-        int originalRecordStart = 0;
-        int originalMasterStart = 0;
+        juce::int64 originalRecordStart = 0;
+        juce::int64 originalMasterStart = 0;
         
         // セグメント描画用データ（プレイヘッド太さ変化・振動用）
         std::vector<float> segmentAngles;   // 各ポイントの角度
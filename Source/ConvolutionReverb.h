@@ -0,0 +1,492 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX の Convolution Reverb（IR を畳み込む、ステレオ）
+    - IR の頭 headSize サンプルは直接畳み込み（FIR）。レイテンシは 0
+    - [headSize, tailStart) は一様分割の重畳保存（パーティション = headSize、FFT = 2 * headSize）
+      入力スペクトルを周波数領域の遅延線（FDL）に並べ、パーティションごとの積和を IFFT 1回で戻す
+    - 不均一の尾部（任意、既定 ON）: [tailStart, 終わり) はパーティション = headSize * tailFactor の2段目
+      積和はフレームの間の headSize ステップごとに少しずつ進め、フレーム末は FFT / IFFT と最新分だけ
+      尾部のフレーム境界はスロットごとにずらし（tailPhase）、重いステップが同じブロックに集まらないようにする
+    - IR の読み込み・リサンプル・スペクトル化（Engine の生成）はオーディオスレッド以外で行い、
+      出来上がった Engine をポインタ1つで渡す。外した Engine は collectGarbage() でオーディオスレッド以外が消す
+    - IR がモノラルなら L / R とも同じ IR、ステレオなら L → L、R → R
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+class ConvolutionReverb
+{
+public:
+	static constexpr int headSize = 64;                // 直接畳み込みの長さ = 1段目のパーティション長
+	static constexpr int tailFactor = 32;              // 尾部のパーティション = headSize * tailFactor
+	static constexpr int tailSize = headSize * tailFactor;
+	static constexpr double maxImpulseSeconds = 10.0;  // これより長い IR は切る
+
+	//==============================================================================
+	// IR と状態をまとめたもの。生成（確保・FFT）はオーディオスレッド以外、process / reset はオーディオスレッド
+	class Engine
+	{
+	public:
+		Engine() = default; // 空（IR なし）
+
+		// impulse は出力と同じレートに変換済み・正規化済みのもの
+		Engine(const juce::AudioBuffer<float>& impulse, bool nonUniformTail, int tailPhase)
+			: length(impulse.getNumSamples()),
+			  numImpulseChannels(juce::jmin(2, impulse.getNumChannels()))
+		{
+			if (length == 0 || numImpulseChannels == 0)
+			{
+				length = 0;
+				return;
+			}
+
+			headLength = juce::jmin(headSize, length);
+			head.assign((size_t)(numImpulseChannels * headSize), 0.0f);
+			for (int ch = 0; ch < numImpulseChannels; ++ch)
+				juce::FloatVectorOperations::copy(head.data() + ch * headSize, impulse.getReadPointer(ch), headLength);
+
+			const int earlyEnd = nonUniformTail && length > tailSize ? tailSize : length;
+			if (earlyEnd > headSize)
+				early = std::make_unique<Section>(impulse, numImpulseChannels, headSize, earlyEnd, headSize, 0);
+			if (earlyEnd < length)
+			{
+				tail = std::make_unique<Section>(impulse, numImpulseChannels, earlyEnd, length, tailSize,
+				                                 (tailPhase % tailFactor) * headSize);
+				// フレーム末のステップを除いた tailFactor - 1 ステップで、遅れパーティションを割り振る
+				tailPartitionsPerStep = (tail->getNumPartitions() - 1 + tailFactor - 2) / (tailFactor - 1);
+			}
+
+			history.assign((size_t)(2 * 2 * headSize), 0.0f);
+		}
+
+		bool isEmpty() const noexcept { return length == 0; }
+		int getLength() const noexcept { return length; }
+
+		void reset() noexcept
+		{
+			std::fill(history.begin(), history.end(), 0.0f);
+			fill = 0;
+			if (early != nullptr) early->reset();
+			if (tail != nullptr)  tail->reset();
+		}
+
+		// buffer の先頭 numSamples（最大2ch）をその場で置き換える（dry * dryLevel + wet * wetLevel）
+		void process(juce::AudioBuffer<float>& buffer, int numSamples, float dryLevel, float wetLevel) noexcept
+		{
+			const int numChannels = juce::jmin(2, buffer.getNumChannels());
+
+			for (int offset = 0; offset < numSamples;)
+			{
+				// headSize の境目で区切る（1段目・尾部のフレーム境界もここに乗る）
+				const int n = juce::jmin(headSize - fill, numSamples - offset);
+
+				for (int ch = 0; ch < numChannels; ++ch)
+				{
+					float* data = buffer.getWritePointer(ch, offset);
+					float* h = history.data() + ch * 2 * headSize;   // [前のフレーム | 今のフレーム]
+					float* w = wet[(size_t)ch].data();
+
+					juce::FloatVectorOperations::copy(h + headSize + fill, data, n);
+					if (early != nullptr) early->write(ch, data, n);
+					if (tail != nullptr)  tail->write(ch, data, n);
+
+					// 頭: w[i] = Σ head[k] * x[i - k]（k < headSize なので前のフレームまでで足りる）
+					const float* taps = head.data() + juce::jmin(ch, numImpulseChannels - 1) * headSize;
+					const float* x = h + headSize + fill;
+					juce::FloatVectorOperations::clear(w, n);
+					for (int k = 0; k < headLength; ++k)
+						juce::FloatVectorOperations::addWithMultiply(w, x - k, taps[k], n);
+
+					// 1段目・尾部は前のフレームの末に計算済みの出力を足すだけ
+					if (early != nullptr) juce::FloatVectorOperations::add(w, early->getOutput(ch), n);
+					if (tail != nullptr)  juce::FloatVectorOperations::add(w, tail->getOutput(ch), n);
+
+					juce::FloatVectorOperations::multiply(data, dryLevel, n);
+					juce::FloatVectorOperations::addWithMultiply(data, w, wetLevel, n);
+				}
+
+				fill += n;
+				offset += n;
+
+				if (early != nullptr && early->advance(n))
+					early->finishFrame();
+
+				if (tail != nullptr)
+				{
+					if (tail->advance(n))
+						tail->finishFrame();
+					else if (fill == headSize)
+						tail->accumulateDelayed(tailPartitionsPerStep);
+				}
+
+				if (fill == headSize)
+				{
+					for (int ch = 0; ch < 2; ++ch)
+					{
+						float* h = history.data() + ch * 2 * headSize;
+						juce::FloatVectorOperations::copy(h, h + headSize, headSize);
+					}
+					fill = 0;
+				}
+			}
+		}
+
+	private:
+		// 一様分割の重畳保存（パーティション N サンプル、FFT 2N）。スペクトルは実部 / 虚部を分けて持つ
+		class Section
+		{
+		public:
+			Section(const juce::AudioBuffer<float>& impulse, int numIrChannels, int start, int end,
+			        int partitionSize, int firstFill)
+				: N(partitionSize),
+				  numBins(partitionSize + 1),
+				  numPartitions((end - start + partitionSize - 1) / partitionSize),
+				  numImpulseChannels(numIrChannels),
+				  initialFill(firstFill),
+				  fft(juce::roundToInt(std::log2((double)(2 * partitionSize))))
+			{
+				scratch.assign((size_t)(4 * N), 0.0f);
+				irRe.assign((size_t)(numImpulseChannels * numPartitions * numBins), 0.0f);
+				irIm.assign(irRe.size(), 0.0f);
+
+				for (int ch = 0; ch < numImpulseChannels; ++ch)
+				{
+					for (int p = 0; p < numPartitions; ++p)
+					{
+						const int first = start + p * N;
+						std::fill(scratch.begin(), scratch.end(), 0.0f);
+						juce::FloatVectorOperations::copy(scratch.data(), impulse.getReadPointer(ch, first),
+						                                  juce::jmin(N, end - first));
+						fft.performRealOnlyForwardTransform(scratch.data(), true);
+						deinterleave(irRe.data() + index(ch, p), irIm.data() + index(ch, p));
+					}
+				}
+
+				fdlRe.assign((size_t)(2 * numPartitions * numBins), 0.0f);
+				fdlIm.assign(fdlRe.size(), 0.0f);
+				accRe.assign((size_t)(2 * numBins), 0.0f);
+				accIm.assign(accRe.size(), 0.0f);
+				window.assign((size_t)(2 * 2 * N), 0.0f);
+				output.assign((size_t)(2 * N), 0.0f);
+				reset();
+			}
+
+			int getNumPartitions() const noexcept { return numPartitions; }
+
+			void reset() noexcept
+			{
+				for (auto* v : { &fdlRe, &fdlIm, &accRe, &accIm, &window, &output })
+					std::fill(v->begin(), v->end(), 0.0f);
+				fill = initialFill;
+				fdlHead = 0;
+				nextPartition = 1;
+			}
+
+			void write(int ch, const float* source, int n) noexcept
+			{
+				juce::FloatVectorOperations::copy(window.data() + ch * 2 * N + N + fill, source, n);
+			}
+
+			// 今のフレームで fill から先に出す分（前のフレームの末に計算済み）
+			const float* getOutput(int ch) const noexcept { return output.data() + ch * N + fill; }
+
+			// フレームが埋まったら true
+			bool advance(int n) noexcept
+			{
+				fill += n;
+				return fill == N;
+			}
+
+			// 遅れパーティション（X[k - p] * H[p]、p >= 1）を count 個ぶん積和に足す
+			void accumulateDelayed(int count) noexcept
+			{
+				const int last = juce::jmin(numPartitions, nextPartition + count);
+				for (; nextPartition < last; ++nextPartition)
+				{
+					// 今のフレームの X はまだ入っていないので、X[k - p] は fdlHead から p - 1 個前
+					const int slot = (fdlHead - (nextPartition - 1) + numPartitions) % numPartitions;
+					for (int ch = 0; ch < 2; ++ch)
+						multiplyAccumulate(ch, slot, nextPartition);
+				}
+			}
+
+			// フレーム末: 残りの遅れパーティション → 今のフレームの FFT と H[0] → IFFT で次のフレームの出力
+			void finishFrame() noexcept
+			{
+				accumulateDelayed(numPartitions);
+				fdlHead = (fdlHead + 1) % numPartitions;
+
+				for (int ch = 0; ch < 2; ++ch)
+				{
+					float* w = window.data() + ch * 2 * N;
+					juce::FloatVectorOperations::copy(scratch.data(), w, 2 * N);
+					fft.performRealOnlyForwardTransform(scratch.data(), true);
+					deinterleave(fdlRe.data() + fdlIndex(ch, fdlHead), fdlIm.data() + fdlIndex(ch, fdlHead));
+					multiplyAccumulate(ch, fdlHead, 0);
+
+					// 積和 → 時間領域。後ろ半分が今のフレームの線形畳み込み
+					float* re = accRe.data() + ch * numBins;
+					float* im = accIm.data() + ch * numBins;
+					for (int bin = 0; bin < numBins; ++bin)
+					{
+						scratch[(size_t)(2 * bin)] = re[bin];
+						scratch[(size_t)(2 * bin + 1)] = im[bin];
+					}
+					fft.performRealOnlyInverseTransform(scratch.data());
+					juce::FloatVectorOperations::copy(output.data() + ch * N, scratch.data() + N, N);
+
+					juce::FloatVectorOperations::clear(re, numBins);
+					juce::FloatVectorOperations::clear(im, numBins);
+					juce::FloatVectorOperations::copy(w, w + N, N);
+				}
+
+				fill = 0;
+				nextPartition = 1;
+			}
+
+		private:
+			int index(int irChannel, int partition) const noexcept { return (irChannel * numPartitions + partition) * numBins; }
+			int fdlIndex(int ch, int slot) const noexcept { return (ch * numPartitions + slot) * numBins; }
+
+			void deinterleave(float* re, float* im) const noexcept
+			{
+				for (int bin = 0; bin < numBins; ++bin)
+				{
+					re[bin] = scratch[(size_t)(2 * bin)];
+					im[bin] = scratch[(size_t)(2 * bin + 1)];
+				}
+			}
+
+			// acc[ch] += X[slot] * H[partition]（複素数の積、実部 / 虚部が別の配列なのでそのままベクトル化される）
+			void multiplyAccumulate(int ch, int slot, int partition) noexcept
+			{
+				const int irChannel = juce::jmin(ch, numImpulseChannels - 1);
+				const float* xr = fdlRe.data() + fdlIndex(ch, slot);
+				const float* xi = fdlIm.data() + fdlIndex(ch, slot);
+				const float* hr = irRe.data() + index(irChannel, partition);
+				const float* hi = irIm.data() + index(irChannel, partition);
+				float* ar = accRe.data() + ch * numBins;
+				float* ai = accIm.data() + ch * numBins;
+
+				for (int bin = 0; bin < numBins; ++bin)
+				{
+					ar[bin] += xr[bin] * hr[bin] - xi[bin] * hi[bin];
+					ai[bin] += xr[bin] * hi[bin] + xi[bin] * hr[bin];
+				}
+			}
+
+			const int N;
+			const int numBins;
+			const int numPartitions;
+			const int numImpulseChannels;
+			const int initialFill;
+			juce::dsp::FFT fft;
+
+			std::vector<float> irRe, irIm;     // [IR ch][パーティション][bin]
+			std::vector<float> fdlRe, fdlIm;   // [ch][スロット][bin]（リング、fdlHead が最新）
+			std::vector<float> accRe, accIm;   // [ch][bin]
+			std::vector<float> window;         // [ch][2N] = [前のフレーム | 今のフレーム]
+			std::vector<float> output;         // [ch][N]
+			std::vector<float> scratch;        // FFT 用（4N）
+
+			int fill = 0;
+			int fdlHead = 0;
+			int nextPartition = 1;
+		};
+
+		int length = 0;
+		int numImpulseChannels = 0;
+		int headLength = 0;
+		std::vector<float> head;        // [IR ch][headSize]
+		std::vector<float> history;     // [ch][2 * headSize] = [前のフレーム | 今のフレーム]
+		std::array<std::array<float, headSize>, 2> wet {};
+		int fill = 0;
+
+		std::unique_ptr<Section> early; // [headSize, tailStart)
+		std::unique_ptr<Section> tail;  // [tailStart, length)
+		int tailPartitionsPerStep = 0;
+	};
+
+	//==============================================================================
+	ConvolutionReverb() = default;
+
+	~ConvolutionReverb()
+	{
+		delete active;
+		delete pending.exchange(nullptr);
+		delete retired.exchange(nullptr);
+	}
+
+	//==============================================================================
+	// IR 側（オーディオスレッド以外。重いのでバックグラウンドのスレッドから呼ぶのがよい）
+
+	// tailPhase: 尾部のフレーム境界をずらす量（headSize 単位）。IR を読み込み済みなら新しいレートで作り直す
+	void prepare(double newSampleRate, int newTailPhase)
+	{
+		const juce::ScopedLock sl(sourceLock);
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		tailPhase = newTailPhase;
+		if (source.getNumSamples() > 0)
+			publish(createEngine());
+	}
+
+	void setNonUniformTail(bool shouldUseNonUniformTail)
+	{
+		const juce::ScopedLock sl(sourceLock);
+		if (nonUniformTail == shouldUseNonUniformTail)
+			return;
+		nonUniformTail = shouldUseNonUniformTail;
+		if (source.getNumSamples() > 0)
+			publish(createEngine());
+	}
+
+	// impulse は任意のレート・長さ（maxImpulseSeconds で切る）。オーディオスレッドには次のブロックから効く
+	bool loadImpulse(const juce::AudioBuffer<float>& impulse, double impulseSampleRate)
+	{
+		if (impulse.getNumChannels() == 0 || impulse.getNumSamples() == 0 || impulseSampleRate <= 0.0)
+			return false;
+
+		const juce::ScopedLock sl(sourceLock);
+		source.makeCopyOf(impulse);
+		sourceSampleRate = impulseSampleRate;
+		publish(createEngine());
+		return true;
+	}
+
+	void clearImpulse()
+	{
+		const juce::ScopedLock sl(sourceLock);
+		source.setSize(0, 0);
+		publish(std::make_unique<Engine>());
+	}
+
+	// オーディオスレッドが外した Engine を消す（メッセージスレッドから定期的に呼ぶ）
+	void collectGarbage()
+	{
+		delete retired.exchange(nullptr, std::memory_order_acq_rel);
+	}
+
+	//==============================================================================
+	// オーディオスレッド
+
+	// IR があれば buffer の先頭 numSamples を畳み込んで true。なければ何もせず false
+	// mix の配分は juce::dsp::Reverb（LooperAudio の ReverbMix）と同じ: dry = 1 - mix / 2、wet = mix
+	bool process(juce::AudioBuffer<float>& buffer, int numSamples, float mix) noexcept
+	{
+		takePendingEngine();
+		if (active == nullptr || active->isEmpty())
+			return false;
+
+		active->process(buffer, numSamples, 1.0f - mix * 0.5f, mix);
+		return true;
+	}
+
+	void reset() noexcept
+	{
+		takePendingEngine();
+		if (active != nullptr)
+			active->reset();
+	}
+
+private:
+	// sourceLock を持った状態で呼ぶ
+	std::unique_ptr<Engine> createEngine() const
+	{
+		const int numChannels = juce::jmin(2, source.getNumChannels());
+		const double ratio = sourceSampleRate / sampleRate;
+		const int maxLength = (int)(maxImpulseSeconds * sampleRate);
+		int length = juce::jmin(maxLength, (int)std::ceil(source.getNumSamples() / ratio));
+
+		juce::AudioBuffer<float> impulse(numChannels, juce::jmax(1, length));
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			if (std::abs(ratio - 1.0) < 1.0e-9)
+			{
+				impulse.copyFrom(ch, 0, source, ch, 0, length);
+			}
+			else
+			{
+				juce::LagrangeInterpolator interpolator;
+				interpolator.process(ratio, source.getReadPointer(ch), impulse.getWritePointer(ch),
+				                     length, source.getNumSamples(), 0);
+			}
+		}
+
+		// 後ろの無音（ピークから -90dB 未満）は畳み込まない
+		float peak = 0.0f;
+		for (int ch = 0; ch < numChannels; ++ch)
+			peak = juce::jmax(peak, impulse.getMagnitude(ch, 0, length));
+		if (peak <= 0.0f)
+			return std::make_unique<Engine>();
+
+		const float silence = peak * 3.2e-5f;
+		while (length > 1)
+		{
+			bool audible = false;
+			for (int ch = 0; ch < numChannels; ++ch)
+				audible = audible || std::abs(impulse.getSample(ch, length - 1)) >= silence;
+			if (audible)
+				break;
+			--length;
+		}
+
+		// エネルギーで正規化（白色雑音の入力なら wet のレベルが dry と同じくらいになる）
+		double energy = 0.0;
+		for (int ch = 0; ch < numChannels; ++ch)
+			for (int i = 0; i < length; ++i)
+				energy += (double)impulse.getSample(ch, i) * impulse.getSample(ch, i);
+		impulse.applyGain(0, length, (float)(1.0 / std::sqrt(energy / numChannels)));
+
+		juce::AudioBuffer<float> trimmed(impulse.getArrayOfWritePointers(), numChannels, length);
+		return std::make_unique<Engine>(trimmed, nonUniformTail, tailPhase);
+	}
+
+	// 前の pending（オーディオスレッドがまだ取っていないもの）はここで消す
+	void publish(std::unique_ptr<Engine> engine)
+	{
+		collectGarbage();
+		delete pending.exchange(engine.release(), std::memory_order_acq_rel);
+	}
+
+	// 外した Engine がまだ消されていないあいだは入れ替えない（次のブロックで取る）
+	void takePendingEngine() noexcept
+	{
+		if (retired.load(std::memory_order_acquire) != nullptr)
+			return;
+
+		if (auto* next = pending.exchange(nullptr, std::memory_order_acq_rel))
+		{
+			retired.store(active, std::memory_order_release);
+			active = next;
+		}
+	}
+
+	// オーディオスレッド側
+	Engine* active = nullptr;
+	std::atomic<Engine*> pending { nullptr };  // IR 側 → オーディオスレッド
+	std::atomic<Engine*> retired { nullptr };  // オーディオスレッド → IR 側（collectGarbage で消す）
+
+	// IR 側（sourceLock で守る）
+	juce::CriticalSection sourceLock;
+	juce::AudioBuffer<float> source;
+	double sourceSampleRate = 44100.0;
+	double sampleRate = 44100.0;
+	int tailPhase = 0;
+	bool nonUniformTail = true;
+
+	JUCE_DECLARE_NON_COPYABLE (ConvolutionReverb)
+};
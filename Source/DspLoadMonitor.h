@@ -0,0 +1,400 @@
+/*
+  ==============================================================================
+
+    DspLoadMonitor.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    オーディオコールバックの負荷計測（音が途切れたときに、どのトラック / どの FX が
+    予算を食ったかを本番で追えるようにする）
+    - 時間は CPU のサイクルカウンタを読むだけ（x86: rdtsc / ARM64: cntvct_el0）
+    - コールバック時間はブロックの締め切りに対する割合でヒストグラムに積む（1% 刻み）。
+      約1秒ごとに窓を切り替え、完了した直近の窓から p50 / p99 / 最大を出す
+    - xrun はコールバックの間隔で検出する（前回の開始から 1.8 ブロック分以上空いたら取りこぼし）
+    - トラック（スロット）× FX ステージごとのサイクル数も窓ごとに平均とピークを出す
+    - オーディオスレッドは atomic に書くだけ（ロックも確保もなし）。UI は get〜 で読むだけ
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+class DspLoadMonitor
+{
+public:
+	// renderTrack の処理順
+	enum class Stage
+	{
+		playback = 0, // ループの読み出し
+		beatRepeat,
+		granular,
+		autotune,
+		filter,
+		compressor,
+		flanger,
+		chorus,
+		tremolo,
+		slicer,
+		bitcrusher,
+		delay,
+		reverb,
+		output,       // メーター・出力への合算・ステム・モニター FIFO
+		numStages
+	};
+
+	static constexpr int numStages = (int)Stage::numStages;
+	static constexpr int maxSlots = 64;
+
+	static const char* getStageName(Stage stage) noexcept
+	{
+		static const char* const names[numStages] = { "playback", "beat repeat", "granular", "autotune", "filter", "compressor",
+		                                              "flanger", "chorus", "tremolo", "slicer", "bitcrusher", "delay", "reverb", "output" };
+		return names[(int)stage];
+	}
+
+	// 締め切り（1ブロックの長さ）に対する割合。1.0 = 100%
+	struct Stats
+	{
+		double deadlineMs = 0.0;
+		float p50 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;             // 直近の窓での最大
+		float peak = 0.0f;            // prepare 以降の最大
+		juce::uint64 numCallbacks = 0;
+		int numXruns = 0;             // コールバック間隔から検出した取りこぼし
+		int numOverruns = 0;          // 締め切りを超えたコールバック
+	};
+
+	struct SectionLoad
+	{
+		float average = 0.0f;         // 直近の窓での平均
+		float peak = 0.0f;            // 直近の窓で一番重かったコールバック
+	};
+
+	//==============================================================================
+	// サイクルカウンタ（どのスレッドからでも呼べる）
+	static juce::uint64 readCycles() noexcept
+	{
+	   #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+		return (juce::uint64)__rdtsc();
+	   #elif defined(__aarch64__)
+		juce::uint64 value;
+		asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+		return value;
+	   #else
+		return (juce::uint64)juce::Time::getHighResolutionTicks();
+	   #endif
+	}
+
+	// 1秒あたりのサイクル数。x86 は初回に高分解能タイマーと突き合わせて測る（約10ms）
+	static double getCyclesPerSecond()
+	{
+		static const double cyclesPerSecond = []
+		{
+		   #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+			const auto ticksStart = juce::Time::getHighResolutionTicks();
+			const auto cyclesStart = readCycles();
+			const auto calibrationTicks = juce::Time::getHighResolutionTicksPerSecond() / 100;
+			while (juce::Time::getHighResolutionTicks() - ticksStart < calibrationTicks) {}
+			const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticksStart);
+			return (double)(readCycles() - cyclesStart) / seconds;
+		   #elif defined(__aarch64__)
+			juce::uint64 frequency;
+			asm volatile ("mrs %0, cntfrq_el0" : "=r" (frequency));
+			return (double)frequency;
+		   #else
+			return (double)juce::Time::getHighResolutionTicksPerSecond();
+		   #endif
+		}();
+		return cyclesPerSecond;
+	}
+
+	DspLoadMonitor() { prepare(48000.0, 512); }
+
+	//==============================================================================
+	// メッセージスレッド専用（オーディオ停止中に呼ぶ）
+	void prepare(double newSampleRate, int blockSize)
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+		cyclesPerSample = getCyclesPerSecond() / sampleRate;
+		windowLength = juce::jmax(1, juce::roundToInt(sampleRate / juce::jmax(1, blockSize)));
+		deadlineMs.store(1000.0 * juce::jmax(1, blockSize) / sampleRate);
+
+		for (auto& w : windows)
+			clearWindow(w);
+
+		completedWindows.store(0);
+		callbacksInWindow = 0;
+		lastCallbackStart = 0;
+		lastNumSamples = 0;
+		callbackStart = 0;
+		windowDeadlineCycles = 0.0;
+
+		for (auto& slot : sectionCycles)
+			slot.fill(0);
+		for (auto& t : windowTracks)
+			t = {};
+		for (auto& s : windowStages)
+			s = {};
+		for (auto& l : trackLoads)
+			l.store({});
+		for (auto& l : stageLoads)
+			l.store({});
+
+		numCallbacks.store(0);
+		numXruns.store(0);
+		numOverruns.store(0);
+		peakLoad.store(0.0f);
+	}
+
+	//==============================================================================
+	// オーディオスレッド専用: コールバックの先頭と最後で呼ぶ（ScopedCallback を使う）
+	void beginCallback(int numSamples) noexcept
+	{
+		const auto now = readCycles();
+
+		// 前回の開始から 1.8 ブロック分以上空いた = デバイスが少なくとも1ブロック待たされた
+		if (lastCallbackStart != 0 && lastNumSamples > 0)
+		{
+			const double expected = lastNumSamples * cyclesPerSample;
+			if ((double)(now - lastCallbackStart) > expected * xrunGapRatio)
+				numXruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		lastCallbackStart = now;
+		lastNumSamples = numSamples;
+		callbackStart = now;
+	}
+
+	void endCallback() noexcept
+	{
+		const auto now = readCycles();
+		const double deadline = juce::jmax(1, lastNumSamples) * cyclesPerSample;
+		const float load = (float)((double)(now - callbackStart) / deadline);
+
+		auto& w = windows[(size_t)(completedWindows.load(std::memory_order_relaxed) % numWindows)];
+		w.bins[(size_t)juce::jlimit(0, numBins - 1, (int)(load * 100.0f))].fetch_add(1, std::memory_order_relaxed);
+		w.count.fetch_add(1, std::memory_order_relaxed);
+		if (load > w.max.load(std::memory_order_relaxed))
+			w.max.store(load, std::memory_order_relaxed);
+
+		numCallbacks.fetch_add(1, std::memory_order_relaxed);
+		if (load > 1.0f)
+			numOverruns.fetch_add(1, std::memory_order_relaxed);
+		if (load > peakLoad.load(std::memory_order_relaxed))
+			peakLoad.store(load, std::memory_order_relaxed);
+
+		accumulateSections(deadline);
+
+		if (++callbacksInWindow >= windowLength)
+			finishWindow();
+	}
+
+	struct ScopedCallback
+	{
+		ScopedCallback(DspLoadMonitor& m, int numSamples) noexcept : monitor(m) { monitor.beginCallback(numSamples); }
+		~ScopedCallback() { monitor.endCallback(); }
+
+		DspLoadMonitor& monitor;
+		JUCE_DECLARE_NON_COPYABLE (ScopedCallback)
+	};
+
+	// slot の stage に since からの時間を足して、今の時刻を返す（次のステージの起点に使う）
+	// スロットごとに書き手は1スレッド（並列レンダリングのワーカーでも可）。集計は endCallback で行う
+	juce::uint64 addStageTime(int slot, Stage stage, juce::uint64 since) noexcept
+	{
+		const auto now = readCycles();
+		sectionCycles[(size_t)slot][(size_t)stage] += now - since;
+		return now;
+	}
+
+	// 複数スロットをまとめて処理したステージの時間を、スロットごとに按分して足す
+	void addStageCycles(int slot, Stage stage, juce::uint64 cycles) noexcept
+	{
+		sectionCycles[(size_t)slot][(size_t)stage] += cycles;
+	}
+
+	//==============================================================================
+	// 読み出し（どのスレッドからでも可）
+	Stats getStats() const
+	{
+		Stats stats;
+		stats.deadlineMs = deadlineMs.load();
+		stats.numCallbacks = numCallbacks.load();
+		stats.numXruns = numXruns.load();
+		stats.numOverruns = numOverruns.load();
+		stats.peak = peakLoad.load();
+
+		// 完了した直近 statsWindows 個の窓をまとめる（まだ1つもなければ書き込み中の窓）
+		std::array<juce::uint32, numBins> bins {};
+		juce::uint32 total = 0;
+
+		const int completed = completedWindows.load(std::memory_order_acquire);
+		const int first = completed > 0 ? juce::jmax(0, completed - statsWindows) : 0;
+		const int last = completed > 0 ? completed : 1;
+
+		for (int i = first; i < last; ++i)
+		{
+			const auto& w = windows[(size_t)(i % numWindows)];
+			for (int b = 0; b < numBins; ++b)
+			{
+				const auto n = w.bins[(size_t)b].load(std::memory_order_relaxed);
+				bins[(size_t)b] += n;
+				total += n;
+			}
+			stats.max = juce::jmax(stats.max, w.max.load(std::memory_order_relaxed));
+		}
+
+		stats.p50 = percentile(bins, total, 0.50);
+		stats.p99 = percentile(bins, total, 0.99);
+		return stats;
+	}
+
+	SectionLoad getTrackLoad(int slot) const
+	{
+		return juce::isPositiveAndBelow(slot, maxSlots) ? trackLoads[(size_t)slot].load() : SectionLoad {};
+	}
+
+	SectionLoad getStageLoad(Stage stage) const
+	{
+		return stageLoads[(size_t)stage].load();
+	}
+
+private:
+	static constexpr int numBins = 256;       // 0% .. 255%（最後は 255% 以上）
+	static constexpr int numWindows = 8;
+	static constexpr int statsWindows = 4;    // 約4秒分で p50 / p99 を出す
+	static constexpr double xrunGapRatio = 1.8;
+
+	// 書き込み中の窓の次を消してから進むので、読み手が見る直近4つは数秒間は消されない
+	struct Window
+	{
+		std::array<std::atomic<juce::uint32>, numBins> bins;
+		std::atomic<juce::uint32> count { 0 };
+		std::atomic<float> max { 0.0f };
+	};
+
+	struct WindowSection
+	{
+		double cycles = 0.0;
+		double peak = 0.0;  // 1コールバックでの最大（締め切りに対する割合）
+	};
+
+	static void clearWindow(Window& w) noexcept
+	{
+		for (auto& b : w.bins)
+			b.store(0, std::memory_order_relaxed);
+		w.count.store(0, std::memory_order_relaxed);
+		w.max.store(0.0f, std::memory_order_relaxed);
+	}
+
+	static float percentile(const std::array<juce::uint32, numBins>& bins, juce::uint32 total, double fraction) noexcept
+	{
+		if (total == 0)
+			return 0.0f;
+
+		// 1% 刻みのビンの上端を返す（実際より少しだけ重めに出る）
+		const auto target = (juce::uint32)std::ceil(fraction * total);
+		juce::uint32 seen = 0;
+		for (int b = 0; b < numBins; ++b)
+		{
+			seen += bins[(size_t)b];
+			if (seen >= target)
+				return (float)(b + 1) * 0.01f;
+		}
+		return (float)numBins * 0.01f;
+	}
+
+	void accumulateSections(double deadline) noexcept
+	{
+		windowDeadlineCycles += deadline;
+
+		// 使っていないスロットは 0 のまま（全スロット舐めても 64 x 12 回の足し算）
+		std::array<double, numStages> stageThisCallback {};
+
+		for (int slot = 0; slot < maxSlots; ++slot)
+		{
+			auto& cycles = sectionCycles[(size_t)slot];
+			juce::uint64 trackCycles = 0;
+			for (int s = 0; s < numStages; ++s)
+			{
+				trackCycles += cycles[(size_t)s];
+				stageThisCallback[(size_t)s] += (double)cycles[(size_t)s];
+			}
+
+			if (trackCycles == 0)
+				continue;
+
+			cycles.fill(0);
+
+			auto& t = windowTracks[(size_t)slot];
+			t.cycles += (double)trackCycles;
+			t.peak = juce::jmax(t.peak, (double)trackCycles / deadline);
+		}
+
+		for (int s = 0; s < numStages; ++s)
+		{
+			auto& st = windowStages[(size_t)s];
+			st.cycles += stageThisCallback[(size_t)s];
+			st.peak = juce::jmax(st.peak, stageThisCallback[(size_t)s] / deadline);
+		}
+	}
+
+	void finishWindow() noexcept
+	{
+		const auto publish = [this] (std::atomic<SectionLoad>& dest, WindowSection& section)
+		{
+			dest.store({ (float)(section.cycles / windowDeadlineCycles), (float)section.peak }, std::memory_order_relaxed);
+			section = {};
+		};
+
+		for (int slot = 0; slot < maxSlots; ++slot)
+			publish(trackLoads[(size_t)slot], windowTracks[(size_t)slot]);
+		for (int s = 0; s < numStages; ++s)
+			publish(stageLoads[(size_t)s], windowStages[(size_t)s]);
+
+		windowDeadlineCycles = 0.0;
+		callbacksInWindow = 0;
+
+		const int completed = completedWindows.load(std::memory_order_relaxed);
+		clearWindow(windows[(size_t)((completed + 1) % numWindows)]);
+		completedWindows.store(completed + 1, std::memory_order_release);
+	}
+
+	// ===== 設定（prepare で決まる） =====
+	double sampleRate = 48000.0;
+	double cyclesPerSample = 1.0;
+	int windowLength = 1;
+	std::atomic<double> deadlineMs { 0.0 };
+
+	// ===== オーディオスレッド専用 =====
+	juce::uint64 lastCallbackStart = 0;
+	juce::uint64 callbackStart = 0;
+	int lastNumSamples = 0;
+	int callbacksInWindow = 0;
+	double windowDeadlineCycles = 0.0;
+	std::array<std::array<juce::uint64, numStages>, maxSlots> sectionCycles {};
+	std::array<WindowSection, maxSlots> windowTracks {};
+	std::array<WindowSection, numStages> windowStages {};
+
+	// ===== 公開（オーディオスレッドが書いて UI が読む） =====
+	std::array<Window, numWindows> windows;
+	std::atomic<int> completedWindows { 0 };
+	std::array<std::atomic<SectionLoad>, maxSlots> trackLoads;
+	std::array<std::atomic<SectionLoad>, numStages> stageLoads;
+	std::atomic<juce::uint64> numCallbacks { 0 };
+	std::atomic<int> numXruns { 0 };
+	std::atomic<int> numOverruns { 0 };
+	std::atomic<float> peakLoad { 0.0f };
+};
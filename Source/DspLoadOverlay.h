@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    DspLoadOverlay.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    DSP 負荷の小さなオーバーレイ（右下に重ねて表示、キー操作で表示切り替え）
+    - コールバック時間 p50 / p99 / 最大（締め切りに対する %）と xrun / 超過回数
+    - トラックごとの負荷バー（平均 + ピーク）
+    - 重い FX ステージ上位3つ
+    値は LooperAudio の DspLoadMonitor から読むだけ（4Hz で更新）
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <algorithm>
+#include <array>
+#include "LooperAudio.h"
+#include "ThemeColours.h"
+
+class DspLoadOverlay : public juce::Component, private juce::Timer
+{
+public:
+	explicit DspLoadOverlay(const LooperAudio& looperRef) : looper(looperRef)
+	{
+		setInterceptsMouseClicks(false, false);
+	}
+
+	static constexpr int preferredWidth = 260;
+	static constexpr int preferredHeight = 190;
+
+	void visibilityChanged() override
+	{
+		if (isVisible())
+		{
+			refresh();
+			startTimerHz(4);
+		}
+		else
+		{
+			stopTimer();
+		}
+	}
+
+	void paint(juce::Graphics& g) override
+	{
+		auto area = getLocalBounds().toFloat();
+		g.setColour(ThemeColours::Background.withAlpha(0.85f));
+		g.fillRoundedRectangle(area, 6.0f);
+		g.setColour(ThemeColours::NeonCyan.withAlpha(0.5f));
+		g.drawRoundedRectangle(area.reduced(0.5f), 6.0f, 1.0f);
+
+		auto content = getLocalBounds().reduced(8);
+		g.setFont(juce::Font(juce::FontOptions(12.0f)));
+
+		// --- コールバック全体 ---
+		g.setColour(loadColour(stats.p99));
+		g.drawText("DSP  p50 " + percent(stats.p50) + "  p99 " + percent(stats.p99) + "  max " + percent(stats.max),
+		           content.removeFromTop(16), juce::Justification::centredLeft);
+
+		g.setColour(ThemeColours::Silver);
+		g.drawText(juce::String(stats.deadlineMs, 2) + " ms/block   xrun " + juce::String(stats.numXruns)
+		               + "   over " + juce::String(stats.numOverruns) + "   peak " + percent(stats.peak),
+		           content.removeFromTop(16), juce::Justification::centredLeft);
+
+		content.removeFromTop(4);
+
+		// --- トラック別（平均のバー + ピークの線） ---
+		const int numRows = juce::jmin(tracks.size(), maxTrackRows);
+		for (int i = 0; i < numRows; ++i)
+		{
+			const auto& t = tracks.getReference(i);
+			auto row = content.removeFromTop(12);
+
+			g.setColour(ThemeColours::Silver);
+			g.drawText("T" + juce::String(t.trackId), row.removeFromLeft(24), juce::Justification::centredLeft);
+
+			auto bar = row.removeFromLeft(row.getWidth() - 44).reduced(0, 2).toFloat();
+			g.setColour(ThemeColours::MetalGray);
+			g.fillRect(bar);
+			g.setColour(loadColour(t.load.peak));
+			g.fillRect(bar.withWidth(bar.getWidth() * juce::jlimit(0.0f, 1.0f, t.load.average)));
+			g.setColour(ThemeColours::NeonMagenta);
+			const float peakX = bar.getX() + bar.getWidth() * juce::jlimit(0.0f, 1.0f, t.load.peak);
+			g.drawVerticalLine((int)peakX, bar.getY(), bar.getBottom());
+
+			g.setColour(ThemeColours::Silver);
+			g.drawText(percent(t.load.average), row, juce::Justification::centredRight);
+		}
+
+		content.removeFromTop(4);
+
+		// --- 重いステージ ---
+		g.setColour(ThemeColours::Silver.withAlpha(0.8f));
+		g.drawText("top: " + topStages, content.removeFromTop(16), juce::Justification::centredLeft);
+	}
+
+private:
+	static constexpr int maxTrackRows = 8;
+
+	struct TrackRow
+	{
+		int trackId = 0;
+		DspLoadMonitor::SectionLoad load;
+	};
+
+	void timerCallback() override
+	{
+		refresh();
+	}
+
+	void refresh()
+	{
+		stats = looper.getDspLoadStats();
+
+		tracks.clearQuick();
+		for (int slot = 0; slot < looper.getNumTracks(); ++slot)
+		{
+			const int trackId = looper.getTrackIdAt(slot);
+			tracks.add({ trackId, looper.getTrackDspLoad(trackId) });
+		}
+
+		// 平均負荷の重い順に上位3つ
+		std::array<std::pair<float, int>, DspLoadMonitor::numStages> stages;
+		for (int s = 0; s < DspLoadMonitor::numStages; ++s)
+			stages[(size_t)s] = { looper.getLoadMonitor().getStageLoad((DspLoadMonitor::Stage)s).average, s };
+		std::partial_sort(stages.begin(), stages.begin() + 3, stages.end(),
+		                  [] (const auto& a, const auto& b) { return a.first > b.first; });
+
+		topStages.clear();
+		for (int i = 0; i < 3 && stages[(size_t)i].first > 0.0f; ++i)
+		{
+			if (i > 0)
+				topStages << ", ";
+			topStages << DspLoadMonitor::getStageName((DspLoadMonitor::Stage)stages[(size_t)i].second)
+			          << " " << percent(stages[(size_t)i].first);
+		}
+		if (topStages.isEmpty())
+			topStages = "-";
+
+		repaint();
+	}
+
+	static juce::String percent(float load)
+	{
+		return juce::String(load * 100.0f, 1) + "%";
+	}
+
+	static juce::Colour loadColour(float load)
+	{
+		if (load >= 0.9f) return ThemeColours::RecordingRed;
+		if (load >= 0.6f) return juce::Colours::orange;
+		return ThemeColours::PlayingGreen;
+	}
+
+	const LooperAudio& looper;
+	DspLoadMonitor::Stats stats;
+	juce::Array<TrackRow> tracks;
+	juce::String topStages { "-" };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DspLoadOverlay)
+};
@@ -100,6 +100,9 @@ FXPanel::FXPanel(LooperAudio& looperRef) : looper(looperRef)
                     case EffectType::Bitcrusher:
                         looper.setTrackBitcrusherEnabled(currentTrackId, isActive);
                         break;
+                    case EffectType::Compressor:
+                        looper.setTrackCompressorEnabled(currentTrackId, isActive);
+                        break;
                     case EffectType::GranularCloud:
                         looper.setTrackGranularEnabled(currentTrackId, isActive);
                         break;
@@ -207,11 +210,28 @@ FXPanel::FXPanel(LooperAudio& looperRef) : looper(looperRef)
                                    (float)compRatioSlider.getValue());
     };
 
+    addChildComponent(compLookaheadButton);
+    compLookaheadButton.setClickingTogglesState(true);
+    compLookaheadButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    compLookaheadButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::ElectricBlue);
+    compLookaheadButton.onClick = [this]() {
+        bool lookahead = compLookaheadButton.getToggleState();
+        slots[selectedSlotIndex].compLookahead = lookahead;
+        looper.setTrackCompressorLookahead(currentTrackId, lookahead);
+    };
+
+    addChildComponent(compGainReductionLabel);
+    compGainReductionLabel.setJustificationType(juce::Justification::centred);
+    compGainReductionLabel.setColour(juce::Label::textColourId, ThemeColours::Silver);
+    compGainReductionLabel.setFont(juce::FontOptions(12.0f));
+
     // --- DELAY ---
     setupSlider(delaySlider, delayLabel, "TIME", "BlackHole");
     delaySlider.setRange(0.0, 1000.0, 1.0);  // 0〜1000ms
     delaySlider.setValue(500.0);
-    delaySlider.textFromValueFunction = [](double value) {
+    delaySlider.textFromValueFunction = [this](double value) {
+        if (slots[selectedSlotIndex].delaySync)
+            return juce::String(BlockDelay::getDivisionName(delayDivisionForValue(value)));
         return juce::String(static_cast<int>(value)) + "ms";
     };
     delaySlider.onValueChange = [this]() {
@@ -220,7 +240,10 @@ FXPanel::FXPanel(LooperAudio& looperRef) : looper(looperRef)
                 delaySlider.setValue(lastSliderValues[&delaySlider], juce::dontSendNotification);
             return;
         }
-        looper.setTrackDelayMix(currentTrackId, (float)delayMixSlider.getValue() / 100.0f, (float)delaySlider.getValue() / 1000.0f);
+        if (slots[selectedSlotIndex].delaySync)
+            looper.setTrackDelayDivision(currentTrackId, delayDivisionForValue(delaySlider.getValue()));
+        else
+            looper.setTrackDelayMix(currentTrackId, (float)delayMixSlider.getValue() / 100.0f, (float)delaySlider.getValue() / 1000.0f);
     };
     
     setupSlider(delayFeedbackSlider, delayFeedbackLabel, "F.BACK", "BlackHole");
@@ -253,6 +276,44 @@ FXPanel::FXPanel(LooperAudio& looperRef) : looper(looperRef)
         looper.setTrackDelayMix(currentTrackId, (float)delayMixSlider.getValue() / 100.0f, (float)delaySlider.getValue() / 1000.0f); 
     };
 
+    setupSlider(delaySendSlider, delaySendLabel, "SEND", "BlackHole");
+    delaySendSlider.setRange(0.0, 100.0, 1.0);  // 0〜100%
+    delaySendSlider.setValue(0.0);
+    delaySendSlider.textFromValueFunction = [](double value) {
+        return juce::String(static_cast<int>(value)) + "%";
+    };
+    delaySendSlider.onValueChange = [this]() {
+        if (midiManager && midiManager->isLearnModeActive()) {
+            if (lastSliderValues.count(&delaySendSlider))
+                delaySendSlider.setValue(lastSliderValues[&delaySendSlider], juce::dontSendNotification);
+            return;
+        }
+        looper.setTrackDelaySend(currentTrackId, (float)delaySendSlider.getValue() / 100.0f);
+    };
+
+    addChildComponent(delaySyncButton);
+    delaySyncButton.setClickingTogglesState(true);
+    delaySyncButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    delaySyncButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::ElectricBlue);
+    delaySyncButton.onClick = [this]() {
+        bool sync = delaySyncButton.getToggleState();
+        slots[selectedSlotIndex].delaySync = sync;
+        if (sync)
+            looper.setTrackDelayDivision(currentTrackId, delayDivisionForValue(delaySlider.getValue()));
+        looper.setTrackDelaySync(currentTrackId, sync);
+        delaySlider.updateText();
+    };
+
+    addChildComponent(delayPingPongButton);
+    delayPingPongButton.setClickingTogglesState(true);
+    delayPingPongButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    delayPingPongButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::ElectricBlue);
+    delayPingPongButton.onClick = [this]() {
+        bool pingPong = delayPingPongButton.getToggleState();
+        slots[selectedSlotIndex].delayPingPong = pingPong;
+        looper.setTrackDelayPingPong(currentTrackId, pingPong);
+    };
+
     // --- REVERB ---
     setupSlider(reverbSlider, reverbLabel, "MIX", "GasGiant");
     reverbSlider.setRange(0.0, 100.0, 1.0);  // 0〜100%
@@ -283,6 +344,37 @@ FXPanel::FXPanel(LooperAudio& looperRef) : looper(looperRef)
         }
         looper.setTrackReverbRoomSize(currentTrackId, (float)reverbDecaySlider.getValue() / 100.0f);
     };
+
+    setupSlider(reverbSendSlider, reverbSendLabel, "SEND", "GasGiant");
+    reverbSendSlider.setRange(0.0, 100.0, 1.0);  // 0〜100%
+    reverbSendSlider.setValue(0.0);
+    reverbSendSlider.textFromValueFunction = [](double value) {
+        return juce::String(static_cast<int>(value)) + "%";
+    };
+    reverbSendSlider.onValueChange = [this]() {
+        if (midiManager && midiManager->isLearnModeActive()) {
+            if (lastSliderValues.count(&reverbSendSlider))
+                reverbSendSlider.setValue(lastSliderValues[&reverbSendSlider], juce::dontSendNotification);
+            return;
+        }
+        looper.setTrackReverbSend(currentTrackId, (float)reverbSendSlider.getValue() / 100.0f);
+    };
+
+    addChildComponent(reverbImpulseButton);
+    reverbImpulseButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+    reverbImpulseButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::ElectricBlue);
+    reverbImpulseButton.onClick = [this]() { showImpulseMenu(); };
+
+    addChildComponent(reverbImpulseLabel);
+    reverbImpulseLabel.setJustificationType(juce::Justification::centred);
+    reverbImpulseLabel.setColour(juce::Label::textColourId, ThemeColours::Silver);
+    reverbImpulseLabel.setFont(juce::FontOptions(12.0f));
+
+    impulseLoader.onLoaded = [this](int trackId, const juce::File& file, bool succeeded) {
+        if (trackId >= 1 && trackId <= 8)
+            impulseNames[trackId - 1] = succeeded ? file.getFileNameWithoutExtension() : juce::String();
+        updateSliderVisibility();
+    };
     
     // --- BEAT REPEAT ---
     setupSlider(repeatDivSlider, repeatDivLabel, "DIV", "IceBlue");
@@ -754,8 +846,10 @@ FXPanel::~FXPanel()
     delaySlider.setLookAndFeel(nullptr);
     delayFeedbackSlider.setLookAndFeel(nullptr);
     delayMixSlider.setLookAndFeel(nullptr);
+    delaySendSlider.setLookAndFeel(nullptr);
     reverbSlider.setLookAndFeel(nullptr);
     reverbDecaySlider.setLookAndFeel(nullptr);
+    reverbSendSlider.setLookAndFeel(nullptr);
     repeatDivSlider.setLookAndFeel(nullptr);
     repeatThreshSlider.setLookAndFeel(nullptr);
     flangerRateSlider.setLookAndFeel(nullptr);
@@ -805,6 +899,30 @@ void FXPanel::setupSlider(juce::Slider& slider, juce::Label& label, const juce::
     label.setFont(juce::FontOptions(12.0f));
 }
 
+int FXPanel::delayDivisionForValue(double value)
+{
+    const int step = juce::jlimit(0, BlockDelay::numDivisions - 1, (int)(value / 1000.0 * BlockDelay::numDivisions));
+    return BlockDelay::numDivisions - 1 - step;
+}
+
+int FXPanel::moduleTypeFor(EffectType type)
+{
+    switch (type) {
+        case EffectType::Filter: return (int)FxModuleType::filter;
+        case EffectType::Compressor: return (int)FxModuleType::compressor;
+        case EffectType::Delay: return (int)FxModuleType::delay;
+        case EffectType::Reverb: return (int)FxModuleType::reverb;
+        case EffectType::Flanger: return (int)FxModuleType::flanger;
+        case EffectType::Chorus: return (int)FxModuleType::chorus;
+        case EffectType::Tremolo: return (int)FxModuleType::tremolo;
+        case EffectType::Slicer: return (int)FxModuleType::slicer;
+        case EffectType::Bitcrusher: return (int)FxModuleType::bitcrusher;
+        case EffectType::GranularCloud: return (int)FxModuleType::granular;
+        case EffectType::Autotune: return (int)FxModuleType::autotune;
+        default: return -1; // Beat Repeat は再生の直後で処理するので並べない
+    }
+}
+
 void FXPanel::setTargetTrackId(int trackId)
 {
     currentTrackId = trackId;
@@ -863,11 +981,16 @@ void FXPanel::updateSliderVisibility()
     hide(filterTypeButton);
     hide(compThreshSlider); hide(compThreshLabel);
     hide(compRatioSlider); hide(compRatioLabel);
+    hide(compLookaheadButton); hide(compGainReductionLabel);
     hide(delaySlider); hide(delayLabel);
     hide(delayFeedbackSlider); hide(delayFeedbackLabel);
     hide(delayMixSlider); hide(delayMixLabel);
+    hide(delaySendSlider); hide(delaySendLabel);
+    hide(delaySyncButton); hide(delayPingPongButton);
     hide(reverbSlider); hide(reverbLabel);
     hide(reverbDecaySlider); hide(reverbDecayLabel);
+    hide(reverbSendSlider); hide(reverbSendLabel);
+    hide(reverbImpulseButton); hide(reverbImpulseLabel);
     hide(repeatActiveButton);
     hide(repeatDivSlider); hide(repeatDivLabel);
     hide(repeatThreshSlider); hide(repeatThreshLabel);
@@ -922,15 +1045,33 @@ void FXPanel::updateSliderVisibility()
         case EffectType::Compressor:
             compThreshSlider.setVisible(true); compThreshLabel.setVisible(true);
             compRatioSlider.setVisible(true); compRatioLabel.setVisible(true);
+            compLookaheadButton.setVisible(true);
+            compLookaheadButton.setToggleState(slots[selectedSlotIndex].compLookahead, juce::dontSendNotification);
+            compGainReductionLabel.setVisible(true);
             break;
         case EffectType::Delay:
             delaySlider.setVisible(true); delayLabel.setVisible(true);
             delayFeedbackSlider.setVisible(true); delayFeedbackLabel.setVisible(true);
             delayMixSlider.setVisible(true); delayMixLabel.setVisible(true);
+            delaySendSlider.setVisible(true); delaySendLabel.setVisible(true);
+            delaySyncButton.setVisible(true);
+            delaySyncButton.setToggleState(slots[selectedSlotIndex].delaySync, juce::dontSendNotification);
+            delayPingPongButton.setVisible(true);
+            delayPingPongButton.setToggleState(slots[selectedSlotIndex].delayPingPong, juce::dontSendNotification);
+            delaySlider.updateText();
             break;
         case EffectType::Reverb:
             reverbSlider.setVisible(true); reverbLabel.setVisible(true);
             reverbDecaySlider.setVisible(true); reverbDecayLabel.setVisible(true);
+            reverbSendSlider.setVisible(true); reverbSendLabel.setVisible(true);
+            reverbImpulseButton.setVisible(true);
+            reverbImpulseLabel.setVisible(true);
+            if (currentTrackId >= 1 && currentTrackId <= 8)
+            {
+                const auto& name = impulseNames[currentTrackId - 1];
+                reverbImpulseButton.setToggleState(name.isNotEmpty(), juce::dontSendNotification);
+                reverbImpulseLabel.setText(name.isNotEmpty() ? name : juce::String("ALGO"), juce::dontSendNotification);
+            }
             break;
         case EffectType::BeatRepeat:
             repeatDivSlider.setVisible(true); repeatDivLabel.setVisible(true);
@@ -1128,17 +1269,26 @@ void FXPanel::resized()
     
     // COMP
     if(compThreshSlider.isVisible()) {
-        placeControls({ {&compThreshSlider, &compThreshLabel}, {&compRatioSlider, &compRatioLabel} });
+        placeControls({ {&compThreshSlider, &compThreshLabel}, {&compRatioSlider, &compRatioLabel} }, &compLookaheadButton);
+        // Position gain reduction readout below lookahead button
+        auto b = compLookaheadButton.getBounds();
+        compGainReductionLabel.setBounds(b.getX(), b.getBottom() + 5, b.getWidth(), 20);
     }
     
     // DELAY
     if(delaySlider.isVisible()) {
-        placeControls({ {&delaySlider, &delayLabel}, {&delayFeedbackSlider, &delayFeedbackLabel}, {&delayMixSlider, &delayMixLabel} });
+        placeControls({ {&delaySlider, &delayLabel}, {&delayFeedbackSlider, &delayFeedbackLabel}, {&delayMixSlider, &delayMixLabel}, {&delaySendSlider, &delaySendLabel} }, &delaySyncButton);
+        // Position ping-pong button below sync button
+        auto b = delaySyncButton.getBounds();
+        delayPingPongButton.setBounds(b.getX(), b.getBottom() + 5, b.getWidth(), 30);
     }
     
     // REVERB
     if(reverbSlider.isVisible()) {
-        placeControls({ {&reverbSlider, &reverbLabel}, {&reverbDecaySlider, &reverbDecayLabel} });
+        placeControls({ {&reverbSlider, &reverbLabel}, {&reverbDecaySlider, &reverbDecayLabel}, {&reverbSendSlider, &reverbSendLabel} }, &reverbImpulseButton);
+        // Position IR name below IR button
+        auto b = reverbImpulseButton.getBounds();
+        reverbImpulseLabel.setBounds(b.getX(), b.getBottom() + 5, b.getWidth(), 20);
     }
 
     // BEAT REPEAT
@@ -1286,6 +1436,44 @@ void FXPanel::mouseDown(const juce::MouseEvent& e)
     }
 }
 
+void FXPanel::showImpulseMenu()
+{
+    const int trackId = currentTrackId;
+    if (trackId < 1 || trackId > 8)
+        return;
+
+    juce::PopupMenu m;
+    m.addItem(1, "Load IR...");
+    m.addItem(2, "Clear IR", impulseNames[trackId - 1].isNotEmpty());
+
+    m.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&reverbImpulseButton), [this, trackId](int result)
+    {
+        if (result == 1)
+        {
+            impulseChooser = std::make_unique<juce::FileChooser>("Select an impulse response", juce::File(),
+                                                                 "*.wav;*.aif;*.aiff;*.flac");
+            impulseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                        [this, trackId](const juce::FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (!file.existsAsFile())
+                    return;
+
+                // 読み込み・リサンプル・FFT はバックグラウンド。終わると onLoaded で表示が変わる
+                impulseLoader.load(trackId, file);
+                if (trackId == currentTrackId)
+                    reverbImpulseLabel.setText("LOADING", juce::dontSendNotification);
+            });
+        }
+        else if (result == 2)
+        {
+            looper.clearTrackReverbImpulse(trackId);
+            impulseNames[trackId - 1].clear();
+            updateSliderVisibility();
+        }
+    });
+}
+
 void FXPanel::showEffectMenu(int slotIndex)
 {
     juce::PopupMenu m;
@@ -1337,6 +1525,7 @@ void FXPanel::showEffectMenu(int slotIndex)
                 case EffectType::Tremolo: looper.setTrackTremoloEnabled(currentTrackId, false); break;
                 case EffectType::Slicer: looper.setTrackSlicerEnabled(currentTrackId, false); break;
                 case EffectType::Bitcrusher: looper.setTrackBitcrusherEnabled(currentTrackId, false); break;
+                case EffectType::Compressor: looper.setTrackCompressorEnabled(currentTrackId, false); break;
                 case EffectType::BeatRepeat: looper.setTrackBeatRepeatActive(currentTrackId, false); break;
                 case EffectType::GranularCloud: looper.setTrackGranularEnabled(currentTrackId, false); break;
                 case EffectType::Autotune: looper.setTrackAutotuneEnabled(currentTrackId, false); break;
@@ -1345,6 +1534,10 @@ void FXPanel::showEffectMenu(int slotIndex)
         }
 
         slots[slotIndex].type = newType;
+
+        // スロットの並びをそのままトラックの FX の処理順にする
+        if (currentTrackId >= 0)
+            looper.setTrackFxSlot(currentTrackId, slotIndex, moduleTypeFor(newType));
         
         // スロットボタンのテキストを更新
         juce::String typeStr;
@@ -1377,6 +1570,11 @@ void FXPanel::showEffectMenu(int slotIndex)
                 case EffectType::Tremolo: looper.setTrackTremoloEnabled(currentTrackId, true); break;
                 case EffectType::Slicer: looper.setTrackSlicerEnabled(currentTrackId, true); break;
                 case EffectType::Bitcrusher: looper.setTrackBitcrusherEnabled(currentTrackId, true); break;
+                case EffectType::Compressor:
+                    // ノブの表示値をそのまま使う（トラック側の既定は 0dB / 1:1 で素通し）
+                    looper.setTrackCompressor(currentTrackId, (float)compThreshSlider.getValue(), (float)compRatioSlider.getValue());
+                    looper.setTrackCompressorEnabled(currentTrackId, true);
+                    break;
                 case EffectType::BeatRepeat: looper.setTrackBeatRepeatActive(currentTrackId, true); break;
                 case EffectType::GranularCloud: looper.setTrackGranularEnabled(currentTrackId, true); break;
                 case EffectType::Autotune: looper.setTrackAutotuneEnabled(currentTrackId, true); break;
@@ -1397,6 +1595,12 @@ void FXPanel::timerCallback()
         looper.popMonitorSamples(buffer);
         visualizer.pushBuffer(buffer);
     }
+
+    if (compGainReductionLabel.isVisible())
+    {
+        const float reduction = looper.getTrackCompressorGainReduction(currentTrackId);
+        compGainReductionLabel.setText("GR -" + juce::String(reduction, 1) + "dB", juce::dontSendNotification);
+    }
 }
 
 // =====================================================
@@ -1419,6 +1623,8 @@ juce::String FXPanel::getControlIdForSlider(juce::Slider* slider)
     if (slider == &delayMixSlider)      return "fx_delay_mix";
     if (slider == &reverbSlider)        return "fx_reverb_mix";
     if (slider == &reverbDecaySlider)   return "fx_reverb_decay";
+    if (slider == &reverbSendSlider)    return "fx_reverb_send";
+    if (slider == &delaySendSlider)     return "fx_delay_send";
     if (slider == &repeatDivSlider)     return "fx_repeat_div";
     if (slider == &repeatThreshSlider)  return "fx_repeat_thresh";
     
@@ -1458,6 +1664,9 @@ juce::String FXPanel::getControlIdForComponent(juce::Component* comp)
     if (comp == &tremoloShapeButton) return "fx_tremolo_shape";
     if (comp == &slicerSyncButton) return "fx_slicer_sync";
     if (comp == &slicerShapeButton) return "fx_slicer_shape";
+    if (comp == &delaySyncButton) return "fx_delay_sync";
+    if (comp == &delayPingPongButton) return "fx_delay_pingpong";
+    if (comp == &compLookaheadButton) return "fx_comp_lookahead";
     if (comp == &filterTypeButton)   return "fx_filter_type";
     if (comp == &repeatActiveButton) return "fx_repeat_active";
     
@@ -1478,6 +1687,8 @@ juce::Slider* FXPanel::getSliderForControlId(const juce::String& controlId)
     if (controlId == "fx_delay_mix")        return &delayMixSlider;
     if (controlId == "fx_reverb_mix")       return &reverbSlider;
     if (controlId == "fx_reverb_decay")     return &reverbDecaySlider;
+    if (controlId == "fx_reverb_send")      return &reverbSendSlider;
+    if (controlId == "fx_delay_send")       return &delaySendSlider;
     if (controlId == "fx_repeat_div")       return &repeatDivSlider;
     if (controlId == "fx_repeat_thresh")    return &repeatThreshSlider;
 
@@ -1564,8 +1775,8 @@ void FXPanel::paintOverChildren(juce::Graphics& g)
     std::vector<juce::Slider*> sliders = {
         &filterSlider, &filterResSlider,
         &compThreshSlider, &compRatioSlider,
-        &delaySlider, &delayFeedbackSlider, &delayMixSlider,
-        &reverbSlider, &reverbDecaySlider,
+        &delaySlider, &delayFeedbackSlider, &delayMixSlider, &delaySendSlider,
+        &reverbSlider, &reverbDecaySlider, &reverbSendSlider,
         &repeatDivSlider, &repeatThreshSlider,
         &flangerRateSlider, &flangerDepthSlider, &flangerFeedbackSlider,
         &chorusRateSlider, &chorusDepthSlider, &chorusMixSlider,
@@ -1634,6 +1845,9 @@ void FXPanel::paintOverChildren(juce::Graphics& g)
     drawButtonOverlay(chorusSyncButton, "fx_chorus_sync");
     drawButtonOverlay(tremoloSyncButton, "fx_tremolo_sync");
     drawButtonOverlay(slicerSyncButton, "fx_slicer_sync");
+    drawButtonOverlay(delaySyncButton, "fx_delay_sync");
+    drawButtonOverlay(delayPingPongButton, "fx_delay_pingpong");
+    drawButtonOverlay(compLookaheadButton, "fx_comp_lookahead");
     
     // FXスロットバイパスボタン
     for (int i = 0; i < 4; ++i)
@@ -1687,6 +1901,21 @@ void FXPanel::handleMidiControl(const juce::String& controlId, float value)
             slicerSyncButton.setToggleState(value > 0.5f, juce::sendNotificationSync);
             slicerSyncButton.onClick();
         }
+        else if (controlId == "fx_delay_sync")
+        {
+            delaySyncButton.setToggleState(value > 0.5f, juce::sendNotificationSync);
+            delaySyncButton.onClick();
+        }
+        else if (controlId == "fx_delay_pingpong")
+        {
+            delayPingPongButton.setToggleState(value > 0.5f, juce::sendNotificationSync);
+            delayPingPongButton.onClick();
+        }
+        else if (controlId == "fx_comp_lookahead")
+        {
+            compLookaheadButton.setToggleState(value > 0.5f, juce::sendNotificationSync);
+            compLookaheadButton.onClick();
+        }
         else if (controlId == "fx_slicer_shape")
         {
             // シェイプサイクル (0=Square, 1=Smooth)
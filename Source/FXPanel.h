@@ -15,6 +15,7 @@
 #include "LooperAudio.h"
 #include "FXSlotButtonLookAndFeel.h"
 #include "FilterSpectrumVisualizer.h"
+#include "ImpulseResponseLoader.h"
 
 class MidiLearnManager; // 前方宣言
 
@@ -49,6 +50,9 @@ public:
         bool chorusSync = false;
         bool tremoloSync = false;
         bool slicerSync = false;
+        bool delaySync = false;
+        bool delayPingPong = false;
+        bool compLookahead = false;
     };
 
     FXPanel(LooperAudio& looperRef);
@@ -83,6 +87,12 @@ private:
     int currentTrackId = -1;
     juce::Label titleLabel;
 
+    // Delay SYNC 中の TIME つまみ (0-1000) → BlockDelay の音符インデックス（上げるほど長い）
+    static int delayDivisionForValue(double value);
+
+    // スロットの FX → ルーパーの処理順に渡す FxModuleType の番号（Beat Repeat / 空きは -1）
+    static int moduleTypeFor(EffectType type);
+
     PlanetKnobLookAndFeel planetLnF;
     FXSlotButtonLookAndFeel slotLnF;
 
@@ -123,6 +133,8 @@ private:
     juce::Label compThreshLabel;
     juce::Slider compRatioSlider;   // Ratio
     juce::Label compRatioLabel;
+    juce::TextButton compLookaheadButton { "LOOK" }; // ON の間は音声を 5ms 遅らせてアタックの頭を抑える
+    juce::Label compGainReductionLabel;              // ゲインリダクション（timerCallback で更新）
     
     // Delay
     juce::Slider delaySlider; // Time
@@ -131,12 +143,20 @@ private:
     juce::Label delayFeedbackLabel;
     juce::Slider delayMixSlider;
     juce::Label delayMixLabel;
+    juce::Slider delaySendSlider;   // 共有 Delay バスへのセンド（インサートとは別）
+    juce::Label delaySendLabel;
+    juce::TextButton delaySyncButton { "SYNC" };      // ON の間は TIME が音符長（マスターループ = 1小節）
+    juce::TextButton delayPingPongButton { "P.PONG" };
     
     // Reverb
     juce::Slider reverbSlider; // Mix
     juce::Label reverbLabel;
     juce::Slider reverbDecaySlider; // RoomSize
     juce::Label reverbDecayLabel;
+    juce::Slider reverbSendSlider;  // 共有 Reverb バスへのセンド（インサートとは別）
+    juce::Label reverbSendLabel;
+    juce::TextButton reverbImpulseButton { "IR" }; // IR ファイルを読み込む（ON の間は畳み込み、DECAY は効かない）
+    juce::Label reverbImpulseLabel;                // 読み込んだ IR のファイル名
     
     // Repeat
     juce::Slider repeatDivSlider;
@@ -211,11 +231,17 @@ private:
 
     void setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& name, const juce::String& style);
     void showEffectMenu(int slotIndex);
+    void showImpulseMenu();
     void updateSliderVisibility();
     
     // MIDI Learn
     MidiLearnManager* midiManager = nullptr;
     std::map<juce::Slider*, double> lastSliderValues; // MIDI Learn中の値復元用
 
+    // Convolution Reverb の IR（読み込みはバックグラウンド、名前はトラック別に表示用）
+    ImpulseResponseLoader impulseLoader { looper };
+    std::unique_ptr<juce::FileChooser> impulseChooser;
+    juce::String impulseNames[8];
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FXPanel)
 };
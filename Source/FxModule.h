@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    FxModule.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX のモジュール共通インターフェース
+    - prepare はメッセージスレッド（確保してよい）、それ以外はオーディオスレッド
+    - パラメータはモジュールが持たず、トラックの TrackFxParams を参照して読む
+      変わったときは parametersChanged が呼ばれるので、係数の計算はそこで行う
+    - getLatencySamples: 入力から出力までの遅延。ルーパーは処理順の合計だけ先読みして揃える
+    - getTailSamples: 入力が止まってから鳴り終わるまでの長さ（目安）
+    - FxModuleType の並びが既定の処理順（スロットに並べなかった FX はこの順で処理する）
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "LoopPagePool.h"
+
+enum class FxModuleType
+{
+	granular = 0,
+	autotune,
+	filter,
+	compressor,
+	flanger,
+	chorus,
+	tremolo,
+	slicer,
+	bitcrusher,
+	delay,
+	reverb,
+	numTypes
+};
+
+// ブロックごとにトラックから渡す情報（モジュール同士で共通）
+struct FxContext
+{
+	const PagedLoopBuffer* loop = nullptr; // トラックのループ（Granular が読む）
+	int loopLength = 1;
+	int blockStart = 0;            // このブロック先頭の再生位置（ループ内）
+	int masterLoopLength = 0;      // 0 = マスター未確定
+	double syncedModRate = 1.0;    // 同期 LFO のレート（Hz）
+	bool loopRestarts = false;     // このブロックの終わりでループが先頭に戻る
+};
+
+class FxModule
+{
+public:
+	virtual ~FxModule() = default;
+
+	// メッセージスレッド（オーディオ停止中 / 初めて ON にしたとき）
+	virtual void prepare(double sampleRate, int maxBlockSize) = 0;
+
+	// buffer（2ch）の先頭 numSamples をその場で置き換える
+	virtual void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext& context) noexcept = 0;
+
+	// 内部状態（ディレイライン・残響・LFO 位相など）を消す
+	virtual void reset() noexcept = 0;
+
+	// TrackFxParams のこのモジュールの値が変わった
+	virtual void parametersChanged() noexcept {}
+
+	virtual int getLatencySamples() const noexcept { return 0; }
+	virtual int getTailSamples() const noexcept { return 0; }
+};
@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    GranularEngine.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    Granular Cloud のグレインエンジン（トラック1本につき1つ、オーディオスレッド専用）
+    - 窓は事前計算した Hann テーブルを線形補間で引く
+    - パンはグレイン生成時に L / R のゲインを決めて固定（サンプルごとの cos / sin はしない）
+    - 読み出しは小数位置の線形補間。ピッチ（速度）は小数のまま進める
+    - ソースの収集だけ1サンプルずつ、窓掛けと加算は FloatVectorOperations（SIMD）
+    - 乱数はトラック専用の xorshift（状態は整数1個、ロックも共有もなし）
+    - 生成間隔・グレイン長・先読み量はすべて ms 指定でサンプルレートから換算
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+#include "LoopPagePool.h"
+
+class GranularEngine
+{
+public:
+	static constexpr int maxGrains = 256;
+
+	struct Params
+	{
+		float sizeMs = 100.0f;      // グレイン長 (50-500ms)
+		float density = 0.5f;       // 0.0 = 500ms 間隔 / 1.0 = 約2ms 間隔
+		float jitter = 0.5f;        // 読み出し位置のばらつき（ループ長に対する割合）
+		float pitch = 1.0f;         // 再生速度 (0.5-2.0)
+		float pitchRandom = 0.2f;   // 速度のばらつき
+	};
+
+	// メッセージスレッド（オーディオ停止中 / addTrack）で呼ぶ
+	void prepare(double newSampleRate) noexcept
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		getWindowTable(); // テーブルの初期化をオーディオスレッドに持ち込まない
+		reset();
+	}
+
+	void setSeed(juce::uint32 seed) noexcept
+	{
+		// xorshift は 0 だと止まるので混ぜてから使う
+		rngState = seed * 2654435761u + 0x9E3779B9u;
+		if (rngState == 0)
+			rngState = 1;
+	}
+
+	void reset() noexcept
+	{
+		numActive = 0;
+		samplesUntilSpawn = 0;
+	}
+
+	int getNumActiveGrains() const noexcept { return numActive; }
+
+	// source のループ [0, loopLength) からグレインを鳴らし、cloud の先頭 numSamples に加算する
+	// blockStartPosition はこのブロック先頭の再生位置（cloud は呼び出し側でクリアしておく）
+	void process(const PagedLoopBuffer& source, int loopLength, int blockStartPosition,
+	             const Params& params, juce::AudioBuffer<float>& cloud, int numSamples) noexcept
+	{
+		if (loopLength <= 0 || numSamples <= 0)
+			return;
+
+		spawnGrains(loopLength, blockStartPosition, params, numSamples);
+
+		float* outL = cloud.getWritePointer(0);
+		float* outR = cloud.getWritePointer(cloud.getNumChannels() > 1 ? 1 : 0);
+		SourceReader reader { source };
+
+		for (int g = 0; g < numActive;)
+		{
+			if (renderGrain(grains[(size_t)g], reader, loopLength, outL, outR, numSamples))
+				++g;
+			else
+				grains[(size_t)g] = grains[(size_t)--numActive]; // 終わったグレインは末尾と入れ替えて詰める
+		}
+	}
+
+private:
+	static constexpr int windowTableSize = 1024;
+	static constexpr int chunkSize = 256;          // スタック上の作業領域（サンプル数）
+	static constexpr float minGapMs = 2.27f;       // 旧実装の 100 サンプル @ 44.1kHz
+	static constexpr float maxGapMs = 500.0f;
+	static constexpr float spawnLookbackMs = 45.0f; // 再生位置より少し手前から読む（旧 2000 サンプル @ 44.1kHz）
+
+	struct Grain
+	{
+		double position = 0.0;   // 読み出し位置（ループ内、小数）
+		double speed = 1.0;
+		float phase = 0.0f;      // 窓テーブル上の位置
+		float phaseIncrement = 0.0f;
+		float gainL = 0.0f;
+		float gainR = 0.0f;
+		int life = 0;            // 残りサンプル数
+		int startOffset = 0;     // 生成されたブロック内での開始位置（次のブロックからは 0）
+	};
+
+	// ページをまたぐまで同じポインタで読む（ページ境界でだけ割り算する）
+	struct SourceReader
+	{
+		const PagedLoopBuffer& buffer;
+		const float* left = nullptr;
+		const float* right = nullptr;
+		int spanStart = 0;
+		int spanEnd = 0;
+
+		void read(int index, float& l, float& r) noexcept
+		{
+			if (index < spanStart || index >= spanEnd)
+			{
+				if (!buffer.getReadSpan(index, left, right, spanStart, spanEnd))
+				{
+					// 長さの外（ページが足りなかった分）は無音
+					left = right = nullptr;
+					spanStart = index;
+					spanEnd = index + 1;
+				}
+			}
+
+			if (left == nullptr)
+			{
+				l = r = 0.0f;
+				return;
+			}
+
+			l = left[index - spanStart];
+			r = right[index - spanStart];
+		}
+	};
+
+	static const std::array<float, windowTableSize + 1>& getWindowTable() noexcept
+	{
+		static const auto table = []
+		{
+			std::array<float, windowTableSize + 1> t {};
+			for (int i = 0; i <= windowTableSize; ++i)
+				t[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)windowTableSize);
+			return t;
+		}();
+		return table;
+	}
+
+	juce::uint32 nextRandom() noexcept
+	{
+		rngState ^= rngState << 13;
+		rngState ^= rngState >> 17;
+		rngState ^= rngState << 5;
+		return rngState;
+	}
+
+	float nextFloat() noexcept { return (float)(nextRandom() >> 8) * (1.0f / 16777216.0f); }
+
+	// [0, maxExclusive)
+	int nextInt(int maxExclusive) noexcept
+	{
+		return (int)(((juce::uint64)nextRandom() * (juce::uint64)juce::jmax(1, maxExclusive)) >> 32);
+	}
+
+	static int wrap(juce::int64 position, int loopLength) noexcept
+	{
+		const auto wrapped = position % loopLength;
+		return (int)(wrapped < 0 ? wrapped + loopLength : wrapped);
+	}
+
+	void spawnGrains(int loopLength, int blockStartPosition, const Params& params, int numSamples) noexcept
+	{
+		const float gapMs = minGapMs + (1.0f - juce::jlimit(0.0f, 1.0f, params.density)) * (maxGapMs - minGapMs);
+		const int gap = juce::jmax(1, juce::roundToInt(gapMs * 0.001 * sampleRate));
+		const int life = juce::jmax(1, juce::roundToInt(params.sizeMs * 0.001 * sampleRate));
+		const int lookback = juce::roundToInt(spawnLookbackMs * 0.001 * sampleRate);
+		const int jitterSamples = (int)(juce::jlimit(0.0f, 1.0f, params.jitter) * (float)loopLength * 0.5f);
+
+		// 間隔が縮んだら（density を上げたら）すぐ反映する
+		int offset = juce::jmin(samplesUntilSpawn, gap);
+
+		for (; offset < numSamples; offset += gap)
+		{
+			if (numActive >= maxGrains)
+				continue; // 空きがなければこの回は見送り（間隔は保つ）
+
+			auto& grain = grains[(size_t)numActive++];
+
+			const int jitterOffset = nextInt(2 * jitterSamples + 1) - jitterSamples;
+			grain.position = wrap((juce::int64)blockStartPosition + offset - lookback + jitterOffset, loopLength);
+
+			const float speed = params.pitch + (nextFloat() * 2.0f - 1.0f) * params.pitchRandom;
+			grain.speed = juce::jmax(0.05f, speed);
+
+			const float pan = nextFloat() * juce::MathConstants<float>::halfPi;
+			grain.gainL = std::cos(pan);
+			grain.gainR = std::sin(pan);
+
+			grain.life = life;
+			grain.phase = 0.0f;
+			grain.phaseIncrement = (float)windowTableSize / (float)life;
+			grain.startOffset = offset;
+		}
+
+		samplesUntilSpawn = offset - numSamples;
+	}
+
+	// false を返したら寿命切れ
+	bool renderGrain(Grain& grain, SourceReader& reader, int loopLength,
+	                 float* outL, float* outR, int numSamples) noexcept
+	{
+		const auto& window = getWindowTable();
+
+		int outPos = grain.startOffset;
+		grain.startOffset = 0;
+
+		int toRender = juce::jmin(numSamples - outPos, grain.life);
+		double position = grain.position >= loopLength ? std::fmod(grain.position, (double)loopLength) : grain.position;
+		float phase = grain.phase;
+
+		std::array<float, chunkSize> srcL, srcR, win;
+
+		while (toRender > 0)
+		{
+			const int n = juce::jmin(toRender, chunkSize);
+
+			// --- ソース（線形補間）と窓を集める ---
+			for (int i = 0; i < n; ++i)
+			{
+				const int i0 = (int)position;
+				const int i1 = i0 + 1 < loopLength ? i0 + 1 : 0;
+				const float frac = (float)(position - i0);
+
+				float l0, r0, l1, r1;
+				reader.read(i0, l0, r0);
+				reader.read(i1, l1, r1);
+				srcL[(size_t)i] = l0 + frac * (l1 - l0);
+				srcR[(size_t)i] = r0 + frac * (r1 - r0);
+
+				const int w0 = juce::jmin((int)phase, windowTableSize - 1);
+				const float wf = phase - (float)w0;
+				win[(size_t)i] = window[(size_t)w0] + wf * (window[(size_t)w0 + 1] - window[(size_t)w0]);
+
+				phase += grain.phaseIncrement;
+				position += grain.speed;
+				if (position >= loopLength)
+					position -= loopLength;
+			}
+
+			// --- 窓掛け + パンして加算（SIMD） ---
+			juce::FloatVectorOperations::multiply(srcL.data(), win.data(), n);
+			juce::FloatVectorOperations::multiply(srcR.data(), win.data(), n);
+			juce::FloatVectorOperations::addWithMultiply(outL + outPos, srcL.data(), grain.gainL, n);
+			juce::FloatVectorOperations::addWithMultiply(outR + outPos, srcR.data(), grain.gainR, n);
+
+			outPos += n;
+			toRender -= n;
+			grain.life -= n;
+		}
+
+		grain.position = position;
+		grain.phase = phase;
+		return grain.life > 0;
+	}
+
+	double sampleRate = 44100.0;
+	juce::uint32 rngState = 1;
+	int samplesUntilSpawn = 0;
+	int numActive = 0;
+	std::array<Grain, maxGrains> grains {};
+};
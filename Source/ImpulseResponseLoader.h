@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseLoader.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    Convolution Reverb の IR をバックグラウンドのスレッドで読み込む
+    - ファイルの読み込み → LooperAudio::setTrackReverbImpulse（リサンプル・FFT）まで全部このスレッドで行う
+      オーディオスレッドは出来上がった IR を次のブロックで受け取るだけ
+    - 同じトラックに続けて頼まれたら最後のものだけ読む
+    - 終わったら onLoaded をメッセージスレッドで呼ぶ
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include "LooperAudio.h"
+#include "ConvolutionReverb.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+class ImpulseResponseLoader : private juce::Thread,
+                              private juce::AsyncUpdater
+{
+public:
+	explicit ImpulseResponseLoader(LooperAudio& looperRef)
+		: juce::Thread("SAROS IR Loader"), looper(looperRef)
+	{
+	}
+
+	~ImpulseResponseLoader() override
+	{
+		cancelPendingUpdate();
+		stopThread(4000);
+	}
+
+	// メッセージスレッド
+	void load(int trackId, const juce::File& file)
+	{
+		{
+			const juce::ScopedLock sl(lock);
+			jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [trackId](const Job& j) { return j.trackId == trackId; }),
+			           jobs.end());
+			jobs.push_back({ trackId, file });
+		}
+
+		if (!isThreadRunning())
+			startThread();
+		notify();
+	}
+
+	// trackId, 読み込んだファイル, 成功したか
+	std::function<void(int, const juce::File&, bool)> onLoaded;
+
+	// ファイルを読んで impulse に入れる（最大2ch、ConvolutionReverb::maxImpulseSeconds まで）
+	// どのスレッドから呼んでもよい（OfflineRenderer からも使う）
+	static bool readFile(const juce::File& file, juce::AudioBuffer<float>& impulse, double& sampleRate)
+	{
+		juce::AudioFormatManager formats;
+		formats.registerBasicFormats();
+
+		std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+		if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+			return false;
+
+		const int length = (int)juce::jmin(reader->lengthInSamples,
+		                                   (juce::int64)(ConvolutionReverb::maxImpulseSeconds * reader->sampleRate));
+		impulse.setSize(juce::jmin(2, (int)reader->numChannels), length);
+		reader->read(&impulse, 0, length, 0, true, true);
+		sampleRate = reader->sampleRate;
+		return true;
+	}
+
+private:
+	struct Job
+	{
+		int trackId;
+		juce::File file;
+		bool succeeded = false;
+	};
+
+	void run() override
+	{
+		while (!threadShouldExit())
+		{
+			Job job { -1, {} };
+			{
+				const juce::ScopedLock sl(lock);
+				if (!jobs.empty())
+				{
+					job = jobs.front();
+					jobs.erase(jobs.begin());
+				}
+			}
+
+			if (job.trackId < 0)
+			{
+				wait(-1);
+				continue;
+			}
+
+			juce::AudioBuffer<float> impulse;
+			double impulseSampleRate = 0.0;
+			job.succeeded = readFile(job.file, impulse, impulseSampleRate)
+			             && looper.setTrackReverbImpulse(job.trackId, impulse, impulseSampleRate);
+
+			DBG("🏛 IR " << job.file.getFileName() << " → track " << job.trackId
+			    << (job.succeeded ? " loaded" : " failed"));
+
+			{
+				const juce::ScopedLock sl(lock);
+				finished.push_back(job);
+			}
+			triggerAsyncUpdate();
+		}
+	}
+
+	void handleAsyncUpdate() override
+	{
+		std::vector<Job> done;
+		{
+			const juce::ScopedLock sl(lock);
+			done.swap(finished);
+		}
+
+		for (const auto& job : done)
+			if (onLoaded)
+				onLoaded(job.trackId, job.file, job.succeeded);
+	}
+
+	LooperAudio& looper;
+	juce::CriticalSection lock;
+	std::vector<Job> jobs;      // メッセージスレッド → 読み込みスレッド
+	std::vector<Job> finished;  // 読み込みスレッド → メッセージスレッド
+
+	JUCE_DECLARE_NON_COPYABLE (ImpulseResponseLoader)
+};
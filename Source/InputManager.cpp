@@ -13,13 +13,33 @@
 void InputManager::prepare(double newSampleRate, int bufferSize)
 {
 	sampleRate = newSampleRate;
-	triggered  = false;
+	routeTriggered.fill(false);
 	recording = false;
-	triggerEvent.reset();
+	for (auto& event : routeEvents)
+		event.reset();
 	smoothedEnergy = 0.0f;
 
-	// Prepare ring buffer (2 seconds)
-    inputBuffer.prepare(sampleRate, 2);
+	// Prepare ring buffer (2 seconds, 入力ペアごと)
+    for (auto& buffer : inputBuffers)
+        buffer.prepare(sampleRate, 2);
+    detector.prepare(sampleRate);
+    
+    // 帯域トリガー: 包絡の係数と作業バッファ（これより長いブロックは全帯域で見る）
+    bandBank.prepare(sampleRate);
+    bandScratchCapacity = juce::jmax(1, bufferSize);
+    bandScratch.setSize(MAX_CHANNELS, bandScratchCapacity);
+    laneBands.fill(-1);
+    laneBandsRunning.fill(-1);
+    laneGains.fill(1.0f);
+    
+    floorTracker.prepare(sampleRate, config.noiseFloorWindowMs);
+
+    // キャリブレーションのピーク（オーディオスレッドでは大きさを変えない）
+    calibrationPeaks.assign((size_t)MAX_CHANNELS, 0.0f);
+    calibrationBandPeaks.assign((size_t)MAX_CHANNELS, {});
+    calibrationSampleCount = 0;
+    calibrating.store(false);
+    calibrationResult.store(resultNone);
 
 	DBG("InputManager::prepare sampleRate = " << sampleRate << "bufferSize = " << bufferSize);
     DBG("AudioInputBuffer initialized.");
@@ -27,10 +47,13 @@ void InputManager::prepare(double newSampleRate, int bufferSize)
 
 void InputManager::reset()
 {
-	triggerEvent.reset();
+	for (auto& event : routeEvents)
+	{
+		event.reset();
+		event.sampleInBlock = -1;
+		event.absIndex = -1;
+	}
 	recording = false;
-	triggerEvent.sampleInBlock = -1;
-	triggerEvent.absIndex = -1;
     // inputBuffer.clear(); // Optional: clear buffer on reset
 	DBG("InputManager::reset()");
 }
@@ -39,187 +62,362 @@ void InputManager::reset()
 // メイン処理（マルチチャンネル対応版）
 //==============================================================================
 
-void InputManager::analyze(const juce::AudioBuffer<float>& input)
+void InputManager::analyze(const juce::AudioBuffer<float>& input, juce::int64 blockStartSample)
 {
     const int numSamples = input.getNumSamples();
     const int numChannels = input.getNumChannels();
     if (numSamples == 0) return;
 
-    // チャンネル数は固定配列のため調整不要（最大8ch）
+    // 1. Write to Ring Buffer（入力ペアごと。ペア p は ch 2p, 2p+1）
+    const int numInputPairs = juce::jlimit(1, maxRoutes, (numChannels + 1) / 2);
+    for (int pair = 0; pair < numInputPairs; ++pair)
+        inputBuffers[(size_t)pair].write(input.getArrayOfReadPointers() + pair * 2,
+                                         juce::jmin(AudioInputBuffer::maxChannels, numChannels - pair * 2),
+                                         numSamples, blockStartSample);
 
-    // Use channel 0 for trigger analysis and buffering (Mono support for now)
-    const float* readPtr = input.getReadPointer(0);
-    
-    // 1. Write to Ring Buffer
-    inputBuffer.write(readPtr, numSamples);
+    // ルーティングはブロックの頭で1回だけ読む。切り替えたら、前のルートの状態は持ち越さない
+    if (const bool routing = perInputRouting.load(); routing != blockRouting)
+    {
+        blockRouting = routing;
+        routingApplied.store(routing);
+        detector.resetPreRoll();
+        routeTriggered.fill(false);
+        for (auto& event : routeEvents)
+            event.reset();
+    }
 
-    // Calculate level for each channel
-    float maxAmp = 0.0f;
-    for (int ch = 0; ch < numChannels; ++ch)
+    // キャリブレーションの開始・打ち切り（メッセージスレッドからの要求）
+    switch (calibrationRequest.exchange(calibrationNone))
     {
-        float chMax = 0.0f;
-        const float* chPtr = input.getReadPointer(ch);
-        for (int i = 0; i < numSamples; ++i)
-        {
-            float absSamp = std::abs(chPtr[i]);
-            if (absSamp > chMax) chMax = absSamp;
-        }
-        
-        // ステレオリンクOFF（モノラルモード）の場合、ゲインブーストを適用
-        if (ch < channelManager.getNumChannels() && !channelManager.getSettings(ch).isStereoLinked)
+        case calibrationStart:
         {
-            chMax *= ChannelTriggerSettings::getMonoGainBoostLinear();
+            // 前回の結果を書き出している最中なら、次のブロックで始める（読まれていない結果は捨てる）
+            int result = resultReady;
+            if (!calibrationResult.compare_exchange_strong(result, resultNone) && result == resultApplying)
+            {
+                int expected = calibrationNone;
+                calibrationRequest.compare_exchange_strong(expected, calibrationStart);
+                break;
+            }
+            std::fill(calibrationPeaks.begin(), calibrationPeaks.end(), 0.0f);
+            for (auto& peaks : calibrationBandPeaks)
+                peaks.fill(0.0f);
+            calibrationSampleCount = 0;
+            calibrating.store(true);
+            break;
         }
-        
-        if (ch < MAX_CHANNELS)
-            channelLevels[static_cast<size_t>(ch)].store(chMax);
-        
-        if (chMax > maxAmp) maxAmp = chMax;
+
+        case calibrationStop:
+            if (calibrating.load())
+                finishCalibration();
+            break;
+
+        default: break;
+    }
+    const bool isMeasuring = calibrating.load();
+
+    // 2. レベル・プリロール・トリガーを全チャンネル1パスで（ルートは検出器のレーングループ）
+    //    帯域トリガーのチャンネルは帯域の包絡で見る（キャリブレーション中は全帯域のレベルを測るのでそのまま）
+    configureDetectorLanes(numChannels);
+    const auto& detectionInput = isMeasuring ? input : makeDetectionInput(input);
+    detector.process(detectionInput, blockStartSample, blockLevels.data());
+
+    float maxAmp = 0.0f;
+    for (size_t ch = 0; ch < (size_t)MAX_CHANNELS; ++ch)
+    {
+        channelLevels[ch].store(blockLevels[ch]);
+        maxAmp = juce::jmax(maxAmp, blockLevels[ch]);
     }
     currentLevel.store(maxAmp); // Update atomic level
     
     // キャリブレーション中はピーク値を記録
-    if (calibrating)
+    if (isMeasuring)
     {
-        for (int ch = 0; ch < numChannels; ++ch)
+        for (int ch = 0; ch < juce::jmin(numChannels, MAX_CHANNELS); ++ch)
         {
-            if (ch < static_cast<int>(calibrationPeaks.size()))
-            {
-                float chLevel = (ch < MAX_CHANNELS) 
-                                ? channelLevels[static_cast<size_t>(ch)].load() : 0.0f;
-                if (chLevel > calibrationPeaks[static_cast<size_t>(ch)])
-                    calibrationPeaks[static_cast<size_t>(ch)] = chLevel;
-            }
+            const float chLevel = blockLevels[static_cast<size_t>(ch)];
+            if (chLevel > calibrationPeaks[static_cast<size_t>(ch)])
+                calibrationPeaks[static_cast<size_t>(ch)] = chLevel;
         }
+        
+        // 帯域ごとのノイズフロアも同時に測る（前の状態が残らないよう、最初のブロックで包絡を消す）
+        if (calibrationSampleCount == 0)
+        {
+            bandBank.reset();
+            laneBandsRunning.fill(-1);
+        }
+        bandBank.measure(input.getArrayOfReadPointers(), numChannels, numSamples, blockBandPeaks);
+        for (size_t ch = 0; ch < juce::jmin(calibrationBandPeaks.size(), blockBandPeaks.size()); ++ch)
+            for (size_t b = 0; b < blockBandPeaks[ch].size(); ++b)
+                calibrationBandPeaks[ch][b] = juce::jmax(calibrationBandPeaks[ch][b], blockBandPeaks[ch][b]);
+        
         calibrationSampleCount += numSamples;
         
         // 2秒間測定したら自動停止
         if (calibrationSampleCount >= static_cast<int>(sampleRate * 2.0))
         {
-            stopCalibration();
+            finishCalibration();
         }
+        detector.resetPreRoll();
         return;  // キャリブレーション中はトリガー処理をスキップ
     }
 
-	// 2. Process Triggers (2-stage logic / Multi-channel)
-    bool trig = detectMultiChannelTrigger(input);
+    // ノイズフロアの追従（録音中のルートの入力は演奏なので学習しない）
+    // トリガー中は止めない: 部屋が閾値より大きくなってトリガーが出っぱなしになっても、追従で閾値が上がって戻れるように
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+        laneFrozen[(size_t)ch] = isRecordingActive(routeOfChannel(ch));
+    floorTracker.process(blockLevels.data(), numSamples, laneFrozen.data());
+    
+    // UI へはアトミックだけで渡す（閾値は次のブロックの configureDetectorLanes が floorTracker から直接計算する）
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+        channelNoiseFloors[(size_t)ch].store(floorTracker.getFloor(ch) * ChannelTriggerSettings::NOISE_FLOOR_MARGIN);
+
+    // 3. State Update（ルートごと）
+    const int numRoutes = blockRouting ? maxRoutes : 1;
+    for (int route = 0; route < numRoutes; ++route)
+        updateRoute(route, numInputPairs);
+}
+
+void InputManager::updateRoute(int route, int numInputPairs)
+{
+    const auto& result = detector.getGroupResult(route);
+    auto& event = routeEvents[(size_t)route];
+    bool& triggered = routeTriggered[(size_t)route];
+
+    // 🔥 鎮火ロジック: 録音中でなく、ルートの全チャンネルが閾値の半分未満なら PreRoll をリセット
+    // （次のトリガーを受け付けられるようにする）
+    if (channelManager.getNumChannels() > 0 && !result.triggered && !isRecordingActive(route)
+        && detector.isInPreRoll(route) && result.maxLevel < routeLowestThreshold[(size_t)route] * 0.5f)
+    {
+        detector.resetPreRoll(route);
+    }
 
-	// 3. State Update
-	if (trig && !triggered)
+	if (result.triggered && !triggered)
 	{
 		triggered = true;
-        
-        // AudioInputBuffer から正確なサンプルインデックスを取得
-        int sampleIdx = inputBuffer.getLastTriggerIndexInBlock();
-        
-        // Fire trigger! AbsIndex is managed by AudioInputBuffer internally mostly,
-        // but we signal capability via the event.
-		triggerEvent.fire(sampleIdx, -1);
-		DBG("🔥 Trigger Fired! High threshold exceeded (sampleIdx: " << sampleIdx << ").");
+
+        // 先読みはアタックの始まりから（勾配で遡る。トリガーしたチャンネルの入力ペアのリングで見る）
+        // ルーティング ON ならこのルートのペアだけ、OFF なら全ペアを同じ位置から出す
+        const int triggerPair = juce::jlimit(0, numInputPairs - 1, result.channel / 2);
+        const auto attackStart = findAttackStartAbs(result.absIndex, triggerPair);
+        if (blockRouting)
+        {
+            inputBuffers[(size_t)route].setLookbackStart(attackStart);
+        }
+        else
+        {
+            for (int pair = 0; pair < numInputPairs; ++pair)
+                inputBuffers[(size_t)pair].setLookbackStart(attackStart);
+        }
+
+		event.fire(result.sampleInBlock, result.absIndex, result.channel);
 	}
 	else if (triggered)
 	{
         // 🔄 Auto-Reset logic:
         // We only reset 'triggered' when the input signal drops below silence threshold
-        // (i.e. Low Threshold) for a sufficient time.
-        // AudioInputBuffer handles this logic via 'inPreRoll' state.
-        
-        if (!inputBuffer.isInPreRoll())
+        // (i.e. Low Threshold) for a sufficient time (TriggerDetector の PreRoll が解けたら).
+        if (!detector.isInPreRoll(route))
         {
             triggered = false;
-            triggerEvent.reset();
-            DBG("🔄 Trigger Re-armed (Silence detected)");
+            event.reset();
         }
 	}
 }
 
 //==============================================================================
-// マルチチャンネル対応のトリガー検出
-// いずれか1チャンネルでも閾値を超えたらトリガー発火（One-shot）
+// チャンネル設定 → 検出器のレーン
+// ルート内のいずれか1チャンネルでも閾値を超えたらそのルートのトリガー発火（One-shot）
 //==============================================================================
 
-bool InputManager::detectMultiChannelTrigger(const juce::AudioBuffer<float>& input)
+void InputManager::configureDetectorLanes(int numInputChannels)
 {
-    const int numChannels = input.getNumChannels();
-    const int numSamples = input.getNumSamples();
+    detector.setLowThreshold(config.silenceThreshold);
     
-    if (numChannels == 0 || numSamples == 0) return false;
-    
-    // チャンネルマネージャーの設定がなければ従来のロジックを使用
-    if (channelManager.getNumChannels() == 0)
+    // チャンネルマネージャーの設定がなければ従来どおりチャンネル 0 だけを見る
+    const int numConfigured = channelManager.getNumChannels();
+    const auto previousBands = laneBands;
+    laneBands.fill(-1);
+    if (numConfigured == 0)
     {
-        const float* readPtr = input.getReadPointer(0);
-        return inputBuffer.processTriggers(readPtr, numSamples, 
-                                           config.silenceThreshold, 
-                                           config.userThreshold);
+        detector.clearLanes();
+        detector.setLane(0, true, config.userThreshold, 1.0f);
+        for (auto& threshold : channelThresholds)
+            threshold.store(0.0f);
+        channelThresholds[0].store(config.userThreshold);
+        routeLowestThreshold.fill(config.userThreshold);
+        return;
     }
     
-    // 全体のピークレベルを計測（鎮火判定用）
-    float maxLevelOverall = 0.0f;
-    float lowestThreshold = 1.0f;  // 最も低い閾値を記録
-    
-    // 各チャンネルをチェック（いずれか1つでも閾値を超えたらトリガー）
-    for (int ch = 0; ch < juce::jmin(numChannels, channelManager.getNumChannels()); ++ch)
+    routeLowestThreshold.fill(1.0f);  // ルートごとに最も低い閾値を記録
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
     {
+        if (ch >= numConfigured)
+        {
+            detector.setLane(ch, false, 1.0f, 1.0f);
+            channelThresholds[(size_t)ch].store(0.0f);
+            continue;
+        }
+        
         const auto& chSettings = channelManager.getSettings(ch);
         
-        // 無効なチャンネルはスキップ
-        if (!chSettings.isActive) continue;
+        // ステレオリンク時は偶数チャンネル（L）が R も見る。奇数チャンネル（R）は検出しない
+        // ステレオリンクOFF（モノラルモード）の場合、ゲインブーストを適用
+        const bool linked = chSettings.isStereoLinked;
+        const bool active = chSettings.isActive && !(linked && ch % 2 == 1);
+        const int partner = (linked && ch + 1 < numInputChannels) ? ch + 1 : -1;
         
-        // ステレオリンク時は偶数チャンネル（L）のみ処理、奇数チャンネル（R）はスキップ
-        if (chSettings.isStereoLinked && (ch % 2 == 1)) continue;
+        // 帯域トリガー: ステレオリンクの R は L の帯域で見る
+        // 帯域の包絡はキャリブレーションでゲインなしで測っているので、モノラルのゲインブーストはかけない
+        const auto& bandOwner = (linked && ch % 2 == 1) ? channelManager.getSettings(ch - 1) : chSettings;
+        laneBands[(size_t)ch] = bandOwner.isBandTrigger() ? bandOwner.triggerBand : -1;
+        const float gain = (linked || laneBands[(size_t)ch] >= 0) ? 1.0f : ChannelTriggerSettings::getMonoGainBoostLinear();
         
-        float effectiveThreshold = chSettings.getEffectiveThreshold();
-        lowestThreshold = juce::jmin(lowestThreshold, effectiveThreshold);
+        // 検出するレベルの尺度が変わったら、ノイズフロアは測り直す
+        if (laneBands[(size_t)ch] != previousBands[(size_t)ch] || gain != laneGains[(size_t)ch])
+        {
+            floorTracker.resetLane(ch);
+            laneGains[(size_t)ch] = gain;
+        }
         
-        const float* chPtr = input.getReadPointer(ch);
+        const float threshold = chSettings.getEffectiveThreshold(floorTracker.getFloor(ch) * ChannelTriggerSettings::NOISE_FLOOR_MARGIN);
+        const int route = routeOfChannel(ch);
+        detector.setLane(ch, active, threshold, gain, partner, route);
+        channelThresholds[(size_t)ch].store(active ? threshold : 0.0f);
+        if (active)
+            routeLowestThreshold[(size_t)route] = juce::jmin(routeLowestThreshold[(size_t)route], threshold);
+    }
+}
+
+const juce::AudioBuffer<float>& InputManager::makeDetectionInput(const juce::AudioBuffer<float>& input)
+{
+    const int numChannels = juce::jmin(input.getNumChannels(), MAX_CHANNELS);
+    const int numSamples = input.getNumSamples();
+    
+    bool anyBand = false;
+    for (int ch = 0; ch < numChannels; ++ch)
+        anyBand = anyBand || laneBands[(size_t)ch] >= 0;
+    
+    // 確保した長さを超えるブロックは全帯域で見る（オーディオスレッドで確保しない）
+    if (!anyBand || numSamples > bandScratchCapacity)
+        return input;
+    
+    bandScratch.setSize(numChannels, numSamples, false, false, true);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const int band = laneBands[(size_t)ch];
         
-        // ステレオリンクの場合、L+R両方をチェック
-        if (chSettings.isStereoLinked && ch + 1 < numChannels)
+        // 帯域が変わったら、前の帯域の包絡は使わない
+        if (band != laneBandsRunning[(size_t)ch])
         {
-            const float* chPtrR = input.getReadPointer(ch + 1);
-            for (int i = 0; i < numSamples; ++i)
-            {
-                float maxSample = juce::jmax(std::abs(chPtr[i]), std::abs(chPtrR[i]));
-                maxLevelOverall = juce::jmax(maxLevelOverall, maxSample);
-                
-                if (maxSample > effectiveThreshold)
-                {
-                    return inputBuffer.processTriggers(chPtr, numSamples, 
-                                                       config.silenceThreshold, 
-                                                       effectiveThreshold);
-                }
-            }
+            bandBank.resetLane(ch);
+            laneBandsRunning[(size_t)ch] = band;
+        }
+        
+        if (band < 0)
+            juce::FloatVectorOperations::copy(bandScratch.getWritePointer(ch), input.getReadPointer(ch), numSamples);
+    }
+    bandBank.process(input.getArrayOfReadPointers(), bandScratch.getArrayOfWritePointers(),
+                     numChannels, numSamples, laneBands.data());
+    return bandScratch;
+}
+
+//==============================================================================
+// アタックの遡り
+//==============================================================================
+
+juce::int64 InputManager::findSilenceStartAbs(juce::int64 triggerAbsIndex, int inputPair) const
+{
+    const auto& inputBuffer = inputBuffers[(size_t)inputPair];
+
+    // トリガーから遡り、silenceThreshold 未満が minSilenceMs 続いた区間の終わり（= 音の始まり）を返す
+    // maxPreRollMs より前は探さない（見つからなければそこまで）
+    // 区間ごとに |x| の最大（findMinAndMax）を見て、静かな区間はまとめて数える。音のある区間だけ両端をサンプル単位で見る
+    // 区間は minSilence 以下なので、静かな区間が音のある区間の中だけで minSilence に届くことはない
+    constexpr int maxChunk = 64;
+    const juce::int64 limit = juce::jmax(inputBuffer.getOldestAbs(),
+                                         triggerAbsIndex - msToSamples(config.maxPreRollMs));
+    const int minSilence = juce::jmax(1, msToSamples(config.minSilenceMs));
+    const int chunk = juce::jmin(maxChunk, minSilence);
+    const float threshold = config.silenceThreshold;
+    
+    juce::int64 runEnd = juce::jmin(triggerAbsIndex, inputBuffer.getWriteAbs()); // いま数えている静かな区間の終わり
+    for (juce::int64 end = runEnd; end > limit;)
+    {
+        const int n = (int)juce::jmin<juce::int64>(chunk, end - limit);
+        const juce::int64 start = end - n;
+
+        if (inputBuffer.getMagnitude(start, n) < threshold)
+        {
+            if (runEnd - start >= minSilence)
+                return runEnd;
         }
         else
         {
-            // モノラルまたは単独チャンネル
-            float gainBoost = chSettings.isStereoLinked ? 1.0f : ChannelTriggerSettings::getMonoGainBoostLinear();
-            
-            for (int i = 0; i < numSamples; ++i)
-            {
-                float sampleLevel = std::abs(chPtr[i]) * gainBoost;
-                maxLevelOverall = juce::jmax(maxLevelOverall, sampleLevel);
-                
-                if (sampleLevel > effectiveThreshold)
-                {
-                    return inputBuffer.processTriggers(chPtr, numSamples, 
-                                                       config.silenceThreshold, 
-                                                       effectiveThreshold);
-                }
-            }
+            // 上端から最初の音まで: いまの静かな区間の続き
+            juce::int64 loud = end - 1;
+            while (inputBuffer.getMagnitude(loud) < threshold)
+                --loud;
+            if (runEnd - (loud + 1) >= minSilence)
+                return runEnd;
+
+            // 下端から最初の音まで: 新しい静かな区間（区間より短いので、ここではまだ届かない）
+            loud = start;
+            while (inputBuffer.getMagnitude(loud) < threshold)
+                ++loud;
+            runEnd = loud;
         }
+        end = start;
     }
+    return juce::jmin(limit, triggerAbsIndex);
+}
+
+juce::int64 InputManager::findAttackStartAbs(juce::int64 triggerAbsIndex, int inputPair) const
+{
+    const auto& inputBuffer = inputBuffers[(size_t)inputPair];
+
+    // attackWindowMs の範囲を 1ms ごとのピーク（包絡）にし、slopeSmoothN 点の移動平均でならす
+    // トリガーから遡って、包絡が下がり続けるあいだ（= トリガーに向かって立ち上がっている）をアタックとする
+    // 静かな区間の終わり（findSilenceStartAbs）より前には戻らない
+    constexpr int maxHops = 128;
+    const juce::int64 floorAbs = juce::jmax(findSilenceStartAbs(triggerAbsIndex, inputPair),
+                                            triggerAbsIndex - msToSamples(config.attackWindowMs));
+    const int hop = juce::jmax(1, msToSamples(1));
+    const int numHops = (int)juce::jmin<juce::int64>(maxHops, (triggerAbsIndex - floorAbs) / hop);
+    if (numHops < 2)
+        return juce::jmin(floorAbs, triggerAbsIndex);
     
-    // 🔥 鎮火ロジック: 録音中でなく、全チャンネルが閾値の半分未満なら PreRoll をリセット
-    // （次のトリガーを受け付けられるようにする）
-    if (!recordingActive && inputBuffer.isInPreRoll() && maxLevelOverall < lowestThreshold * 0.5f)
+    // hop k はトリガーの k+1 個手前の 1ms（0 がトリガーの直前）
+    std::array<float, maxHops> envelope {};
+    for (int k = 0; k < numHops; ++k)
     {
-        inputBuffer.resetPreRoll();
-        DBG("🔄 PreRoll reset (silence detected, level: " << maxLevelOverall << ")");
+        const juce::int64 hopStart = triggerAbsIndex - (juce::int64)(k + 1) * hop;
+        envelope[(size_t)k] = inputBuffer.getMagnitude(hopStart, hop);
     }
     
-    return false;
+    // 前後対称の移動平均（遅れなし）。窓の端では幅を左右同じだけ縮める（端で平らにならないように）
+    const int halfWidth = juce::jmax(0, (config.slopeSmoothN - 1) / 2);
+    auto smoothed = [&](int k)
+    {
+        const int width = juce::jmin(halfWidth, k, numHops - 1 - k);
+        const int from = k - width;
+        const int to = k + width;
+        float sum = 0.0f;
+        for (int j = from; j <= to; ++j)
+            sum += envelope[(size_t)j];
+        return sum / (float)(to - from + 1);
+    };
+    
+    // 手前の hop の方が静かなうちは遡る（勾配が正 = 立ち上がりの途中）
+    int k = 0;
+    while (k + 1 < numHops && smoothed(k + 1) < smoothed(k))
+        ++k;
+    
+    // 窓の端まで立ち上がり続けていたら、端（静かな区間の終わり）から
+    if (k == numHops - 1)
+        return floorAbs;
+    
+    return juce::jmax(floorAbs, triggerAbsIndex - (juce::int64)(k + 1) * hop);
 }
 
 //==============================================================================
@@ -271,20 +469,34 @@ float InputManager::computeEnergy(const juce::AudioBuffer<float>& input)
 
 void InputManager::startCalibration()
 {
-    int numChannels = channelManager.getNumChannels();
-    if (numChannels == 0) numChannels = 2;  // デフォルト2ch
-    
-    calibrationPeaks.clear();
-    calibrationPeaks.resize(static_cast<size_t>(numChannels), 0.0f);
-    calibrationSampleCount = 0;
-    calibrating = true;
+    // 前回の結果がまだ書かれていなければ先に書く（オーディオスレッドがピークを消す前に）
+    applyCalibrationResult();
+    calibrationRequest.store(calibrationStart);
     
-    DBG("📊 Calibration started (" << numChannels << " channels)");
+    DBG("📊 Calibration requested (" << channelManager.getNumChannels() << " channels)");
 }
 
 void InputManager::stopCalibration()
 {
-    calibrating = false;
+    // 測定中なら、次の analyze がそこまでの値で打ち切る
+    int expected = calibrationNone;
+    calibrationRequest.compare_exchange_strong(expected, calibrationStop);
+    if (expected == calibrationStart)
+        calibrationRequest.compare_exchange_strong(expected, calibrationNone); // 始まる前なら取り消す
+}
+
+// オーディオスレッド: 測定を止めて、ピークをメッセージスレッドに渡す
+void InputManager::finishCalibration()
+{
+    calibrating.store(false);
+    calibrationResult.store(resultReady);
+}
+
+bool InputManager::applyCalibrationResult()
+{
+    int expected = resultReady;
+    if (!calibrationResult.compare_exchange_strong(expected, resultApplying))
+        return false;
     
     // 測定結果をチャンネル設定に反映
     int numChannels = juce::jmin(static_cast<int>(calibrationPeaks.size()), 
@@ -294,13 +506,17 @@ void InputManager::stopCalibration()
     {
         float noiseFloor = calibrationPeaks[static_cast<size_t>(ch)];
         // ノイズフロアに少しマージンを追加（1.5倍）
-        channelManager.getSettings(ch).calibratedNoiseFloor = noiseFloor * 1.5f;
+        auto& settings = channelManager.getSettings(ch);
+        settings.calibratedNoiseFloor = noiseFloor * ChannelTriggerSettings::NOISE_FLOOR_MARGIN;
         
-        DBG("📊 Channel " << ch << " noise floor: " << noiseFloor 
-            << " -> calibrated: " << (noiseFloor * 1.5f));
+        // 帯域ごとも同じマージンで
+        if (ch < static_cast<int>(calibrationBandPeaks.size()))
+            for (size_t b = 0; b < settings.calibratedBandFloor.size(); ++b)
+                settings.calibratedBandFloor[b] = calibrationBandPeaks[static_cast<size_t>(ch)][b] * ChannelTriggerSettings::NOISE_FLOOR_MARGIN;
     }
     
-    DBG("📊 Calibration complete!");
+    calibrationResult.store(resultNone);
+    return true;
 }
 
 //==============================================================================
@@ -316,13 +532,14 @@ void InputManager::updateStateMachine()
 //==============================================================================
 juce::TriggerEvent& InputManager::getTriggerEvent() noexcept
 {
-	return triggerEvent;
+	return routeEvents[0];
 
 }
 
 void InputManager::setConfig(const SmartRecConfig& newConfig) noexcept
 {
 	config = newConfig;
+	perInputRouting.store(newConfig.perInputRouting); // オーディオスレッドは config.perInputRouting を見ない
 }
 
 const SmartRecConfig& InputManager::getConfig() const noexcept
@@ -352,8 +569,8 @@ bool InputManager::detectTriggerSample(const juce::AudioBuffer<float>& input)
 
 		if(frameAmp > threshold)
 		{
-			triggerEvent.sampleInBlock = s;
-			triggerEvent.channel = 0;
+			routeEvents[0].sampleInBlock = s;
+			routeEvents[0].channel = 0;
 			return true;
 		}
 	}
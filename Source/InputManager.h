@@ -13,6 +13,9 @@
 #include "TriggerEvent.h"
 #include "AudioInputBuffer.h"
 #include "ChannelTriggerSettings.h"
+#include "TriggerDetector.h"
+#include "BandEnvelopeBank.h"
+#include "NoiseFloorTracker.h"
 
 struct SmartRecConfig
 {
@@ -21,8 +24,10 @@ struct SmartRecConfig
 	int minSilenceMs = 10;		   //無音が続く時間(停止判定などに使用予定)
 	int maxPreRollMs = 25;		   //遡り記録の最大時間
 	int attackWindowMs = 25;		   //勾配検知の探索窓
-	int slopeSmoothN = 5;		   //フェード時間
+	int slopeSmoothN = 5;		   //勾配を見る包絡（1ms ごとのピーク）の移動平均の点数
 	int fadeMs = 8;
+	int noiseFloorWindowMs = 4000;   //ノイズフロア追従の窓（この間のいちばん静かな区間のピーク。prepare で反映）
+	bool perInputRouting = false;    //入力ペアごとにトリガーを分ける（OFF = どの入力でも全体で1つのトリガー）
 };
 
 
@@ -30,6 +35,11 @@ struct SmartRecConfig
 // ===============================================
 // SmartRecの中心：InputManager
 // マルチチャンネル対応版
+// - 先読みリングは入力ペア（ch 1/2, 3/4, ...）ごと。トラックは入力ペアを1組録音する
+// - ルート = トリガーの状態（プリロール・発火・再アーム・録音中）を共有するまとまり
+//   perInputRouting OFF: ルート 0 だけ（どの入力でも発火し、全ペアの先読みを同じ位置から出す）
+//   perInputRouting ON : 入力ペア p = ルート p。ペアごとに独立して発火する
+// - 検出は全チャンネル1パス（TriggerDetector のグループ = ルート）
 // ===============================================
 
 class InputManager
@@ -49,14 +59,26 @@ class InputManager
 	
 	int getNumChannels() const { return channelManager.getNumChannels(); }
 
+	static constexpr int maxRoutes = TriggerDetector::maxGroups; // = 入力ペアの数の上限
+
 	//メイン解析処理
-	void analyze(const juce::AudioBuffer<float>& input) ;
-	juce::TriggerEvent& getTriggerEvent() noexcept;
-	void setTriggerEvent(){triggerEvent.triggerd = false;}
+	// blockStartSample: このブロック先頭の絶対サンプル位置（トリガーの absIndex はこの時計で付く）
+	void analyze(const juce::AudioBuffer<float>& input, juce::int64 blockStartSample);
+	juce::TriggerEvent& getTriggerEvent() noexcept; // ルート 0（perInputRouting OFF なら唯一のトリガー）
+	void setTriggerEvent(){routeEvents[0].triggerd = false;}
+	
+	// ルートごとのトリガー
+	// ルート数と入力ペアのルートは、直前の analyze が使ったルーティングで答える（トリガーと食い違わない）
+	juce::TriggerEvent& getRouteTriggerEvent(int route) noexcept { return routeEvents[(size_t)route]; }
+	int getNumRoutes() const noexcept { return routingApplied.load(std::memory_order_relaxed) ? maxRoutes : 1; }
+	int getRouteForInputPair(int inputPair) const noexcept
+	{
+		return routingApplied.load(std::memory_order_relaxed) ? juce::jlimit(0, maxRoutes - 1, inputPair) : 0;
+	}
 
 	//TriggerEvent& getTriggerEvent() {return triggerEvent;}
 	//TriggerEvent& getTriggerEvent() {return triggerEvent;}
-	void processInput (const juce::AudioBuffer<float>& input)
+	void processInput (const juce::AudioBuffer<float>& /*input*/)
 	{}
     
 	//設定
@@ -76,13 +98,36 @@ class InputManager
 	bool isCalibrationEnabled() const { return channelManager.isCalibrationEnabled(); }
 	
 	// キャリブレーション実行（ノイズフロア測定開始）
+	// start / stop は要求を出すだけで、次の analyze（オーディオスレッド）が測定を始める・打ち切る。
+	// 測り終えた結果は applyCalibrationResult（メッセージスレッドから定期的に呼ぶ）でチャンネル設定に書く
 	void startCalibration();
 	void stopCalibration();
-	bool isCalibrating() const { return calibrating; }
+	bool isCalibrating() const { return calibrating.load() || calibrationRequest.load() == calibrationStart; }
+	bool applyCalibrationResult(); // 書いたら true
 	
-	// 録音状態（鎮火抑制用）
-	void setRecordingActive(bool active) { recordingActive = active; }
-	bool isRecordingActive() const { return recordingActive; }
+	// ノイズフロアの追従（キャリブレーションの代わりに常に測り続ける）
+	void setAdaptiveFloorEnabled(bool enabled) { channelManager.setAdaptiveFloorEnabled(enabled); }
+	bool isAdaptiveFloorEnabled() const { return channelManager.isAdaptiveFloorEnabled(); }
+
+	// 入力ペアごとのトリガー（切り替えると次のブロックで全ルートの状態を消す）
+	void setPerInputRouting(bool enabled) { config.perInputRouting = enabled; perInputRouting.store(enabled); }
+	bool isPerInputRouting() const        { return perInputRouting.load(); }
+
+	// 録音状態（鎮火抑制・ノイズフロアの学習停止用）。ルートごと。route なしは全ルート
+	void setRecordingActive(int route, bool active) { routeRecordingActive[(size_t)route].store(active); }
+	void setRecordingActive(bool active)
+	{
+		for (auto& r : routeRecordingActive)
+			r.store(active);
+	}
+	bool isRecordingActive(int route) const { return routeRecordingActive[(size_t)route].load(); }
+	bool isRecordingActive() const
+	{
+		for (auto& r : routeRecordingActive)
+			if (r.load())
+				return true;
+		return false;
+	}
 
 private:
 
@@ -94,38 +139,78 @@ private:
 	//内部ロジック
 	bool detectTriggerSample(const juce::AudioBuffer<float>& input);
 	
-	// マルチチャンネル対応のトリガー検出
-	bool detectMultiChannelTrigger(const juce::AudioBuffer<float>& input);
+	// チャンネル設定を検出器のレーンに写す。ルートごとの有効なレーンの最も低い閾値を routeLowestThreshold に入れる（鎮火判定用）
+	// 帯域トリガーのレーンは laneBands に帯域を入れる（-1 = 全帯域）
+	void configureDetectorLanes(int numInputChannels);
+	int routeOfChannel(int channel) const noexcept { return blockRouting ? channel / 2 : 0; }
+	
+	// ルート r の検出結果から、発火・再アーム・鎮火を進める
+	void updateRoute(int route, int numInputPairs);
+	
+	// 検出に使う信号: 帯域トリガーのチャンネルだけ帯域の包絡に置き換えたもの（bandScratch）
+	// 帯域トリガーがなければ input をそのまま返す
+	const juce::AudioBuffer<float>& makeDetectionInput(const juce::AudioBuffer<float>& input);
 	
-	long findSilenceStartAbs(long triggerAbsIndex);
-	long findAttackStartAbs(long triggerAbsIndex);
+	// トリガー位置から遡って、静かな区間（minSilenceMs）が終わった位置 / 勾配で見たアタックの始まり
+	// どちらも入力ペア inputPair のリングバッファ（ペアの |x| の最大）を見て、maxPreRollMs より前には戻らない
+	juce::int64 findSilenceStartAbs(juce::int64 triggerAbsIndex, int inputPair) const;
+	juce::int64 findAttackStartAbs(juce::int64 triggerAbsIndex, int inputPair) const;
+	int msToSamples(int ms) const noexcept { return (int)(sampleRate * ms / 1000.0); }
 	void updateStateMachine();
 
 	//===内部データ===
-    AudioInputBuffer inputBuffer; // Ring Buffer for 2-stage trigger
+    std::array<AudioInputBuffer, maxRoutes> inputBuffers; // Ring Buffer for 2-stage trigger（入力ペアごと）
+    TriggerDetector detector;     // レベル・プリロール・トリガーを1パスで
+    BandEnvelopeBank bandBank;    // 帯域トリガーの包絡
+    NoiseFloorTracker floorTracker; // チャンネルごとのノイズフロア（検出に使うレベルで追従）
     MultiChannelTriggerManager channelManager;  // マルチチャンネル設定
 
 	SmartRecConfig config;
-	juce::TriggerEvent triggerEvent;
+	std::array<juce::TriggerEvent, maxRoutes> routeEvents;
 
 	double sampleRate = 44100.0;
-	bool triggered = false;
+	std::array<bool, maxRoutes> routeTriggered {};       // 発火してから、プリロールが解けて再アームするまで
+	std::array<float, maxRoutes> routeLowestThreshold {};
+	std::atomic<bool> perInputRouting { false };         // UI が切り替える値。analyze の先頭で1回だけ読む
+	bool blockRouting = false;                           // このブロックの perInputRouting（analyze の中ではこれだけを見る）
+	std::atomic<bool> routingApplied { false };          // blockRouting を他のスレッドに見せる（getNumRoutes 等）
 	bool recording = false;
 	
 	float smoothedEnergy = 0.0f;
 	
+	// 検出器のレベル出力（analyze の作業用）
+	std::array<float, MAX_CHANNELS> blockLevels {};
+	
+	// 帯域トリガー（prepare で確保）
+	std::array<int, MAX_CHANNELS> laneBands {};       // レーンごとの帯域（-1 = 全帯域）
+	std::array<int, MAX_CHANNELS> laneBandsRunning {}; // 前のブロックで包絡を進めていた帯域（変わったら状態を消す）
+	std::array<float, MAX_CHANNELS> laneGains {};      // レーンのゲイン（帯域・ゲインが変わったらノイズフロアを測り直す）
+	juce::AudioBuffer<float> bandScratch;
+	int bandScratchCapacity = 0;
+	
 	// キャリブレーション用
-	bool calibrating = false;
+	// ピークは prepare で MAX_CHANNELS 分確保する。測定中（calibrating）はオーディオスレッドが書き、
+	// 結果を書き出している間（resultApplying）はオーディオスレッドが次の測定を始めない
+	enum CalibrationRequest : int { calibrationNone, calibrationStart, calibrationStop };
+	enum CalibrationResult : int { resultNone, resultReady, resultApplying };
+	std::atomic<int> calibrationRequest { calibrationNone };
+	std::atomic<bool> calibrating { false };
+	std::atomic<int> calibrationResult { resultNone };
 	int calibrationSampleCount = 0;
 	std::vector<float> calibrationPeaks;  // チャンネルごとのピーク値
+	std::vector<std::array<float, ChannelTriggerSettings::NUM_BANDS>> calibrationBandPeaks; // チャンネル × 帯域の包絡のピーク
+	void finishCalibration();
+	std::array<std::array<float, ChannelTriggerSettings::NUM_BANDS>, MAX_CHANNELS> blockBandPeaks {}; // analyze の作業用
 	
 	// 録音状態（鎮火抑制用）
-	bool recordingActive = false;
+	std::array<std::atomic<bool>, maxRoutes> routeRecordingActive {};
+	std::array<bool, MAX_CHANNELS> laneFrozen {}; // ノイズフロアを学習しないレーン（analyze の作業用）
 
 public:
-    // Lookback wrapper
-    void getLookbackData(juce::AudioBuffer<float>& dest) { inputBuffer.getLookbackData(dest); }
-    AudioInputBuffer& getInputBuffer() { return inputBuffer; }
+    // Lookback wrapper（リングを直接指すビュー。同じオーディオコールバックの中で使い切ること）
+    // 入力ペアごと。トリガーが先読みの開始位置を入れたペアだけ中身がある
+    AudioInputBuffer::LookbackView getLookback(int inputPair = 0) { return inputBuffers[(size_t)inputPair].getLookback(); }
+    AudioInputBuffer& getInputBuffer(int inputPair = 0) { return inputBuffers[(size_t)inputPair]; }
     
     float getCurrentLevel() const { return currentLevel.load(); }
     
@@ -136,9 +221,26 @@ public:
             return channelLevels[static_cast<size_t>(channel)].load();
         return 0.0f;
     }
+    
+    // 追従中のノイズフロア（マージン込み、0 = まだ）と、いまトリガーに使っている閾値（UI の描画用）
+    float getChannelNoiseFloor(int channel) const
+    {
+        if (channel >= 0 && channel < MAX_CHANNELS)
+            return channelNoiseFloors[static_cast<size_t>(channel)].load();
+        return 0.0f;
+    }
+    
+    float getChannelThreshold(int channel) const
+    {
+        if (channel >= 0 && channel < MAX_CHANNELS)
+            return channelThresholds[static_cast<size_t>(channel)].load();
+        return 0.0f;
+    }
 
 private:
     std::atomic<float> currentLevel { 0.0f };
     std::array<std::atomic<float>, MAX_CHANNELS> channelLevels {};  // チャンネルごとのレベル
+    std::array<std::atomic<float>, MAX_CHANNELS> channelNoiseFloors {};
+    std::array<std::atomic<float>, MAX_CHANNELS> channelThresholds {};
 };
 
@@ -2,114 +2,55 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include "InputManager.h"
 #include "SmartGate.h"
+#include "AllocationTripwire.h"
 
 //------------------------------------------------------------
-// 入力オーディオデータをキャプチャして保持するユーティリティ
+// 入力の解析（レベル計測・トリガー検出・先読みバッファ）
+// 以前は別の AudioIODeviceCallback として入力をコピーしていたが、ルーパー側の
+// コールバックとの間に同期がなく、古い/書きかけのブロックを録音することがあった。
+// 今は MainComponent::getNextAudioBlock（1本の duplex コールバック）から、
+// ルーパーが録音するのと同じブロックで process() を呼ぶ
 //------------------------------------------------------------
-class InputTap : public juce::AudioIODeviceCallback
+class InputTap
 {
 	public:
 
-	std::atomic<bool> triggerFlag = false;
-
 	InputTap() {	}
 
 	void prepare(double newSampleRate, int bufferSize)
 	{
 		sampleRate = newSampleRate;
-		buffer.setSize(2, bufferSize);
-		buffer.clear();
+		smartGate.setThresholds (0.015f,0.1f);
+		smartGate.setSpeeds(0.05f, 0.03f);
 
 		inputManager.prepare(sampleRate, bufferSize);
 
 	}
-	void process(const juce::AudioBuffer<float>& input);
 
-	void audioDeviceAboutToStart(juce::AudioIODevice* device) override
+	// オーディオスレッド専用: デバイス入力のブロックを解析する（トリガーはこのブロック内の位置で立つ）
+	// blockStartSample はルーパーの currentSamplePosition（トリガーの absIndex がルーパーの時計で付く）
+	void process(const juce::AudioBuffer<float>& input, juce::int64 blockStartSample)
 	{
-		const int inCh = device ? device->getActiveInputChannels().countNumberOfSetBits() : 0;
-		const int bufSize = device ? device->getCurrentBufferSizeSamples() : 512;
-		buffer.setSize(juce::jmax(1, inCh), bufSize);
-		buffer.clear();
-		//DBG("🎧 InputTap started: channels=" << inCh << " bufferSize=" << bufSize);
-	}
-
-	// ✅ JUCE 7.0.5以降（macOS含む）で使用
-	void audioDeviceIOCallbackWithContext(const float* const* inputChannelData,
-										  int numInputChannels,
-										  float* const* outputChannelData,
-										  int numOutputChannels,
-										  int numSamples,
-										  const juce::AudioIODeviceCallbackContext&) override
-	{
-		juce::ignoreUnused(outputChannelData, numOutputChannels);
-		if (numInputChannels == 0) return;
-
-		buffer.setSize(numInputChannels, numSamples, false, false, true);
-		smartGate.setThresholds (0.015f,0.1f);
-		smartGate.setSpeeds(0.05f, 0.03f);
+		allocation_tripwire::ScopedAudioThread noAllocations;
 
-
-		for (int ch = 0; ch < numInputChannels; ++ch)
-		{
-			if (inputChannelData[ch] != nullptr)
-				buffer.copyFrom(ch, 0, inputChannelData[ch], numSamples);
-		}
+		if (input.getNumChannels() == 0 || input.getNumSamples() == 0) return;
 
 		//smartGate.processBlock(buffer,buffer);
 
-		updateInputLevel(buffer);
-
-		inputManager.analyze(buffer);
-
-
-		// 🎙️ 音声レベルチェック
-		if (numInputChannels > 0 && inputChannelData[0] != nullptr)
-		{
-			auto range = juce::FloatVectorOperations::findMinAndMax(inputChannelData[0], numSamples);
-			if (std::abs(range.getStart()) > 0.001f || std::abs(range.getEnd()) > 0.001f)
-			{
-//				DBG("🎙️ Input active | range: "
-//					<< range.getStart() << " ~ " << range.getEnd());
-			}
-		}
-//		if(inputManager.getTriggerEvent().triggerd)
-//			triggerFlag.store(true);
+		updateInputLevel(input);
 
+		inputManager.analyze(input, blockStartSample);
 	}
 
-
-	// ✅ JUCE 7.0.4以前（もしくは別環境）用の後方互換
-	void audioDeviceIOCallback(const float* const* inputChannelData,
-							   int numInputChannels,
-							   float* const* outputChannelData,
-							   int numOutputChannels,
-							   int numSamples) 
-	{
-		juce::ignoreUnused(outputChannelData, numOutputChannels);
-		captureInput(inputChannelData, numInputChannels, numSamples);
-		
-	}
-
-	void audioDeviceStopped() override
-	{
-		buffer.setSize(0, 0);
-		//DBG("🛑 InputTap stopped");
-	}
-
-	void getLatestInput(juce::AudioBuffer<float>& dest)
-	{
-		const int channels = juce::jmin(dest.getNumChannels(), buffer.getNumChannels());
-		const int samples  = juce::jmin(dest.getNumSamples(),  buffer.getNumSamples());
-		for (int ch = 0; ch < channels; ++ch)
-			dest.copyFrom(ch, 0, buffer, ch, 0, samples);
-	}
 	void resetTriggerEvent()
 	{
-		auto& trig = inputManager.getTriggerEvent();
-		trig.triggerd = false;
-		trig.sampleInBlock = -1;
-		trig.absIndex = -1;
+		for (int route = 0; route < InputManager::maxRoutes; ++route)
+		{
+			auto& trig = inputManager.getRouteTriggerEvent(route);
+			trig.triggerd = false;
+			trig.sampleInBlock = -1;
+			trig.absIndex = -1;
+		}
 	}
 
 
@@ -125,7 +66,6 @@ class InputTap : public juce::AudioIODeviceCallback
 	}
 
 private:
-	juce::AudioBuffer<float> buffer;
 	InputManager inputManager;
 	SmartGate smartGate;
 
@@ -147,25 +87,5 @@ private:
 		else
 			currentInputLevel.store(current * decayRate + rms * (1.0f - decayRate));
 	}
-
-	void captureInput(const float* const* inputChannelData, int numInputChannels, int numSamples)
-	{
-		if (numInputChannels == 0)
-			return;
-
-		buffer.setSize(numInputChannels, numSamples, false, false, true);
-		for (int ch = 0; ch < numInputChannels; ++ch)
-		{
-			if (inputChannelData[ch] != nullptr)
-				buffer.copyFrom(ch, 0, inputChannelData[ch], numSamples);
-		}
-		
-		updateInputLevel(buffer);
-
-		// 🎙️ Debugログ（入力検知）
-		//auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(0), numSamples);
-		//if (std::abs(range.getStart()) > 0.001f || std::abs(range.getEnd()) > 0.001f)
-		//	DBG("🎙️ InputTap active | range: " << range.getStart() << " ~ " << range.getEnd());
-	}
 };
 
@@ -13,6 +13,7 @@ public:
     static constexpr const char* ACTION_REC = "rec";
     static constexpr const char* ACTION_PLAY = "play";
     static constexpr const char* ACTION_UNDO = "undo";
+    static constexpr const char* ACTION_REDO = "redo";
     static constexpr const char* ACTION_TRACK_1 = "track_1";
     static constexpr const char* ACTION_TRACK_2 = "track_2";
     static constexpr const char* ACTION_TRACK_3 = "track_3";
@@ -24,6 +25,7 @@ public:
     static constexpr const char* ACTION_AUTO_ARM = "auto_arm";
     static constexpr const char* ACTION_VISUAL_MODE = "visual_mode";
     static constexpr const char* ACTION_FX_MODE = "fx_mode";
+    static constexpr const char* ACTION_DSP_LOAD = "dsp_load";
     
     // FXトグルアクションはgetAllActions()で動的生成
     // パターン: fx_t{trackId}_slot{slotId}_bypass, fx_t{trackId}_filter_type, fx_t{trackId}_repeat_active
@@ -60,6 +62,7 @@ public:
             { ACTION_REC, "REC (Record)" },
             { ACTION_PLAY, "PLAY" },
             { ACTION_UNDO, "UNDO" },
+            { ACTION_REDO, "REDO" },
             { ACTION_TRACK_1, "Track 1 Select" },
             { ACTION_TRACK_2, "Track 2 Select" },
             { ACTION_TRACK_3, "Track 3 Select" },
@@ -70,7 +73,8 @@ public:
             { ACTION_TRACK_8, "Track 8 Select" },
             { ACTION_AUTO_ARM, "AUTO-ARM Toggle" },
             { ACTION_VISUAL_MODE, "VISUAL MODE Toggle" },
-            { ACTION_FX_MODE, "FX MODE Toggle" }
+            { ACTION_FX_MODE, "FX MODE Toggle" },
+            { ACTION_DSP_LOAD, "DSP LOAD Overlay Toggle" }
         };
         
         // FXトグルアクションを動的生成（8トラック × 6アクション = 48個）
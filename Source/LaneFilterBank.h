@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    LaneFilterBank.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック横断の State Variable フィルタ（最大8トラック = 16レーン、オーディオスレッド専用）
+    - juce::dsp::StateVariableTPTFilter と同じ式・同じ係数。L / R を1レーンずつ SIMDRegister に並べ、
+      8トラック分を1回のパスで回す（レーンごとに cutoff / resonance / type が違ってよい）
+    - type はレーンごとの LP / BP / HP の重み（0 / 1）で選ぶので、分岐なしで混在できる
+    - トラックのバッファからレーン並びへは chunkSize サンプルずつ詰め替える
+    - レーン = スロット % maxTracks に固定し、状態はブロックをまたいでそのレーンに残る
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <cmath>
+
+class LaneFilterBank
+{
+public:
+	using Register = juce::dsp::SIMDRegister<float>;
+	using Type = juce::dsp::StateVariableTPTFilterType;
+
+	static constexpr int maxTracks = 8;
+	static constexpr int maxLanes = maxTracks * 2;                      // L / R で1レーンずつ
+	static constexpr int laneWidth = (int)Register::SIMDNumElements;    // SSE / NEON = 4、AVX = 8
+	static constexpr int numRegisters = (maxLanes + laneWidth - 1) / laneWidth;
+	static constexpr int numPaddedLanes = numRegisters * laneWidth;
+
+	// トラック t の L / R = lanes[2t], lanes[2t + 1]。nullptr のトラックは処理しない
+	using LanePointers = std::array<float*, maxLanes>;
+
+	// メッセージスレッドで呼ぶ
+	void prepare(double newSampleRate)
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		for (auto& p : trackParams)
+			p = {};
+		for (int track = 0; track < maxTracks; ++track)
+			setParameters(track, 1000.0f, 1.0f / juce::MathConstants<float>::sqrt2, Type::lowpass);
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		std::fill(s1.begin(), s1.end(), 0.0f);
+		std::fill(s2.begin(), s2.end(), 0.0f);
+	}
+
+	void resetTrack(int track) noexcept
+	{
+		for (int lane = track * 2; lane < track * 2 + 2; ++lane)
+			s1[(size_t)lane] = s2[(size_t)lane] = 0.0f;
+	}
+
+	// 値が変わったときだけ係数を計算し直す（毎ブロック呼んでよい）
+	void setParameters(int track, float cutoff, float resonance, Type type) noexcept
+	{
+		auto& p = trackParams[(size_t)track];
+		if (p.cutoff == cutoff && p.resonance == resonance && p.type == type)
+			return;
+		p = { cutoff, resonance, type };
+
+		const auto g = (float)std::tan(juce::MathConstants<double>::pi * cutoff / sampleRate);
+		const auto r2 = 1.0f / resonance;
+		const auto h = 1.0f / (1.0f + r2 * g + g * g);
+
+		for (int lane = track * 2; lane < track * 2 + 2; ++lane)
+		{
+			coefG[(size_t)lane] = g;
+			coefGR[(size_t)lane] = g + r2;
+			coefH[(size_t)lane] = h;
+			mixLP[(size_t)lane] = type == Type::lowpass ? 1.0f : 0.0f;
+			mixBP[(size_t)lane] = type == Type::bandpass ? 1.0f : 0.0f;
+			mixHP[(size_t)lane] = type == Type::highpass ? 1.0f : 0.0f;
+		}
+	}
+
+	// 各レーンの先頭 numSamples をその場で置き換える
+	void process(const LanePointers& lanes, int numSamples) noexcept
+	{
+		// 使っているレーンが1つもないレジスタは飛ばす。使っていないレーンには 0 を流す
+		std::array<bool, numRegisters> active {};
+		for (int lane = 0; lane < maxLanes; ++lane)
+			active[(size_t)(lane / laneWidth)] |= lanes[(size_t)lane] != nullptr;
+
+		for (int offset = 0; offset < numSamples; offset += chunkSize)
+		{
+			const int n = juce::jmin(chunkSize, numSamples - offset);
+
+			// --- 1. 詰める: frames[i] = サンプル i の全レーン ---
+			for (int lane = 0; lane < maxLanes; ++lane)
+			{
+				if (!active[(size_t)(lane / laneWidth)])
+					continue;
+				if (const float* src = lanes[(size_t)lane])
+					for (int i = 0; i < n; ++i)
+						frames[(size_t)i][(size_t)lane] = src[offset + i];
+				else
+					for (int i = 0; i < n; ++i)
+						frames[(size_t)i][(size_t)lane] = 0.0f;
+			}
+
+			// --- 2. レジスタ単位で TPT SVF ---
+			for (int r = 0; r < numRegisters; ++r)
+				if (active[(size_t)r])
+					processRegister(r, n);
+
+			// --- 3. 戻す ---
+			for (int lane = 0; lane < maxLanes; ++lane)
+				if (float* dest = lanes[(size_t)lane])
+					for (int i = 0; i < n; ++i)
+						dest[offset + i] = frames[(size_t)i][(size_t)lane];
+		}
+
+		// StateVariableTPTFilter::snapToZero と同じ（デノーマル対策）
+		for (int lane = 0; lane < maxLanes; ++lane)
+		{
+			juce::dsp::util::snapToZero(s1[(size_t)lane]);
+			juce::dsp::util::snapToZero(s2[(size_t)lane]);
+		}
+	}
+
+private:
+	static constexpr int chunkSize = 64;   // 詰め替え用の作業領域（サンプル数）
+
+	struct TrackParams
+	{
+		float cutoff = -1.0f;
+		float resonance = -1.0f;
+		Type type = Type::lowpass;
+	};
+
+	using LaneArray = std::array<float, (size_t)numPaddedLanes>;
+
+	void processRegister(int r, int n) noexcept
+	{
+		const size_t base = (size_t)(r * laneWidth);
+		const auto g   = Register::fromRawArray(coefG.data() + base);
+		const auto gr  = Register::fromRawArray(coefGR.data() + base);
+		const auto h   = Register::fromRawArray(coefH.data() + base);
+		const auto mLP = Register::fromRawArray(mixLP.data() + base);
+		const auto mBP = Register::fromRawArray(mixBP.data() + base);
+		const auto mHP = Register::fromRawArray(mixHP.data() + base);
+		auto z1 = Register::fromRawArray(s1.data() + base);
+		auto z2 = Register::fromRawArray(s2.data() + base);
+
+		for (int i = 0; i < n; ++i)
+		{
+			float* frame = frames[(size_t)i].data() + base;
+			const auto x = Register::fromRawArray(frame);
+
+			const auto yHP = h * (x - z1 * gr - z2);
+			const auto yBP = yHP * g + z1;
+			z1 = yHP * g + yBP;
+			const auto yLP = yBP * g + z2;
+			z2 = yBP * g + yLP;
+
+			(yLP * mLP + yBP * mBP + yHP * mHP).copyToRawArray(frame);
+		}
+
+		z1.copyToRawArray(s1.data() + base);
+		z2.copyToRawArray(s2.data() + base);
+	}
+
+	double sampleRate = 44100.0;
+	std::array<TrackParams, maxTracks> trackParams {};
+
+	// レーンごとの係数と状態（パディングのレーンは 0 のまま）
+	alignas(Register::SIMDRegisterSize) LaneArray coefG {};
+	alignas(Register::SIMDRegisterSize) LaneArray coefGR {};
+	alignas(Register::SIMDRegisterSize) LaneArray coefH {};
+	alignas(Register::SIMDRegisterSize) LaneArray mixLP {};
+	alignas(Register::SIMDRegisterSize) LaneArray mixBP {};
+	alignas(Register::SIMDRegisterSize) LaneArray mixHP {};
+	alignas(Register::SIMDRegisterSize) LaneArray s1 {};
+	alignas(Register::SIMDRegisterSize) LaneArray s2 {};
+	alignas(Register::SIMDRegisterSize) std::array<LaneArray, chunkSize> frames {};
+};
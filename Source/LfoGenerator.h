@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    LfoGenerator.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    Tremolo / Slicer 共用の LFO・ゲート（状態なし、オーディオスレッドから呼ぶ）
+    - 1ブロック分のゲインをまとめて作り、FloatVectorOperations でまとめて掛ける
+    - 波形は事前計算したウェーブテーブルを線形補間で引く（サンプルごとの sin / cos・switch なし）
+    - 矩形・ゲートは倍音を 32 次で打ち切った帯域制限版（角が丸く、クリックが出ない）
+      デューティ付きゲートは帯域制限ノコギリ波2本の差で作る
+    - 位相はブロック先頭の値（double）だけ呼び出し側が持ち、ブロック内は float で進める
+      同期中はループ上の再生位置から位相を決める（ループの途中から再生しても揃う）
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+
+class LfoGenerator
+{
+public:
+	enum class Shape
+	{
+		sine = 0,    // Tremolo: SINE
+		square,      // Tremolo: SQUARE（デューティ 50%）
+		triangle,    // Tremolo: TRI
+		gate,        // Slicer: Square（デューティ付き）
+		smoothGate   // Slicer: Smooth（開閉をデューティの 10% でフェード）
+	};
+
+	// テーブルの初期化をオーディオスレッドに持ち込まないよう、起動時に一度呼んでおく
+	static void prepareTables() noexcept
+	{
+		getTables();
+	}
+
+	// buffer の全チャンネル先頭 numSamples に 1 - depth * (1 - lfo) を掛ける。次のブロック先頭の位相（0-1）を返す
+	static double process(juce::AudioBuffer<float>& buffer, int numSamples, Shape shape,
+	                      double phase, double increment, float duty, float depth) noexcept
+	{
+		std::array<float, chunkSize> gains;
+
+		for (int offset = 0; offset < numSamples; offset += chunkSize)
+		{
+			const int n = juce::jmin(chunkSize, numSamples - offset);
+			phase = renderGains(shape, phase, increment, duty, depth, gains.data(), n);
+
+			for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+				juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch, offset), gains.data(), n);
+		}
+		return phase;
+	}
+
+	// gains[i] = 1 - depth * (1 - lfo(phase + i * increment))。次のブロック先頭の位相（0-1）を返す
+	static double renderGains(Shape shape, double phase, double increment, float duty, float depth,
+	                          float* gains, int numSamples) noexcept
+	{
+		const auto& t = getTables();
+		const float start = (float)(phase - std::floor(phase));
+		const float step = (float)increment;
+
+		switch (shape)
+		{
+			case Shape::sine:       lookup(t.sine.data(), start, step, gains, numSamples); break;
+			case Shape::square:     lookup(t.square.data(), start, step, gains, numSamples); break;
+			case Shape::triangle:   lookup(t.triangle.data(), start, step, gains, numSamples); break;
+			case Shape::gate:       renderGate(t, start, step, duty, gains, numSamples); break;
+			case Shape::smoothGate: renderSmoothGate(t, start, step, duty, gains, numSamples); break;
+		}
+
+		// lfo → ゲイン（SIMD）
+		const float d = juce::jlimit(0.0f, 1.0f, depth);
+		juce::FloatVectorOperations::multiply(gains, d, numSamples);
+		juce::FloatVectorOperations::add(gains, 1.0f - d, numSamples);
+
+		const double next = phase + increment * numSamples;
+		return next - std::floor(next);
+	}
+
+	// ループ位置に揃えた位相: loopLength サンプルで cyclesPerLoop 周する LFO の、position における位相
+	static double phaseAtLoopPosition(juce::int64 position, int loopLength, double cyclesPerLoop) noexcept
+	{
+		if (loopLength <= 0)
+			return 0.0;
+		const double phase = (double)position * cyclesPerLoop / (double)loopLength;
+		return phase - std::floor(phase);
+	}
+
+private:
+	static constexpr int chunkSize = 512;   // スタック上のゲイン領域（サンプル数）
+	static constexpr int tableSize = 2048;
+	static constexpr int numHarmonics = 32;
+
+	struct Tables
+	{
+		std::array<float, tableSize + 1> sine {}, square {}, triangle {}, saw {}, edge {};
+	};
+
+	static const Tables& getTables() noexcept
+	{
+		static const Tables tables = []
+		{
+			Tables t;
+			const double twoPi = juce::MathConstants<double>::twoPi;
+
+			for (int i = 0; i <= tableSize; ++i)
+			{
+				const double p = (double)i / tableSize;
+
+				// 0-1 の範囲。p = 0 で sine / triangle は中央 / 最小、square は開いた直後
+				t.sine[(size_t)i] = (float)(0.5 + 0.5 * std::sin(twoPi * p));
+
+				double square = 0.5, triangle = 0.5, saw = 0.0;
+				for (int k = 1; k <= numHarmonics; ++k)
+				{
+					// Lanczos の σ で打ち切りのリンギング（ギブス現象）を抑える
+					const double x = juce::MathConstants<double>::pi * k / (numHarmonics + 1);
+					const double sigma = std::sin(x) / x;
+
+					saw -= sigma * std::sin(twoPi * k * p) / (juce::MathConstants<double>::pi * k);
+					if (k % 2 == 1)
+					{
+						square += sigma * 2.0 / (juce::MathConstants<double>::pi * k) * std::sin(twoPi * k * p);
+						triangle -= 4.0 / (juce::MathConstants<double>::pi * juce::MathConstants<double>::pi * k * k) * std::cos(twoPi * k * p);
+					}
+				}
+
+				t.square[(size_t)i] = (float)square;
+				t.triangle[(size_t)i] = (float)triangle;
+				t.saw[(size_t)i] = (float)saw;                                          // ≒ frac(p) - 0.5
+				t.edge[(size_t)i] = (float)(0.5 - 0.5 * std::cos(juce::MathConstants<double>::pi * p)); // 0 → 1 の半周 cos
+			}
+			return t;
+		}();
+		return tables;
+	}
+
+	static float wrap(float p) noexcept { return p - std::floor(p); }
+
+	static float read(const float* table, float p) noexcept
+	{
+		const float index = p * (float)tableSize;
+		const int i0 = juce::jmin((int)index, tableSize - 1);
+		const float frac = index - (float)i0;
+		return table[i0] + frac * (table[i0 + 1] - table[i0]);
+	}
+
+	static void lookup(const float* table, float start, float step, float* dest, int n) noexcept
+	{
+		for (int i = 0; i < n; ++i)
+			dest[i] = read(table, wrap(start + step * (float)i));
+	}
+
+	// 開 (1) = phase < duty。saw(p) ≒ frac(p) - 0.5 なので duty - saw(p) + saw(p - duty) が 0 / 1 の矩形になる
+	static void renderGate(const Tables& t, float start, float step, float duty, float* dest, int n) noexcept
+	{
+		const float d = juce::jlimit(0.0f, 1.0f, duty);
+		for (int i = 0; i < n; ++i)
+		{
+			const float p = wrap(start + step * (float)i);
+			const float g = d - read(t.saw.data(), p) + read(t.saw.data(), wrap(p - d + 1.0f));
+			dest[i] = juce::jlimit(0.0f, 1.0f, g);
+		}
+	}
+
+	// 開き始めと閉じる手前の fade（= デューティの 10%）を半周 cos でつなぐ
+	static void renderSmoothGate(const Tables& t, float start, float step, float duty, float* dest, int n) noexcept
+	{
+		const float d = juce::jlimit(0.0f, 1.0f, duty);
+		const float inverseFade = 1.0f / juce::jmax(1.0e-4f, 0.1f * d);
+		for (int i = 0; i < n; ++i)
+		{
+			const float p = wrap(start + step * (float)i);
+			const float rise = read(t.edge.data(), juce::jlimit(0.0f, 1.0f, p * inverseFade));
+			const float fall = read(t.edge.data(), juce::jlimit(0.0f, 1.0f, (d - p) * inverseFade));
+			dest[i] = juce::jmin(rise, fall);
+		}
+	}
+};
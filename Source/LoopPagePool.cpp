@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    LoopPagePool.cpp
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+  ==============================================================================
+*/
+
+#include "LoopPagePool.h"
+
+#if defined(_WIN32)
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+#endif
+
+namespace
+{
+	// スワップアウトされないようにページを固定する（失敗しても動作は続ける）
+	bool lockPages(void* data, size_t bytes)
+	{
+	   #if defined(_WIN32)
+		// VirtualLock はワーキングセットの最小値までしか固定できないので先に広げる
+		SIZE_T minSize = 0, maxSize = 0;
+		auto process = GetCurrentProcess();
+		if (GetProcessWorkingSetSize(process, &minSize, &maxSize))
+			SetProcessWorkingSetSize(process, minSize + bytes, juce::jmax(maxSize, minSize + bytes));
+
+		return VirtualLock(data, bytes) != 0;
+	   #else
+		return mlock(data, bytes) == 0;
+	   #endif
+	}
+
+	void unlockPages(void* data, size_t bytes)
+	{
+	   #if defined(_WIN32)
+		VirtualUnlock(data, bytes);
+	   #else
+		munlock(data, bytes);
+	   #endif
+	}
+}
+
+bool LoopPagePool::allocate(int totalSamples, int samplesPerPage, bool lockMemory)
+{
+	jassert(freeCount == numPages); // 貸し出し中のページがあってはいけない
+	releaseMemory();
+
+	pageSize = juce::jmax(256, samplesPerPage);
+	numPages = juce::jmax(1, (totalSamples + pageSize - 1) / pageSize);
+
+	const size_t floatsPerPage = (size_t)pageSize * (size_t)numChannels;
+	const size_t totalFloats = floatsPerPage * (size_t)numPages;
+
+	storage.malloc(totalFloats);
+	freeList.malloc((size_t)numPages);
+	refCounts.calloc((size_t)numPages);
+
+	if (storage == nullptr || freeList == nullptr || refCounts == nullptr)
+	{
+		DBG("❌ LoopPagePool: failed to allocate " << numPages << " pages");
+		storage.free();
+		freeList.free();
+		refCounts.free();
+		numPages = 0;
+		freeCount = 0;
+		numFreePages.store(0);
+		return false;
+	}
+
+	storageBytes = totalFloats * sizeof(float);
+
+	// プリフォルト: 全ページに書き込んで物理メモリを割り当てさせる
+	// (録音中に初めて触ったページでページフォルトが起きないように)
+	// 先頭ページから順に貸し出されるよう、フリーリストには末尾から積む
+	for (int i = 0; i < numPages; ++i)
+	{
+		float* page = storage.get() + floatsPerPage * (size_t)i;
+		juce::FloatVectorOperations::clear(page, (int)floatsPerPage);
+		freeList[numPages - 1 - i] = page;
+	}
+
+	if (lockMemory)
+	{
+		memoryLocked = lockPages(storage.get(), storageBytes);
+		if (!memoryLocked)
+			DBG("⚠️ LoopPagePool: memory lock failed (" << (juce::int64)(storageBytes / (1024 * 1024)) << " MB), continuing unlocked");
+	}
+
+	freeCount = numPages;
+	numFreePages.store(freeCount);
+
+	DBG("📄 LoopPagePool: " << numPages << " pages x " << pageSize << " samples ("
+		<< (juce::int64)(storageBytes / (1024 * 1024)) << " MB" << (memoryLocked ? ", locked)" : ")"));
+	return true;
+}
+
+void LoopPagePool::releaseMemory()
+{
+	if (memoryLocked && storage != nullptr)
+		unlockPages(storage.get(), storageBytes);
+
+	memoryLocked = false;
+	storage.free();
+	freeList.free();
+	refCounts.free();
+	storageBytes = 0;
+	numPages = 0;
+	freeCount = 0;
+	numFreePages.store(0);
+}
@@ -0,0 +1,333 @@
+/*
+  ==============================================================================
+
+    LoopPagePool.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    ループ音声のページ管理
+    - LoopPagePool: 固定サイズページ（ステレオ）を起動時にまとめて確保し、
+      全ページに書き込んでプリフォルトしておく（任意で mlock / VirtualLock）
+    - PagedLoopBuffer: トラックごとのページ表。録音で伸びた分だけページを借り、
+      縮めたら返す。どちらもオーディオスレッドで確保しない（O(ページ数)のポインタ操作のみ）
+    - ページは参照カウント付き。UNDO履歴は shareFrom でページ表を共有するだけで、
+      共有中のページに書き込むときに初めて複製する（コピーオンライト）
+
+    ページの貸し借りはオーディオスレッドだけが行う（コマンド適用・録音中）。
+    allocate / attach はオーディオ開始前のメッセージスレッド専用。
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+class LoopPagePool
+{
+public:
+	static constexpr int numChannels = 2;
+	static constexpr int defaultPageSize = 4096; // 1ページ = 4096サンプル x 2ch (32KB)
+
+	LoopPagePool() = default;
+	~LoopPagePool() { releaseMemory(); }
+
+	// totalSamples 分（1chあたり）のページを確保してプリフォルトする
+	// 使用中のページがある状態で呼んではいけない
+	bool allocate(int totalSamples, int samplesPerPage, bool lockMemory);
+	void releaseMemory();
+
+	int  getPageSize() const noexcept      { return pageSize; }
+	int  getNumPages() const noexcept      { return numPages; }
+	int  getNumFreePages() const noexcept  { return numFreePages.load(std::memory_order_relaxed); }
+	int  getTotalSamples() const noexcept  { return numPages * pageSize; }
+	bool isMemoryLocked() const noexcept   { return memoryLocked; }
+
+	// ===== オーディオスレッド専用 =====
+	float* claimPage() noexcept
+	{
+		if (freeCount == 0)
+			return nullptr;
+
+		numFreePages.store(--freeCount, std::memory_order_relaxed);
+		float* page = freeList[freeCount];
+		refCounts[pageIndex(page)] = 1;
+		return page;
+	}
+
+	// 参照を1つ足す（ページ表の共有）
+	void retainPage(float* page) noexcept
+	{
+		jassert(page != nullptr && refCounts[pageIndex(page)] > 0);
+		++refCounts[pageIndex(page)];
+	}
+
+	// 参照を1つ減らし、誰も使わなくなったらフリーリストに戻す
+	void releasePage(float* page) noexcept
+	{
+		jassert(page != nullptr && refCounts[pageIndex(page)] > 0);
+		if (--refCounts[pageIndex(page)] > 0)
+			return;
+
+		jassert(freeCount < numPages);
+		freeList[freeCount++] = page;
+		numFreePages.store(freeCount, std::memory_order_relaxed);
+	}
+
+	bool isShared(const float* page) const noexcept { return refCounts[pageIndex(page)] > 1; }
+
+private:
+	size_t pageIndex(const float* page) const noexcept
+	{
+		return (size_t)(page - storage.get()) / ((size_t)pageSize * (size_t)numChannels);
+	}
+
+	juce::HeapBlock<float> storage;
+	juce::HeapBlock<float*> freeList;
+	juce::HeapBlock<int> refCounts; // ページごとの参照数（オーディオスレッドだけが触る）
+	size_t storageBytes = 0;
+
+	int pageSize = defaultPageSize;
+	int numPages = 0;
+	int freeCount = 0;
+	std::atomic<int> numFreePages { 0 }; // UI表示用
+	bool memoryLocked = false;
+
+	JUCE_DECLARE_NON_COPYABLE (LoopPagePool)
+};
+
+//==============================================================================
+// トラック1本分のページ表。AudioBuffer と同じ感覚で使える最小限の API を持つ。
+// 長さの外側の読み出しは無音、書き込みは捨てる（ページが足りないときも落ちない）
+class PagedLoopBuffer
+{
+public:
+	PagedLoopBuffer() = default;
+	~PagedLoopBuffer() { setSize(0); }
+
+	// プールに紐付けてページ表を確保する（メッセージスレッド、ページを持っていないとき）
+	void attach(LoopPagePool* newPool)
+	{
+		jassert(numPages == 0);
+		pool = newPool;
+		pageSize = pool != nullptr ? pool->getPageSize() : LoopPagePool::defaultPageSize;
+		pageCapacity = pool != nullptr ? pool->getNumPages() : 0;
+		pages.calloc((size_t)juce::jmax(1, pageCapacity));
+		numSamples = 0;
+	}
+
+	int getNumChannels() const noexcept { return LoopPagePool::numChannels; }
+	int getNumSamples() const noexcept  { return numSamples; }
+	int getNumPages() const noexcept    { return numPages; }
+
+	// 長さを変える。伸ばした分は無音になる。足りないページはプールから借り、
+	// 余ったページは返す。プールが足りなければ何もせず false
+	bool setSize(int newNumSamples) noexcept
+	{
+		newNumSamples = juce::jmax(0, newNumSamples);
+		const int pagesNeeded = (newNumSamples + pageSize - 1) / pageSize;
+
+		if (pagesNeeded > numPages)
+		{
+			// 末尾ページが共有中なら、伸ばした分の無音化で複製するぶんも要る
+			const int tailCopy = (numPages > 0 && pool->isShared(pages[numPages - 1])) ? 1 : 0;
+
+			if (pool == nullptr || pagesNeeded > pageCapacity
+				|| pagesNeeded - numPages + tailCopy > pool->getNumFreePages())
+				return false;
+
+			while (numPages < pagesNeeded)
+				pages[numPages++] = pool->claimPage();
+		}
+		else
+		{
+			while (numPages > pagesNeeded)
+				pool->releasePage(pages[--numPages]);
+		}
+
+		if (newNumSamples > numSamples)
+			clearRange(numSamples, newNumSamples - numSamples);
+
+		numSamples = newNumSamples;
+		return true;
+	}
+
+	void clear() noexcept { clearRange(0, numSamples); }
+
+	float getSample(int ch, int index) const noexcept
+	{
+		if (index < 0 || index >= numSamples)
+			return 0.0f;
+		return channelPtr(index / pageSize, ch)[index % pageSize];
+	}
+
+	// index を含むページの L / R の先頭と、そのページが受け持つ範囲 [spanStart, spanEnd) を返す
+	// （1サンプルずつ読む処理がページをまたぐまで割り算なしで読めるように）。長さの外なら false
+	bool getReadSpan(int index, const float*& left, const float*& right, int& spanStart, int& spanEnd) const noexcept
+	{
+		if (index < 0 || index >= numSamples)
+			return false;
+
+		const int page = index / pageSize;
+		left = channelPtr(page, 0);
+		right = channelPtr(page, 1);
+		spanStart = page * pageSize;
+		spanEnd = juce::jmin(spanStart + pageSize, numSamples);
+		return true;
+	}
+
+	void setSample(int ch, int index, float value) noexcept
+	{
+		if (index >= 0 && index < numSamples && makePageWritable(index / pageSize))
+			channelPtr(index / pageSize, ch)[index % pageSize] = value;
+	}
+
+	// 録音: src → このバッファ
+	void copyFrom(int destCh, int destStart, const juce::AudioBuffer<float>& src,
+				  int srcCh, int srcStart, int num) noexcept
+	{
+		const float* s = src.getReadPointer(srcCh, srcStart);
+		forEachSpan(destStart, num, [&](int page, int pageOffset, int spanOffset, int len)
+		{
+			if (makePageWritable(page))
+				juce::FloatVectorOperations::copy(channelPtr(page, destCh) + pageOffset, s + spanOffset, len);
+		});
+	}
+
+	// 録音: 連続したサンプル列 → このバッファ（先読みのリングなど AudioBuffer でない入力から）
+	void copyFrom(int destCh, int destStart, const float* src, int num) noexcept
+	{
+		forEachSpan(destStart, num, [&](int page, int pageOffset, int spanOffset, int len)
+		{
+			if (makePageWritable(page))
+				juce::FloatVectorOperations::copy(channelPtr(page, destCh) + pageOffset, src + spanOffset, len);
+		});
+	}
+
+	// 再生: このバッファ * gain → dest に加算
+	void addTo(juce::AudioBuffer<float>& dest, int destCh, int destStart,
+			   int srcCh, int srcStart, int num, float gain) const noexcept
+	{
+		float* d = dest.getWritePointer(destCh, destStart);
+		forEachSpan(srcStart, num, [&](int page, int pageOffset, int spanOffset, int len)
+		{
+			juce::FloatVectorOperations::addWithMultiply(d + spanOffset, channelPtr(page, srcCh) + pageOffset, gain, len);
+		});
+	}
+
+	// 連続したバッファに書き出す（ビジュアライザ・書き出し用。dest を確保するのでメッセージスレッドで）
+	void copyTo(juce::AudioBuffer<float>& dest) const
+	{
+		dest.setSize(getNumChannels(), numSamples);
+		for (int ch = 0; ch < getNumChannels(); ++ch)
+		{
+			float* d = dest.getWritePointer(ch);
+			forEachSpan(0, numSamples, [&](int page, int pageOffset, int spanOffset, int len)
+			{
+				juce::FloatVectorOperations::copy(d + spanOffset, channelPtr(page, ch) + pageOffset, len);
+			});
+		}
+	}
+
+	// other と同じ内容にする。ページは参照を足して共有するだけでコピーしない
+	// （どちらかが書き込むときに、そのページだけ複製される）
+	void shareFrom(const PagedLoopBuffer& other) noexcept
+	{
+		jassert(pool == other.pool && other.numPages <= pageCapacity);
+		setSize(0);
+
+		for (int i = 0; i < other.numPages; ++i)
+		{
+			pages[i] = other.pages[i];
+			pool->retainPage(pages[i]);
+		}
+
+		numPages = other.numPages;
+		numSamples = other.numSamples;
+	}
+
+	// ページ表ごと入れ替える（同じプールに紐付いていること）
+	void swapWith(PagedLoopBuffer& other) noexcept
+	{
+		jassert(pool == other.pool);
+		pages.swapWith(other.pages);
+		std::swap(pageCapacity, other.pageCapacity);
+		std::swap(numPages, other.numPages);
+		std::swap(numSamples, other.numSamples);
+	}
+
+private:
+	float* channelPtr(int page, int ch) const noexcept
+	{
+		return pages[page] + (size_t)ch * (size_t)pageSize;
+	}
+
+	// 共有中のページなら自分用に複製してから書き込む。プールが空なら false（書き込みは捨てる）
+	bool makePageWritable(int page) noexcept
+	{
+		float*& p = pages[page];
+		if (!pool->isShared(p))
+			return true;
+
+		float* copy = pool->claimPage();
+		if (copy == nullptr)
+			return false;
+
+		juce::FloatVectorOperations::copy(copy, p, pageSize * getNumChannels());
+		pool->releasePage(p);
+		p = copy;
+		return true;
+	}
+
+	// [start, start + num) のうち長さの内側をページ単位の区間に分けて fn(page, pageOffset, spanOffset, len)
+	template <typename Fn>
+	void forEachSpan(int start, int num, Fn&& fn) const noexcept
+	{
+		int spanOffset = 0;
+		if (start < 0)
+		{
+			spanOffset = -start;
+			start = 0;
+		}
+
+		int end = juce::jmin(start + num - spanOffset, numSamples);
+
+		while (start < end)
+		{
+			const int page = start / pageSize;
+			const int pageOffset = start - page * pageSize;
+			const int len = juce::jmin(pageSize - pageOffset, end - start);
+
+			fn(page, pageOffset, spanOffset, len);
+
+			start += len;
+			spanOffset += len;
+		}
+	}
+
+	void clearRange(int start, int num) noexcept
+	{
+		const int end = juce::jmin(start + num, numPages * pageSize);
+		while (start < end)
+		{
+			const int page = start / pageSize;
+			const int pageOffset = start - page * pageSize;
+			const int len = juce::jmin(pageSize - pageOffset, end - start);
+
+			if (makePageWritable(page))
+				for (int ch = 0; ch < getNumChannels(); ++ch)
+					juce::FloatVectorOperations::clear(channelPtr(page, ch) + pageOffset, len);
+
+			start += len;
+		}
+	}
+
+	LoopPagePool* pool = nullptr;
+	juce::HeapBlock<float*> pages;
+	int pageSize = LoopPagePool::defaultPageSize;
+	int pageCapacity = 0;
+	int numPages = 0;
+	int numSamples = 0;
+
+	JUCE_DECLARE_NON_COPYABLE (PagedLoopBuffer)
+};
@@ -1,14 +1,74 @@
                                                                         #include "LooperAudio.h"
 #include <juce_events/juce_events.h>
+#include <algorithm>
+#include "AllocationTripwire.h"
 
 LooperAudio::LooperAudio(double sr, int max)
     : sampleRate(sr), maxSamples(max)
 {
     monitorFifoBuffer.resize(monitorFifoSize, 0.0f);
+    trackSlots.fill(-1);
+
+    // ループ音声は全トラック共有のページプールから借りる（ここで確保・プリフォルトまで済ませる）
+    // 0 なら確保しない（サンプルレートが決まってから setLoopMemory で確保する）
+    if (maxSamples > 0)
+        pagePool.allocate(maxSamples, LoopPagePool::defaultPageSize, false);
+    maxSamples = pagePool.getTotalSamples();
+
+    // UNDO用の履歴は録音前のページ表を共有するだけなので、ページ表の枠だけ用意しておく
+    for (auto& entry : history)
+        entry.buffer.attach(&pagePool);
+}
+
+void LooperAudio::setLoopMemory(int totalSamples, bool lockMemory)
+{
+    const int pageSize = pagePool.getPageSize();
+    const int roundedSamples = ((juce::jmax(1, totalSamples) + pageSize - 1) / pageSize) * pageSize;
+    if (roundedSamples == pagePool.getTotalSamples() && lockMemory == pagePool.isMemoryLocked())
+        return;
+
+    // 借りているページを全部返してから確保し直す（録ってあったループは消えるので UI に知らせる）
+    bool hadLoops = canUndo() || canRedo();
+    for (int slot = 0; slot < numTracks; ++slot)
+    {
+        auto track = trackAt(slot);
+        hadLoops = hadLoops || track.recordLength > 0 || track.isRecording;
+        track.buffer.setSize(0);
+        track.isRecording = false;
+        track.isPlaying = false;
+        track.recordLength = 0;
+        track.lengthInSample = 0;
+    }
+    clearHistory();
+    masterTrackId = -1;
+    masterLoopLength = 0;
+
+    for (int slot = 0; slot < numTracks; ++slot)
+    {
+        waveformSnapshots[(size_t)slot].setSize(0);
+        snapshotStates[(size_t)slot].store(snapshotEmpty);
+    }
+    heldSnapshots = 0;
+    pendingSnapshots = 0;
+
+    pagePool.allocate(totalSamples, pageSize, lockMemory);
+    maxSamples = pagePool.getTotalSamples();
+
+    for (int slot = 0; slot < numTracks; ++slot)
+    {
+        trackData[(size_t)slot].buffer.attach(&pagePool);
+        waveformSnapshots[(size_t)slot].attach(&pagePool);
+    }
+    for (auto& entry : history)
+        entry.buffer.attach(&pagePool);
+
+    if (hadLoops)
+        pendingLoopsCleared.store(true, std::memory_order_release);
 }
 
 LooperAudio::~LooperAudio()
 {
+    renderPool.stop();
     listeners.clear();
 }
 
@@ -20,22 +80,138 @@ void LooperAudio::prepareToPlay(int samplesPerBlockExpected, double sr)
     fxSpec.sampleRate = sampleRate;
     fxSpec.maximumBlockSize = samplesPerBlockExpected;
     fxSpec.numChannels = 2;
+
+    // ブロック処理用の作業バッファ（以降オーディオスレッドでは確保しない）
+    trackScratch.setSize(2, samplesPerBlockExpected);
+    LfoGenerator::prepareTables();
+
+    for (int slot = 0; slot < numTracks; ++slot)
+        prepareTrackFX(slot);
+
+    for (auto& bank : laneFilters)
+        bank.prepare(sampleRate);
+
+    sendBuses.prepare(sampleRate, samplesPerBlockExpected);
+
+    loadMonitor.prepare(sampleRate, samplesPerBlockExpected);
+
+    // 並列レンダリング / トラック横断レーン: スロットごとの作業バッファを確保
+    if (renderThreadCount > 0 || crossTrackLanes)
+    {
+        for (auto& scratch : renderScratch)
+            scratch.track.setSize(2, samplesPerBlockExpected);
+    }
+
+    // 並列レンダリング: ワーカーを起動
+    if (renderThreadCount > 0)
+        renderPool.start(renderThreadCount, samplesPerBlockExpected, sampleRate);
+    else
+        renderPool.stop();
+}
+
+void LooperAudio::setRenderThreadCount(int numWorkerThreads)
+{
+    renderThreadCount = juce::jlimit(0, TrackRenderPool::maxWorkers, numWorkerThreads);
+    DBG("🧵 Render threads: " << renderThreadCount << (renderThreadCount > 0 ? " (parallel)" : " (serial)"));
+}
+
+void LooperAudio::prepareTrackFX(int slot)
+{
+    auto& fx = *trackData[(size_t)slot].fx;
+
+    laneFilters[(size_t)(slot / LaneFilterBank::maxTracks)].resetTrack(slot % LaneFilterBank::maxTracks);
+
+    // Autotune の検出はホップごと。スロットごとに位相を 1/8 ホップずつずらして、FFT が同じブロックに集まらないようにする
+    fx.autotuneHop = autotuneDetectionHop;
+    fx.autotuneHopOffset = (slot % 8) * autotuneDetectionHop / 8;
+
+    // 作ってあるモジュールだけ（まだ ON にしていない FX はメモリも使わない）
+    {
+        const juce::ScopedLock sl(fxModuleLock);
+        fx.graph.prepareModules(sampleRate, (int)fxSpec.maximumBlockSize);
+    }
+
+    // Convolution Reverb: IR を読み込み済みならこのレートで作り直す
+    // 尾部のフレーム境界もスロットごとに 1/8 フレームずつずらす
+    fx.convolution.setNonUniformTail(convolutionNonUniformTail);
+    fx.convolution.prepare(sampleRate, (slot % 8) * ConvolutionReverb::tailFactor / 8);
+}
+
+void LooperAudio::createTrackFxModule(int trackId, FxModuleType type)
+{
+    const int slot = slotOf(trackId);
+    if (slot < 0)
+        return;
+
+    auto& fx = *trackData[(size_t)slot].fx;
+    const juce::ScopedLock sl(fxModuleLock);
+    if (fx.graph.hasModule(type))
+        return;
+
+    std::unique_ptr<FxModule> module;
+    switch (type)
+    {
+        case FxModuleType::granular:   module = std::make_unique<GranularModule>(fx); break;
+        case FxModuleType::autotune:   module = std::make_unique<AutotuneModule>(fx); break;
+        case FxModuleType::filter:     module = std::make_unique<FilterModule>(fx); break;
+        case FxModuleType::compressor: module = std::make_unique<CompressorModule>(fx); break;
+        case FxModuleType::flanger:    module = std::make_unique<ModulationModule>(fx, ModulationModule::Kind::flanger); break;
+        case FxModuleType::chorus:     module = std::make_unique<ModulationModule>(fx, ModulationModule::Kind::chorus); break;
+        case FxModuleType::tremolo:    module = std::make_unique<GainLfoModule>(fx, GainLfoModule::Kind::tremolo); break;
+        case FxModuleType::slicer:     module = std::make_unique<GainLfoModule>(fx, GainLfoModule::Kind::slicer); break;
+        case FxModuleType::bitcrusher: module = std::make_unique<BitcrusherModule>(fx); break;
+        case FxModuleType::delay:      module = std::make_unique<DelayModule>(fx); break;
+        case FxModuleType::reverb:     module = std::make_unique<ReverbModule>(fx, fx.convolution); break;
+        default: return;
+    }
+
+    // prepareToPlay 前なら prepareToPlay 側で prepare する
+    if (fxSpec.sampleRate > 0)
+        module->prepare(sampleRate, (int)fxSpec.maximumBlockSize);
+
+    DBG("🎛 FX module " << (int)type << " created for track " << trackId);
+    fx.graph.install(type, std::move(module));
+}
+
+void LooperAudio::setTrackModuleEnabled(int trackId, FxModuleType type, LooperCommand::Type command, bool enabled)
+{
+    // ON のコマンドより先にモジュールを渡しておく（オーディオスレッドはコマンドを見てから使う）
+    if (enabled)
+        createTrackFxModule(trackId, type);
+    postCommand(LooperCommand::makeInt(command, trackId, enabled));
 }
 
 void LooperAudio::processBlock(juce::AudioBuffer<float>& output,
                                const juce::AudioBuffer<float>& input)
 {
-    const juce::ScopedLock sl(audioLock); // 再生開始処理(startAllPlayback)との競合を防ぐ
+    allocation_tripwire::ScopedAudioThread noAllocations;
 
-    // 録音・再生処理
     output.clear();
+
+    const int numSamples = input.getNumSamples();
+
+    // UIからのコマンドを全件取り出し、ブロック先頭で投入順に適用する
+    // (ロックを取らないので、UIがどれだけ詰まってもオーディオスレッドは待たない)
+    const int numPending = commandQueue.popAll(pendingCommands);
+    for (int i = 0; i < numPending; ++i)
+        applyCommand(pendingCommands[(size_t)i]);
+
+    // 読み終えた波形のページを返し、取れなかった波形を取り直す
+    updateWaveformSnapshots();
+
+    if (stemOutputs != nullptr)
+        for (int slot = 0; slot < numTracks; ++slot)
+            stemOutputs[slot].clear(0, numSamples);
+
+    // 録音・再生処理
     recordIntoTracks(input);
     mixTracksToOutput(output);
 
+    currentSamplePosition += numSamples;
+
     // 入力音をモニター出力
     const int numInChannels = input.getNumChannels();
     const int numOutChannels = output.getNumChannels();
-    const int numSamples = input.getNumSamples();
 
     if (numInChannels > 0)
     {
@@ -44,86 +220,99 @@ void LooperAudio::processBlock(juce::AudioBuffer<float>& output,
             output.addFrom(ch, 0, input, ch % numInChannels, 0, numSamples);
         }
     }
-    
-    currentSamplePosition += numSamples;
+}
+
+
+//==============================================================================
+// コマンド投入（メッセージスレッド）
+//==============================================================================
+
+void LooperAudio::postCommand(const LooperCommand& cmd)
+{
+    if (!commandQueue.push(cmd))
+    {
+        // 1024件溜まる = オーディオが止まっている。捨てるしかない
+        DBG("⚠️ LooperAudio command queue full, dropped command " << (int)cmd.type);
+        jassertfalse;
+    }
 }
 
 void LooperAudio::addTrack(int trackId)
 {
-    auto& track = tracks[trackId];
-    track.buffer.setSize(2, maxSamples);
-    track.buffer.clear();
-    
-    // Initialize per-track FX
-    if (fxSpec.sampleRate > 0)
+    int slot = slotOf(trackId);
+    if (slot < 0)
     {
-        track.fx.compressor.prepare(fxSpec);
-        track.fx.filter.prepare(fxSpec);
-        track.fx.delay.prepare(fxSpec);
-        track.fx.reverb.prepare(fxSpec);
-        
-        // Defaults
-        track.fx.compressor.setThreshold(0.0f);
-        track.fx.compressor.setRatio(1.0f);
-        track.fx.filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
-        track.fx.filter.setCutoffFrequency(20000.0f);
-        track.fx.delay.setMaximumDelayInSamples(static_cast<int>(sampleRate * 2.0));
-        
-        juce::dsp::Reverb::Parameters params;
-        params.dryLevel = 1.0f; params.wetLevel = 0.0f; params.roomSize = 0.5f;
-        track.fx.reverb.setParameters(params);
+        if (trackId < 0 || trackId >= maxTrackIds || numTracks >= maxTracks)
+        {
+            DBG("⚠️ addTrack: trackId " << trackId << " rejected (capacity " << maxTracks << ")");
+            jassertfalse;
+            return;
+        }
+
+        slot = numTracks++;
+        trackIds[(size_t)slot] = trackId;
+        trackSlots[(size_t)trackId] = slot;
 
-        // Flanger Init
-        track.fx.flanger.prepare(fxSpec);
-        track.fx.flanger.setCentreDelay(1.5f); // 1.5ms for Flanger
-        track.fx.flanger.setFeedback(0.0f);
-        track.fx.flanger.setMix(0.5f);
-        track.fx.flanger.setDepth(0.5f);
-        track.fx.flanger.setRate(0.5f);
+        transport.gain[(size_t)slot] = 1.0f;
+        transport.loopMultiplier[(size_t)slot] = 1.0f;
+        trackData[(size_t)slot].fx = std::make_unique<FXChain>();
 
-        // Chorus Init (longer delay for thickening effect)
-        track.fx.chorus.prepare(fxSpec);
-        track.fx.chorus.setCentreDelay(10.0f); // 10ms for Chorus
-        track.fx.chorus.setFeedback(0.0f);
-        track.fx.chorus.setMix(0.5f);
-        track.fx.chorus.setDepth(0.5f);
-        track.fx.chorus.setRate(0.3f);
+        // Granular の乱数はトラックIDで固定シード（並列/シリアルで同じ結果になる）
+        trackData[(size_t)slot].fx->granularSeed = (juce::uint32)trackId;
+
+        // ページ表の枠だけ用意。音声ページは録音したときに必要な分だけ借りる
+        trackData[(size_t)slot].buffer.attach(&pagePool);
+        waveformSnapshots[(size_t)slot].attach(&pagePool);
     }
+
+    auto track = trackAt(slot);
+    track.buffer.setSize(0);
+    
+    // Defaults
+    track.fx.compressorThreshold = 0.0f;
+    track.fx.compressorRatio = 1.0f;
+
+    // Initialize per-track FX（prepareToPlay 前なら prepareToPlay 側でまとめて行う）
+    if (fxSpec.sampleRate > 0)
+        prepareTrackFX(slot);
 }
 
 
 
 void LooperAudio::startRecording(int trackId)
 {
-    // 履歴に追加
-    backupTrackBeforeRecord(trackId);
+    postCommand(LooperCommand::make(LooperCommand::Type::StartRecording, trackId));
+}
+
+void LooperAudio::applyStartRecording(int trackId, const juce::TriggerEvent* trigger)
+{
+    const int slot = slotOf(trackId);
+    if (slot < 0) return;
+    auto track = trackAt(slot);
 
-    auto& track = tracks[trackId];
+    // 履歴に追加（ページ表を共有するだけ）。録音は従来どおり無音のページから始める
+    pushHistory(slot);
+    track.buffer.setSize(0);
     
-    // Safety: Ensure buffer is full size if we are defining a new master loop
+    // マスター録音: 長さは決まっていないので、録音しながらページを借りて伸ばす（recordIntoTracks）
     if (masterLoopLength <= 0)
     {
-        if (track.buffer.getNumSamples() < maxSamples)
-        {
-            track.buffer.setSize(2, maxSamples);
-            DBG("🔧 Resized Track " << trackId << " buffer to maxSamples (" << maxSamples << ")");
-        }
-        
         // 新しいマスターループの基準時間を設定
         masterStartSample = currentSamplePosition;
-        DBG("🏁 Master Start Sample reset to " << masterStartSample);
     }
     // Optimization/Safety: If Slave, ensure at least Master Length * multiplier
     else if (masterLoopLength > 0)
     {
         int requiredSize = (int)(masterLoopLength * track.loopMultiplier);
-        // サイズが異なる場合は必ずリサイズ（大きすぎる場合も縮小してVisualizerの表示ズレを防ぐ）
-        if (track.buffer.getNumSamples() != requiredSize)
+
+        // プールから必要なページを借りる（確保はしない）。足りなければ等倍に落とす
+        if (!resizeTrackBuffer(track.buffer, requiredSize) && track.loopMultiplier > 1.0f)
         {
-            track.buffer.setSize(2, requiredSize);
-            DBG("🔧 Resized Track " << trackId << " buffer to " << requiredSize 
-                << " (masterLoopLength * multiplier=" << track.loopMultiplier << ")");
+            track.loopMultiplier = 1.0f;
+            requiredSize = masterLoopLength;
+            resizeTrackBuffer(track.buffer, requiredSize);
         }
+        // それでも足りなければ借りられた分だけ（残りは無音で録音される）
     }
 
     track.isRecording = true;
@@ -131,17 +320,18 @@ void LooperAudio::startRecording(int trackId)
     track.recordLength = 0;
 
     // マスターが再生中なら、その位置から録音開始
-    if (masterLoopLength > 0 && tracks.find(masterTrackId) != tracks.end() && tracks[masterTrackId].isPlaying)
+    if (masterLoopLength > 0 && isTrackPlaying(masterTrackId))
     {
         // === x2位相のスマート調整 (Smart Phase Alignment) ===
         // もしこれが「最初の長尺トラック（倍率>1）」の録音で、かつ奇数週目（裏拍）なら、
         // グローバル時間をシフトして「偶数週目（表拍）」に合わせる。
         if (track.loopMultiplier > 1.0f)
         {
-            bool hasOtherLongTracks = false;
-            for (const auto& [id, t] : tracks)
+            [[maybe_unused]] bool hasOtherLongTracks = false; // 下の Smart Phase Alignment を戻すときに使う
+            for (size_t i = 0; i < (size_t)numTracks; ++i)
             {
-                if (id != trackId && t.loopMultiplier > 1.0f && t.buffer.getNumSamples() > 0 && (t.isPlaying || t.recordLength > 0))
+                if (trackIds[i] != trackId && transport.loopMultiplier[i] > 1.0f && trackData[i].buffer.getNumSamples() > 0
+                    && (transport.isPlaying[i] || transport.recordLength[i] > 0))
                 {
                     hasOtherLongTracks = true;
                     break;
@@ -164,74 +354,75 @@ void LooperAudio::startRecording(int trackId)
             */
         }
 
-        // A. Trigger録音の場合：ブロック内の正確なトリガー位置を使用
-        int sampleIdxInBlock = (triggerRef && triggerRef->triggerd) ? triggerRef->sampleInBlock : 0;
+        // A. Trigger録音の場合：正確なトリガー位置を使用
+        int sampleIdxInBlock = (trigger && trigger->triggerd) ? trigger->sampleInBlock : 0;
         if (sampleIdxInBlock < 0) sampleIdxInBlock = 0;
 
-        // マスターの位置に同期させる: 絶対位置から計算することで、x2等の長いトラックでの「2周目」を正しく判定
-        // currentSamplePosition（ブロック先頭）にブロック内オフセットを加算
-        int64_t exactTriggerPosition = currentSamplePosition + sampleIdxInBlock;
-        int64_t relativeGlobal = exactTriggerPosition - masterStartSample;
-        int trackLoopLength = track.buffer.getNumSamples();
-        if (relativeGlobal < 0) relativeGlobal = 0;
+        // トリガーの absIndex はこの時計の絶対位置（後のブロックで録音を始めてもずれない）。
+        // なければ currentSamplePosition（ブロック先頭）にブロック内オフセットを加算
+        int64_t exactTriggerPosition = (trigger && trigger->triggerd && trigger->absIndex >= 0)
+            ? trigger->absIndex
+            : currentSamplePosition + sampleIdxInBlock;
+        int trackLoopLength = juce::jmax(1, (int)(masterLoopLength * track.loopMultiplier));
 
-        track.writePosition = (int)(relativeGlobal % trackLoopLength);
-        
-        // Visualizerの描画開始位置: 絶対時刻を使用する
-        track.recordStartSample = (int)exactTriggerPosition;
+        // 書き込み位置はこのブロックの先頭（recordIntoTracks と同じく絶対位置から計算するので、
+        // x2等の長いトラックでの「2周目」も正しく判定できる）。先読みはここで終わるように手前へ書く
+        int64_t relativeBlockStart = currentSamplePosition - masterStartSample;
+        if (relativeBlockStart < 0) relativeBlockStart = 0;
+
+        track.writePosition = (int)(relativeBlockStart % trackLoopLength);
         track.recordingStartPhase = track.writePosition;
         
-        DBG("🎬 Start recording track " << trackId
-            << " (Precision Aligned). AbsDiff: " << relativeGlobal 
-            << " (sampleInBlock: " << sampleIdxInBlock << ")"
-            << " -> WritePos: " << track.writePosition
-            << " | RecordStartSample: " << track.recordStartSample);
+        // Visualizerの描画開始位置: トリガーの絶対時刻を使用する（書き込み位置には使わない）
+        track.recordStartSample = exactTriggerPosition;
     }
     // TriggerEventが有効なら記録開始位置として反映
-    else if (triggerRef && triggerRef->triggerd)
+    else if (trigger && trigger->triggerd)
     {
-        int sampleIdx = triggerRef->sampleInBlock >= 0 ? triggerRef->sampleInBlock : 0;
+        int sampleIdx = trigger->sampleInBlock >= 0 ? trigger->sampleInBlock : 0;
         
         // absIndexが有効な場合はそれを使用、無効（-1）の場合は現在位置＋オフセットで計算
-        int64_t triggerAbsTime = (triggerRef->absIndex >= 0) 
-            ? triggerRef->absIndex 
+        int64_t triggerAbsTime = (trigger->absIndex >= 0) 
+            ? trigger->absIndex 
             : (currentSamplePosition + sampleIdx);
         
-        track.recordStartSample = static_cast<int>(triggerAbsTime);
+        track.recordStartSample = triggerAbsTime;
         track.writePosition = juce::jlimit(0, maxSamples - 1, (int)(triggerAbsTime % maxSamples));
-        DBG("🎬 Start recording track " << trackId
-            << " triggered at " << triggerAbsTime << " (sampleIdx: " << sampleIdx << ")");
     }
     else
     {
         track.readPosition = 0;
         track.writePosition = 0;
         track.recordStartSample = 0;
-
-        DBG("🎬 Start recording track " << trackId << " from beginning");
     }
-    track.buffer.clear();
+    // 録音前のページは履歴に預けてあるので、ここで借りたページは全部無音から始まる
 
-    listeners.call([&](Listener& l) { l.onRecordingStarted(trackId); });
+    notifyRecordingStarted(trackId);
 }
 
-void LooperAudio::startRecordingWithLookback(int trackId, const juce::AudioBuffer<float>& lookbackData)
+void LooperAudio::startRecordingWithLookback(int trackId, const AudioInputBuffer::LookbackView& lookback,
+                                             const juce::TriggerEvent& trigger)
 {
-    // First, standard start
-    startRecording(trackId);
+    // First, standard start (既にオーディオスレッドなのでキューを経由しない)
+    applyStartRecording(trackId, &trigger);
 
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    if (const int slot = slotOf(trackId); slot >= 0)
     {
-        auto& track = it->second;
-        int numLookback = lookbackData.getNumSamples();
+        auto track = trackAt(slot);
+        int numLookback = lookback.numSamples;
         if (numLookback <= 0) return;
 
+        // マスター録音はまだ空なので、先読み分だけページを借りて先頭から書く
+        if (masterLoopLength <= 0 && track.buffer.getNumSamples() < numLookback)
+            resizeTrackBuffer(track.buffer, juce::jmin(numLookback, maxSamples));
+
         // Loop limit definition: Use track's buffer size (handles x2, etc.)
         const int loopLimit = track.buffer.getNumSamples();
         if (loopLimit <= 0) return;
 
         // Calculate write start position (go back in time)
-        int startWritePos = track.writePosition - numLookback;
+        // スレーブの writePosition はこのブロックの先頭（recordIntoTracks が書き始める位置）。先読みはその直前で終わる
+        int startWritePos = (masterLoopLength <= 0) ? 0 : track.writePosition - numLookback;
         while (startWritePos < 0) startWritePos += loopLimit;
 
         // Limit lookback to loop size (sanity check)
@@ -240,25 +431,30 @@ void LooperAudio::startRecordingWithLookback(int trackId, const juce::AudioBuffe
             samplesToCopy = loopLimit;
 
         // --- Wrap-around Copy Logic ---
+        // リングの区間（最大2）をそのままトラックのページへ。ループの終わりでも折り返す
+        // チャンネルは recordIntoTracks と同じ対応（入力 ch → トラック ch、ない方は書かない）
+        const int numChannels = juce::jmin(lookback.numChannels, track.buffer.getNumChannels());
         int currentWritePos = startWritePos;
-        int lookbackOffset = 0;
         int remaining = samplesToCopy;
 
-        while (remaining > 0)
+        for (int s = 0; s < lookback.numSpans && remaining > 0; ++s)
         {
-            int samplesToEnd = loopLimit - currentWritePos;
-            int chunk = juce::jmin(remaining, samplesToEnd);
+            const auto& span = lookback.spans[(size_t)s];
+            int spanOffset = 0;
+            int spanRemaining = juce::jmin(span.numSamples, remaining);
 
-            // Channel mapping (handle Mono to Stereo if needed)
-            for (int ch = 0; ch < track.buffer.getNumChannels(); ++ch)
+            while (spanRemaining > 0)
             {
-                int srcCh = (ch < lookbackData.getNumChannels()) ? ch : 0;
-                track.buffer.copyFrom(ch, currentWritePos, lookbackData, srcCh, lookbackOffset, chunk);
-            }
+                const int chunk = juce::jmin(spanRemaining, loopLimit - currentWritePos);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    track.buffer.copyFrom(ch, currentWritePos, span.channels[(size_t)ch] + spanOffset, chunk);
 
-            currentWritePos = (currentWritePos + chunk) % loopLimit;
-            lookbackOffset += chunk;
-            remaining -= chunk;
+                currentWritePos = (currentWritePos + chunk) % loopLimit;
+                spanOffset += chunk;
+                spanRemaining -= chunk;
+                remaining -= chunk;
+            }
         }
 
         // --- Update Track State ---
@@ -282,8 +478,6 @@ void LooperAudio::startRecordingWithLookback(int trackId, const juce::AudioBuffe
             // Visualizerのために開始位置も調整（PreRoll分戻す）
             track.recordStartSample -= samplesToCopy; 
         }
-
-        DBG("🔙 Lookback injected: " << samplesToCopy << " samples. Adjusted start: " << track.recordStartSample);
     }
 }
 
@@ -314,11 +508,14 @@ void shiftBufferLeft(juce::AudioBuffer<float>& buffer, int numSamplesToShift)
 
 void LooperAudio::stopRecording(int trackId)
 {
-    auto& track = tracks[trackId];
-    track.isRecording = false;
-
-    track.isRecording = false;
+    postCommand(LooperCommand::make(LooperCommand::Type::StopRecording, trackId));
+}
 
+void LooperAudio::applyStopRecording(int trackId)
+{
+    const int slot = slotOf(trackId);
+    if (slot < 0) return;
+    auto track = trackAt(slot);
     track.isRecording = false;
 
     // バッファアラインメント（強制シフト）は削除
@@ -341,50 +538,41 @@ void LooperAudio::stopRecording(int trackId)
         masterReadPosition = 0;
         track.readPosition = 0;  // 🆕 ギャップ修正: マスター作成時は直接0から開始
 
-        DBG("🎛 Master loop length set to " << masterLoopLength
-            << " samples | recorded=" << recordedLength
-            << " | masterStart=" << masterStartSample
-            << " | readPos reset to 0");
+        // 録音中に借りた末尾の余りページを返す
+        track.buffer.setSize(masterLoopLength);
     }
     else
     {
         // スレーブトラック: loopMultiplierを考慮したサイズでアラインメント
-        int effectiveLength = (int)(masterLoopLength * track.loopMultiplier);
-        juce::AudioBuffer<float> aligned;
-        aligned.setSize(2, effectiveLength, false, false, true);
-        aligned.clear();
-
-        const int copyLen = juce::jmin(effectiveLength, track.buffer.getNumSamples());
-        
-        aligned.copyFrom(0, 0, track.buffer, 0, 0, copyLen);
-        aligned.copyFrom(1, 0, track.buffer, 1, 0, copyLen);
-
-        track.buffer.makeCopyOf(aligned);
+        // ページ表を切り詰める/伸ばすだけ（コピーしない）。伸ばした分は無音
+        int effectiveLength = juce::jmin((int)(masterLoopLength * track.loopMultiplier), maxSamples);
+        resizeTrackBuffer(track.buffer, effectiveLength); // 足りなければ今の長さのまま
         track.lengthInSample = effectiveLength;
         track.recordLength = recordedLength; 
 
         // ★ 重要: recordStartSampleは録音開始時に設定済み。ここで上書きしない。
         // (以前は masterStartSample で上書きしていたが、それが startAngleRatio=0 の原因だった)
-
-        DBG("🟢 Track " << trackId << ": aligned to " << effectiveLength 
-            << " samples (master=" << masterLoopLength << " * multiplier=" << track.loopMultiplier << ")");
     }
 
-    listeners.call([&](Listener& l) { l.onRecordingStopped(trackId); });
+    notifyRecordingStopped(trackId);
 }
 
 void LooperAudio::startPlaying(int trackId, bool syncToMaster)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    postCommand(LooperCommand::makeInt(LooperCommand::Type::StartPlaying, trackId, syncToMaster ? 1 : 0));
+}
+
+void LooperAudio::applyStartPlaying(int trackId, bool syncToMaster)
+{
+    if (const int slot = slotOf(trackId); slot >= 0)
     {
-        auto& track = it->second;
+        auto track = trackAt(slot);
         track.isPlaying = true;
 
         if (trackId == masterTrackId)
         {
             // マスタートラックは常に位置0から
             track.readPosition = 0;
-            DBG("▶️ Start playing master track " << trackId << " from position 0");
         }
         else if (syncToMaster && masterLoopLength > 0)
         {
@@ -394,61 +582,72 @@ void LooperAudio::startPlaying(int trackId, bool syncToMaster)
 
             int64_t relativePos = currentSamplePosition - masterStartSample;
             track.readPosition = (int)(relativePos % effectiveLoopLength);
-            
-            DBG("▶️ Start playing track " << trackId
-                << " synced to master at " << track.readPosition);
         }
         else
         {
             // 手動停止→再生時: 位置0から
             track.readPosition = 0;
-            DBG("▶️ Start playing track " << trackId << " from position 0");
         }
     }
 }
 
 void LooperAudio::startAllPlayback()
 {
-    // 全トラックを一斉に0位置からスタートさせる（ループで個別に呼ぶとコールバック割り込みでズレるため）
-    const juce::ScopedLock sl(audioLock); // 必要ならロック
-    
+    // 全トラックを一斉に0位置からスタートさせる（1コマンドで適用されるのでブロック途中でズレない）
+    postCommand(LooperCommand::make(LooperCommand::Type::StartAllPlayback, -1));
+}
+
+void LooperAudio::applyStartAllPlayback()
+{
     // 📍 プレイヘッド位置をリセット（getEffectiveNormalizedPositionが0から始まるように）
     masterStartSample = currentSamplePosition;
     
     // まずマスタートラックがあるか確認（あればそれもリセット）
-    for (auto& [id, track] : tracks)
+    for (int slot = 0; slot < numTracks; ++slot)
     {
+        auto track = trackAt(slot);
         if (track.recordLength > 0)
         {
             track.isPlaying = true;
             track.readPosition = 0;
         }
     }
-    DBG("▶️ Start ALL tracks from position 0 (masterStartSample reset to " << masterStartSample << ")");
 }
 
 void LooperAudio::stopPlaying(int trackId)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.isPlaying = false;
+    postCommand(LooperCommand::make(LooperCommand::Type::StopPlaying, trackId));
 }
 
 void LooperAudio::clearTrack(int trackId)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.buffer.clear();
+    postCommand(LooperCommand::make(LooperCommand::Type::ClearTrack, trackId));
+}
+
+void LooperAudio::masterPositionReset()
+{
+    postCommand(LooperCommand::make(LooperCommand::Type::MasterPositionReset, -1));
 }
 
 void LooperAudio::recordIntoTracks(const juce::AudioBuffer<float>& input)
 {
     const int numSamples = input.getNumSamples();
 
-    for (auto& [id, track] : tracks)
+    for (int slot = 0; slot < numTracks; ++slot)
     {
+        const int id = trackIds[(size_t)slot];
+        auto track = trackAt(slot);
         if (!track.isRecording)
             continue;
 
-        const int numChannels = juce::jmin(input.getNumChannels(), track.buffer.getNumChannels());
+        // トラックの入力ペアのチャンネルだけ（入力にないペアは無音のまま位置だけ進む）
+        const int firstInputChannel = transport.inputPair[(size_t)slot] * 2;
+        const int numChannels = juce::jlimit(0, track.buffer.getNumChannels(), input.getNumChannels() - firstInputChannel);
+
+        // マスター録音: 今回のブロック分だけページを借りて伸ばす。
+        // プールが尽きたら今の長さで折り返す（従来の maxSamples で折り返すのと同じ）
+        if (masterLoopLength <= 0 && track.buffer.getNumSamples() < track.recordLength + numSamples)
+            resizeTrackBuffer(track.buffer, juce::jmin(track.recordLength + numSamples, maxSamples));
         
         const int loopLimit = (masterLoopLength > 0)
             ? (int)(masterLoopLength * track.loopMultiplier)
@@ -494,7 +693,7 @@ void LooperAudio::recordIntoTracks(const juce::AudioBuffer<float>& input)
 
             for (int ch = 0; ch < numChannels; ++ch)
             {
-                track.buffer.copyFrom(ch, currentWritePos, input, ch, inputReadOffset, samplesToCopy);
+                track.buffer.copyFrom(ch, currentWritePos, input, firstInputChannel + ch, inputReadOffset, samplesToCopy);
             }
 
             currentWritePos = (currentWritePos + samplesToCopy) % loopLimit;
@@ -539,10 +738,8 @@ void LooperAudio::recordIntoTracks(const juce::AudioBuffer<float>& input)
             // 録音終了条件：サンプル数が目標に達した
             if (reachedTarget)
             {
-                stopRecording(id);
-                startPlaying(id);
-                DBG("✅ Master-synced loop complete for Track " << id
-                    << " | length=" << track.recordLength << " (multiplier=" << track.loopMultiplier << ")");
+                applyStopRecording(id);
+                applyStartPlaying(id, true);
             }
         }
     }
@@ -551,613 +748,629 @@ void LooperAudio::recordIntoTracks(const juce::AudioBuffer<float>& input)
 void LooperAudio::mixTracksToOutput(juce::AudioBuffer<float>& output)
 {
     const int numSamples = output.getNumSamples();
-    
-    // Temporary buffer for per-track FX processing
-    juce::AudioBuffer<float> trackBuffer(2, numSamples);
-    
-    // Sum all tracks to output
-    for (auto& [id, track] : tracks)
+
+    // Calculate synced rate based on track count and loop length（全トラック共通）
+    const double syncedModRate = getSyncedModRate();
+
+    sendBuses.beginBlock(numSamples);
+
+    // 再生していないトラックはレベルを減衰させるだけ
+    int numJobs = 0;
+    for (int slot = 0; slot < numTracks; ++slot)
     {
-        if (!track.isPlaying)
+        auto& level = transport.currentLevel[(size_t)slot];
+        if (!transport.isPlaying[(size_t)slot])
         {
-            track.currentLevel *= 0.8f;
-            if (track.currentLevel < 0.001f) track.currentLevel = 0.0f;
+            level *= 0.8f;
+            if (level < 0.001f) level = 0.0f;
             continue;
         }
+        renderJobSlots[(size_t)numJobs++] = slot;
+    }
 
-        const int outChannels = output.getNumChannels();
-        
-        const int loopLength = (masterLoopLength > 0)
-            ? (int)(masterLoopLength * track.loopMultiplier)
-            : juce::jmax(1, track.recordLength > 0 ? track.recordLength : track.buffer.getNumSamples());
-
-        // Clear temp buffer
-        trackBuffer.clear();
-        
-        int readPos = track.readPosition;
-        int remaining = numSamples;
-        int outputOffset = 0;
-
-        // 🔄 再生ラップアラウンドループ - write to temp buffer first
-        while (remaining > 0)
+    if (crossTrackLanes)
+    {
+        // 🧮 トラック横断レーン: 処理順で Filter より前 → Filter（8トラックずつ1パス）→ 後ろ。
+        // 前と後ろは並列モードならワーカーで。Filter が OFF のトラックは前で全部済ませる
+        auto sourceJob = [this, numSamples, syncedModRate] (int jobIndex)
         {
-            const int samplesToEnd = loopLength - readPos;
-            const int samplesToCopy = juce::jmin(remaining, samplesToEnd);
-
-            for (int ch = 0; ch < trackBuffer.getNumChannels(); ++ch)
-            {
-                trackBuffer.addFrom(ch, outputOffset, track.buffer, ch, readPos, samplesToCopy, track.gain);
-            }
+            const int slot = renderJobSlots[(size_t)jobIndex];
+            auto& scratch = renderScratch[(size_t)slot];
+            const auto& graph = trackData[(size_t)slot].fx->graph;
+            const int filterIndex = graph.indexOf(FxModuleType::filter);
+            scratch.track.setSize(2, numSamples, false, false, true);
+            renderTrackSource(slot, scratch.track, numSamples);
+            renderTrackModules(slot, scratch.track, numSamples, syncedModRate, 0,
+                               filterIndex >= 0 ? filterIndex : graph.getNumNodes());
+        };
+        auto effectsJob = [this, numSamples, syncedModRate] (int jobIndex)
+        {
+            const int slot = renderJobSlots[(size_t)jobIndex];
+            auto& trackBuffer = renderScratch[(size_t)slot].track;
+            const auto& graph = trackData[(size_t)slot].fx->graph;
+            const int filterIndex = graph.indexOf(FxModuleType::filter);
+            if (filterIndex >= 0)
+                renderTrackModules(slot, trackBuffer, numSamples, syncedModRate, filterIndex + 1, graph.getNumNodes());
+            renderTrackMeter(slot, trackBuffer, numSamples);
+        };
+
+        if (renderPool.getNumWorkers() > 0)
+            renderPool.parallelFor(numJobs, sourceJob);
+        else
+            for (int j = 0; j < numJobs; ++j) sourceJob(j);
 
-            readPos = (readPos + samplesToCopy) % loopLength;
-            remaining -= samplesToCopy;
-            outputOffset += samplesToCopy;
-        }
+        processLaneFilters(numJobs, numSamples);
 
-        track.readPosition = readPos;
+        if (renderPool.getNumWorkers() > 0)
+            renderPool.parallelFor(numJobs, effectsJob);
+        else
+            for (int j = 0; j < numJobs; ++j) effectsJob(j);
 
-        // ============ Beat Repeat (Stutter) Logic ============
-        auto& br = track.fx.beatRepeat;
-        if (br.isActive)
+        for (int j = 0; j < numJobs; ++j)
         {
-            // --- 1. Transient Detection (if armed but not repeating) ---
-            if (!br.isRepeating)
-            {
-                // Check current block for peaks
-                float blockPeak = trackBuffer.getMagnitude(0, 0, numSamples);
-                
-                // Simple transient detection: current peak > lastPeak + threshold
-                if (blockPeak > br.lastPeak + br.threshold && blockPeak > 0.05f)
-                {
-                    br.isRepeating = true;
-                    //基準点のキャプチャ（現在のブロックの開始位置を基準にする）
-                    br.repeatSourcePos = (track.readPosition - numSamples + loopLength) % loopLength;
-                    br.repeatLength = loopLength / br.division;
-                    br.currentRepeatPos = 0;
-                    
-                    DBG("🔥 Beat Repeat Triggered! Track " << id << " | Div: " << br.division << " | Pos: " << br.repeatSourcePos);
-                }
-                br.lastPeak = blockPeak * 0.9f; // Decay for next detection
-            }
-
-            // --- 2. Playback Substitution (if repeating) ---
-            if (br.isRepeating)
-            {
-                // Recalculate repeatLength in case division changed while repeating
-                int newRepeatLength = loopLength / juce::jmax(1, br.division);
-                if (newRepeatLength != br.repeatLength)
-                {
-                    br.repeatLength = newRepeatLength;
-                    br.currentRepeatPos = br.currentRepeatPos % br.repeatLength;
-                }
-                
-                // Clear the buffer that was just filled with normal playback
-                trackBuffer.clear();
-                
-                int samplesToFill = numSamples;
-                int fillOffset = 0;
-                
-                while (samplesToFill > 0)
-                {
-                    int samplesInSegmentToEnd = br.repeatLength - br.currentRepeatPos;
-                    int chunk = juce::jmin(samplesToFill, samplesInSegmentToEnd);
-                    
-                    int sourceReadPos = (br.repeatSourcePos + br.currentRepeatPos) % loopLength;
-                    
-                    // Copy from captured segment
-                    for (int ch = 0; ch < trackBuffer.getNumChannels(); ++ch)
-                    {
-                        trackBuffer.addFrom(ch, fillOffset, track.buffer, ch, sourceReadPos, chunk, track.gain);
-                    }
-                    
-                    br.currentRepeatPos = (br.currentRepeatPos + chunk) % br.repeatLength;
-                    samplesToFill -= chunk;
-                    fillOffset += chunk;
-                }
-            }
+            const int slot = renderJobSlots[(size_t)j];
+            addTrackToOutput(slot, renderScratch[(size_t)slot].track, output);
         }
-        else
+    }
+    else if (renderPool.getNumWorkers() > 0)
+    {
+        // 🧵 並列: トラックごとに専用バッファへレンダリング → スロット順に合算（決定的）
+        auto renderJob = [this, numSamples, syncedModRate] (int jobIndex)
         {
-            br.lastPeak = 0.0f;
-            br.isRepeating = false;
+            const int slot = renderJobSlots[(size_t)jobIndex];
+            auto& scratch = renderScratch[(size_t)slot];
+            scratch.track.setSize(2, numSamples, false, false, true);
+            renderTrack(slot, scratch.track, numSamples, syncedModRate);
+        };
+        renderPool.parallelFor(numJobs, renderJob);
+
+        for (int j = 0; j < numJobs; ++j)
+        {
+            const int slot = renderJobSlots[(size_t)j];
+            addTrackToOutput(slot, renderScratch[(size_t)slot].track, output);
         }
+    }
+    else
+    {
+        // Temporary buffer for per-track FX processing（prepareToPlay で確保済み）
+        auto& trackBuffer = trackScratch;
+        trackBuffer.setSize(2, numSamples, false, false, true);
 
-        // ============ Granular Cloud Logic ============
-        auto& gr = track.fx.granular;
-        if (gr.enabled)
+        for (int j = 0; j < numJobs; ++j)
         {
-            // --- 1. Grain Spawning ---
-            // Density determines the gap between grains
-            // Density 0.0 -> Gap 500ms
-            // Density 1.0 -> Gap 2ms (super dense)
-            float densityMap = 1.0f - gr.density; // 1.0(sparse) -> 0.0(dense)
-            int minGap = 100; // ~2ms at 44.1k
-            int maxGap = 22050; // 500ms
-            int targetGap = minGap + (int)(densityMap * (maxGap - minGap));
-            
-            for (int i = 0; i < numSamples; ++i)
-            {
-                gr.spawnTimer++;
-                
-                if (gr.spawnTimer >= targetGap)
-                {
-                    // Reset timer with some randomness if desired for organic feel
-                    // For now, strict density control with jittery position
-                    gr.spawnTimer = 0; 
-                    
-                    // Spawn logic
-                   // Try to find inactive grain
-                   for (auto& grain : gr.activeGrains)
-                   {
-                       if (!grain.isActive)
-                       {
-                           grain.isActive = true;
-                           
-                           // Calculate source position
-                           int loopLen = loopLength; 
-                           int jitterSamples = (int)(gr.jitter * loopLen * 0.5f);
-                           int offset = (juce::Random::getSystemRandom().nextInt(2 * jitterSamples + 1)) - jitterSamples;
-                           
-                           // Target playback position (roughly where we are now, minus some history)
-                           int targetPos = (track.readPosition + i - 2000 + loopLen) % loopLen; 
-                           grain.position = (targetPos + offset + loopLen) % loopLen;
-                           
-                           // Life & Speed
-                           float baseLife = gr.sizeMs * 0.001f * sampleRate;
-                           grain.totalLife = (int)baseLife;
-                           grain.life = grain.totalLife;
-                           
-                           float pitchMod = (juce::Random::getSystemRandom().nextFloat() * 2.0f - 1.0f) * gr.pitchRandom;
-                           grain.speed = gr.pitch + pitchMod;
-                           
-                           grain.pan = juce::Random::getSystemRandom().nextFloat();
-                           grain.gain = 1.0f;
-                           break; // Spawned one, stop searching
-                       }
-                   }
-                }
-            }
-            
-            // --- 2. Grain Processing ---
-            // Process grains into a separate cloud buffer to mix later
-            juce::AudioBuffer<float> cloudBuffer(2, numSamples);
-            cloudBuffer.clear();
-            
-            int activeGrainCount = 0;
-            
-            for (auto& grain : gr.activeGrains)
-            {
-                if (!grain.isActive) continue;
-                
-                activeGrainCount++;
-                
-                for (int i = 0; i < numSamples; ++i)
-                {
-                    if (grain.life <= 0) break;
-                    
-                    // Read sample (no interpolation for now to save CPU, add Linear later if needed)
-                    int readIdx = (int)grain.position % track.buffer.getNumSamples();
-                    
-                    float l = track.buffer.getSample(0, readIdx);
-                    float r = (track.buffer.getNumChannels() > 1) ? track.buffer.getSample(1, readIdx) : l;
-                    
-                    // Windowing (Hanning-ish triangle)
-                    float progress = 1.0f - (float)grain.life / grain.totalLife;
-                    float win = 0.0f;
-                    if (progress < 0.5f) win = progress * 2.0f;
-                    else win = (1.0f - progress) * 2.0f;
-                    
-                    // Panning
-                    float panL = std::cos(grain.pan * 1.57f);
-                    float panR = std::sin(grain.pan * 1.57f);
-                    
-                    float sampleL = l * win * grain.gain * panL;
-                    float sampleR = r * win * grain.gain * panR;
-                    
-                    cloudBuffer.addSample(0, i, sampleL);
-                    cloudBuffer.addSample(1, i, sampleR);
-                    
-                    // Advance
-                    grain.position += (int)(grain.speed); // Handle float speed better with interpolation later
-                    grain.life--;
-                }
-                
-                if (grain.life <= 0) grain.isActive = false;
-            }
-            
-            // --- 3. Mixing ---
-            // Mix cloudBuffer into trackBuffer based on gr.mix
-            // dry = 1.0 - mix, wet = 1.0 (additive) or equal power?
-            // Let's do simple linear fade
-            float dry = 1.0f - gr.mix;
-            float wet = gr.mix;
-            
-            trackBuffer.applyGain(dry);
-            
-            for (int ch = 0; ch < trackBuffer.getNumChannels(); ++ch)
-            {
-                trackBuffer.addFrom(ch, 0, cloudBuffer, ch, 0, numSamples, wet);
-            }
+            const int slot = renderJobSlots[(size_t)j];
+            renderTrack(slot, trackBuffer, numSamples, syncedModRate);
+            addTrackToOutput(slot, trackBuffer, output);
         }
+    }
 
-        // ============ Autotune Processing ============
-        auto& at = track.fx.autotune;
-        if (at.enabled)
-        {
-            // Scale definitions (semitones from root)
-            static const int chromaticScale[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
-            static const int majorScale[] = {0, 2, 4, 5, 7, 9, 11};
-            static const int minorScale[] = {0, 2, 3, 5, 7, 8, 10};
-            const int* scale = chromaticScale;
-            int scaleSize = 12;
-            if (at.scale == 1) { scale = majorScale; scaleSize = 7; }
-            else if (at.scale == 2) { scale = minorScale; scaleSize = 7; }
-
-            // Push mono signal to pitch detector
-            for (int i = 0; i < numSamples; ++i)
-            {
-                float mono = trackBuffer.getSample(0, i);
-                if (trackBuffer.getNumChannels() > 1)
-                    mono = (mono + trackBuffer.getSample(1, i)) * 0.5f;
-                at.detector.pushSamples(&mono, 1);
-            }
+    processSendBuses(output, numSamples);
 
-            // Detect pitch
-            float detectedFreq = at.detector.detectPitch();
-            at.currentPitch = detectedFreq;
+    // 再生中または録音中のトラックが1つでもあるかチェック
+    bool isActive = isAnyPlaying() || isAnyRecording();
 
-            if (detectedFreq > 50.0f && detectedFreq < 2000.0f)
-            {
-                // Convert frequency to MIDI note
-                float midiNote = 12.0f * std::log2(detectedFreq / 440.0f) + 69.0f;
-                int noteNum = static_cast<int>(std::round(midiNote)) % 12;
-                int octave = static_cast<int>(std::round(midiNote)) / 12;
-
-                // Find nearest note in scale relative to key
-                int relNote = (noteNum - at.key + 12) % 12;
-                int nearestScaleNote = 0;
-                int minDist = 12;
-                for (int s = 0; s < scaleSize; ++s)
-                {
-                    int dist = std::abs(relNote - scale[s]);
-                    if (dist > 6) dist = 12 - dist;
-                    if (dist < minDist)
-                    {
-                        minDist = dist;
-                        nearestScaleNote = scale[s];
-                    }
-                }
+    // マスターが決まっていて、かつ「誰かが動いている時だけ」時間を進める
+    if (masterLoopLength > 0 && isActive)
+    {
+        masterReadPosition = (masterReadPosition + numSamples) % masterLoopLength;
+    }
+}
 
-                // Target MIDI note
-                int targetNote = (nearestScaleNote + at.key) % 12 + octave * 12;
-                float targetFreq = 440.0f * std::pow(2.0f, (targetNote - 69.0f) / 12.0f);
-                at.targetPitch = targetFreq;
+double LooperAudio::getSyncedModRate() const
+{
+    // Rate = recordedTrackCount / (loopLength / sampleRate)
+    double syncedModRate = 1.0;
+    if (masterLoopLength > 0)
+    {
+        int recordedCount = 0;
+        for (int i = 0; i < numTracks; ++i) { if (transport.recordLength[(size_t)i] > 0) recordedCount++; }
+        if (recordedCount == 0) recordedCount = 1;
+        
+        syncedModRate = (double)recordedCount / ((double)masterLoopLength / sampleRate);
+    }
+    return syncedModRate;
+}
 
-                // Calculate pitch ratio
-                float targetRatio = targetFreq / detectedFreq;
+void LooperAudio::renderTrack(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples, double syncedModRate)
+{
+    renderTrackSource(slot, trackBuffer, numSamples);
+    renderTrackModules(slot, trackBuffer, numSamples, syncedModRate, 0, trackData[(size_t)slot].fx->graph.getNumNodes());
+    renderTrackMeter(slot, trackBuffer, numSamples);
+}
 
-                // Apply amount and speed smoothing
-                float correctedRatio = 1.0f + (targetRatio - 1.0f) * at.amount;
-                float smoothFactor = 0.99f - at.speed * 0.98f; // speed 0=instant, 1=slow
-                at.smoothedRatio = at.smoothedRatio * smoothFactor + correctedRatio * (1.0f - smoothFactor);
-            }
-            else
-            {
-                // No pitch detected, gradually return to unity
-                at.smoothedRatio = at.smoothedRatio * 0.99f + 1.0f * 0.01f;
-            }
+void LooperAudio::processLaneFilters(int numJobs, int numSamples)
+{
+    constexpr int numBanks = maxTracks / LaneFilterBank::maxTracks;
+    std::array<LaneFilterBank::LanePointers, numBanks> lanes {};
+    std::array<int, numBanks> numFiltered {};
 
-            // Apply pitch shift
-            at.shifterL.setPitchRatio(at.smoothedRatio);
-            at.shifterR.setPitchRatio(at.smoothedRatio);
+    for (int j = 0; j < numJobs; ++j)
+    {
+        const int slot = renderJobSlots[(size_t)j];
+        auto& fx = *trackData[(size_t)slot].fx;
+        if (fx.graph.indexOf(FxModuleType::filter) < 0)
+            continue;
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                float l = trackBuffer.getSample(0, i);
-                float r = (trackBuffer.getNumChannels() > 1) ? trackBuffer.getSample(1, i) : l;
+        // パラメータはトラックの Filter モジュールと同じ値
+        const int bank = slot / LaneFilterBank::maxTracks;
+        const int lane = slot % LaneFilterBank::maxTracks;
+        laneFilters[(size_t)bank].setParameters(lane, fx.filterCutoff, fx.filterRes,
+                                                fx.filterType == 1 ? LaneFilterBank::Type::highpass : LaneFilterBank::Type::lowpass);
 
-                float shiftedL = at.shifterL.process(l);
-                float shiftedR = at.shifterR.process(r);
+        auto& trackBuffer = renderScratch[(size_t)slot].track;
+        lanes[(size_t)bank][(size_t)(lane * 2)] = trackBuffer.getWritePointer(0);
+        lanes[(size_t)bank][(size_t)(lane * 2 + 1)] = trackBuffer.getWritePointer(1);
+        ++numFiltered[(size_t)bank];
+    }
 
-                trackBuffer.setSample(0, i, shiftedL);
-                if (trackBuffer.getNumChannels() > 1)
-                    trackBuffer.setSample(1, i, shiftedR);
-            }
-        }
+    for (int bank = 0; bank < numBanks; ++bank)
+    {
+        if (numFiltered[(size_t)bank] == 0)
+            continue;
 
-        // Calculate synced rate based on track count and loop length
-        // Rate = recordedTrackCount / (loopLength / sampleRate)
-        double syncedModRate = 1.0;
-        if (masterLoopLength > 0)
-        {
-            int recordedCount = 0;
-            for (auto& t : tracks) { if (t.second.recordLength > 0) recordedCount++; }
-            if (recordedCount == 0) recordedCount = 1;
-            
-            syncedModRate = (double)recordedCount / ((double)masterLoopLength / sampleRate);
-        }
+        const auto start = DspLoadMonitor::readCycles();
+        laneFilters[(size_t)bank].process(lanes[(size_t)bank], numSamples);
 
-        // --- FX Reset at Loop Start ---
-        if (track.readPosition == 0)
-        {
-            if (track.fx.flangerSync) {
-                track.fx.flanger.reset(); // Reset Internal LFO if possible
-                track.fx.flangerPhase = 0.0;
-            }
-            if (track.fx.chorusSync) {
-                track.fx.chorus.reset();
-                track.fx.chorusPhase = 0.0;
-            }
-            if (track.fx.tremoloSync) {
-                track.fx.tremoloPhase = 0.0;
-            }
-            if (track.fx.slicerSync) {
-                track.fx.slicerPhase = 0.0;
-            }
-        }
+        // ⏱ 1パスの時間を、使ったトラックで等分して Filter ステージに付ける
+        const auto share = (DspLoadMonitor::readCycles() - start) / (juce::uint64)numFiltered[(size_t)bank];
+        for (int lane = 0; lane < LaneFilterBank::maxTracks; ++lane)
+            if (lanes[(size_t)bank][(size_t)(lane * 2)] != nullptr)
+                loadMonitor.addStageCycles(bank * LaneFilterBank::maxTracks + lane, DspLoadMonitor::Stage::filter, share);
+    }
+}
 
-        // ============ Per-Track FX Processing ============
-        juce::dsp::AudioBlock<float> block(trackBuffer);
-        juce::dsp::ProcessContextReplacing<float> context(block);
-        
-        // Filter (only if enabled)
-        if (track.fx.filterEnabled)
-            track.fx.filter.process(context);
-        
-        // Flanger
-        if (track.fx.flangerEnabled)
-        {
-            if (track.fx.flangerSync)
-                track.fx.flanger.setRate((float)syncedModRate);
-            else
-                track.fx.flanger.setRate(track.fx.flangerRate);
-                
-            track.fx.flanger.process(context);
-        }
+void LooperAudio::renderTrackSource(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples)
+{
+    // ⏱ ステージごとの処理時間（サイクルカウンタを読むだけ）。無効な FX は計測しない
+    auto stageStart = DspLoadMonitor::readCycles();
+    using Stage = DspLoadMonitor::Stage;
 
-        // Chorus
-        if (track.fx.chorusEnabled)
-        {
-            if (track.fx.chorusSync)
-                track.fx.chorus.setRate((float)syncedModRate);
-            else
-                track.fx.chorus.setRate(track.fx.chorusRate);
+    auto track = trackAt(slot);
 
-            track.fx.chorus.process(context);
-        }
+    const int loopLength = (masterLoopLength > 0)
+        ? (int)(masterLoopLength * track.loopMultiplier)
+        : juce::jmax(1, track.recordLength > 0 ? track.recordLength : track.buffer.getNumSamples());
 
-        // Tremolo (LFO-based amplitude modulation)
-        if (track.fx.tremoloEnabled)
-        {
-            auto* left = trackBuffer.getWritePointer(0);
-            auto* right = trackBuffer.getWritePointer(1);
-            
-            double effectiveRate = track.fx.tremoloSync ? syncedModRate : (double)track.fx.tremoloRate;
-            double phaseIncrement = effectiveRate / sampleRate;
+    // Clear temp buffer
+    trackBuffer.clear();
+    
+    int readPos = track.readPosition;
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                // LFO waveform calculation
-                float lfoValue = 0.0f;
-                switch (track.fx.tremoloShape)
-                {
-                    case 0: // Sine
-                        lfoValue = static_cast<float>(0.5 + 0.5 * std::sin(track.fx.tremoloPhase * juce::MathConstants<double>::twoPi));
-                        break;
-                    case 1: // Square
-                        lfoValue = (track.fx.tremoloPhase < 0.5) ? 1.0f : 0.0f;
-                        break;
-                    case 2: // Triangle
-                        lfoValue = static_cast<float>(1.0 - std::abs(2.0 * track.fx.tremoloPhase - 1.0));
-                        break;
-                }
+    // FX の遅延（Autotune のシフタ、Compressor のルックアヘッド）の合計だけ先を読んでループと揃える
+    int playPos = readPos;
+    if (const int latency = track.fx.graph.getLatencySamples(); latency > 0)
+        playPos = (readPos + latency % loopLength) % loopLength;
 
-                // Apply depth: gain = 1 - depth * (1 - lfoValue)
-                float gain = 1.0f - track.fx.tremoloDepth * (1.0f - lfoValue);
-                left[i] *= gain;
-                right[i] *= gain;
+    int remaining = numSamples;
+    int outputOffset = 0;
 
-                // Advance phase
-                track.fx.tremoloPhase += phaseIncrement;
-                if (track.fx.tremoloPhase >= 1.0)
-                    track.fx.tremoloPhase -= 1.0;
-            }
-        }
+    // 🔄 再生ラップアラウンドループ - write to temp buffer first
+    while (remaining > 0)
+    {
+        const int samplesToEnd = loopLength - playPos;
+        const int samplesToCopy = juce::jmin(remaining, samplesToEnd);
 
-        // Slicer / Trance Gate (rhythmic volume gate)
-        if (track.fx.slicerEnabled)
+        for (int ch = 0; ch < trackBuffer.getNumChannels(); ++ch)
         {
-            auto* left = trackBuffer.getWritePointer(0);
-            auto* right = trackBuffer.getWritePointer(1);
+            track.buffer.addTo(trackBuffer, ch, outputOffset, ch, playPos, samplesToCopy, track.gain);
+        }
 
-            double effectiveRate = track.fx.slicerSync ? syncedModRate : (double)track.fx.slicerRate;
-            double phaseIncrement = effectiveRate / sampleRate;
+        playPos = (playPos + samplesToCopy) % loopLength;
+        remaining -= samplesToCopy;
+        outputOffset += samplesToCopy;
+    }
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                // Gate calculation based on duty cycle
-                float gateValue = 0.0f;
+    track.readPosition = (readPos + numSamples) % loopLength;
+    stageStart = loadMonitor.addStageTime(slot, Stage::playback, stageStart);
 
-                if (track.fx.slicerShape == 0)  // Square (hard gate)
-                {
-                    // Gate is open when phase < duty, closed otherwise
-                    gateValue = (track.fx.slicerPhase < track.fx.slicerDuty) ? 1.0f : 0.0f;
-                }
-                else  // Smooth (soft gate with fade)
-                {
-                    // Smooth transition using raised cosine for both edges
-                    float fadeZone = 0.1f;  // 10% of cycle for fade
-                    float duty = track.fx.slicerDuty;
-                    float phase = static_cast<float>(track.fx.slicerPhase);
-
-                    if (phase < fadeZone * duty)
-                    {
-                        // Fade in at start
-                        gateValue = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * phase / (fadeZone * duty));
-                    }
-                    else if (phase < duty - fadeZone * duty)
-                    {
-                        // Full open
-                        gateValue = 1.0f;
-                    }
-                    else if (phase < duty)
-                    {
-                        // Fade out before closing
-                        float fadeProgress = (phase - (duty - fadeZone * duty)) / (fadeZone * duty);
-                        gateValue = 0.5f + 0.5f * std::cos(juce::MathConstants<float>::pi * fadeProgress);
-                    }
-                    else
-                    {
-                        // Closed
-                        gateValue = 0.0f;
-                    }
-                }
-
-                // Apply depth: gain = 1 - depth * (1 - gateValue)
-                float gain = 1.0f - track.fx.slicerDepth * (1.0f - gateValue);
-                left[i] *= gain;
-                right[i] *= gain;
-
-                // Advance phase
-                track.fx.slicerPhase += phaseIncrement;
-                if (track.fx.slicerPhase >= 1.0)
-                    track.fx.slicerPhase -= 1.0;
+    // ============ Beat Repeat (Stutter) Logic ============
+    auto& br = track.fx.beatRepeat;
+    if (br.isActive)
+    {
+        // --- 1. Transient Detection (if armed but not repeating) ---
+        if (!br.isRepeating)
+        {
+            // Check current block for peaks
+            float blockPeak = trackBuffer.getMagnitude(0, 0, numSamples);
+            
+            // Simple transient detection: current peak > lastPeak + threshold
+            if (blockPeak > br.lastPeak + br.threshold && blockPeak > 0.05f)
+            {
+                br.isRepeating = true;
+                //基準点のキャプチャ（現在のブロックの開始位置を基準にする）
+                br.repeatSourcePos = (track.readPosition - numSamples + loopLength) % loopLength;
+                br.repeatLength = loopLength / br.division;
+                br.currentRepeatPos = 0;
             }
+            br.lastPeak = blockPeak * 0.9f; // Decay for next detection
         }
 
-        // Delay (only if enabled and mix > 0)
-        if (track.fx.delayEnabled && track.fx.delayMix > 0.0f)
+        // --- 2. Playback Substitution (if repeating) ---
+        if (br.isRepeating)
         {
-            auto* left = trackBuffer.getWritePointer(0);
-            auto* right = trackBuffer.getWritePointer(1);
+            // Recalculate repeatLength in case division changed while repeating
+            int newRepeatLength = loopLength / juce::jmax(1, br.division);
+            if (newRepeatLength != br.repeatLength)
+            {
+                br.repeatLength = newRepeatLength;
+                br.currentRepeatPos = br.currentRepeatPos % br.repeatLength;
+            }
             
-            for(int i = 0; i < numSamples; ++i)
+            // Clear the buffer that was just filled with normal playback
+            trackBuffer.clear();
+            
+            int samplesToFill = numSamples;
+            int fillOffset = 0;
+            
+            while (samplesToFill > 0)
             {
-                float inL = left[i];
-                float inR = right[i];
-                
-                float wetL = track.fx.delay.popSample(0);
-                float wetR = track.fx.delay.popSample(1);
+                int samplesInSegmentToEnd = br.repeatLength - br.currentRepeatPos;
+                int chunk = juce::jmin(samplesToFill, samplesInSegmentToEnd);
                 
-                left[i] = inL * (1.0f - track.fx.delayMix) + wetL * track.fx.delayMix;
-                right[i] = inR * (1.0f - track.fx.delayMix) + wetR * track.fx.delayMix;
+                int sourceReadPos = (br.repeatSourcePos + br.currentRepeatPos) % loopLength;
                 
-                float feedL = inL + wetL * track.fx.delayFeedback;
-                float feedR = inR + wetR * track.fx.delayFeedback;
-                
-                feedL = std::tanh(feedL);
-                feedR = std::tanh(feedR);
+                // Copy from captured segment
+                for (int ch = 0; ch < trackBuffer.getNumChannels(); ++ch)
+                {
+                    track.buffer.addTo(trackBuffer, ch, fillOffset, ch, sourceReadPos, chunk, track.gain);
+                }
                 
-                track.fx.delay.pushSample(0, feedL);
-                track.fx.delay.pushSample(1, feedR);
+                br.currentRepeatPos = (br.currentRepeatPos + chunk) % br.repeatLength;
+                samplesToFill -= chunk;
+                fillOffset += chunk;
             }
         }
-        
-        // Reverb (only if enabled)
-        if (track.fx.reverbEnabled)
-            track.fx.reverb.process(context);
-        
-        // Add FX-processed track to final output
-        for (int ch = 0; ch < outChannels; ++ch)
+        stageStart = loadMonitor.addStageTime(slot, Stage::beatRepeat, stageStart);
+    }
+    else
+    {
+        br.lastPeak = 0.0f;
+        br.isRepeating = false;
+    }
+}
+
+void LooperAudio::renderTrackModules(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples, double syncedModRate,
+                                     int begin, int end)
+{
+    if (begin >= end)
+        return;
+
+    // FxModuleType → 負荷計測のステージ
+    using Stage = DspLoadMonitor::Stage;
+    static constexpr Stage stages[] = { Stage::granular, Stage::autotune, Stage::filter, Stage::compressor, Stage::flanger,
+                                        Stage::chorus, Stage::tremolo, Stage::slicer, Stage::bitcrusher, Stage::delay, Stage::reverb };
+    static_assert(std::size(stages) == (size_t)FxModuleType::numTypes, "every FX module has a load stage");
+
+    auto stageStart = DspLoadMonitor::readCycles();
+    auto track = trackAt(slot);
+
+    // readPosition は renderTrackSource でこのブロック分だけ進んでいるので、ブロック先頭に戻す
+    FxContext context;
+    context.loop = &track.buffer;
+    context.loopLength = (masterLoopLength > 0)
+        ? (int)(masterLoopLength * track.loopMultiplier)
+        : juce::jmax(1, track.recordLength > 0 ? track.recordLength : track.buffer.getNumSamples());
+    context.blockStart = ((track.readPosition - numSamples) % context.loopLength + context.loopLength) % context.loopLength;
+    context.masterLoopLength = masterLoopLength;
+    context.syncedModRate = syncedModRate;
+    context.loopRestarts = track.readPosition == 0;
+
+    // ============ Per-Track FX Processing ============
+    // ON のモジュールだけが処理順に並んでいる（OFF の FX は分岐もしない）
+    const auto& graph = track.fx.graph;
+    for (int i = begin; i < end; ++i)
+    {
+        const auto& node = graph.getNode(i);
+        node.module->process(trackBuffer, numSamples, context);
+        stageStart = loadMonitor.addStageTime(slot, stages[(size_t)node.type], stageStart);
+    }
+}
+
+void LooperAudio::renderTrackMeter(int slot, const juce::AudioBuffer<float>& trackBuffer, int numSamples)
+{
+    const auto stageStart = DspLoadMonitor::readCycles();
+    auto track = trackAt(slot);
+
+    // 🧮 RMS計算 (Visualizer用)
+    // FX適用後の trackBuffer から計算する（ブロック全体のRMS）
+    float rmsValue = 0.0f;
+    if (numSamples > 0)
+    {
+        rmsValue = trackBuffer.getRMSLevel(0, 0, numSamples);
+        // 2chの場合は平均
+        if (trackBuffer.getNumChannels() > 1)
         {
-            output.addFrom(ch, 0, trackBuffer, ch % 2, 0, numSamples);
+            rmsValue = (rmsValue + trackBuffer.getRMSLevel(1, 0, numSamples)) * 0.5f;
         }
+    }
+    
+    rmsValue *= track.gain;
+    constexpr float decayRate = 0.95f;
+    if (rmsValue > track.currentLevel)
+        track.currentLevel = rmsValue;
+    else
+        track.currentLevel = track.currentLevel * decayRate + rmsValue * (1.0f - decayRate);
+    track.currentEffectRMS = track.currentLevel;
+
+    loadMonitor.addStageTime(slot, DspLoadMonitor::Stage::output, stageStart);
+}
+
+void LooperAudio::addTrackToOutput(int slot, const juce::AudioBuffer<float>& trackBuffer, juce::AudioBuffer<float>& output)
+{
+    const auto outputStart = DspLoadMonitor::readCycles();
+    const int numSamples = output.getNumSamples();
+
+    // Add FX-processed track to final output
+    for (int ch = 0; ch < output.getNumChannels(); ++ch)
+    {
+        output.addFrom(ch, 0, trackBuffer, ch % 2, 0, numSamples);
+    }
+
+    if (stemOutputs != nullptr)
+        for (int ch = 0; ch < 2; ++ch)
+            stemOutputs[slot].copyFrom(ch, 0, trackBuffer, ch, 0, numSamples);
 
-        // --- Visualization Monitoring ---
-        if (id == monitorTrackId.load())
+    // Send / Return バスへ（スロット順に呼ばれるので合算の順番は決まっている）
+    sendBuses.addSends(slot, trackBuffer, numSamples);
+
+    // --- Visualization Monitoring ---
+    if (trackIds[(size_t)slot] == monitorTrackId.load())
+    {
+        // モノラルミックスしてFIFOへ
+        int start1, size1, start2, size2;
+        monitorFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+        
+        if (size1 > 0)
         {
-            // モノラルミックスしてFIFOへ
-            int start1, size1, start2, size2;
-            monitorFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
-            
-            if (size1 > 0)
-            {
-                // Channel 0 only for simplified viz
-                for (int i = 0; i < size1; ++i)
-                    monitorFifoBuffer[start1 + i] = trackBuffer.getSample(0, i);
-            }
-            if (size2 > 0)
-            {
-                for (int i = 0; i < size2; ++i)
-                    monitorFifoBuffer[start2 + i] = trackBuffer.getSample(0, size1 + i);
-            }
-            monitorFifo.finishedWrite(size1 + size2);
+            // Channel 0 only for simplified viz
+            for (int i = 0; i < size1; ++i)
+                monitorFifoBuffer[start1 + i] = trackBuffer.getSample(0, i);
         }
-
-        // 🧮 RMS計算 (Visualizer用)
-        // FX適用後の trackBuffer から計算する（ブロック全体のRMS）
-        float rmsValue = 0.0f;
-        if (numSamples > 0)
+        if (size2 > 0)
         {
-            rmsValue = trackBuffer.getRMSLevel(0, 0, numSamples);
-            // 2chの場合は平均
-            if (trackBuffer.getNumChannels() > 1)
-            {
-                rmsValue = (rmsValue + trackBuffer.getRMSLevel(1, 0, numSamples)) * 0.5f;
-            }
+            for (int i = 0; i < size2; ++i)
+                monitorFifoBuffer[start2 + i] = trackBuffer.getSample(0, size1 + i);
         }
-        
-        rmsValue *= track.gain;
-        constexpr float decayRate = 0.95f;
-        if (rmsValue > track.currentLevel)
-            track.currentLevel = rmsValue;
-        else
-            track.currentLevel = track.currentLevel * decayRate + rmsValue * (1.0f - decayRate);
-        track.currentEffectRMS = track.currentLevel;
-    } // End track loop
+        monitorFifo.finishedWrite(size1 + size2);
+    }
 
-    // 再生中または録音中のトラックが1つでもあるかチェック
-    bool isActive = isAnyPlaying() || isAnyRecording();
+    loadMonitor.addStageTime(slot, DspLoadMonitor::Stage::output, outputStart);
+}
 
-    // マスターが決まっていて、かつ「誰かが動いている時だけ」時間を進める
-    if (masterLoopLength > 0 && isActive)
+void LooperAudio::processSendBuses(juce::AudioBuffer<float>& output, int numSamples)
+{
+    const auto& delaySettings = sendBuses.getDelaySettings();
+    const float delaySamples = (delaySettings.sync && masterLoopLength > 0)
+        ? BlockDelay::getSyncedDelaySamples(masterLoopLength, delaySettings.division, sendBuses.getMaxDelaySamples())
+        : delaySettings.timeSeconds * (float)sampleRate;
+
+    // バスの負荷は、このブロックで送ったトラックで等分する（残響だけのブロックは按分先なし）
+    for (auto bus : { SendBuses::reverbBus, SendBuses::delayBus })
     {
-        masterReadPosition = (masterReadPosition + numSamples) % masterLoopLength;
+        const auto senders = sendBuses.getSenders(bus);
+        const auto start = DspLoadMonitor::readCycles();
+        if (!sendBuses.processReturn(bus, output, numSamples, delaySamples) || senders == 0)
+            continue;
+
+        const auto share = (DspLoadMonitor::readCycles() - start) / (juce::uint64)juce::countNumberOfBits(senders);
+        const auto stage = bus == SendBuses::reverbBus ? DspLoadMonitor::Stage::reverb : DspLoadMonitor::Stage::delay;
+        for (int slot = 0; slot < numTracks; ++slot)
+            if ((senders >> slot) & 1)
+                loadMonitor.addStageCycles(slot, stage, share);
     }
 }
 
-void LooperAudio::backupTrackBeforeRecord(int trackId)
+// ================= Undo / Redo =================
+// 履歴は「録音前のトラック状態」をリングに積んだもの。ページ表は参照を足して共有するだけなので、
+// 何段積んでもオーディオスレッドでのコストはページ数ぶんのポインタ操作で済む
+
+void LooperAudio::pushHistory(int slot)
+{
+    // 新しく録音したら、取り消し済みの録音（REDO 側）には戻れない
+    dropRedoHistory();
+
+    if (historySize == maxHistoryEntries)
+        evictOldestHistory();
+
+    auto track = trackAt(slot);
+    auto& entry = historyAt(historySize);
+    entry.trackId = trackIds[(size_t)slot];
+    entry.buffer.shareFrom(track.buffer);
+    entry.recordLength = track.recordLength;
+    entry.lengthInSample = track.lengthInSample;
+    entry.loopMultiplier = track.loopMultiplier;
+    entry.recordStartSample = track.recordStartSample;
+    entry.recordingStartPhase = track.recordingStartPhase;
+
+    historyCursor = ++historySize;
+    enforceUndoBudget();
+    publishHistoryState();
+}
+
+void LooperAudio::swapWithHistory(int slot, TrackHistory& entry)
+{
+    auto track = trackAt(slot);
+
+    // ページ表と長さ情報を入れ替えるだけ（コピーなし）
+    track.buffer.swapWith(entry.buffer);
+    std::swap(track.recordLength, entry.recordLength);
+    std::swap(track.lengthInSample, entry.lengthInSample);
+    std::swap(track.loopMultiplier, entry.loopMultiplier);
+    std::swap(track.recordStartSample, entry.recordStartSample);
+    std::swap(track.recordingStartPhase, entry.recordingStartPhase);
+
+    track.isRecording = false;
+    track.isPlaying = false;
+    track.writePosition = 0;
+    track.readPosition = 0;
+}
+
+bool LooperAudio::evictOldestHistory()
+{
+    // REDO 側しか残っていないときは捨てない（カーソルより前だけが古い履歴）
+    if (historyCursor == 0)
+        return false;
+
+    auto& entry = historyAt(0);
+    entry.buffer.setSize(0); // 他で共有されていなければページはプールへ戻る
+    entry.trackId = -1;
+
+    historyHead = (historyHead + 1) % maxHistoryEntries;
+    --historySize;
+    --historyCursor;
+    return true;
+}
+
+void LooperAudio::dropRedoHistory()
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    while (historySize > historyCursor)
     {
-        lastHistory = TrackHistory();
-        lastHistory->trackId = trackId;
-        lastHistory->previousBuffer.makeCopyOf(it->second.buffer);
+        auto& entry = historyAt(--historySize);
+        entry.buffer.setSize(0);
+        entry.trackId = -1;
+    }
+}
+
+void LooperAudio::clearHistory()
+{
+    for (auto& entry : history)
+    {
+        entry.buffer.setSize(0);
+        entry.trackId = -1;
+    }
+
+    historyHead = historySize = historyCursor = 0;
+    publishHistoryState();
+}
+
+void LooperAudio::enforceUndoBudget()
+{
+    int pages = 0;
+    for (int i = 0; i < historySize; ++i)
+        pages += historyAt(i).buffer.getNumPages();
+
+    const int budgetPages = undoBudgetSamples.load() / pagePool.getPageSize();
+    while (pages > budgetPages && historyCursor > 0)
+    {
+        pages -= historyAt(0).buffer.getNumPages();
+        evictOldestHistory();
+    }
+}
+
+void LooperAudio::publishHistoryState()
+{
+    int pages = 0;
+    for (int i = 0; i < historySize; ++i)
+        pages += historyAt(i).buffer.getNumPages();
+
+    historyPagesInUse.store(pages);
+    undoableTrackId.store(historyCursor > 0 ? historyAt(historyCursor - 1).trackId : -1);
+    redoableTrackId.store(historyCursor < historySize ? historyAt(historyCursor).trackId : -1);
+}
+
+bool LooperAudio::resizeTrackBuffer(PagedLoopBuffer& buffer, int numSamples)
+{
+    if (buffer.setSize(numSamples))
+        return true;
+
+    // ループ用メモリが尽きたら、古い履歴から手放して録音を優先する
+    bool evicted = false;
+    while (evictOldestHistory())
+    {
+        evicted = true;
+        if (buffer.setSize(numSamples))
+            break;
+    }
 
-        DBG("💾 Backup created for track " << trackId);
+    if (evicted)
+    {
+        publishHistoryState();
     }
+
+    return buffer.getNumSamples() == juce::jmax(0, numSamples);
 }
 
 int LooperAudio::undoLastRecording()
 {
-    if (!lastHistory.has_value())
+    // 履歴本体はオーディオスレッドが持っているので、ここでは依頼するだけ
+    // （表示の更新は onTrackRestored で届く）
+    const int undoneTrackId = undoableTrackId.load();
+    if (undoneTrackId < 0)
     {
         DBG("⚠️ Nothing to undo");
         return -1;
     }
 
-    auto& history = lastHistory.value();
-    int undoneTrackId = history.trackId;
-    
-    if (auto it = tracks.find(history.trackId); it != tracks.end())
+    postCommand(LooperCommand::make(LooperCommand::Type::Undo, undoneTrackId));
+    return undoneTrackId;
+}
+
+int LooperAudio::redoLastRecording()
+{
+    const int redoneTrackId = redoableTrackId.load();
+    if (redoneTrackId < 0)
     {
-        it->second.buffer.makeCopyOf(history.previousBuffer);
-        it->second.isRecording = false;
-        it->second.isPlaying = false;
-        it->second.writePosition = 0;
-        it->second.recordLength = history.previousBuffer.getNumSamples();
+        DBG("⚠️ Nothing to redo");
+        return -1;
+    }
+
+    postCommand(LooperCommand::make(LooperCommand::Type::Redo, redoneTrackId));
+    return redoneTrackId;
+}
+
+void LooperAudio::applyUndo()
+{
+    if (historyCursor == 0)
+        return;
 
-        DBG("↩️ Undo applied to track " << history.trackId);
+    auto& entry = historyAt(historyCursor - 1);
+    const int slot = slotOf(entry.trackId);
+    if (slot < 0)
+        return;
+
+    // 録音中のトラックは入れ替えない（録音が終わってから）
+    if (trackAt(slot).isRecording)
+    {
+        return;
     }
-    lastHistory.reset();
-    return undoneTrackId;
+
+    // 入れ替えたあとの entry が REDO 用の状態になる
+    swapWithHistory(slot, entry);
+    --historyCursor;
+    enforceUndoBudget();
+    publishHistoryState();
+    notifyTrackRestored(entry.trackId);
+}
+
+void LooperAudio::applyRedo()
+{
+    if (historyCursor >= historySize)
+        return;
+
+    auto& entry = historyAt(historyCursor);
+    const int slot = slotOf(entry.trackId);
+    if (slot < 0 || trackAt(slot).isRecording)
+        return;
+
+    swapWithHistory(slot, entry);
+    ++historyCursor;
+    enforceUndoBudget();
+    publishHistoryState();
+    notifyTrackRestored(entry.trackId);
 }
 
 void LooperAudio::allClear()
 {
-    for (auto& [id, track] : tracks)
+    postCommand(LooperCommand::make(LooperCommand::Type::AllClear, -1));
+}
+
+void LooperAudio::applyAllClear()
+{
+    for (int slot = 0; slot < numTracks; ++slot)
     {
-        track.buffer.clear();
+        auto track = trackAt(slot);
+        track.buffer.setSize(0); // ページはプールへ返す
+        dropWaveformSnapshot(slot); // 読まれていない波形もページを返す
         track.isPlaying = false;
         track.isRecording = false;
         track.writePosition = 0;
@@ -1166,35 +1379,15 @@ void LooperAudio::allClear()
         track.loopMultiplier = 1.0f; // Multiplierもリセット
         
         // === FXリセット ===
-        // DelayLineのバッファをクリア（ゴミデータがノイズの原因）
-        track.fx.delay.reset();
-        
-        // Reverbの内部状態をリセット
-        track.fx.reverb.reset();
-        
-        // Filterの内部状態をリセット
-        track.fx.filter.reset();
-        
-        // Compressorの内部状態をリセット
-        track.fx.compressor.reset();
-        
-        // Flanger/Chorusの内部状態をリセット
-        track.fx.flanger.reset();
-        track.fx.chorus.reset();
-        
-        // Autotune関連リセット
-        track.fx.autotune.smoothedRatio = 1.0f;
-        track.fx.autotune.currentPitch = 0.0f;
-        track.fx.autotune.targetPitch = 0.0f;
-        
-        // LFO phaseリセット
-        track.fx.flangerPhase = 0.0;
-        track.fx.chorusPhase = 0.0;
-        track.fx.tremoloPhase = 0.0;
-        track.fx.slicerPhase = 0.0;
+        // モジュールの内部状態（ディレイライン・残響・LFO 位相など）を消す（IR は残す）
+        track.fx.graph.resetModules();
+        track.fx.convolution.reset();
+        sendBuses.clearSlot(slot);
         
         // Enable状態をリセット
         track.fx.filterEnabled = false;
+        track.fx.compressorEnabled = false;
+        track.fx.bitcrusherEnabled = false;
         track.fx.delayEnabled = false;
         track.fx.reverbEnabled = false;
         track.fx.flangerEnabled = false;
@@ -1202,19 +1395,30 @@ void LooperAudio::allClear()
         track.fx.tremoloEnabled = false;
         track.fx.slicerEnabled = false;
         track.fx.beatRepeat.isActive = false;
+        track.fx.granular.enabled = false;
         track.fx.autotune.enabled = false;
+        track.fx.graph.compile(track.fx);
     }
+    // 共有バスの残響も消す
+    sendBuses.reset();
+
     masterTrackId = -1;
     masterLoopLength = 0;
     masterReadPosition = 0;
 
-    DBG("🧹 LooperAudio::clearAll() → All buffers and FX cleared");
+    clearHistory();
 }
 
 void LooperAudio::stopAllTracks()
 {
-    for (auto& [id, track] : tracks)
+    postCommand(LooperCommand::make(LooperCommand::Type::StopAllTracks, -1));
+}
+
+void LooperAudio::applyStopAllTracks()
+{
+    for (int slot = 0; slot < numTracks; ++slot)
     {
+        auto track = trackAt(slot);
         track.isRecording = false;
         track.isPlaying = false;
         track.readPosition = 0; // 停止時に読み込み位置を先頭に戻す
@@ -1227,43 +1431,44 @@ int LooperAudio::getCurrentTrackId() const
     if (currentRecordingIndex >= 0 && currentRecordingIndex < (int)recordingQueue.size())
         return recordingQueue[currentRecordingIndex];
 
-    if (!tracks.empty())
-        return tracks.begin()->first;
+    if (numTracks > 0)
+        return *std::min_element(trackIds.begin(), trackIds.begin() + numTracks);
 
     return -1;
 }
 
 bool LooperAudio::isAnyRecording() const
 {
-    return anyTrackSatisfies(tracks, [](const auto& t) { return t.isRecording; });
+    const auto end = transport.isRecording.begin() + numTracks;
+    return std::find(transport.isRecording.begin(), end, true) != end;
 }
 
 bool LooperAudio::isAnyPlaying() const
 {
-    return anyTrackSatisfies(tracks, [](const auto& t) { return t.isPlaying; });
+    const auto end = transport.isPlaying.begin() + numTracks;
+    return std::find(transport.isPlaying.begin(), end, true) != end;
 }
 
 bool LooperAudio::hasRecordedTracks() const
 {
-    for (const auto& [id, track] : tracks)
-        if (track.recordLength > 0) return true;
+    for (int slot = 0; slot < numTracks; ++slot)
+        if (transport.recordLength[(size_t)slot] > 0) return true;
     return false;
 }
 
 
 
-void LooperAudio::setTrackGain(int trackId, float gain)
+void LooperAudio::generateTestClick(int trackId)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.gain = gain;
+    postCommand(LooperCommand::make(LooperCommand::Type::GenerateTestClick, trackId));
 }
 
-void LooperAudio::generateTestClick(int trackId)
+void LooperAudio::applyGenerateTestClick(int trackId)
 {
-    auto it = tracks.find(trackId);
-    if (it == tracks.end()) return;
+    const int slot = slotOf(trackId);
+    if (slot < 0) return;
     
-    auto& track = it->second;
+    auto track = trackAt(slot);
     
     const int samplesPerBeat = static_cast<int>(sampleRate * 0.5);
     const int numBeats = 4;
@@ -1272,6 +1477,10 @@ void LooperAudio::generateTestClick(int trackId)
     const float clickFrequency = 1000.0f;  
     const int clickDuration = static_cast<int>(sampleRate * 0.02); 
     
+    if (!track.buffer.setSize(totalSamples))
+    {
+        return;
+    }
     track.buffer.clear();
     
     for (int beat = 0; beat < numBeats; ++beat)
@@ -1302,14 +1511,17 @@ void LooperAudio::generateTestClick(int trackId)
         masterLoopLength = totalSamples;
         masterStartSample = 0;
         masterReadPosition = 0;
-        DBG("🎛 Master loop set from test click: " << totalSamples << " samples");
     }
     
-    DBG("🔊 Test click generated for track " << trackId << " | " << numBeats << " beats @ 120BPM");
-    listeners.call([trackId](Listener& l) { l.onRecordingStopped(trackId); });
+    notifyRecordingStopped(trackId);
 }
 
 void LooperAudio::generateTestWaveformsForVisualTest()
+{
+    postCommand(LooperCommand::make(LooperCommand::Type::GenerateTestWaveforms, -1));
+}
+
+void LooperAudio::applyGenerateTestWaveforms()
 {
     // 120BPM = 0.5秒/ビート、4ビート = 2秒がマスターループ
     const int samplesPerBeat = static_cast<int>(sampleRate * 0.5);
@@ -1319,7 +1531,7 @@ void LooperAudio::generateTestWaveformsForVisualTest()
     const float clickFrequency = 1000.0f;
     const int clickDuration = static_cast<int>(sampleRate * 0.02);
     
-    auto generateClick = [this, clickFrequency, clickDuration](juce::AudioBuffer<float>& buffer, int position) {
+    auto generateClick = [this, clickFrequency, clickDuration](PagedLoopBuffer& buffer, int position) {
         for (int i = 0; i < clickDuration && (position + i) < buffer.getNumSamples(); ++i)
         {
             float envelope = std::exp(-5.0f * (float)i / (float)clickDuration);
@@ -1332,9 +1544,10 @@ void LooperAudio::generateTestWaveformsForVisualTest()
     };
     
     // ===== トラック1: マスター（等倍）=====
+    if (const int slot = slotOf(1); slot >= 0)
     {
-        auto& track = tracks[1];
-        track.buffer.setSize(2, masterSamples);
+        auto track = trackAt(slot);
+        track.buffer.setSize(masterSamples);
         track.buffer.clear();
         
         // 4拍のクリック音（各拍の先頭）
@@ -1354,15 +1567,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         masterReadPosition = 0;
         masterTrackId = 1;
         
-        DBG("🎵 Track 1 (Master x1): " << masterSamples << " samples, 4 clicks");
-        listeners.call([](Listener& l) { l.onRecordingStopped(1); });
+        notifyRecordingStopped(1);
     }
     
     // ===== トラック2: x2（先頭にクリック）=====
+    if (const int slot = slotOf(2); slot >= 0)
     {
-        auto& track = tracks[2];
+        auto track = trackAt(slot);
         int x2Samples = masterSamples * 2;  // x2 = 8拍分
-        track.buffer.setSize(2, x2Samples);
+        track.buffer.setSize(x2Samples);
         track.buffer.clear();
         
         // 先頭にクリック（x2ループの開始点を示す）
@@ -1379,15 +1592,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 2 (x2): " << x2Samples << " samples, clicks at 0 and " << masterSamples);
-        listeners.call([](Listener& l) { l.onRecordingStopped(2); });
+        notifyRecordingStopped(2);
     }
     
     // ===== トラック3: /2（先頭にクリック）=====
+    if (const int slot = slotOf(3); slot >= 0)
     {
-        auto& track = tracks[3];
+        auto track = trackAt(slot);
         int halfSamples = masterSamples / 2;  // /2 = 2拍分
-        track.buffer.setSize(2, halfSamples);
+        track.buffer.setSize(halfSamples);
         track.buffer.clear();
         
         // 先頭にクリック（/2ループの開始点を示す）
@@ -1401,14 +1614,14 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 3 (/2): " << halfSamples << " samples, click at 0");
-        listeners.call([](Listener& l) { l.onRecordingStopped(3); });
+        notifyRecordingStopped(3);
     }
     
     // ===== トラック4: x1 (2拍目から録音開始、長さは1周分) =====
+    if (const int slot = slotOf(4); slot >= 0)
     {
-        auto& track = tracks[4];
-        track.buffer.setSize(2, masterSamples); // フル尺確保
+        auto track = trackAt(slot);
+        track.buffer.setSize(masterSamples); // フル尺確保
         track.buffer.clear();
         
         // 録音開始直後（バッファ先頭）にクリック
@@ -1423,15 +1636,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 4 (x1, Start@Beat2): click at buffer start, len: " << masterSamples);
-        listeners.call([](Listener& l) { l.onRecordingStopped(4); });
+        notifyRecordingStopped(4);
     }
 
     // ===== トラック5: x2 (2拍目から録音開始、長さはx2周分) =====
+    if (const int slot = slotOf(5); slot >= 0)
     {
-        auto& track = tracks[5];
+        auto track = trackAt(slot);
         int x2Samples = masterSamples * 2;
-        track.buffer.setSize(2, x2Samples); // フル尺確保
+        track.buffer.setSize(x2Samples); // フル尺確保
         track.buffer.clear();
         
         // 最初の小節の2拍目（バッファ先頭）にのみクリック。2小節目（後半）は無音。
@@ -1445,15 +1658,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 5 (x2, Start@Beat2): click at buffer start, len: " << x2Samples);
-        listeners.call([](Listener& l) { l.onRecordingStopped(5); });
+        notifyRecordingStopped(5);
     }
 
     // ===== トラック6: /2 (2拍目から録音開始、長さは/2周分) =====
+    if (const int slot = slotOf(6); slot >= 0)
     {
-        auto& track = tracks[6];
+        auto track = trackAt(slot);
         int halfSamples = masterSamples / 2;
-        track.buffer.setSize(2, halfSamples); // フル尺確保
+        track.buffer.setSize(halfSamples); // フル尺確保
         track.buffer.clear();
         
         generateClick(track.buffer, 0);
@@ -1466,15 +1679,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 6 (/2, Start@Beat2): click at buffer start, len: " << halfSamples);
-        listeners.call([](Listener& l) { l.onRecordingStopped(6); });
+        notifyRecordingStopped(6);
     }
 
     // ===== トラック7: x2 (2小節目の4拍目から録音開始) =====
+    if (const int slot = slotOf(7); slot >= 0)
     {
-        auto& track = tracks[7];
+        auto track = trackAt(slot);
         int x2Samples = masterSamples * 2;
-        track.buffer.setSize(2, x2Samples);
+        track.buffer.setSize(x2Samples);
         track.buffer.clear();
         
         // 録音開始直後（バッファ先頭）にクリック
@@ -1492,15 +1705,15 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 7 (x2, Start@Bar2-Beat4): click at buffer start");
-        listeners.call([](Listener& l) { l.onRecordingStopped(7); });
+        notifyRecordingStopped(7);
     }
 
     // ===== トラック8: /2 (2小節目の4拍目から録音開始) =====
+    if (const int slot = slotOf(8); slot >= 0)
     {
-        auto& track = tracks[8];
+        auto track = trackAt(slot);
         int halfSamples = masterSamples / 2;
-        track.buffer.setSize(2, halfSamples);
+        track.buffer.setSize(halfSamples);
         track.buffer.clear();
         
         generateClick(track.buffer, 0);
@@ -1517,417 +1730,492 @@ void LooperAudio::generateTestWaveformsForVisualTest()
         track.isPlaying = true;
         track.isRecording = false;
         
-        DBG("🎵 Track 8 (/2, Start@Bar2-Beat4): click at buffer start");
-        listeners.call([](Listener& l) { l.onRecordingStopped(8); });
+        notifyRecordingStopped(8);
     }
-    
-    DBG("✅ Visual test waveforms generated: T1-3(Full), T4-6(Punch-in @ Beat2), T7-8(Punch-in @ Bar2-Beat4)");
-}
-
-void LooperAudio::setTrackFilterCutoff(int trackId, float freq)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.filter.setCutoffFrequency(freq);
 }
 
-void LooperAudio::setTrackFilterResonance(int trackId, float q)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.filter.setResonance(q);
-}
+// ================= Track / FX Setters (メッセージスレッド) =================
+// すべてコマンド化してキューに積むだけ。実際の書き換えは applyCommand で行う
+
+using Cmd = LooperCommand::Type;
+
+void LooperAudio::setTrackGain(int trackId, float gain)                    { postCommand(LooperCommand::make(Cmd::Gain, trackId, gain)); }
+void LooperAudio::setTrackLoopMultiplier(int trackId, float multiplier)    { postCommand(LooperCommand::make(Cmd::LoopMultiplier, trackId, multiplier)); }
+void LooperAudio::setTrackInputPair(int trackId, int inputPair)            { postCommand(LooperCommand::makeInt(Cmd::InputPair, trackId, inputPair)); }
+
+void LooperAudio::setTrackFilterEnabled(int trackId, bool enabled)         { setTrackModuleEnabled(trackId, FxModuleType::filter, Cmd::FilterEnabled, enabled); }
+void LooperAudio::setTrackFilterCutoff(int trackId, float freq)            { postCommand(LooperCommand::make(Cmd::FilterCutoff, trackId, freq)); }
+void LooperAudio::setTrackFilterResonance(int trackId, float q)            { postCommand(LooperCommand::make(Cmd::FilterResonance, trackId, q)); }
+void LooperAudio::setTrackFilterType(int trackId, int type)                { postCommand(LooperCommand::makeInt(Cmd::FilterType, trackId, type)); }
+
+void LooperAudio::setTrackFlangerEnabled(int trackId, bool enabled)        { setTrackModuleEnabled(trackId, FxModuleType::flanger, Cmd::FlangerEnabled, enabled); }
+void LooperAudio::setTrackFlangerRate(int trackId, float rate)             { postCommand(LooperCommand::make(Cmd::FlangerRate, trackId, rate)); }
+void LooperAudio::setTrackFlangerDepth(int trackId, float depth)           { postCommand(LooperCommand::make(Cmd::FlangerDepth, trackId, depth)); }
+void LooperAudio::setTrackFlangerFeedback(int trackId, float feedback)     { postCommand(LooperCommand::make(Cmd::FlangerFeedback, trackId, feedback)); }
+void LooperAudio::setTrackFlangerSync(int trackId, bool sync)              { postCommand(LooperCommand::makeInt(Cmd::FlangerSync, trackId, sync)); }
 
-void LooperAudio::setTrackFilterType(int trackId, int type)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+void LooperAudio::setTrackChorusEnabled(int trackId, bool enabled)         { setTrackModuleEnabled(trackId, FxModuleType::chorus, Cmd::ChorusEnabled, enabled); }
+void LooperAudio::setTrackChorusRate(int trackId, float rate)              { postCommand(LooperCommand::make(Cmd::ChorusRate, trackId, rate)); }
+void LooperAudio::setTrackChorusDepth(int trackId, float depth)            { postCommand(LooperCommand::make(Cmd::ChorusDepth, trackId, depth)); }
+void LooperAudio::setTrackChorusMix(int trackId, float mix)                { postCommand(LooperCommand::make(Cmd::ChorusMix, trackId, mix)); }
+void LooperAudio::setTrackChorusSync(int trackId, bool sync)               { postCommand(LooperCommand::makeInt(Cmd::ChorusSync, trackId, sync)); }
+
+void LooperAudio::setTrackTremoloEnabled(int trackId, bool enabled)        { setTrackModuleEnabled(trackId, FxModuleType::tremolo, Cmd::TremoloEnabled, enabled); }
+void LooperAudio::setTrackTremoloRate(int trackId, float rate)             { postCommand(LooperCommand::make(Cmd::TremoloRate, trackId, rate)); }
+void LooperAudio::setTrackTremoloDepth(int trackId, float depth)           { postCommand(LooperCommand::make(Cmd::TremoloDepth, trackId, depth)); }
+void LooperAudio::setTrackTremoloShape(int trackId, int shape)             { postCommand(LooperCommand::makeInt(Cmd::TremoloShape, trackId, shape)); }
+void LooperAudio::setTrackTremoloSync(int trackId, bool sync)              { postCommand(LooperCommand::makeInt(Cmd::TremoloSync, trackId, sync)); }
+
+void LooperAudio::setTrackSlicerEnabled(int trackId, bool enabled)         { setTrackModuleEnabled(trackId, FxModuleType::slicer, Cmd::SlicerEnabled, enabled); }
+void LooperAudio::setTrackSlicerRate(int trackId, float rate)              { postCommand(LooperCommand::make(Cmd::SlicerRate, trackId, rate)); }
+void LooperAudio::setTrackSlicerDepth(int trackId, float depth)            { postCommand(LooperCommand::make(Cmd::SlicerDepth, trackId, depth)); }
+void LooperAudio::setTrackSlicerDuty(int trackId, float duty)              { postCommand(LooperCommand::make(Cmd::SlicerDuty, trackId, duty)); }
+void LooperAudio::setTrackSlicerShape(int trackId, int shape)              { postCommand(LooperCommand::makeInt(Cmd::SlicerShape, trackId, shape)); }
+void LooperAudio::setTrackSlicerSync(int trackId, bool sync)               { postCommand(LooperCommand::makeInt(Cmd::SlicerSync, trackId, sync)); }
+
+void LooperAudio::setTrackBitcrusherEnabled(int trackId, bool enabled)     { setTrackModuleEnabled(trackId, FxModuleType::bitcrusher, Cmd::BitcrusherEnabled, enabled); }
+void LooperAudio::setTrackBitcrusherDepth(int trackId, float depth)        { postCommand(LooperCommand::make(Cmd::BitcrusherDepth, trackId, depth)); }
+void LooperAudio::setTrackBitcrusherRate(int trackId, float rate)          { postCommand(LooperCommand::make(Cmd::BitcrusherRate, trackId, rate)); }
+
+void LooperAudio::setTrackGranularEnabled(int trackId, bool enabled)       { setTrackModuleEnabled(trackId, FxModuleType::granular, Cmd::GranularEnabled, enabled); }
+void LooperAudio::setTrackGranularSize(int trackId, float sizeMs)          { postCommand(LooperCommand::make(Cmd::GranularSize, trackId, sizeMs)); }
+void LooperAudio::setTrackGranularDensity(int trackId, float density)      { postCommand(LooperCommand::make(Cmd::GranularDensity, trackId, density)); }
+void LooperAudio::setTrackGranularPitch(int trackId, float pitchVal)       { postCommand(LooperCommand::make(Cmd::GranularPitch, trackId, pitchVal)); }
+void LooperAudio::setTrackGranularJitter(int trackId, float jitterVal)     { postCommand(LooperCommand::make(Cmd::GranularJitter, trackId, jitterVal)); }
+void LooperAudio::setTrackGranularMix(int trackId, float mix)              { postCommand(LooperCommand::make(Cmd::GranularMix, trackId, mix)); }
+
+void LooperAudio::setTrackAutotuneEnabled(int trackId, bool enabled)       { setTrackModuleEnabled(trackId, FxModuleType::autotune, Cmd::AutotuneEnabled, enabled); }
+void LooperAudio::setTrackAutotuneKey(int trackId, int key)                { postCommand(LooperCommand::makeInt(Cmd::AutotuneKey, trackId, key)); }
+void LooperAudio::setTrackAutotuneScale(int trackId, int scale)            { postCommand(LooperCommand::makeInt(Cmd::AutotuneScale, trackId, scale)); }
+void LooperAudio::setTrackAutotuneAmount(int trackId, float amount)        { postCommand(LooperCommand::make(Cmd::AutotuneAmount, trackId, amount)); }
+void LooperAudio::setTrackAutotuneSpeed(int trackId, float speed)          { postCommand(LooperCommand::make(Cmd::AutotuneSpeed, trackId, speed)); }
+void LooperAudio::setTrackAutotuneFormants(int trackId, bool preserve)     { postCommand(LooperCommand::makeInt(Cmd::AutotuneFormants, trackId, preserve)); }
+
+void LooperAudio::setTrackReverbEnabled(int trackId, bool enabled)         { setTrackModuleEnabled(trackId, FxModuleType::reverb, Cmd::ReverbEnabled, enabled); }
+void LooperAudio::setTrackReverbMix(int trackId, float mix)                { postCommand(LooperCommand::make(Cmd::ReverbMix, trackId, mix)); }
+void LooperAudio::setTrackReverbDamping(int trackId, float damping)        { postCommand(LooperCommand::make(Cmd::ReverbDamping, trackId, damping)); }
+void LooperAudio::setTrackReverbRoomSize(int trackId, float size)          { postCommand(LooperCommand::make(Cmd::ReverbRoomSize, trackId, size)); }
+
+// IR はコマンドキューを通さない（ConvolutionReverb がポインタ1つでオーディオスレッドへ渡す）
+bool LooperAudio::setTrackReverbImpulse(int trackId, const juce::AudioBuffer<float>& impulse, double impulseSampleRate)
+{
+    const int slot = slotOf(trackId);
+    if (slot < 0)
+        return false;
+    return trackData[(size_t)slot].fx->convolution.loadImpulse(impulse, impulseSampleRate);
+}
+
+void LooperAudio::clearTrackReverbImpulse(int trackId)
+{
+    if (const int slot = slotOf(trackId); slot >= 0)
+        trackData[(size_t)slot].fx->convolution.clearImpulse();
+}
+
+void LooperAudio::setTrackReverbSend(int trackId, float level)             { postCommand(LooperCommand::make(Cmd::ReverbSend, trackId, level)); }
+void LooperAudio::setTrackDelaySend(int trackId, float level)              { postCommand(LooperCommand::make(Cmd::DelaySend, trackId, level)); }
+void LooperAudio::setBusReverbRoomSize(float size)                         { postCommand(LooperCommand::make(Cmd::BusReverbRoomSize, -1, size)); }
+void LooperAudio::setBusReverbDamping(float damping)                       { postCommand(LooperCommand::make(Cmd::BusReverbDamping, -1, damping)); }
+void LooperAudio::setBusReverbReturn(float level)                          { postCommand(LooperCommand::make(Cmd::BusReverbReturn, -1, level)); }
+void LooperAudio::setBusDelayTime(float seconds)                           { postCommand(LooperCommand::make(Cmd::BusDelayTime, -1, seconds)); }
+void LooperAudio::setBusDelayFeedback(float feedback)                      { postCommand(LooperCommand::make(Cmd::BusDelayFeedback, -1, feedback)); }
+void LooperAudio::setBusDelaySync(bool sync)                               { postCommand(LooperCommand::makeInt(Cmd::BusDelaySync, -1, sync)); }
+void LooperAudio::setBusDelayDivision(int division)                        { postCommand(LooperCommand::makeInt(Cmd::BusDelayDivision, -1, division)); }
+void LooperAudio::setBusDelayReturn(float level)                           { postCommand(LooperCommand::make(Cmd::BusDelayReturn, -1, level)); }
+
+void LooperAudio::setTrackDelayEnabled(int trackId, bool enabled)          { setTrackModuleEnabled(trackId, FxModuleType::delay, Cmd::DelayEnabled, enabled); }
+void LooperAudio::setTrackDelayMix(int trackId, float mix, float time)     { postCommand(LooperCommand::make(Cmd::DelayMix, trackId, mix, time)); }
+void LooperAudio::setTrackDelayFeedback(int trackId, float feedback)       { postCommand(LooperCommand::make(Cmd::DelayFeedback, trackId, feedback)); }
+void LooperAudio::setTrackDelaySync(int trackId, bool sync)                { postCommand(LooperCommand::makeInt(Cmd::DelaySync, trackId, sync)); }
+void LooperAudio::setTrackDelayDivision(int trackId, int division)         { postCommand(LooperCommand::makeInt(Cmd::DelayDivision, trackId, division)); }
+void LooperAudio::setTrackDelayPingPong(int trackId, bool pingPong)        { postCommand(LooperCommand::makeInt(Cmd::DelayPingPong, trackId, pingPong)); }
+
+void LooperAudio::setTrackCompressor(int trackId, float threshold, float ratio) { postCommand(LooperCommand::make(Cmd::Compressor, trackId, threshold, ratio)); }
+void LooperAudio::setTrackCompressorEnabled(int trackId, bool enabled)      { setTrackModuleEnabled(trackId, FxModuleType::compressor, Cmd::CompressorEnabled, enabled); }
+void LooperAudio::setTrackCompressorLookahead(int trackId, bool lookahead)  { postCommand(LooperCommand::makeInt(Cmd::CompressorLookahead, trackId, lookahead)); }
+
+void LooperAudio::setTrackBeatRepeatActive(int trackId, bool active)       { postCommand(LooperCommand::makeInt(Cmd::BeatRepeatActive, trackId, active)); }
+void LooperAudio::setTrackBeatRepeatDiv(int trackId, int div)              { postCommand(LooperCommand::makeInt(Cmd::BeatRepeatDiv, trackId, div)); }
+void LooperAudio::setTrackBeatRepeatThresh(int trackId, float thresh)      { postCommand(LooperCommand::make(Cmd::BeatRepeatThresh, trackId, thresh)); }
+
+void LooperAudio::setTrackFxSlot(int trackId, int slotIndex, int moduleType)
+{
+    auto cmd = LooperCommand::makeInt(Cmd::FxSlot, trackId, slotIndex);
+    cmd.floatValue = (float)moduleType;
+    postCommand(cmd);
+}
+
+//==============================================================================
+// コマンド適用（オーディオスレッド / processBlock 内のみ）
+//==============================================================================
+
+void LooperAudio::applyCommand(const LooperCommand& cmd)
+{
+    const int trackId = cmd.trackId;
+    const float value = cmd.floatValue;
+    const bool on = cmd.intValue != 0;
+
+    // トラックを伴わない操作
+    switch (cmd.type)
     {
-        if(type == 0) it->second.fx.filter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
-        else if(type == 1) it->second.fx.filter.setType(juce::dsp::StateVariableTPTFilterType::highpass);
+        case Cmd::StartRecording:        applyStartRecording(trackId, triggerRef); return;
+        case Cmd::StopRecording:         applyStopRecording(trackId); return;
+        case Cmd::StartPlaying:          applyStartPlaying(trackId, on); return;
+        case Cmd::StartAllPlayback:      applyStartAllPlayback(); return;
+        case Cmd::StopAllTracks:         applyStopAllTracks(); return;
+        case Cmd::AllClear:              applyAllClear(); return;
+        case Cmd::Undo:                  applyUndo(); return;
+        case Cmd::Redo:                  applyRedo(); return;
+        case Cmd::MasterPositionReset:   masterReadPosition = 0; return;
+        case Cmd::GenerateTestClick:     applyGenerateTestClick(trackId); return;
+        case Cmd::GenerateTestWaveforms: applyGenerateTestWaveforms(); return;
+        case Cmd::LoopMultiplier:        applyLoopMultiplier(trackId, value); return;
+
+        // --- Send / Return バス ---
+        case Cmd::BusReverbRoomSize:     sendBuses.setReverbRoomSize(value); return;
+        case Cmd::BusReverbDamping:      sendBuses.setReverbDamping(value); return;
+        case Cmd::BusReverbReturn:       sendBuses.setReturnLevel(SendBuses::reverbBus, value); return;
+        case Cmd::BusDelayTime:          sendBuses.getDelaySettings().timeSeconds = value; return;
+        case Cmd::BusDelayFeedback:      sendBuses.getDelaySettings().feedback = juce::jlimit(0.0f, 0.95f, value); return;
+        case Cmd::BusDelaySync:          sendBuses.getDelaySettings().sync = on; return;
+        case Cmd::BusDelayDivision:      sendBuses.getDelaySettings().division = juce::jlimit(0, BlockDelay::numDivisions - 1, cmd.intValue); return;
+        case Cmd::BusDelayReturn:        sendBuses.setReturnLevel(SendBuses::delayBus, value); return;
+        default: break;
     }
-}
 
-void LooperAudio::setTrackCompressor(int trackId, float threshold, float ratio)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-    {
-        it->second.fx.compressor.setThreshold(threshold);
-        it->second.fx.compressor.setRatio(ratio);
-    }
-}
-
-void LooperAudio::setTrackDelayMix(int trackId, float mix, float time)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-    {
-        it->second.fx.delayMix = mix;
-        
-        float maxDelay = sampleRate * 1.0f;
-        float delaySamples = time * maxDelay;
-        if(delaySamples < 1.0f) delaySamples = 1.0f;
-        
-        it->second.fx.delay.setDelay(delaySamples);
-    }
-}
+    const int slot = slotOf(trackId);
+    if (slot < 0)
+        return;
 
-void LooperAudio::setTrackDelayFeedback(int trackId, float feedback)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.delayFeedback = feedback;
-}
+    auto track = trackAt(slot);
+    auto& fx = track.fx;
 
-void LooperAudio::setTrackReverbMix(int trackId, float mix)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    // パラメータを書いたあと、モジュールがあれば係数を計算し直させる
+    auto changed = [&fx](FxModuleType type)
     {
-        it->second.fx.reverbMix = mix;
-        juce::dsp::Reverb::Parameters params = it->second.fx.reverb.getParameters();
-        params.dryLevel = 1.0f - (mix * 0.5f);
-        params.wetLevel = mix;
-        it->second.fx.reverb.setParameters(params);
-    }
-}
+        if (auto* module = fx.graph.getModule(type))
+            module->parametersChanged();
+    };
 
-void LooperAudio::setTrackReverbDamping(int trackId, float damping)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    // ON / OFF を切り替えて処理順を組み直す。ON にしたときは前回の残り（ディレイ・グレイン等）を捨てる
+    auto setEnabled = [&fx](FxModuleType type, bool& enabled, bool newState)
     {
-        juce::dsp::Reverb::Parameters params = it->second.fx.reverb.getParameters();
-        params.damping = damping;
-        it->second.fx.reverb.setParameters(params);
-    }
-}
+        if (newState && !enabled)
+        {
+            if (auto* module = fx.graph.getModule(type))
+            {
+                module->reset();
+                module->parametersChanged();
+            }
+        }
+        enabled = newState;
+        fx.graph.compile(fx);
+    };
 
-void LooperAudio::setTrackReverbRoomSize(int trackId, float size)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    switch (cmd.type)
     {
-        juce::dsp::Reverb::Parameters params = it->second.fx.reverb.getParameters();
-        params.roomSize = size;
-        it->second.fx.reverb.setParameters(params);
+        case Cmd::StopPlaying:      track.isPlaying = false; break;
+        case Cmd::ClearTrack:
+            // ページはプールへ返す。録音中でも止めて、空のバッファへ書き続けないようにする
+            track.buffer.setSize(0);
+            track.isRecording = false;
+            track.isPlaying = false;
+            track.writePosition = 0;
+            track.readPosition = 0;
+            track.recordLength = 0;
+            track.lengthInSample = 0;
+            notifyTrackRestored(trackId); // UI はトラックを空の表示に戻す
+            break;
+        case Cmd::Gain:             track.gain = value; break;
+        case Cmd::InputPair:        transport.inputPair[(size_t)slot] = juce::jmax(0, cmd.intValue); break;
+
+        // --- Filter ---
+        case Cmd::FilterEnabled:    setEnabled(FxModuleType::filter, fx.filterEnabled, on); break;
+        case Cmd::FilterCutoff:     fx.filterCutoff = value; changed(FxModuleType::filter); break;
+        case Cmd::FilterResonance:  fx.filterRes = value; changed(FxModuleType::filter); break;
+        case Cmd::FilterType:
+            if (cmd.intValue == 0 || cmd.intValue == 1)
+            {
+                fx.filterType = cmd.intValue;
+                changed(FxModuleType::filter);
+            }
+            break;
+
+        // --- Flanger ---（レートはモジュールがブロックごとに読む）
+        case Cmd::FlangerEnabled:   setEnabled(FxModuleType::flanger, fx.flangerEnabled, on); break;
+        case Cmd::FlangerRate:      fx.flangerRate = value; break;
+        case Cmd::FlangerDepth:     fx.flangerDepth = value; changed(FxModuleType::flanger); break;
+        case Cmd::FlangerFeedback:  fx.flangerFeedback = value; changed(FxModuleType::flanger); break;
+        case Cmd::FlangerSync:      fx.flangerSync = on; break;
+
+        // --- Chorus ---
+        case Cmd::ChorusEnabled:    setEnabled(FxModuleType::chorus, fx.chorusEnabled, on); break;
+        case Cmd::ChorusRate:       fx.chorusRate = value; break;
+        case Cmd::ChorusDepth:      fx.chorusDepth = value; changed(FxModuleType::chorus); break;
+        case Cmd::ChorusMix:        fx.chorusMix = value; changed(FxModuleType::chorus); break;
+        case Cmd::ChorusSync:       fx.chorusSync = on; break;
+
+        // --- Tremolo ---
+        case Cmd::TremoloEnabled:   setEnabled(FxModuleType::tremolo, fx.tremoloEnabled, on); break;
+        case Cmd::TremoloRate:      fx.tremoloRate = value; break;
+        case Cmd::TremoloDepth:     fx.tremoloDepth = value; break;
+        case Cmd::TremoloShape:     fx.tremoloShape = cmd.intValue; break;
+        case Cmd::TremoloSync:      fx.tremoloSync = on; break;
+
+        // --- Slicer ---
+        case Cmd::SlicerEnabled:    setEnabled(FxModuleType::slicer, fx.slicerEnabled, on); break;
+        case Cmd::SlicerRate:       fx.slicerRate = value; break;
+        case Cmd::SlicerDepth:      fx.slicerDepth = value; break;
+        case Cmd::SlicerDuty:       fx.slicerDuty = value; break;
+        case Cmd::SlicerShape:      fx.slicerShape = cmd.intValue; break;
+        case Cmd::SlicerSync:       fx.slicerSync = on; break;
+
+        // --- Bitcrusher ---
+        case Cmd::BitcrusherEnabled: setEnabled(FxModuleType::bitcrusher, fx.bitcrusherEnabled, on); break;
+        case Cmd::BitcrusherDepth:   fx.bitcrusherDepth = value; break;
+        case Cmd::BitcrusherRate:    fx.bitcrusherRate = value; break;
+
+        // --- Granular ---
+        case Cmd::GranularEnabled:  setEnabled(FxModuleType::granular, fx.granular.enabled, on); break;
+        case Cmd::GranularSize:     fx.granular.grain.sizeMs = value; break;
+        case Cmd::GranularDensity:  fx.granular.grain.density = value; break;
+        case Cmd::GranularPitch:    fx.granular.grain.pitch = value; break;
+        case Cmd::GranularJitter:   fx.granular.grain.jitter = value; break;
+        case Cmd::GranularMix:      fx.granular.mix = value; break;
+
+        // --- Autotune ---
+        case Cmd::AutotuneEnabled:  setEnabled(FxModuleType::autotune, fx.autotune.enabled, on); break;
+        case Cmd::AutotuneKey:      fx.autotune.key = juce::jlimit(0, 11, cmd.intValue); break;
+        case Cmd::AutotuneScale:    fx.autotune.scale = juce::jlimit(0, 2, cmd.intValue); break;
+        case Cmd::AutotuneAmount:   fx.autotune.amount = juce::jlimit(0.0f, 1.0f, value); break;
+        case Cmd::AutotuneSpeed:    fx.autotune.speed = juce::jlimit(0.0f, 1.0f, value); break;
+        case Cmd::AutotuneFormants: fx.autotune.preserveFormants = on; changed(FxModuleType::autotune); break;
+
+        // --- Reverb ---
+        case Cmd::ReverbEnabled:    setEnabled(FxModuleType::reverb, fx.reverbEnabled, on); break;
+        case Cmd::ReverbMix:        fx.reverbMix = value; changed(FxModuleType::reverb); break;
+        case Cmd::ReverbDamping:    fx.reverbDamping = value; changed(FxModuleType::reverb); break;
+        case Cmd::ReverbRoomSize:   fx.reverbRoomSize = value; changed(FxModuleType::reverb); break;
+
+        // --- Delay ---
+        case Cmd::DelayEnabled:     setEnabled(FxModuleType::delay, fx.delayEnabled, on); break;
+        case Cmd::DelayMix:
+            fx.delayMix = value;
+            fx.delayTime = juce::jlimit(0.0f, 1.0f, cmd.floatValue2); // 秒（サンプル数へは DelayModule で）
+            break;
+        case Cmd::DelayFeedback:    fx.delayFeedback = value; break;
+        case Cmd::DelaySync:        fx.delaySync = on; break;
+        case Cmd::DelayDivision:    fx.delayDivision = juce::jlimit(0, BlockDelay::numDivisions - 1, cmd.intValue); break;
+        case Cmd::DelayPingPong:    fx.delayPingPong = on; break;
+
+        // --- Compressor ---
+        case Cmd::Compressor:
+            fx.compressorThreshold = value;
+            fx.compressorRatio = juce::jmax(1.0f, cmd.floatValue2);
+            break;
+        case Cmd::CompressorEnabled: setEnabled(FxModuleType::compressor, fx.compressorEnabled, on); break;
+        case Cmd::CompressorLookahead:
+            // ルックアヘッドの遅延は先読みで揃えるので、切り替えたら遅延の合計が変わる
+            fx.compressorLookahead = on;
+            fx.graph.compile(fx);
+            break;
+
+        // --- Beat Repeat ---
+        case Cmd::BeatRepeatActive:
+            fx.beatRepeat.isActive = on;
+            if (!on)
+                fx.beatRepeat.isRepeating = false;
+            break;
+        case Cmd::BeatRepeatDiv:    fx.beatRepeat.division = juce::jmax(1, cmd.intValue); break;
+        case Cmd::BeatRepeatThresh: fx.beatRepeat.threshold = value; break;
+
+        // --- FX の処理順 ---
+        case Cmd::FxSlot:
+            fx.graph.setSlot(cmd.intValue, (int)value);
+            fx.graph.compile(fx);
+            break;
+
+        // --- Send / Return バス ---
+        case Cmd::ReverbSend:       sendBuses.setSendLevel(slot, SendBuses::reverbBus, value); break;
+        case Cmd::DelaySend:        sendBuses.setSendLevel(slot, SendBuses::delayBus, value); break;
+
+        default: break;
     }
 }
 
-// ================= Beat Repeat Setters =================
-
-void LooperAudio::setTrackBeatRepeatActive(int trackId, bool active)
+void LooperAudio::applyLoopMultiplier(int trackId, float multiplier)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    if (const int slot = slotOf(trackId); slot >= 0)
     {
-        it->second.fx.beatRepeat.isActive = active;
-        if (!active)
-            it->second.fx.beatRepeat.isRepeating = false;
+        auto track = trackAt(slot);
+        track.loopMultiplier = multiplier;
+        
+        // 再生位置を現在の絶対時刻に合わせて再計算（x2切り替え時のズレ防止）
+        if (masterLoopLength > 0)
+        {
+            int64_t relativePos = currentSamplePosition - masterStartSample;
+            int effectiveLoopLength = (int)(masterLoopLength * multiplier);
+            if (effectiveLoopLength > 0)
+            {
+                track.readPosition = (int)(relativePos % effectiveLoopLength);
+            }
+        }
     }
 }
 
-void LooperAudio::setTrackBeatRepeatDiv(int trackId, int div)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.beatRepeat.division = juce::jmax(1, div);
-}
-
-void LooperAudio::setTrackBeatRepeatThresh(int trackId, float thresh)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.beatRepeat.threshold = thresh;
-}
-
-// ================= Monitor / Visualization =================
+// ================= Listener Notifications =================
 
-void LooperAudio::setMonitorTrackId(int trackId)
+void LooperAudio::notifyRecordingStarted(int trackId) noexcept
 {
-    monitorTrackId.store(trackId);
+    if (const int slot = slotOf(trackId); slot >= 0)
+        pendingRecordingStarted.fetch_or(juce::uint64 { 1 } << slot, std::memory_order_release);
 }
 
-void LooperAudio::popMonitorSamples(juce::AudioBuffer<float>& destBuffer)
+// 録音終了と UNDO / REDO / クリアは、リスナーが波形を描き直すので先に波形を取っておく
+void LooperAudio::notifyRecordingStopped(int trackId) noexcept
 {
-    const int numSamples = destBuffer.getNumSamples();
-    int start1, size1, start2, size2;
-    monitorFifo.prepareToRead(numSamples, start1, size1, start2, size2);
-    
-    if (size1 > 0)
-        destBuffer.copyFrom(0, 0, monitorFifoBuffer.data() + start1, size1);
-    
-    if (size2 > 0)
-        destBuffer.copyFrom(0, size1, monitorFifoBuffer.data() + start2, size2);
-        
-    monitorFifo.finishedRead(size1 + size2);
-    
-    // データが足りない場合はゼロ埋め（または前回の値を維持するか、ここでゼロクリアするか）
-    // AbstractFifoは読み込めた分だけ返すので、足りない分はクリアしておく方が安全
-    if (size1 + size2 < numSamples)
+    if (const int slot = slotOf(trackId); slot >= 0)
     {
-        destBuffer.clear(size1 + size2, numSamples - (size1 + size2));
+        publishWaveformSnapshot(slot);
+        pendingRecordingStopped.fetch_or(juce::uint64 { 1 } << slot, std::memory_order_release);
     }
 }
 
-// ================= FX Enable/Disable =================
-
-void LooperAudio::setTrackFilterEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.filterEnabled = enabled;
-}
-
-
-
-void LooperAudio::setTrackFlangerEnabled(int trackId, bool enabled)
+void LooperAudio::notifyTrackRestored(int trackId) noexcept
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.flangerEnabled = enabled;
-}
-
-void LooperAudio::setTrackFlangerRate(int trackId, float rate)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    if (const int slot = slotOf(trackId); slot >= 0)
     {
-        it->second.fx.flangerRate = rate;
-        if (!it->second.fx.flangerSync)
-            it->second.fx.flanger.setRate(rate);
+        publishWaveformSnapshot(slot);
+        pendingTrackRestored.fetch_or(juce::uint64 { 1 } << slot, std::memory_order_release);
     }
 }
 
-void LooperAudio::setTrackFlangerSync(int trackId, bool sync)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.flangerSync = sync;
-}
-
-void LooperAudio::setTrackFlangerDepth(int trackId, float depth)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.flanger.setDepth(depth);
-}
-
-void LooperAudio::setTrackFlangerFeedback(int trackId, float feedback)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.flanger.setFeedback(feedback);
-}
+// ================= Waveform Snapshots =================
 
-void LooperAudio::setTrackChorusEnabled(int trackId, bool enabled)
+void LooperAudio::publishWaveformSnapshot(int slot) noexcept
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.chorusEnabled = enabled;
-}
+    const auto bit = juce::uint64 { 1 } << slot;
+    auto& state = snapshotStates[(size_t)slot];
 
-void LooperAudio::setTrackChorusRate(int trackId, float rate)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    // 読まれていない前の波形は取り返す。メッセージスレッドが読んでいる最中なら次のブロックで
+    int expected = snapshotReady;
+    if (! state.compare_exchange_strong(expected, snapshotEmpty, std::memory_order_acq_rel)
+        && expected == snapshotReading)
     {
-        it->second.fx.chorusRate = rate;
-        if (!it->second.fx.chorusSync)
-            it->second.fx.chorus.setRate(rate);
+        pendingSnapshots |= bit;
+        return;
     }
-}
-
-void LooperAudio::setTrackChorusSync(int trackId, bool sync)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.chorusSync = sync;
-}
-
-void LooperAudio::setTrackChorusDepth(int trackId, float depth)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.chorus.setDepth(depth);
-}
 
-void LooperAudio::setTrackChorusMix(int trackId, float mix)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.chorus.setMix(mix);
+    // ページは参照を足すだけ（確保もコピーもしない）
+    waveformSnapshots[(size_t)slot].shareFrom(trackData[(size_t)slot].buffer);
+    heldSnapshots |= bit;
+    pendingSnapshots &= ~bit;
+    state.store(snapshotReady, std::memory_order_release);
 }
 
-void LooperAudio::setTrackTremoloEnabled(int trackId, bool enabled)
+void LooperAudio::dropWaveformSnapshot(int slot) noexcept
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.tremoloEnabled = enabled;
-}
+    const auto bit = juce::uint64 { 1 } << slot;
+    auto& state = snapshotStates[(size_t)slot];
+    pendingSnapshots &= ~bit;
 
-void LooperAudio::setTrackTremoloRate(int trackId, float rate)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.tremoloRate = rate;
-}
+    int expected = snapshotReady;
+    state.compare_exchange_strong(expected, snapshotEmpty, std::memory_order_acq_rel);
 
-void LooperAudio::setTrackTremoloDepth(int trackId, float depth)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.tremoloDepth = depth;
-}
-
-void LooperAudio::setTrackTremoloShape(int trackId, int shape)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.tremoloShape = shape;
-}
-
-void LooperAudio::setTrackTremoloSync(int trackId, bool sync)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.tremoloSync = sync;
-}
-
-// Slicer / Trance Gate
-void LooperAudio::setTrackSlicerEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerEnabled = enabled;
-}
-
-void LooperAudio::setTrackSlicerRate(int trackId, float rate)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerRate = rate;
-}
-
-void LooperAudio::setTrackSlicerDepth(int trackId, float depth)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerDepth = depth;
-}
-
-void LooperAudio::setTrackSlicerDuty(int trackId, float duty)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerDuty = duty;
-}
-
-void LooperAudio::setTrackSlicerShape(int trackId, int shape)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerShape = shape;
+    if ((heldSnapshots & bit) != 0 && state.load(std::memory_order_acquire) == snapshotEmpty)
+    {
+        waveformSnapshots[(size_t)slot].setSize(0);
+        heldSnapshots &= ~bit;
+    }
 }
 
-void LooperAudio::setTrackSlicerSync(int trackId, bool sync)
+void LooperAudio::updateWaveformSnapshots() noexcept
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.slicerSync = sync;
-}
+    if ((heldSnapshots | pendingSnapshots) == 0)
+        return;
 
-void LooperAudio::setTrackBitcrusherEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.bitcrusherEnabled = enabled;
-}
+    for (int slot = 0; slot < numTracks; ++slot)
+    {
+        const auto bit = juce::uint64 { 1 } << slot;
 
-void LooperAudio::setTrackBitcrusherDepth(int trackId, float depth)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.bitcrusherDepth = depth;
+        if ((pendingSnapshots & bit) != 0)
+            publishWaveformSnapshot(slot);
+        else if ((heldSnapshots & bit) != 0
+                 && snapshotStates[(size_t)slot].load(std::memory_order_acquire) == snapshotEmpty)
+        {
+            waveformSnapshots[(size_t)slot].setSize(0); // 読み終えた
+            heldSnapshots &= ~bit;
+        }
+    }
 }
 
-void LooperAudio::setTrackBitcrusherRate(int trackId, float rate)
+bool LooperAudio::copyTrackAudio(int trackId, juce::AudioBuffer<float>& dest)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.bitcrusherRate = rate;
-}
+    // slotOf は addTrack（メッセージスレッド）でしか変わらない
+    const int slot = slotOf(trackId);
+    if (slot < 0)
+        return false;
 
-// Granular Cloud
-void LooperAudio::setTrackGranularEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.enabled = enabled;
-}
+    auto& state = snapshotStates[(size_t)slot];
+    int expected = snapshotReady;
+    if (! state.compare_exchange_strong(expected, snapshotReading, std::memory_order_acq_rel))
+        return false;
 
-void LooperAudio::setTrackGranularSize(int trackId, float sizeMs)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.sizeMs = sizeMs;
+    waveformSnapshots[(size_t)slot].copyTo(dest);
+    state.store(snapshotEmpty, std::memory_order_release); // ページはオーディオスレッドが返す
+    return true;
 }
 
-void LooperAudio::setTrackGranularDensity(int trackId, float density)
+void LooperAudio::dispatchPendingNotifications()
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.density = density;
-}
+    // オーディオスレッドが外した Convolution Reverb の IR をここで消す
+    for (int slot = 0; slot < numTracks; ++slot)
+        trackData[(size_t)slot].fx->convolution.collectGarbage();
 
-void LooperAudio::setTrackGranularPitch(int trackId, float pitchVal)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.pitch = pitchVal;
-}
+    const auto started = pendingRecordingStarted.exchange(0, std::memory_order_acquire);
+    const auto stopped = pendingRecordingStopped.exchange(0, std::memory_order_acquire);
+    const auto restored = pendingTrackRestored.exchange(0, std::memory_order_acquire);
 
-void LooperAudio::setTrackGranularJitter(int trackId, float jitterVal)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.jitter = jitterVal;
-}
+    if (pendingLoopsCleared.exchange(false, std::memory_order_acquire))
+        listeners.call([](Listener& l) { l.onLoopsCleared(); });
 
-void LooperAudio::setTrackGranularMix(int trackId, float mix)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.granular.mix = mix;
-}
+    if ((started | stopped | restored) == 0) return;
 
-// ================== Autotune ==================
-void LooperAudio::setTrackAutotuneEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
+    for (int slot = 0; slot < numTracks; ++slot)
     {
-        auto& at = it->second.fx.autotune;
-        at.enabled = enabled;
-        if (enabled)
-        {
-            at.detector.prepare(sampleRate, 512);
-            at.shifterL.prepare(sampleRate, 512);
-            at.shifterR.prepare(sampleRate, 512);
-        }
-    }
-}
+        const auto bit = juce::uint64 { 1 } << slot;
+        const int trackId = trackIds[(size_t)slot];
 
-void LooperAudio::setTrackAutotuneKey(int trackId, int key)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.autotune.key = juce::jlimit(0, 11, key);
-}
-
-void LooperAudio::setTrackAutotuneScale(int trackId, int scale)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.autotune.scale = juce::jlimit(0, 2, scale);
-}
-
-void LooperAudio::setTrackAutotuneAmount(int trackId, float amount)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.autotune.amount = juce::jlimit(0.0f, 1.0f, amount);
-}
-
-void LooperAudio::setTrackAutotuneSpeed(int trackId, float speed)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.autotune.speed = juce::jlimit(0.0f, 1.0f, speed);
+        if (started & bit) listeners.call([trackId](Listener& l) { l.onRecordingStarted(trackId); });
+        if (stopped & bit) listeners.call([trackId](Listener& l) { l.onRecordingStopped(trackId); });
+        if (restored & bit) listeners.call([trackId](Listener& l) { l.onTrackRestored(trackId); });
+    }
 }
 
-void LooperAudio::setTrackDelayEnabled(int trackId, bool enabled)
-{
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.delayEnabled = enabled;
-}
+// ================= Monitor / Visualization =================
 
-void LooperAudio::setTrackReverbEnabled(int trackId, bool enabled)
+void LooperAudio::setMonitorTrackId(int trackId)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-        it->second.fx.reverbEnabled = enabled;
+    monitorTrackId.store(trackId);
 }
 
-void LooperAudio::setTrackLoopMultiplier(int trackId, float multiplier)
+void LooperAudio::popMonitorSamples(juce::AudioBuffer<float>& destBuffer)
 {
-    if (auto it = tracks.find(trackId); it != tracks.end())
-    {
-        it->second.loopMultiplier = multiplier;
-        
-        // 再生位置を現在の絶対時刻に合わせて再計算（x2切り替え時のズレ防止）
-        if (masterLoopLength > 0)
-        {
-            int64_t relativePos = currentSamplePosition - masterStartSample;
-            int effectiveLoopLength = (int)(masterLoopLength * multiplier);
-            if (effectiveLoopLength > 0)
-            {
-                it->second.readPosition = (int)(relativePos % effectiveLoopLength);
-            }
-        }
+    const int numSamples = destBuffer.getNumSamples();
+    int start1, size1, start2, size2;
+    monitorFifo.prepareToRead(numSamples, start1, size1, start2, size2);
+    
+    if (size1 > 0)
+        destBuffer.copyFrom(0, 0, monitorFifoBuffer.data() + start1, size1);
+    
+    if (size2 > 0)
+        destBuffer.copyFrom(0, size1, monitorFifoBuffer.data() + start2, size2);
         
-        DBG("Track " << trackId << " loop multiplier set to " << multiplier << " | ReadPos adjusted to " << it->second.readPosition);
+    monitorFifo.finishedRead(size1 + size2);
+    
+    // データが足りない場合はゼロ埋め（または前回の値を維持するか、ここでゼロクリアするか）
+    // AbstractFifoは読み込めた分だけ返すので、足りない分はクリアしておく方が安全
+    if (size1 + size2 < numSamples)
+    {
+        destBuffer.clear(size1 + size2, numSamples - (size1 + size2));
     }
 }
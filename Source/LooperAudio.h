@@ -2,18 +2,37 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
 #include "TriggerEvent.h"
-#include <map>
-#include <optional>
-#include "TrackUtils.h"
+#include "AudioInputBuffer.h"
+#include <array>
+#include <memory>
+#include <limits>
 #include "PitchDetector.h"
 #include "PitchShifter.h"
-
-
-//UNDO用の履歴
+#include "LooperCommandQueue.h"
+#include "TrackRenderPool.h"
+#include "LoopPagePool.h"
+#include "DspLoadMonitor.h"
+#include "GranularEngine.h"
+#include "BlockDelay.h"
+#include "LfoGenerator.h"
+#include "LaneFilterBank.h"
+#include "BlockCompressor.h"
+#include "BlockBitcrusher.h"
+#include "ConvolutionReverb.h"
+#include "SendBuses.h"
+#include "TrackFxModules.h"
+
+
+//UNDO/REDO用の履歴1件分（録音前のトラック状態）
 struct TrackHistory
 {
 	int trackId = -1;
-	juce::AudioBuffer<float> previousBuffer;
+	PagedLoopBuffer buffer; // トラックのページ表を共有するだけ（コピーしない）
+	int recordLength = 0;
+	int lengthInSample = 0;
+	float loopMultiplier = 1.0f;
+	juce::int64 recordStartSample = 0;
+	int recordingStartPhase = 0;
 };
 
 
@@ -27,9 +46,18 @@ class LooperAudio
 
 		virtual void onRecordingStarted(int trackID) = 0;
 		virtual void onRecordingStopped(int trackID) = 0;
+		// UNDO / REDO / クリアでトラックの中身が入れ替わった
+		virtual void onTrackRestored(int trackID) {}
+		// ループ用メモリを確保し直したので、全トラックと UNDO 履歴が消えた（サンプルレートの変更など）
+		virtual void onLoopsCleared() {}
 	};
 
-	LooperAudio(double sr,int max);
+	static constexpr int maxTracks = 64;       // トラックストアの固定容量
+	static constexpr int maxTrackIds = 256;    // trackId の有効範囲 [0, maxTrackIds)
+
+	// loopMemorySamples: 全トラックで共有するループ用メモリ（1chあたりのサンプル数）
+	// 0 = まだ確保しない（オーディオ開始前に setLoopMemory で確保する）
+	LooperAudio(double sr,int loopMemorySamples);
 
 	~LooperAudio();
 
@@ -37,14 +65,62 @@ class LooperAudio
 	void processBlock(juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& input);
 	void releaseResources() {}
 
-	//TriggerEventの参照をセット
+	// トラックのレンダリング（再生 + FX）をワーカースレッドで並列に回す（オプトイン）
+	// 0 = 従来どおりオーディオスレッドだけで処理。addTrack と同じくオーディオ開始前専用で、
+	// 次の prepareToPlay でワーカーが起動する。合算はスロット順なので結果はシリアルと同一
+	void setRenderThreadCount(int numWorkerThreads);
+	int getRenderThreadCount() const { return renderThreadCount; }
+	int getActiveRenderThreadCount() const { return renderPool.getNumWorkers(); } // CPU数で頭打ちになった実数
+
+	// Autotune のピッチ検出を何サンプルごとに走らせるか（既定 256）。addTrack と同じく
+	// オーディオ開始前専用で、次の prepareToPlay から効く
+	void setAutotuneDetectionHop(int samples) { autotuneDetectionHop = juce::jmax(1, samples); }
+	int  getAutotuneDetectionHop() const { return autotuneDetectionHop; }
+
+	// トラック横断レーン（オプトイン）: 8トラックずつの Filter を SIMD レーンにまとめて1パスで回す。
+	// レンダリングを「再生〜処理順で Filter の前まで」「Filter（全トラック）」「残りの FX」の3段に分けるので、
+	// トラックごとの作業バッファを使う。addTrack と同じくオーディオ開始前専用で、次の prepareToPlay から効く
+	void setCrossTrackLanes(bool shouldUseLanes) { crossTrackLanes = shouldUseLanes; }
+	bool getCrossTrackLanes() const { return crossTrackLanes; }
+
+	// Convolution Reverb の尾部を大きいパーティションに分けるか（既定 ON）。OFF はすべて
+	// ConvolutionReverb::headSize の一様分割（比較用、長い IR では重い）。オーディオ開始前専用で、次の prepareToPlay から効く
+	void setConvolutionNonUniformTail(bool shouldUseNonUniformTail) { convolutionNonUniformTail = shouldUseNonUniformTail; }
+	bool getConvolutionNonUniformTail() const { return convolutionNonUniformTail; }
+
+	// ループ用ページプールの大きさ（全トラック共有）と mlock の有無を変える。
+	// 確保し直すので録音済みの内容は消える。addTrack と同じくオーディオ開始前専用
+	void setLoopMemory(int totalSamples, bool lockMemory);
+	int  getLoopMemoryTotalSamples() const { return pagePool.getTotalSamples(); }
+	int  getLoopMemoryFreeSamples() const  { return pagePool.getNumFreePages() * pagePool.getPageSize(); }
+	bool isLoopMemoryLocked() const        { return pagePool.isMemoryLocked(); }
+
+	// オフラインレンダリング用: トラックごとの出力（FX・ゲイン適用後）を stems[slot] にも書く。
+	// stems は maxTracks 個の配列で、addTrack した順（スロット順）に並ぶ。各バッファは
+	// 2ch x 最大ブロック長を呼び出し側で確保しておくこと。nullptr で無効（オーディオ開始前に設定）
+	void setStemOutputs(juce::AudioBuffer<float>* stems) { stemOutputs = stems; }
+
+	// ⏱ DSP 負荷の計測。オーディオコールバック（getNextAudioBlock）の入口で
+	// DspLoadMonitor::ScopedCallback を張ると、コールバック時間・xrun・トラック / FX ステージ別の
+	// 負荷が集計される（張らなければトラック別の時間は溜まるだけで集計されない）
+	DspLoadMonitor& getLoadMonitor() noexcept { return loadMonitor; }
+	const DspLoadMonitor& getLoadMonitor() const noexcept { return loadMonitor; }
+	DspLoadMonitor::Stats getDspLoadStats() const { return loadMonitor.getStats(); }
+	DspLoadMonitor::SectionLoad getTrackDspLoad(int trackId) const { return loadMonitor.getTrackLoad(slotOf(trackId)); }
+
+	//TriggerEventの参照をセット（startRecording のコマンドで録音を始めるときに見るトリガー）
 	void setTriggerReference(juce::TriggerEvent& ref)
 	{triggerRef = &ref;}
 
 //トラック操作
+	// addTrack はオーディオ開始前（構築時）専用。それ以外の操作はコマンドとして
+	// キューに積まれ、次の processBlock 先頭で適用される。
 	void addTrack(int trackId);
 	void startRecording(int trackId);
-    void startRecordingWithLookback(int trackId, const juce::AudioBuffer<float>& lookbackData);
+	// オーディオスレッド専用（getNextAudioBlock 内、processBlock の直前に呼ぶ）
+	// trigger: 録音を始めたトリガー（入力ルートごとに別。位置はこれに合わせる）
+    void startRecordingWithLookback(int trackId, const AudioInputBuffer::LookbackView& lookback,
+                                    const juce::TriggerEvent& trigger);
 	void stopRecording(int trackId);
 	void startPlaying(int trackId, bool syncToMaster = true);
     void startAllPlayback(); // 全トラックを一斉に再生開始（同期ズレ防止）
@@ -54,7 +130,7 @@ class LooperAudio
 	void startSequentialRecording(const std::vector<int>& selectedTracks);
 	void stopRecordingAndContinue();
 
-	void masterPositionReset(){ masterReadPosition = 0;}
+	void masterPositionReset();
 
 	bool isRecordingActive() const;
 	bool isLastTrackRecording() const;
@@ -69,85 +145,36 @@ class LooperAudio
 	void stopAllTracks();
 
 	//UNDO関連
-	void backupTrackBeforeRecord (int trackId);
-	int undoLastRecording();  // undoしたトラックIDを返す（-1は失敗）
+	// 録音を始めるたびに、そのトラックの録音前の状態を履歴に積む（全トラック共通で最大 maxHistoryEntries 段）
+	static constexpr int maxHistoryEntries = 32;
+	int undoLastRecording();  // undoするトラックIDを返す（-1は失敗）
+	int redoLastRecording();  // redoするトラックIDを返す（-1は失敗）
+	bool canUndo() const { return undoableTrackId.load() >= 0; }
+	bool canRedo() const { return redoableTrackId.load() >= 0; }
+	// 履歴が抱えておけるループ用メモリの上限（1chあたりのサンプル数）。超えたら古い履歴から捨てる
+	void setUndoMemoryBudget(int samples) { undoBudgetSamples.store(juce::jmax(0, samples)); }
+	int  getUndoMemoryUsage() const       { return historyPagesInUse.load() * pagePool.getPageSize(); }
 
 	//リスナー関係
 	void addListener(Listener* l) {listeners.add(l);}
 	void removeListener(Listener* l){listeners.remove(l);}
 
+	// オーディオスレッドで溜まった録音開始/終了通知をリスナーに配る（メッセージスレッドから定期的に呼ぶ）
+	void dispatchPendingNotifications();
+
 
 private:
 
 	//トラック音声関連のデータ
 	//トラック音声関連のデータ
     // FX Chain Definition
-    struct FXChain
+    // パラメータ（TrackFxParams）は常に持ち、DSP モジュールは初めて ON にしたときに作る（TrackFxModules.h）
+    struct FXChain : TrackFxParams
     {
-        // Modules
-        juce::dsp::Compressor<float> compressor;
-        juce::dsp::StateVariableTPTFilter<float> filter;
-        juce::dsp::DelayLine<float> delay { 96000 }; 
-        juce::dsp::Reverb reverb;
-        
-        // Parameters
-        float filterCutoff = 20000.0f;
-        float filterRes = 0.707f;
-        int   filterType = 0; // 0=LPF, 1=HPF
-        bool  filterEnabled = false;
-
-        float reverbMix = 0.0f;
-        bool  reverbEnabled = false;
-        
-        float delayMix = 0.0f;
-        float delayFeedback = 0.0f;
-        float delayTime = 0.5f; // sec
-        bool  delayEnabled = false;
-
-        // Flanger (using Chorus with short delay)
-        juce::dsp::Chorus<float> flanger;
-        bool flangerEnabled = false;
-        bool flangerSync = false;
-        float flangerRate = 0.5f;
-        float flangerDepth = 0.5f;
-        float flangerFeedback = 0.0f;
-        double flangerPhase = 0.0;   // Manual phase if synced
-
-        // Chorus (using Chorus with longer delay for thickening)
-        juce::dsp::Chorus<float> chorus;
-        bool chorusEnabled = false;
-        bool chorusSync = false;
-        float chorusRate = 0.3f;
-        float chorusDepth = 0.5f;
-        float chorusMix = 0.5f;
-        double chorusPhase = 0.0;    // Manual phase if synced
-
-        // Tremolo (LFO-based volume modulation)
-        bool tremoloEnabled = false;
-        bool tremoloSync = false;
-        float tremoloRate = 4.0f;    // Hz
-        float tremoloDepth = 0.5f;   // 0.0-1.0
-        int tremoloShape = 0;        // 0=Sine, 1=Square, 2=Triangle
-        double tremoloPhase = 0.0;   // LFO phase state
-
-        // Slicer / Trance Gate (rhythmic volume gate)
-        bool slicerEnabled = false;
-        bool slicerSync = false;
-        float slicerRate = 4.0f;     // Hz (gate frequency)
-        float slicerDepth = 1.0f;    // 0.0-1.0 (gate depth, 1.0 = full cut)
-        float slicerDuty = 0.5f;     // 0.0-1.0 (gate open ratio)
-        int slicerShape = 0;         // 0=Square, 1=Smooth
-        double slicerPhase = 0.0;    // LFO phase state
-
-        // Bitcrusher
-        bool bitcrusherEnabled = false;
-        float bitcrusherDepth = 0.0f; // Bits Reduction: 0.0(24bit) -> 1.0(4bit)
-        float bitcrusherRate = 0.0f;  // Downsampling: 0.0(1x) -> 1.0(40x)
-        float bitcrusherLastSampleL = 0.0f; // For sample & hold (L)
-        float bitcrusherLastSampleR = 0.0f; // For sample & hold (R)
-        int bitcrusherSampleCount = 0;      // Counter for downsampling
-
-        // Beat Repeat (Stutter)
+        ConvolutionReverb convolution; // IR を読み込んだトラックは Reverb モジュールがこちらを使う
+        TrackFxGraph graph;            // 作ったモジュールと、スロット順に並べた処理順
+
+        // Beat Repeat (Stutter)。ループの読み出しを差し替えるのでモジュールにせず、再生の直後で処理する
         struct BeatRepeatState
         {
             bool isActive = false;      // ON/OFF toggle
@@ -161,80 +188,54 @@ private:
             
             float lastPeak = 0.0f;      // For simple attack detection
         } beatRepeat;
-
-        // Granular Cloud
-        struct Grain
-        {
-            bool isActive = false;
-            int position = 0;       // Current read position in buffer
-            int life = 0;           // Remaining samples
-            int totalLife = 0;      // Total duration
-            float speed = 1.0f;     // Playback speed
-            float pan = 0.5f;       // 0.0 (L) - 1.0 (R)
-            float gain = 1.0f;
-            float window = 0.0f;    // Current window gain
-        };
-
-        struct GranularParams
-        {
-            bool enabled = false;
-            
-            // Parameters
-            float sizeMs = 100.0f;      // Grain duration (50-500ms)
-            float density = 0.5f;       // Spawn probability/rate (0.0-1.0)
-            float jitter = 0.5f;        // Position randomness (0.0-1.0)
-            float pitch = 1.0f;         // Base pitch shift (0.5-2.0)
-            float pitchRandom = 0.2f;   // Pitch randomness
-            float mix = 0.5f;           // Dry/Wet
-            float feedback = 0.0f;      // Feedback (optional)
-            
-            // Runtime
-            static const int MAX_GRAINS = 32;
-            std::vector<Grain> activeGrains;
-            int spawnTimer = 0; // Timer for next grain spawn
-            
-            GranularParams() {
-                activeGrains.resize(MAX_GRAINS);
-            }
-        } granular;
-
-        // Autotune (Pitch Correction)
-        struct AutotuneParams
-        {
-            bool enabled = false;
-            int key = 0;            // 0=C, 1=C#, 2=D, ... 11=B
-            int scale = 0;          // 0=Chromatic, 1=Major, 2=Minor
-            float amount = 1.0f;    // 0.0=No correction, 1.0=Hard tune
-            float speed = 0.1f;     // Correction speed (0=instant, 1=slow glide)
-
-            PitchDetector detector;
-            PitchShifter shifterL;
-            PitchShifter shifterR;
-
-            float currentPitch = 0.0f;
-            float targetPitch = 0.0f;
-            float smoothedRatio = 1.0f;
-        } autotune;
     };
 
+	// ===== トラックストア =====
+	// 固定長・インデックス指定。ブロックごとに舐めるホットな transport 状態は SoA で
+	// 連続配置し、バッファや FXChain などのコールドな状態はスロットごとに別置きする。
+	struct TrackTransport
+	{
+		std::array<bool,  maxTracks> isRecording {};
+		std::array<bool,  maxTracks> isPlaying {};
+		std::array<int,   maxTracks> readPosition {};
+		std::array<int,   maxTracks> writePosition {};
+		std::array<int,   maxTracks> recordLength {};
+		std::array<int,   maxTracks> lengthInSample {}; //トラックの長さ
+		std::array<float, maxTracks> gain {};
+		std::array<float, maxTracks> loopMultiplier {}; // 1.0, 2.0 (x2), 0.5 (/2)
+		std::array<float, maxTracks> currentLevel {};
+		std::array<int,   maxTracks> inputPair {};  // 録音する入力ペア（入力 ch 2p, 2p+1 → トラック ch 0, 1）
+	};
+
 	struct TrackData
 	{
-		juce::AudioBuffer<float> buffer;
-		bool isRecording = false;
-		bool isPlaying = false;
-		int writePosition = 0;
-		int readPosition = 0;
-		int recordLength = 0;
-		int recordStartSample = 0; //グローバル位置での録音開始サンプル
+		PagedLoopBuffer buffer; // ページ単位で伸び縮みする（LoopPagePool から借りる）
+		juce::int64 recordStartSample = 0; //グローバル位置での録音開始サンプル
 		int recordingStartPhase = 0; // マスター基準の録音開始位相 (0~masterLength)
-		int lengthInSample = 0; //トラックの長さ
-		float currentLevel = 0.0f;
-		float gain = 1.0f;
-		float loopMultiplier = 1.0f; // 1.0, 2.0 (x2), 0.5 (/2)
         std::atomic<float> currentEffectRMS {0.0f}; // FX適用後のRMS（Visualizer用）
 		
-		// Per-Track FX Chain
-		FXChain fx;
+		// Per-Track FX Chain（サイズが大きいので別アロケーション）
+		std::unique_ptr<FXChain> fx;
+	};
+
+	// ホット/コールドを従来どおり track.xxx で扱うための参照ビュー（インライン展開で消える）
+	struct TrackRef
+	{
+		bool&  isRecording;
+		bool&  isPlaying;
+		int&   readPosition;
+		int&   writePosition;
+		int&   recordLength;
+		int&   lengthInSample;
+		float& gain;
+		float& loopMultiplier;
+		float& currentLevel;
+
+		PagedLoopBuffer& buffer;
+		juce::int64& recordStartSample;
+		int& recordingStartPhase;
+		std::atomic<float>& currentEffectRMS;
+		FXChain& fx;
 	};
 
 public:
@@ -243,7 +244,51 @@ public:
 	//トラックIDと状態のゲッター
 	//===================================
 	
-	const std::map<int, TrackData>& getTracks() const {return tracks;}
+	int  getNumTracks() const { return numTracks; }
+	int  getTrackIdAt(int slot) const { return trackIds[(size_t)slot]; }
+	bool hasTrack(int trackId) const { return slotOf(trackId) >= 0; }
+
+	bool isTrackRecording(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		return slot >= 0 && transport.isRecording[(size_t)slot];
+	}
+
+	bool isTrackPlaying(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		return slot >= 0 && transport.isPlaying[(size_t)slot];
+	}
+
+	// 録音する入力ペア（0 = ch 1/2, 1 = ch 3/4, ...）
+	int getTrackInputPair(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		return slot >= 0 ? transport.inputPair[(size_t)slot] : 0;
+	}
+
+	int getTrackRecordLength(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		return slot >= 0 ? transport.recordLength[(size_t)slot] : 0;
+	}
+
+	float getTrackEffectRMS(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		return slot >= 0 ? trackData[(size_t)slot].currentEffectRMS.load() : 0.0f;
+	}
+
+	// Compressor のゲインリダクション（直前ブロックの最大、正の dB）。メーター用
+	float getTrackCompressorGainReduction(int trackId) const
+	{
+		const int slot = slotOf(trackId);
+		if (slot < 0)
+			return 0.0f;
+		auto* compressor = static_cast<const CompressorModule*>(trackData[(size_t)slot].fx->graph.getModule(FxModuleType::compressor));
+		return compressor != nullptr ? compressor->getGainReductionDb() : 0.0f;
+	}
+
 	bool isAnyRecording() const;
 	bool isAnyPlaying() const;
 	bool hasRecordedTracks() const;
@@ -251,6 +296,7 @@ public:
     
 	void setTrackGain(int trackId, float gain);
 	void setTrackLoopMultiplier(int trackId, float multiplier);
+	void setTrackInputPair(int trackId, int inputPair);
 
     // Per-Track FX Setters
     void setTrackFilterCutoff(int trackId, float freq);
@@ -305,15 +351,27 @@ public:
     void setTrackAutotuneScale(int trackId, int scale);
     void setTrackAutotuneAmount(int trackId, float amount);
     void setTrackAutotuneSpeed(int trackId, float speed);
+    void setTrackAutotuneFormants(int trackId, bool preserve);
 
     void setTrackReverbMix(int trackId, float mix); // 0.0 - 1.0
     void setTrackReverbDamping(int trackId, float damping);
     void setTrackReverbRoomSize(int trackId, float size);
 
+    // Convolution Reverb の IR（任意のレート・長さ、最大2ch）。リサンプルと FFT をその場で行うので重い:
+    // オーディオスレッド以外、できればバックグラウンドのスレッドから呼ぶ（ImpulseResponseLoader）
+    // IR があるトラックの Reverb は畳み込みになる（Mix はそのまま、Decay は効かない）
+    bool setTrackReverbImpulse(int trackId, const juce::AudioBuffer<float>& impulse, double impulseSampleRate);
+    void clearTrackReverbImpulse(int trackId);
+
     void setTrackDelayMix(int trackId, float mix, float time); // mix 0-1, time 0-1 sec
     void setTrackDelayFeedback(int trackId, float feedback); // 0-1
+    void setTrackDelaySync(int trackId, bool sync);
+    void setTrackDelayDivision(int trackId, int division); // BlockDelay::numDivisions 未満
+    void setTrackDelayPingPong(int trackId, bool pingPong);
 
     void setTrackCompressor(int trackId, float threshold, float ratio); 
+    void setTrackCompressorEnabled(int trackId, bool enabled);
+    void setTrackCompressorLookahead(int trackId, bool lookahead);
 
     // Beat Repeat Setters
     void setTrackBeatRepeatActive(int trackId, bool active);
@@ -325,17 +383,32 @@ public:
     void setTrackDelayEnabled(int trackId, bool enabled);
     void setTrackReverbEnabled(int trackId, bool enabled);
 
+    // FX スロットの並び（FXPanel の4スロット）。moduleType は FxModuleType の番号、-1 = 空き / Beat Repeat
+    // スロットに並べた FX がこの順で先に処理され、ON になっている残りの FX は FxModuleType の順で後ろに付く
+    // FX のモジュールは初めて ON にしたとき（上の setTrack*Enabled）にこのスレッドで作られる
+    void setTrackFxSlot(int trackId, int slotIndex, int moduleType);
+
+    // Send / Return バス（全トラック共有の Reverb / Delay、ブロックに1回だけ処理）
+    // センドは FX 後の音から取る。インサート（上の Reverb / Delay）とは別で、どちらも使える
+    void setTrackReverbSend(int trackId, float level); // 0.0 - 1.0
+    void setTrackDelaySend(int trackId, float level);  // 0.0 - 1.0
+    void setBusReverbRoomSize(float size);
+    void setBusReverbDamping(float damping);
+    void setBusReverbReturn(float level);
+    void setBusDelayTime(float seconds);
+    void setBusDelayFeedback(float feedback);          // 0.0 - 0.95
+    void setBusDelaySync(bool sync);
+    void setBusDelayDivision(int division);            // BlockDelay::numDivisions 未満
+    void setBusDelayReturn(float level);
+
     // ================= Monitor / Visualization =================
     void setMonitorTrackId(int trackId);
     int getMonitorTrackId() const { return monitorTrackId.load(); }
     void popMonitorSamples(juce::AudioBuffer<float>& destBuffer);
-	// ビジュアライザ用
-	const juce::AudioBuffer<float>* getTrackBuffer(int trackId) const
-	{
-		if (auto it = tracks.find(trackId); it != tracks.end())
-			return &it->second.buffer;
-		return nullptr;
-	}
+	// ビジュアライザ用: トラックの音声を連続したバッファにコピーする（メッセージスレッド）
+	// 録音終了 / UNDO / REDO / クリアの通知と一緒にオーディオスレッドが取った波形を書き出す。
+	// 1回の通知につき1回だけ読める（まだ届いていない・読み終えたあとは false）
+	bool copyTrackAudio(int trackId, juce::AudioBuffer<float>& dest);
 
 	float getMasterNormalizedPosition() const
 	{
@@ -366,29 +439,28 @@ public:
     // トラックのサンプル長取得 (アライメント後の長さ)
     int getTrackLength(int trackId) const
     {
-        if (auto it = tracks.find(trackId); it != tracks.end())
-        {
-            // スレーブトラックはアライメント後、masterLoopLength と同じ長さのバッファになる
-            // recordLength は実際に録音した長さ（メタデータ）
-            // lengthInSample がループとして再生される長さ
-            if (it->second.lengthInSample > 0)
-                return it->second.lengthInSample;
-            // マスタートラック（まだ lengthInSample が設定されていない場合）
-            return it->second.recordLength;
-        }
-        return 0;
+        const int slot = slotOf(trackId);
+        if (slot < 0)
+            return 0;
+
+        // スレーブトラックはアライメント後、masterLoopLength と同じ長さのバッファになる
+        // recordLength は実際に録音した長さ（メタデータ）
+        // lengthInSample がループとして再生される長さ
+        if (transport.lengthInSample[(size_t)slot] > 0)
+            return transport.lengthInSample[(size_t)slot];
+        // マスタートラック（まだ lengthInSample が設定されていない場合）
+        return transport.recordLength[(size_t)slot];
     }
 
     // トラックの録音開始位置（グローバル位置）を取得
-    int getTrackRecordStart(int trackId) const
+    juce::int64 getTrackRecordStart(int trackId) const
     {
-        if (auto it = tracks.find(trackId); it != tracks.end())
-             return it->second.recordStartSample; // グローバルサンプル数
-        return 0;
+        const int slot = slotOf(trackId);
+        return slot >= 0 ? trackData[(size_t)slot].recordStartSample : 0; // グローバルサンプル数
     }
     
     // マスター作成時の開始絶対位置を取得 (トラックの相対位置計算用)
-    int getMasterStartSample() const { return masterStartSample; }
+    juce::int64 getMasterStartSample() const { return masterStartSample; }
     
     // 現在の最大ループ倍率を取得
     float getMaxLoopMultiplier() const
@@ -397,23 +469,23 @@ public:
         if (masterLoopLength == 0) return 1.0f;
 
         float maxMult = 1.0f;
-        for(const auto& t : tracks)
+        for (size_t slot = 0; slot < (size_t)numTracks; ++slot)
         {
             float mult = 1.0f;
             // 録音中のトラックは設定されている倍率を使用（recordLengthが増加中なので）
-            if (t.second.isRecording)
+            if (transport.isRecording[slot])
             {
-                mult = t.second.loopMultiplier;
+                mult = transport.loopMultiplier[slot];
             }
             // 録音済みの場合は実際の長さから倍率を計算
-            else if (t.second.recordLength > 0)
+            else if (transport.recordLength[slot] > 0)
             {
-                mult = (float)t.second.recordLength / (float)masterLoopLength;
+                mult = (float)transport.recordLength[slot] / (float)masterLoopLength;
             }
             // 未録音の場合は設定されている倍率を使用
             else
             {
-                mult = t.second.loopMultiplier;
+                mult = transport.loopMultiplier[slot];
             }
 
             if (mult > maxMult) maxMult = mult;
@@ -424,42 +496,185 @@ public:
     // トラックの現在のRMSを取得 (Visualizer用)
     float getTrackRMS(int trackId) const
     {
-        if (auto it = tracks.find(trackId); it != tracks.end())
-            return it->second.currentLevel;
-        return 0.0f;
+        const int slot = slotOf(trackId);
+        return slot >= 0 ? transport.currentLevel[(size_t)slot] : 0.0f;
     }
 
     // 現在の絶対サンプル位置を取得（Video Mode用）
-    long getCurrentSamplePosition() const { return currentSamplePosition; }
+    int64_t getCurrentSamplePosition() const { return currentSamplePosition; }
 
 private:
 
-	std::map<int, TrackData> tracks;
-	std::optional<TrackHistory> lastHistory;
+	LoopPagePool pagePool; // トラックと履歴より先に宣言（ページを返してから破棄される）
+	TrackTransport transport;
+	std::array<TrackData, maxTracks> trackData;
+	std::array<int, maxTracks> trackIds {};     // slot -> trackId
+	std::array<int, maxTrackIds> trackSlots {}; // trackId -> slot (-1 = 未登録)
+	int numTracks = 0;
+
+	int slotOf(int trackId) const noexcept
+	{
+		return (trackId >= 0 && trackId < maxTrackIds) ? trackSlots[(size_t)trackId] : -1;
+	}
+
+	TrackRef trackAt(int slot) noexcept
+	{
+		const auto i = (size_t)slot;
+		auto& d = trackData[i];
+		return { transport.isRecording[i], transport.isPlaying[i], transport.readPosition[i],
+		         transport.writePosition[i], transport.recordLength[i], transport.lengthInSample[i],
+		         transport.gain[i], transport.loopMultiplier[i], transport.currentLevel[i],
+		         d.buffer, d.recordStartSample, d.recordingStartPhase, d.currentEffectRMS, *d.fx };
+	}
+
+	// 履歴のリングバッファ（オーディオスレッド専用）。[0, historyCursor) が UNDO 側、
+	// [historyCursor, historySize) が REDO 側。UNDO / REDO はトラックと履歴の中身を入れ替えるだけ
+	std::array<TrackHistory, maxHistoryEntries> history;
+	int historyHead = 0;   // 一番古い履歴の位置
+	int historySize = 0;
+	int historyCursor = 0;
+
+	// UIから参照する UNDO / REDO 対象と使用量（history はオーディオスレッド専用）
+	std::atomic<int> undoableTrackId { -1 };
+	std::atomic<int> redoableTrackId { -1 };
+	std::atomic<int> historyPagesInUse { 0 };
+	std::atomic<int> undoBudgetSamples { std::numeric_limits<int>::max() };
+
+	TrackHistory& historyAt(int index) noexcept { return history[(size_t)((historyHead + index) % maxHistoryEntries)]; }
+	void pushHistory(int slot);
+	void swapWithHistory(int slot, TrackHistory& entry);
+	bool evictOldestHistory();
+	void dropRedoHistory();
+	void clearHistory();
+	void enforceUndoBudget();
+	void publishHistoryState();
+	// 録音用にトラックの長さを変える。プールが足りなければ古い履歴を捨てて空ける
+	bool resizeTrackBuffer(PagedLoopBuffer& buffer, int numSamples);
+
+	// ビジュアライザ用の波形（スロットごと）。オーディオスレッドがトラックのページ表を共有して作り、
+	// メッセージスレッドが copyTrackAudio で書き出す。共有中のページはコピーオンライトなので、
+	// 書き出している間にトラックへ録音しても中身は変わらない（参照カウントはオーディオスレッドだけが触る）
+	// snapshotEmpty の間はオーディオスレッドのもの。Ready / Reading の間はページ表に触らない
+	enum SnapshotState : int { snapshotEmpty, snapshotReady, snapshotReading };
+	std::array<PagedLoopBuffer, maxTracks> waveformSnapshots;
+	std::array<std::atomic<int>, maxTracks> snapshotStates {};
+	juce::uint64 heldSnapshots = 0;    // ページを抱えている波形（オーディオスレッド専用）
+	juce::uint64 pendingSnapshots = 0; // 読み出し中で取れなかった波形。次のブロックで取り直す
+
+	void publishWaveformSnapshot(int slot) noexcept;
+	void dropWaveformSnapshot(int slot) noexcept;
+	void updateWaveformSnapshots() noexcept;
 
 	double sampleRate;
-	int maxSamples;
-	juce::dsp::ProcessSpec fxSpec; // For per-track FX initialization
+	int maxSamples; // ページプールの総容量（1トラックの最大長でもある）
+	juce::dsp::ProcessSpec fxSpec {}; // For per-track FX initialization
 
 	//最初に録音完了したトラックをマスターとする
-	int masterStartSample    = 0;
+	juce::int64 masterStartSample = 0;
 	int masterTrackId = -1;
 	int masterLoopLength = 0;
 	int masterReadPosition = 0;
-	long currentSamplePosition = 0;
+	int64_t currentSamplePosition = 0;
 
 	std::vector<int> recordingQueue;
 	int currentRecordingIndex = -1;
 
 	juce::ListenerList<Listener> listeners;
-    
-    juce::CriticalSection audioLock;
+
+	// 録音開始/終了の通知（slot ごとのビット）。オーディオスレッドは立てるだけで、
+	// リスナー呼び出しは dispatchPendingNotifications() でメッセージスレッドから行う
+	static_assert(maxTracks <= 64, "notification masks hold one bit per slot");
+	std::atomic<juce::uint64> pendingRecordingStarted { 0 };
+	std::atomic<juce::uint64> pendingRecordingStopped { 0 };
+	std::atomic<juce::uint64> pendingTrackRestored { 0 };
+	std::atomic<bool> pendingLoopsCleared { false };
+
+	void notifyRecordingStarted(int trackId) noexcept;
+	void notifyRecordingStopped(int trackId) noexcept;
+	void notifyTrackRestored(int trackId) noexcept;
 
 	juce::TriggerEvent* triggerRef = nullptr;
 
+	// ===== コマンドキュー =====
+	// UIスレッドは push するだけ。オーディオスレッドは processBlock 先頭で全件取り出し、
+	// 投入順に適用する（ロックは一切取らない）
+	static constexpr int commandQueueSize = 1024;
+	LooperCommandQueue<commandQueueSize> commandQueue;
+	std::array<LooperCommand, commandQueueSize> pendingCommands {};
+
+	void postCommand(const LooperCommand& cmd);
+	void applyCommand(const LooperCommand& cmd);
+	juce::AudioBuffer<float>* stemOutputs = nullptr;
+
+	// オーディオスレッド側の実処理
+	void applyStartRecording(int trackId, const juce::TriggerEvent* trigger);
+	void applyStopRecording(int trackId);
+	void applyStartPlaying(int trackId, bool syncToMaster);
+	void applyStartAllPlayback();
+	void applyStopAllTracks();
+	void applyAllClear();
+	void applyUndo();
+	void applyRedo();
+	void applyLoopMultiplier(int trackId, float multiplier);
+	void applyGenerateTestClick(int trackId);
+	void applyGenerateTestWaveforms();
+
 	void recordIntoTracks(const juce::AudioBuffer<float>& input);
 	void mixTracksToOutput(juce::AudioBuffer<float>& output);
 
+	// 1トラック分の再生 + FX を trackBuffer に書く。並列モードではワーカーから呼ばれるので、
+	// このスロット以外の状態は読むだけにすること
+	void renderTrack(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples, double syncedModRate);
+	// renderTrack を3つに分けたもの: 再生と Beat Repeat / 処理順の [begin, end) のモジュール / RMS
+	void renderTrackSource(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples);
+	void renderTrackModules(int slot, juce::AudioBuffer<float>& trackBuffer, int numSamples, double syncedModRate,
+							int begin, int end);
+	void renderTrackMeter(int slot, const juce::AudioBuffer<float>& trackBuffer, int numSamples);
+	// トラック横断レーン: renderJobSlots の Filter をバンク（8スロット）ごとに1パスで処理（オーディオスレッド）
+	void processLaneFilters(int numJobs, int numSamples);
+	// レンダリング済みのトラックを出力に足し、センドをバスに送り、モニター用FIFOに流す（オーディオスレッド）
+	void addTrackToOutput(int slot, const juce::AudioBuffer<float>& trackBuffer, juce::AudioBuffer<float>& output);
+	// 共有バスの FX を回してリターンを出力に足す（全トラックを足したあと、オーディオスレッド）
+	void processSendBuses(juce::AudioBuffer<float>& output, int numSamples);
+	double getSyncedModRate() const;
+
+	// ===== 事前確保 =====
+	// オーディオスレッドでは確保しない。ここにあるバッファは prepareToPlay で
+	// 最大ブロックサイズ分を確保しておき、ブロックごとに setSize(avoidReallocating) で使う
+	// (ループ音声そのものは pagePool から借りる)
+	juce::AudioBuffer<float> trackScratch;    // トラックごとのFX処理用
+
+	// 並列レンダリング用: スロットごとの作業バッファ（ワーカー同士で共有しない）
+	struct RenderScratch
+	{
+		juce::AudioBuffer<float> track;
+	};
+
+	int renderThreadCount = 0;
+	TrackRenderPool renderPool;
+	std::array<RenderScratch, maxTracks> renderScratch;
+	std::array<int, maxTracks> renderJobSlots {};
+
+	// トラック横断レーン: バンク = スロット / LaneFilterBank::maxTracks
+	bool crossTrackLanes = false;
+	static_assert(maxTracks % LaneFilterBank::maxTracks == 0, "every slot belongs to a lane bank");
+	std::array<LaneFilterBank, maxTracks / LaneFilterBank::maxTracks> laneFilters;
+
+	bool convolutionNonUniformTail = true;
+
+	// Send / Return バス（センド量はスロットごと）
+	SendBuses sendBuses;
+
+	void prepareTrackFX(int slot);
+	// FX のモジュールがまだなければ作って prepare し、トラックに渡す（メッセージスレッド）
+	void createTrackFxModule(int trackId, FxModuleType type);
+	void setTrackModuleEnabled(int trackId, FxModuleType type, LooperCommand::Type command, bool enabled);
+	juce::CriticalSection fxModuleLock; // モジュールを作る側同士（オーディオスレッドは取らない）
+	int autotuneDetectionHop = PitchDetector::defaultHopSize;
+
+	static_assert(maxTracks <= DspLoadMonitor::maxSlots, "load monitor keeps one counter set per slot");
+	DspLoadMonitor loadMonitor;
+
     // Monitoring
     std::atomic<int> monitorTrackId { -1 };
     
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    LooperCommandQueue.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    メッセージスレッド → オーディオスレッドへの操作コマンドキュー
+    (SPSC / 固定長 / ロックフリー)
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// ===============================================
+// LooperAudio への操作1件分（POD）
+// UIはこれを積むだけで、tracks は processBlock 先頭でのみ書き換えられる
+// ===============================================
+struct LooperCommand
+{
+	enum class Type : std::uint8_t
+	{
+		// --- Transport / 構造変更 ---
+		StartRecording,
+		StopRecording,
+		StartPlaying,        // intValue = syncToMaster
+		StartAllPlayback,
+		StopPlaying,
+		StopAllTracks,
+		ClearTrack,
+		AllClear,
+		Undo,
+		Redo,
+		MasterPositionReset,
+		GenerateTestClick,
+		GenerateTestWaveforms,
+
+		// --- Track ---
+		Gain,
+		LoopMultiplier,
+		InputPair,           // intValue = 録音する入力ペア（0 = ch 1/2）
+
+		// --- Filter ---
+		FilterEnabled,
+		FilterCutoff,
+		FilterResonance,
+		FilterType,
+
+		// --- Flanger ---
+		FlangerEnabled,
+		FlangerRate,
+		FlangerDepth,
+		FlangerFeedback,
+		FlangerSync,
+
+		// --- Chorus ---
+		ChorusEnabled,
+		ChorusRate,
+		ChorusDepth,
+		ChorusMix,
+		ChorusSync,
+
+		// --- Tremolo ---
+		TremoloEnabled,
+		TremoloRate,
+		TremoloDepth,
+		TremoloShape,
+		TremoloSync,
+
+		// --- Slicer ---
+		SlicerEnabled,
+		SlicerRate,
+		SlicerDepth,
+		SlicerDuty,
+		SlicerShape,
+		SlicerSync,
+
+		// --- Bitcrusher ---
+		BitcrusherEnabled,
+		BitcrusherDepth,
+		BitcrusherRate,
+
+		// --- Granular ---
+		GranularEnabled,
+		GranularSize,
+		GranularDensity,
+		GranularPitch,
+		GranularJitter,
+		GranularMix,
+
+		// --- Autotune ---
+		AutotuneEnabled,
+		AutotuneKey,
+		AutotuneScale,
+		AutotuneAmount,
+		AutotuneSpeed,
+		AutotuneFormants,
+
+		// --- Reverb ---
+		ReverbEnabled,
+		ReverbMix,
+		ReverbDamping,
+		ReverbRoomSize,
+
+		// --- Delay ---
+		DelayEnabled,
+		DelayMix,            // floatValue = mix, floatValue2 = time
+		DelayFeedback,
+		DelaySync,
+		DelayDivision,       // intValue = BlockDelay の音符インデックス
+		DelayPingPong,
+
+		// --- Compressor ---
+		Compressor,          // floatValue = threshold, floatValue2 = ratio
+		CompressorEnabled,
+		CompressorLookahead,
+
+		// --- Beat Repeat ---
+		BeatRepeatActive,
+		BeatRepeatDiv,
+		BeatRepeatThresh,
+
+		// --- FX の処理順 ---
+		FxSlot,              // intValue = スロット番号, floatValue = FxModuleType（-1 = 空き）
+
+		// --- Send / Return バス（Bus* はトラックを伴わない） ---
+		ReverbSend,
+		DelaySend,
+		BusReverbRoomSize,
+		BusReverbDamping,
+		BusReverbReturn,
+		BusDelayTime,        // floatValue = 秒
+		BusDelayFeedback,
+		BusDelaySync,
+		BusDelayDivision,    // intValue = BlockDelay の音符インデックス
+		BusDelayReturn
+	};
+
+	Type  type = Type::Gain;
+	int   trackId = -1;
+	int   intValue = 0;
+	float floatValue = 0.0f;
+	float floatValue2 = 0.0f;
+
+	static LooperCommand make(Type t, int id, float f = 0.0f, float f2 = 0.0f) noexcept
+	{
+		LooperCommand c;
+		c.type = t;
+		c.trackId = id;
+		c.floatValue = f;
+		c.floatValue2 = f2;
+		return c;
+	}
+
+	static LooperCommand makeInt(Type t, int id, int i) noexcept
+	{
+		LooperCommand c;
+		c.type = t;
+		c.trackId = id;
+		c.intValue = i;
+		return c;
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<LooperCommand>, "LooperCommand must stay POD");
+
+// ===============================================
+// 固定長 SPSC キュー
+// producer: メッセージスレッド / consumer: オーディオスレッド
+// AbstractFifo はアトミックの load/store のみなので、どちらも待たない
+// ===============================================
+template <int Capacity>
+class LooperCommandQueue
+{
+public:
+	// 満杯なら false（コマンドは破棄される）
+	bool push(const LooperCommand& cmd) noexcept
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+		if (size1 + size2 == 0)
+			return false;
+
+		slots[(size_t)(size1 > 0 ? start1 : start2)] = cmd;
+		fifo.finishedWrite(1);
+		return true;
+	}
+
+	// 溜まっているコマンドを dest に取り出す（投入順）
+	template <size_t N>
+	int popAll(std::array<LooperCommand, N>& dest) noexcept
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead((int)N, start1, size1, start2, size2);
+
+		int count = 0;
+		for (int i = 0; i < size1; ++i) dest[(size_t)count++] = slots[(size_t)(start1 + i)];
+		for (int i = 0; i < size2; ++i) dest[(size_t)count++] = slots[(size_t)(start2 + i)];
+
+		fifo.finishedRead(size1 + size2);
+		return count;
+	}
+
+	int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+	// AbstractFifo は (size - 1) 件まで格納できる
+	juce::AbstractFifo fifo { Capacity + 1 };
+	std::array<LooperCommand, (size_t)(Capacity + 1)> slots {};
+};
@@ -273,6 +273,28 @@ LooperTrackUi::LooperTrackUi(int id, TrackState initState)
 
 	addAndMakeVisible(gainSlider);
 
+    // 入力ペアの選択（Per-Input Triggers のときは、このペアのトリガーで録音が始まる）
+    inputPairButton.setColour(juce::TextButton::buttonColourId, juce::Colours::black.withAlpha(0.6f));
+    inputPairButton.setTooltip("Input pair this track records");
+    inputPairButton.onClick = [this]()
+    {
+        juce::PopupMenu menu;
+        for (int pair = 0; pair < maxInputPairs; ++pair)
+            menu.addItem(pair + 1, "IN " + juce::String(pair * 2 + 1) + "/" + juce::String(pair * 2 + 2), true, pair == inputPair);
+
+        menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&inputPairButton),
+                           [safeThis = juce::Component::SafePointer<LooperTrackUi>(this)](int result)
+                           {
+                               if (safeThis == nullptr || result <= 0)
+                                   return;
+                               safeThis->setInputPair(result - 1);
+                               if (safeThis->onInputPairChange)
+                                   safeThis->onInputPairChange(result - 1);
+                           });
+    };
+    setInputPair(0);
+    addAndMakeVisible(inputPairButton);
+
     // Multiplier Buttons (Skip for Master Track 1)
     if (trackId != 1)
     {
@@ -352,10 +374,24 @@ void LooperTrackUi::resized()
         multHalfButton.setBounds(startX + btnWidth, buttonY, btnWidth, buttonHeight);
     }
 	
+    // 入力ペアは選択ボタンの内側上部
+    {
+        int buttonHeight = 18;
+        int margin = 4;
+        int totalBtnWidth = (int)(width * 0.9f);
+        inputPairButton.setBounds(((int)width - totalBtnWidth) / 2, margin, totalBtnWidth, buttonHeight);
+    }
+	
 	// 左40%はメーター用に空けて、右60%にスライダーを配置
 	gainSlider.setBounds(bottomArea.removeFromRight((int)(width * 0.6f)).reduced(0, 0)); // reducedは不要になるかもだが一応0
 }
 
+void LooperTrackUi::setInputPair(int pair)
+{
+	inputPair = juce::jlimit(0, maxInputPairs - 1, pair);
+	inputPairButton.setButtonText("IN " + juce::String(inputPair * 2 + 1) + "/" + juce::String(inputPair * 2 + 2));
+}
+
 //==============================================================================
 void LooperTrackUi::mouseDown(const juce::MouseEvent& e)
 {
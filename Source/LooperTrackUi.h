@@ -123,6 +123,18 @@ public:
     juce::TextButton mult2xButton { "x2" };
     juce::TextButton multHalfButton { "/2" };
 
+    // 録音する入力ペア（クリックでメニュー。0 = IN 1/2）
+    static constexpr int maxInputPairs = 8;
+    juce::TextButton inputPairButton;
+    std::function<void(int)> onInputPairChange;
+    int getInputPair() const { return inputPair; }
+    void setInputPair(int pair);
+
+private:
+    int inputPair = 0;
+
+public:
+
 	void setLevel(float rms);
 	float getGain() const { return (float)gainSlider.getValue(); }
     void setGainValue(float newGain) { gainSlider.setValue(newGain, juce::dontSendNotification); } // 🆕 Added setter
@@ -1,10 +1,11 @@
 #include "MainComponent.h"
 #include "SettingsComponent.h"
+#include "AllocationTripwire.h"
 
 //==============================================================================
 MainComponent::MainComponent()
 	: sharedTrigger(inputTap.getTriggerEvent()),
-		looper(44100, 44100 * 30),  // 30秒バッファ
+		looper(44100, 0),  // ループ用メモリはデバイスのサンプルレートが決まってから確保する（prepareToPlay）
 		transportPanel(looper),
         fxPanel(looper)
 {
@@ -19,7 +20,6 @@ MainComponent::MainComponent()
 	
 	// 保存されたオーディオ設定を読み込み
 	loadAudioDeviceSettings();
-	deviceManager.addAudioCallback(&inputTap); // 入力だけTapする
 
 	startTimerHz(60); // Animation smoother for video
 
@@ -95,6 +95,12 @@ MainComponent::MainComponent()
             
             visualizer.setMaxMultiplier(maxMult);
         };
+        
+        // 入力ペア変更時のコールバック
+        track->onInputPairChange = [this, newId](int inputPair)
+        {
+            looper.setTrackInputPair(newId, inputPair);
+        };
 		
 		addAndMakeVisible(track.get());
 		trackUIs.push_back(std::move(track));
@@ -106,6 +112,7 @@ MainComponent::MainComponent()
     
 	addAndMakeVisible(transportPanel);
 	addChildComponent(fxPanel); // Initially hidden
+	addChildComponent(dspLoadOverlay); // ⏱ 初期は非表示
 	
 	// FXパネルからのトラック選択コールバック
 	fxPanel.onTrackSelected = [this](int trackId) {
@@ -161,7 +168,17 @@ MainComponent::MainComponent()
 						}
 					}
 				}
-				forceRecordRequest = true;
+
+				// 🔥 Force Record: コマンドキュー経由なので次のオーディオブロック先頭で開始される
+				isStandbyMode = false;
+				for (auto& t : trackUIs)
+				{
+					if (t->getState() == LooperTrackUi::TrackState::Standby)
+					{
+						looper.startRecording(t->getTrackId());
+						t->setState(LooperTrackUi::TrackState::Recording);
+					}
+				}
 			}
 			else
 			{
@@ -201,13 +218,7 @@ MainComponent::MainComponent()
              }
              
              // PLAYボタン: 全トラックを一斉に再生開始（同期ズレなし）
-             const auto& tracks = looper.getTracks();
-             bool anyExists = false;
-             for(const auto& [id, data] : tracks) {
-                 if(data.recordLength > 0) { anyExists = true; break; }
-             }
-             
-             if (anyExists) {
+             if (looper.hasRecordedTracks()) {
                  looper.startAllPlayback();
              } else {
                  DBG("⚠️ No tracks to play");
@@ -231,17 +242,11 @@ MainComponent::MainComponent()
 			updateStateVisual();
 		}
 		else if (action == "UNDO") {
-			int undoneTrackId = looper.undoLastRecording();
-			if (undoneTrackId > 0)
-			{
-				visualizer.removeWaveform(undoneTrackId);
-				// UIの状態もIdleに戻す
-				for (auto& t : trackUIs)
-				{
-					if (t->getTrackId() == undoneTrackId)
-						t->setState(LooperTrackUi::TrackState::Idle);
-				}
-			}
+			// 波形とトラック表示は、オーディオスレッドで入れ替わったあと onTrackRestored で更新する
+			looper.undoLastRecording();
+		}
+		else if (action == "REDO") {
+			looper.redoLastRecording();
 		}
 		else if (action == "CLEAR") {
         looper.allClear();
@@ -268,7 +273,7 @@ MainComponent::MainComponent()
 		
 		// 🔊 トリガーイベントもリセット（自動検知録音が再び機能するように）
 		inputTap.resetTriggerEvent();
-        lastTriggerTime = 0; // タイマーもリセット
+        lastTriggerTimes.fill(0); // タイマーもリセット
 		
 		// 全トラックを初期状態に戻す
 		for (auto& t : trackUIs) {
@@ -474,7 +479,24 @@ MainComponent::~MainComponent()
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
 	inputTap.prepare(sampleRate, samplesPerBlockExpected);
+
+	// （同じ大きさなら確保し直さない。サンプルレートが変わったときだけループを捨てて確保し直し、onLoopsCleared で表示を戻す）
+	// （同じ大きさなら確保し直さない。サンプルレートが変わったときだけループを捨てて確保し直す）
+	looper.setLoopMemory((int)(sampleRate * loopMemorySeconds), lockLoopMemory);
+	looper.setUndoMemoryBudget((int)(sampleRate * undoMemorySeconds));
 	looper.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+	// getNextAudioBlock で使う作業バッファ（AudioSourcePlayer は入出力の多い方のチャンネル数で渡してくる）
+	int numChannels = 2;
+	int numInputs = 0;
+	if (auto* device = deviceManager.getCurrentAudioDevice())
+	{
+		numInputs = device->getActiveInputChannels().countNumberOfSetBits();
+		numChannels = juce::jmax(numChannels, numInputs,
+								 device->getActiveOutputChannels().countNumberOfSetBits());
+	}
+	numActiveInputChannels = juce::jmin(numInputs, MAX_CHANNELS);
+	inputScratch.setSize(numChannels, samplesPerBlockExpected);
 	looper.setTriggerReference(inputTap.getManager().getTriggerEvent());
 
 	DBG("InputTap trigger address = " + juce::String((juce::uint64)(uintptr_t)&inputTap.getTriggerEvent()));
@@ -490,33 +512,61 @@ void MainComponent::releaseResources()
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-	auto& trig = sharedTrigger;
-	bufferToFill.clearActiveBufferRegion();
+	allocation_tripwire::ScopedAudioThread noAllocations;
+	DspLoadMonitor::ScopedCallback loadMeasurement(looper.getLoadMonitor(), bufferToFill.numSamples);
+
+	// 入力は AudioSourcePlayer がこのバッファの先頭チャンネルに入れて渡してくる（duplex）。
+	// 出力で上書きする前に作業バッファへ移す（prepareToPlay で確保済みの領域を使い回す）
+	auto& device = *bufferToFill.buffer;
+	const int numSamples = bufferToFill.numSamples;
+	const int numInputs = juce::jmin(numActiveInputChannels, device.getNumChannels());
 
-	// 入力バッファを取得
-	juce::AudioBuffer<float> input(bufferToFill.buffer->getNumChannels(),
-								   bufferToFill.numSamples);
+	auto& input = inputScratch;
+	input.setSize(device.getNumChannels(), numSamples, false, false, true);
 	input.clear();
-	inputTap.getLatestInput(input);
+	for (int ch = 0; ch < numInputs; ++ch)
+		input.copyFrom(ch, 0, device, ch, bufferToFill.startSample, numSamples);
+
+	bufferToFill.clearActiveBufferRegion();
+
+	// 解析・トリガー検出もこのブロックで行うので、トリガーが立ったブロックをそのまま録音できる
+	// （入力チャンネル分だけを参照するビュー。チャンネル数が少ないので確保は起きない）
+	if (numInputs > 0)
+	{
+		juce::AudioBuffer<float> deviceInput(input.getArrayOfWritePointers(), numInputs, numSamples);
+		inputTap.process(deviceInput, looper.getCurrentSamplePosition());
+	}
 
-	// === トリガーが立ったら ===
-	if (trig.triggerd)
+	// === トリガーが立ったら（入力ルートごと。Per-Input Triggers が OFF ならルート 0 だけ）===
+	// ルートのトラック = 選択中で、入力ペアがそのルートのトラック。ルートごとに独立して録音を始める
+	auto& manager = inputTap.getManager();
+	auto isRouteTrack = [this, &manager](const LooperTrackUi& t, int route)
 	{
+		return t.getIsSelected()
+			&& manager.getRouteForInputPair(looper.getTrackInputPair(t.getTrackId())) == route;
+	};
+
+	// 先読みは入力ペアごとに1回だけ取り出す（同じペアを録音するトラックで同じビューを使う）
+	std::array<AudioInputBuffer::LookbackView, InputManager::maxRoutes> lookbacks {};
+	std::array<bool, InputManager::maxRoutes> lookbackFetched {};
+
+	for (int route = 0; route < manager.getNumRoutes(); ++route)
+	{
+		auto& trig = manager.getRouteTriggerEvent(route);
+		if (!trig.triggerd)
+			continue;
+
+		auto& lastTriggerTime = lastTriggerTimes[(size_t)route];
 		bool anyRecording = false;
 		isStandbyMode = false; // 録音開始でスタンバイ解除
 		
 		// 録音状態チェック...
 		for (auto& t : trackUIs)
 		{
-			if (t->getIsSelected())
+			if (isRouteTrack(*t, route) && looper.isTrackRecording(t->getTrackId()))
 			{
-				int trackId = t->getTrackId();
-				const auto& tracks = looper.getTracks();
-				if (auto it = tracks.find(trackId); it != tracks.end() && it->second.isRecording)
-				{
-					anyRecording = true;
-					break;
-				}
+				anyRecording = true;
+				break;
 			}
 		}
 
@@ -525,26 +575,23 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
 			// 録音開始を試みる
 			bool startSuccess = false;
 			
-            // Prepare lookback data from buffer
-            juce::AudioBuffer<float> lookback;
-            inputTap.getManager().getLookbackData(lookback);
-            
-			// トラックが選択されているか確認
-			bool hasSelectedTrack = false;
 			for (auto& t : trackUIs)
 			{
-				if (t->getIsSelected())
+				if (isRouteTrack(*t, route))
 				{
-					hasSelectedTrack = true;
+					// Prepare lookback data from buffer（リングを直接指すビュー。コピーはトラックへ書くときの1回だけ）
+					const int inputPair = juce::jlimit(0, InputManager::maxRoutes - 1, looper.getTrackInputPair(t->getTrackId()));
+					if (!lookbackFetched[(size_t)inputPair])
+					{
+						lookbacks[(size_t)inputPair] = manager.getLookback(inputPair);
+						lookbackFetched[(size_t)inputPair] = true;
+					}
 					
 					// 🔒 録音中フラグを立てる（鎮火抑制）
-					inputTap.getManager().setRecordingActive(true);
+					manager.setRecordingActive(route, true);
 					
-					looper.startRecordingWithLookback(t->getTrackId(), lookback);
-
-					juce::MessageManager::callAsync([this, &trig, &t]()
-					{t->setState(LooperTrackUi::TrackState::Recording);
-					});
+					// UIの Recording 表示は onRecordingStarted（timerCallback 経由）で反映される
+					looper.startRecordingWithLookback(t->getTrackId(), lookbacks[(size_t)inputPair], trig);
 					
 					startSuccess = true;
 				}
@@ -567,7 +614,6 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
 				// 500ms経過しても録音開始できなければ諦めてリセット
 				if (now - lastTriggerTime > 500)
 				{
-					DBG("⏰ Trigger expired without recording target");
 					trig.triggerd = false;
 					trig.sampleInBlock = -1;
 					trig.absIndex = -1;
@@ -584,25 +630,6 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
 			lastTriggerTime = 0;
 		}
 	}
-    // 🔥 Force Record Trigger (Manual)
-    if (forceRecordRequest.exchange(false))
-    {
-        isStandbyMode = false;
-        
-        for (auto& t : trackUIs)
-        {
-            if (t->getState() == LooperTrackUi::TrackState::Standby)
-            {
-                looper.startRecording(t->getTrackId());
-                
-                juce::MessageManager::callAsync([this, &t]()
-                {
-                    t->setState(LooperTrackUi::TrackState::Recording);
-                });
-            }
-        }
-    }
-
 	// 🌀 LooperAudio の処理は常に実行
 	looper.processBlock(*bufferToFill.buffer, input);
 
@@ -802,6 +829,11 @@ void MainComponent::resized()
     // Video Mode Button（左上に配置、コンパクトなアイコンボタン）
     int videoButtonSize = 30;
     videoModeButton.setBounds(margin, 5, videoButtonSize, videoButtonSize);
+
+	// ⏱ DSP 負荷オーバーレイ（右下に重ねる）
+	dspLoadOverlay.setBounds(getWidth() - DspLoadOverlay::preferredWidth - margin,
+	                         getHeight() - DspLoadOverlay::preferredHeight - margin,
+	                         DspLoadOverlay::preferredWidth, DspLoadOverlay::preferredHeight);
 	
 // ⬇️ Top margin for layout (skip past the 40px header bar)
 	area.removeFromTop(30);
@@ -1029,7 +1061,10 @@ void MainComponent::updateStateVisual()
 
 void MainComponent::timerCallback()
 {
-	const auto& tracks = looper.getTracks();
+	// オーディオスレッドからの録音開始/終了通知をここで配る
+	looper.dispatchPendingNotifications();
+	// 測り終えたキャリブレーションをチャンネル設定に書く
+	inputTap.getManager().applyCalibrationResult();
 
     // Global Star Animation Update
     for (auto& s : stars)
@@ -1067,14 +1102,16 @@ void MainComponent::timerCallback()
         }
     }
 
-	bool anyRecording = anyTrackSatisfies(tracks, [](const auto& track){ return track.isRecording; });
-	bool anyPlaying = anyTrackSatisfies(tracks, [](const auto& track){ return track.isPlaying; });
+	bool anyRecording = looper.isAnyRecording();
+	bool anyPlaying = looper.isAnyPlaying();
 
 	//TrackUIの状態更新
-	for (const auto& [id, data] : tracks)
+	for (int slot = 0; slot < looper.getNumTracks(); ++slot)
 	{
+		const int id = looper.getTrackIdAt(slot);
+
         // Physics for Visualizer
-        visualizer.updateTrackRMS(id, data.currentEffectRMS.load());
+        visualizer.updateTrackRMS(id, looper.getTrackEffectRMS(id));
 
 		if (id -1 >= trackUIs.size())
 			continue;
@@ -1082,9 +1119,9 @@ void MainComponent::timerCallback()
 		auto& trackUI = trackUIs[id - 1];
 		auto newState = LooperTrackUi::TrackState::Idle;
 
-		if (data.isRecording)
+		if (looper.isTrackRecording(id))
 			newState = LooperTrackUi::TrackState::Recording;
-		else if (data.isPlaying)
+		else if (looper.isTrackPlaying(id))
 			newState = LooperTrackUi::TrackState::Playing;
 		
         // 🟡 Standby状態はLooper側にはないので、UI側で維持する
@@ -1189,8 +1226,14 @@ void MainComponent::onRecordingStarted(int trackID)
 
 void MainComponent::onRecordingStopped(int trackID)
 {
-    // 🔓 録音中フラグを解除（鎮火許可）
-    inputTap.getManager().setRecordingActive(false);
+    // 🔓 録音中フラグを解除（鎮火許可）。まだ録音中のトラックがあるルートだけ残す
+    auto& manager = inputTap.getManager();
+    std::array<bool, InputManager::maxRoutes> stillRecording {};
+    for (auto& t : trackUIs)
+        if (t->getTrackId() != trackID && looper.isTrackRecording(t->getTrackId()))
+            stillRecording[(size_t)manager.getRouteForInputPair(looper.getTrackInputPair(t->getTrackId()))] = true;
+    for (int route = 0; route < InputManager::maxRoutes; ++route)
+        manager.setRecordingActive(route, stillRecording[(size_t)route]);
     
     // UIスレッドで安全に一括更新
     util::safeUi([this, trackID]()
@@ -1215,10 +1258,12 @@ void MainComponent::onRecordingStopped(int trackID)
         // その前に MaxMultiplier を最新化（テスト生成時などに重要）
         visualizer.setMaxMultiplier((double)looper.getMaxLoopMultiplier());
         
-        if (auto* buffer = looper.getTrackBuffer(trackID))
+        // ループ音声はページ単位で持っているので、描画用に連続したバッファへ書き出す
+        juce::AudioBuffer<float> waveform;
+        if (looper.copyTrackAudio(trackID, waveform))
         {
             // 録音開始位置とマスター開始位置から、正しい描画オフセットを計算
-            visualizer.addWaveform(trackID, *buffer, 
+            visualizer.addWaveform(trackID, waveform, 
                                    looper.getTrackLength(trackID), 
                                    looper.getMasterLoopLength(),
                                    looper.getTrackRecordStart(trackID), // 正しいrecordStart
@@ -1261,6 +1306,60 @@ void MainComponent::onRecordingStopped(int trackID)
 		repaint();
 }
 
+void MainComponent::onTrackRestored(int trackID)
+{
+	// UNDO / REDO / クリアでトラックの中身が入れ替わった（録音前の状態に戻った、録音をやり直した、または空になった）
+	util::safeUi([this, trackID]()
+	{
+		const bool hasAudio = looper.getTrackRecordLength(trackID) > 0;
+
+		for (auto& t : trackUIs)
+		{
+			if (t->getTrackId() == trackID)
+				t->setState(hasAudio ? LooperTrackUi::TrackState::Stopped : LooperTrackUi::TrackState::Idle);
+		}
+
+		visualizer.removeWaveform(trackID);
+
+		juce::AudioBuffer<float> waveform;
+		if (hasAudio && looper.copyTrackAudio(trackID, waveform))
+		{
+			visualizer.setMaxMultiplier((double)looper.getMaxLoopMultiplier());
+			visualizer.addWaveform(trackID, waveform,
+								   looper.getTrackLength(trackID),
+								   looper.getMasterLoopLength(),
+								   looper.getTrackRecordStart(trackID),
+								   looper.getMasterStartSample());
+		}
+
+		updateStateVisual();
+	});
+}
+
+void MainComponent::onLoopsCleared()
+{
+	// サンプルレートが変わってループ用メモリを確保し直した。全トラックが空になったので表示も戻す
+	util::safeUi([this]()
+	{
+		visualizer.setMaxMultiplier(1.0f);
+		visualizer.clear();
+
+		isStandbyMode = false;
+		selectedTrackId = 0;
+		isAutoArmEnabled = false;
+		autoArmButton.setToggleState(false, juce::dontSendNotification);
+		nextTargetTrackId = -1;
+
+		for (auto& t : trackUIs)
+		{
+			t->setSelected(false);
+			t->setState(LooperTrackUi::TrackState::Idle);
+		}
+
+		updateStateVisual();
+	});
+}
+
 //==============================================================================
 // 設定保存・読み込み
 //==============================================================================
@@ -1278,6 +1377,8 @@ void MainComponent::saveAudioDeviceSettings()
 			// マルチチャンネル設定を保存
 			appProperties->setValue("stereoLinked", inputTap.getManager().isStereoLinked());
 			appProperties->setValue("calibrationEnabled", inputTap.getManager().isCalibrationEnabled());
+			appProperties->setValue("adaptiveNoiseFloor", inputTap.getManager().isAdaptiveFloorEnabled());
+			appProperties->setValue("perInputRouting", inputTap.getManager().isPerInputRouting());
 			
 			// チャンネル設定をJSON形式で保存
 			juce::var channelSettings = inputTap.getManager().getChannelManager().toVar();
@@ -1291,6 +1392,29 @@ void MainComponent::saveAudioDeviceSettings()
 
 void MainComponent::loadAudioDeviceSettings()
 {
+	// 🧵 並列レンダリング（オプトイン）: renderThreads = ワーカー数（0 = 従来のシリアル処理）
+	// オーディオ開始前に決める必要があるので setAudioChannels より先に読む
+	if (appProperties != nullptr)
+		looper.setRenderThreadCount(appProperties->getIntValue("renderThreads", 0));
+
+	// 🧮 トラック横断レーン（オプトイン）: crossTrackLanes = true で Filter を 8 トラックずつ SIMD でまとめる
+	if (appProperties != nullptr)
+		looper.setCrossTrackLanes(appProperties->getBoolValue("crossTrackLanes", false));
+
+	// 🎯 Autotune のピッチ検出間隔: autotuneDetectionHop（サンプル数。小さいほど追従が速く重い）
+	if (appProperties != nullptr)
+		looper.setAutotuneDetectionHop(appProperties->getIntValue("autotuneDetectionHop", PitchDetector::defaultHopSize));
+
+	// 📄 ループ用メモリ: loopMemorySeconds（全トラック合計）と lockLoopMemory（mlock）
+	// ↩️ UNDO履歴が抱えてよいループ用メモリ: undoMemorySeconds（超えたら古い履歴から捨てる）
+	// どちらもデバイスのサンプルレートで換算するので、確保は prepareToPlay で1回だけ
+	if (appProperties != nullptr)
+	{
+		loopMemorySeconds = juce::jmax(1, appProperties->getIntValue("loopMemorySeconds", defaultLoopMemorySeconds));
+		lockLoopMemory = appProperties->getBoolValue("lockLoopMemory", false);
+		undoMemorySeconds = juce::jmax(0, appProperties->getIntValue("undoMemorySeconds", defaultUndoMemorySeconds));
+	}
+
 	// まず基本的な初期化（デフォルト設定）
 	setAudioChannels(MAX_CHANNELS, MAX_CHANNELS);
 	
@@ -1322,6 +1446,12 @@ void MainComponent::loadAudioDeviceSettings()
         bool calibEnabled = appProperties->getBoolValue("calibrationEnabled", true);
         inputTap.getManager().setCalibrationEnabled(calibEnabled);
         
+        bool adaptiveFloor = appProperties->getBoolValue("adaptiveNoiseFloor", true);
+        inputTap.getManager().setAdaptiveFloorEnabled(adaptiveFloor);
+        
+        bool perInputRouting = appProperties->getBoolValue("perInputRouting", false);
+        inputTap.getManager().setPerInputRouting(perInputRouting);
+        
         // チャンネル設定をJSONから復元
         juce::String channelSettingsJson = appProperties->getValue("channelSettings", "");
         if (channelSettingsJson.isNotEmpty())
@@ -1338,12 +1468,11 @@ void MainComponent::loadAudioDeviceSettings()
 // ===== Auto-Arm 機能 =====
 int MainComponent::findNextEmptyTrack(int fromTrackId) const
 {
-	const auto& tracks = looper.getTracks();
 	int maxTracks = 8;
 	
 	for (int i = fromTrackId + 1; i <= maxTracks; i++)
 	{
-		if (auto it = tracks.find(i); it == tracks.end() || it->second.recordLength == 0)
+		if (looper.getTrackRecordLength(i) == 0)
 		{
 			return i;
 		}
@@ -1526,6 +1655,12 @@ bool MainComponent::keyPressed(const juce::KeyPress& key)
 			transportPanel.onAction("UNDO");
 		return true;
 	}
+	if (action == KeyboardMappingManager::ACTION_REDO)
+	{
+		if (transportPanel.onAction)
+			transportPanel.onAction("REDO");
+		return true;
+	}
 	
 	// === Track Selection	// トラック選択アクション
 	if (action.startsWith("track_"))
@@ -1556,6 +1691,14 @@ bool MainComponent::keyPressed(const juce::KeyPress& key)
 		return true;
 	}
 	
+	// === DSP Load Overlay Toggle ===
+	if (action == KeyboardMappingManager::ACTION_DSP_LOAD)
+	{
+		dspLoadOverlay.setVisible(!dspLoadOverlay.isVisible());
+		dspLoadOverlay.toFront(false);
+		return true;
+	}
+
 	// === FX Mode Toggle ===
 	if (action == KeyboardMappingManager::ACTION_FX_MODE)
 	{
@@ -12,6 +12,7 @@
 #include "FXPanel.h"
 #include "MidiLearnManager.h"
 #include "KeyboardMappingManager.h"
+#include "DspLoadOverlay.h"
 
 //==============================================================================
 // ルーパーアプリ本体
@@ -27,6 +28,8 @@ public MidiLearnManager::Listener
 	MainComponent();
 	void onRecordingStarted(int trackID) override;
 	void onRecordingStopped(int trackID) override;
+	void onTrackRestored(int trackID) override;
+	void onLoopsCleared() override;
 
 
 
@@ -62,7 +65,17 @@ public MidiLearnManager::Listener
 	// ===== オーディオ関連 =====
 	InputTap inputTap;
 	juce::TriggerEvent& sharedTrigger;
-	LooperAudio looper ; // 30秒バッファ
+	// ループ用メモリ（全トラック共有のページプール）の既定値。設定 loopMemorySeconds で変更可
+	static constexpr int defaultLoopMemorySeconds = 120;
+	static constexpr int defaultUndoMemorySeconds = 60;
+	int loopMemorySeconds = defaultLoopMemorySeconds; // 設定値（秒）。prepareToPlay でデバイスのサンプルレートで換算する
+	bool lockLoopMemory = false;
+	int undoMemorySeconds = defaultUndoMemorySeconds;
+	LooperAudio looper ;
+
+	// オーディオスレッド用の作業バッファ（prepareToPlay で確保）
+	juce::AudioBuffer<float> inputScratch;
+	int numActiveInputChannels = 0; // デバイスの有効な入力チャンネル数（prepareToPlay で更新）
 
 	void timerCallback()override;
 
@@ -90,10 +103,10 @@ public MidiLearnManager::Listener
 	CircularVisualizer visualizer;
 	TransportPanel transportPanel;
 	FXPanel fxPanel;
+	DspLoadOverlay dspLoadOverlay { looper }; // ⏱ DSP 負荷（キー操作で表示切り替え）
 	bool isFXMode = false;
 	int selectedTrackId = 0;
 	std::atomic<bool> isStandbyMode { false };
-    std::atomic<bool> forceRecordRequest { false };
     
     // Auto-Arm 機能
     juce::ToggleButton autoArmButton;
@@ -111,8 +124,8 @@ public MidiLearnManager::Listener
     // MIDI Learn 機能
     juce::ToggleButton midiLearnButton;
     
-    // トリガーデバウンス制御
-    juce::int64 lastTriggerTime = 0;
+    // トリガーデバウンス制御（入力ルートごと）
+    std::array<juce::int64, InputManager::maxRoutes> lastTriggerTimes {};
 
 
 	std::vector<std::unique_ptr<LooperTrackUi>> trackUIs;
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    NoiseFloorTracker.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    チャンネルごとのノイズフロアの追従（最大 MAX_CHANNELS、オーディオスレッド専用）
+    - 最小統計: 窓を numSubWindows 個の小区間に分け、小区間ごとにブロックのピークの最大を取る
+      ノイズフロア = 直近 numSubWindows 個の小区間の最大のうち最小（= いちばん静かだった区間のピーク）
+      2秒のキャリブレーション（静かな間のピーク）と同じ意味の値が、演奏の合間ごとに更新される
+    - 1ブロックあたりレーンごとに比較1回。小区間が終わったときだけ numSubWindows 個の最小を取り直す（定数時間）
+    - 下がる方はその小区間が終われば追従し、上がる方は窓全体が大きくなってから追従する
+      （窓より短い演奏やトリガーではフロアは上がらない）
+    - 止めたレーン（録音中の入力）はその間の小区間を履歴に入れず、フロアは止めたときの値のまま
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ChannelTriggerSettings.h"
+#include <array>
+#include <limits>
+
+class NoiseFloorTracker
+{
+public:
+	static constexpr int numLanes = MAX_CHANNELS;
+	static constexpr int numSubWindows = 8;
+
+	NoiseFloorTracker() { reset(); }
+
+	// メッセージスレッド。windowMs = 最小を取る範囲の全体
+	void prepare(double sampleRate, int windowMs)
+	{
+		subWindowSamples = juce::jmax(1, (int)(sampleRate * windowMs / 1000.0 / numSubWindows));
+		reset();
+	}
+
+	// まだ何も測っていない状態（フロア 0 = 不明）に戻す
+	void reset() noexcept
+	{
+		for (int lane = 0; lane < numLanes; ++lane)
+			resetLane(lane);
+		subWindowElapsed = 0;
+	}
+
+	// 1レーンだけやり直す（検出する信号が変わったとき）
+	void resetLane(int lane) noexcept
+	{
+		const auto l = (size_t)lane;
+		for (auto& window : history)
+			window[l] = empty;
+		currentMax[l] = noData;
+		floor[l] = 0.0f;
+	}
+
+	// levels: このブロックのレーンごとのピーク（numLanes 個）
+	// frozen: 学習しないレーン（nullptr = 全レーン学習する）
+	void process(const float* levels, int numSamples, const bool* frozen = nullptr) noexcept
+	{
+		for (size_t l = 0; l < (size_t)numLanes; ++l)
+			if (frozen == nullptr || !frozen[l])
+				currentMax[l] = juce::jmax(currentMax[l], levels[l]);
+
+		subWindowElapsed += numSamples;
+		if (subWindowElapsed < subWindowSamples)
+			return;
+
+		// 小区間の終わり: 最大を履歴に入れて、履歴の最小を取り直す
+		subWindowElapsed = 0;
+		auto& window = history[(size_t)historyPos];
+		for (size_t l = 0; l < (size_t)numLanes; ++l)
+			window[l] = currentMax[l] >= 0.0f ? currentMax[l] : empty;
+		historyPos = (historyPos + 1) % numSubWindows;
+		currentMax.fill(noData);
+
+		// 履歴が全部空（ずっと止めていた）なら、フロアは前の値のまま
+		for (size_t l = 0; l < (size_t)numLanes; ++l)
+		{
+			float lowest = empty;
+			for (const auto& w : history)
+				lowest = juce::jmin(lowest, w[l]);
+			if (lowest < empty)
+				floor[l] = lowest;
+		}
+	}
+
+	// 0 = まだ小区間が1つも終わっていない
+	float getFloor(int lane) const noexcept { return floor[(size_t)lane]; }
+
+private:
+	static constexpr float empty = std::numeric_limits<float>::max();
+	static constexpr float noData = -1.0f; // この小区間はまだ学習していない
+
+	int subWindowSamples = 24000;
+	int subWindowElapsed = 0;
+	int historyPos = 0;
+
+	std::array<float, numLanes> currentMax {};
+	std::array<std::array<float, numLanes>, numSubWindows> history {};
+	std::array<float, numLanes> floor {};
+};
@@ -0,0 +1,470 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "ImpulseResponseLoader.h"
+#include <algorithm>
+
+namespace
+{
+	constexpr double fallbackSampleRate = 48000.0;
+
+	// fx アクションのパラメータ名 → LooperAudio のセッター
+	struct FxParameter
+	{
+		const char* name;
+		void (*apply)(LooperAudio&, int trackId, float value, float value2);
+	};
+
+	const FxParameter fxParameters[] =
+	{
+		{ "filter",            [](LooperAudio& l, int id, float v, float)  { l.setTrackFilterEnabled(id, v >= 0.5f); } },
+		{ "filter.cutoff",     [](LooperAudio& l, int id, float v, float)  { l.setTrackFilterCutoff(id, v); } },
+		{ "filter.res",        [](LooperAudio& l, int id, float v, float)  { l.setTrackFilterResonance(id, v); } },
+		{ "filter.type",       [](LooperAudio& l, int id, float v, float)  { l.setTrackFilterType(id, (int)v); } },
+		{ "flanger",           [](LooperAudio& l, int id, float v, float)  { l.setTrackFlangerEnabled(id, v >= 0.5f); } },
+		{ "flanger.rate",      [](LooperAudio& l, int id, float v, float)  { l.setTrackFlangerRate(id, v); } },
+		{ "flanger.depth",     [](LooperAudio& l, int id, float v, float)  { l.setTrackFlangerDepth(id, v); } },
+		{ "flanger.feedback",  [](LooperAudio& l, int id, float v, float)  { l.setTrackFlangerFeedback(id, v); } },
+		{ "flanger.sync",      [](LooperAudio& l, int id, float v, float)  { l.setTrackFlangerSync(id, v >= 0.5f); } },
+		{ "chorus",            [](LooperAudio& l, int id, float v, float)  { l.setTrackChorusEnabled(id, v >= 0.5f); } },
+		{ "chorus.rate",       [](LooperAudio& l, int id, float v, float)  { l.setTrackChorusRate(id, v); } },
+		{ "chorus.depth",      [](LooperAudio& l, int id, float v, float)  { l.setTrackChorusDepth(id, v); } },
+		{ "chorus.mix",        [](LooperAudio& l, int id, float v, float)  { l.setTrackChorusMix(id, v); } },
+		{ "chorus.sync",       [](LooperAudio& l, int id, float v, float)  { l.setTrackChorusSync(id, v >= 0.5f); } },
+		{ "tremolo",           [](LooperAudio& l, int id, float v, float)  { l.setTrackTremoloEnabled(id, v >= 0.5f); } },
+		{ "tremolo.rate",      [](LooperAudio& l, int id, float v, float)  { l.setTrackTremoloRate(id, v); } },
+		{ "tremolo.depth",     [](LooperAudio& l, int id, float v, float)  { l.setTrackTremoloDepth(id, v); } },
+		{ "tremolo.shape",     [](LooperAudio& l, int id, float v, float)  { l.setTrackTremoloShape(id, (int)v); } },
+		{ "tremolo.sync",      [](LooperAudio& l, int id, float v, float)  { l.setTrackTremoloSync(id, v >= 0.5f); } },
+		{ "slicer",            [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerEnabled(id, v >= 0.5f); } },
+		{ "slicer.rate",       [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerRate(id, v); } },
+		{ "slicer.depth",      [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerDepth(id, v); } },
+		{ "slicer.duty",       [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerDuty(id, v); } },
+		{ "slicer.shape",      [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerShape(id, (int)v); } },
+		{ "slicer.sync",       [](LooperAudio& l, int id, float v, float)  { l.setTrackSlicerSync(id, v >= 0.5f); } },
+		{ "bitcrusher",        [](LooperAudio& l, int id, float v, float)  { l.setTrackBitcrusherEnabled(id, v >= 0.5f); } },
+		{ "bitcrusher.depth",  [](LooperAudio& l, int id, float v, float)  { l.setTrackBitcrusherDepth(id, v); } },
+		{ "bitcrusher.rate",   [](LooperAudio& l, int id, float v, float)  { l.setTrackBitcrusherRate(id, v); } },
+		{ "granular",          [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularEnabled(id, v >= 0.5f); } },
+		{ "granular.size",     [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularSize(id, v); } },
+		{ "granular.density",  [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularDensity(id, v); } },
+		{ "granular.pitch",    [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularPitch(id, v); } },
+		{ "granular.jitter",   [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularJitter(id, v); } },
+		{ "granular.mix",      [](LooperAudio& l, int id, float v, float)  { l.setTrackGranularMix(id, v); } },
+		{ "autotune",          [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneEnabled(id, v >= 0.5f); } },
+		{ "autotune.key",      [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneKey(id, (int)v); } },
+		{ "autotune.scale",    [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneScale(id, (int)v); } },
+		{ "autotune.amount",   [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneAmount(id, v); } },
+		{ "autotune.speed",    [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneSpeed(id, v); } },
+		{ "autotune.formants", [](LooperAudio& l, int id, float v, float)  { l.setTrackAutotuneFormants(id, v >= 0.5f); } },
+		{ "reverb",            [](LooperAudio& l, int id, float v, float)  { l.setTrackReverbEnabled(id, v >= 0.5f); } },
+		{ "reverb.mix",        [](LooperAudio& l, int id, float v, float)  { l.setTrackReverbMix(id, v); } },
+		{ "reverb.damping",    [](LooperAudio& l, int id, float v, float)  { l.setTrackReverbDamping(id, v); } },
+		{ "reverb.size",       [](LooperAudio& l, int id, float v, float)  { l.setTrackReverbRoomSize(id, v); } },
+		{ "delay",             [](LooperAudio& l, int id, float v, float)  { l.setTrackDelayEnabled(id, v >= 0.5f); } },
+		{ "delay.mix",         [](LooperAudio& l, int id, float v, float t) { l.setTrackDelayMix(id, v, t); } },   // 値2 = 時間(秒)
+		{ "delay.feedback",    [](LooperAudio& l, int id, float v, float)  { l.setTrackDelayFeedback(id, v); } },
+		{ "delay.sync",        [](LooperAudio& l, int id, float v, float)  { l.setTrackDelaySync(id, v >= 0.5f); } },
+		{ "delay.division",    [](LooperAudio& l, int id, float v, float)  { l.setTrackDelayDivision(id, (int)v); } },
+		{ "delay.pingpong",    [](LooperAudio& l, int id, float v, float)  { l.setTrackDelayPingPong(id, v >= 0.5f); } },
+		{ "reverb.send",       [](LooperAudio& l, int id, float v, float)  { l.setTrackReverbSend(id, v); } },
+		{ "delay.send",        [](LooperAudio& l, int id, float v, float)  { l.setTrackDelaySend(id, v); } },
+		// 共有バス（トラック番号は無視）
+		{ "bus.reverb.size",   [](LooperAudio& l, int, float v, float)     { l.setBusReverbRoomSize(v); } },
+		{ "bus.reverb.damping",[](LooperAudio& l, int, float v, float)     { l.setBusReverbDamping(v); } },
+		{ "bus.reverb.return", [](LooperAudio& l, int, float v, float)     { l.setBusReverbReturn(v); } },
+		{ "bus.delay.time",    [](LooperAudio& l, int, float v, float)     { l.setBusDelayTime(v); } },
+		{ "bus.delay.feedback",[](LooperAudio& l, int, float v, float)     { l.setBusDelayFeedback(v); } },
+		{ "bus.delay.sync",    [](LooperAudio& l, int, float v, float)     { l.setBusDelaySync(v >= 0.5f); } },
+		{ "bus.delay.division",[](LooperAudio& l, int, float v, float)     { l.setBusDelayDivision((int)v); } },
+		{ "bus.delay.return",  [](LooperAudio& l, int, float v, float)     { l.setBusDelayReturn(v); } },
+		{ "compressor",        [](LooperAudio& l, int id, float v, float r) { l.setTrackCompressor(id, v, r); } }, // 値2 = レシオ
+		{ "compressor.enabled", [](LooperAudio& l, int id, float v, float) { l.setTrackCompressorEnabled(id, v >= 0.5f); } },
+		{ "compressor.lookahead", [](LooperAudio& l, int id, float v, float) { l.setTrackCompressorLookahead(id, v >= 0.5f); } },
+		{ "beatrepeat",        [](LooperAudio& l, int id, float v, float)  { l.setTrackBeatRepeatActive(id, v >= 0.5f); } },
+		{ "beatrepeat.div",    [](LooperAudio& l, int id, float v, float)  { l.setTrackBeatRepeatDiv(id, (int)v); } },
+		{ "beatrepeat.thresh", [](LooperAudio& l, int id, float v, float)  { l.setTrackBeatRepeatThresh(id, v); } },
+		{ "slot",              [](LooperAudio& l, int id, float v, float t) { l.setTrackFxSlot(id, (int)v, (int)t); } }, // 値 = スロット, 値2 = FxModuleType（-1 = 空き）
+	};
+
+	// on / off / true / false も数値として受け付ける
+	float parseValue(const juce::String& text, float defaultValue)
+	{
+		const auto t = text.trim().toLowerCase();
+		if (t.isEmpty())                   return defaultValue;
+		if (t == "on" || t == "true")      return 1.0f;
+		if (t == "off" || t == "false")    return 0.0f;
+		return t.getFloatValue();
+	}
+
+	// トラックIDを取るアクション
+	bool actionTakesTrack(const juce::String& name)
+	{
+		return name == "record" || name == "stop" || name == "play" || name == "pause"
+			|| name == "clear" || name == "gain" || name == "multiplier" || name == "fx" || name == "impulse";
+	}
+
+	bool isKnownAction(const juce::String& name)
+	{
+		return actionTakesTrack(name) || name == "playall" || name == "stopall"
+			|| name == "allclear" || name == "undo" || name == "redo";
+	}
+
+	std::unique_ptr<juce::AudioFormatWriter> createWavWriter(const juce::File& file, double sampleRate, int bitDepth)
+	{
+		file.deleteFile();
+		auto stream = file.createOutputStream();
+		if (stream == nullptr || stream->failedToOpen())
+			return nullptr;
+
+		juce::WavAudioFormat wav;
+		std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor(stream.get(), sampleRate, 2,
+																			  bitDepth, {}, 0));
+		if (writer != nullptr)
+			stream.release(); // writer が所有する
+
+		return writer;
+	}
+}
+
+OfflineRenderer::OfflineRenderer(const Options& o)
+	: options(o)
+{
+	options.blockSize = juce::jmax(1, options.blockSize);
+	options.numTracks = juce::jlimit(1, LooperAudio::maxTracks, options.numTracks);
+	formatManager.registerBasicFormats();
+}
+
+juce::int64 OfflineRenderer::toSamples(double seconds) const
+{
+	const double sr = options.sampleRate > 0.0 ? options.sampleRate : fallbackSampleRate;
+	return (juce::int64)std::llround(juce::jmax(0.0, seconds) * sr);
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::addInputFile(const juce::File& file, double startSeconds)
+{
+	std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor(file));
+	if (reader == nullptr)
+		return juce::Result::fail("cannot read audio file: " + file.getFullPathName());
+
+	if (options.sampleRate <= 0.0)
+		options.sampleRate = reader->sampleRate;
+
+	const int fileLength = (int)reader->lengthInSamples;
+	juce::AudioBuffer<float> fileAudio ((int)reader->numChannels, fileLength);
+	reader->read(&fileAudio, 0, fileLength, 0, true, true);
+
+	Input input;
+	input.startSample = toSamples(startSeconds);
+
+	// ステレオにそろえる（モノラルは両チャンネルに、3ch以上は先頭2chを使う）
+	const double ratio = reader->sampleRate / options.sampleRate;
+	const int length = (int)std::ceil(fileLength / ratio);
+	input.audio.setSize(2, length);
+
+	for (int ch = 0; ch < 2; ++ch)
+	{
+		const int srcCh = juce::jmin(ch, fileAudio.getNumChannels() - 1);
+
+		if (std::abs(ratio - 1.0) < 1.0e-9)
+		{
+			input.audio.copyFrom(ch, 0, fileAudio, srcCh, 0, length);
+		}
+		else
+		{
+			// レートが違う入力は読み込み時に変換しておく（レンダリング中は変換しない）
+			juce::LagrangeInterpolator interpolator;
+			interpolator.process(ratio, fileAudio.getReadPointer(srcCh), input.audio.getWritePointer(ch),
+								 length, fileLength, 0);
+		}
+	}
+
+	DBG("📥 OfflineRenderer: input " << file.getFileName() << " (" << length << " samples @ "
+		<< options.sampleRate << " Hz) at " << startSeconds << " s");
+
+	inputs.push_back(std::move(input));
+	return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::loadScript(const juce::File& scriptFile)
+{
+	if (!scriptFile.existsAsFile())
+		return juce::Result::fail("script not found: " + scriptFile.getFullPathName());
+
+	return parseScript(scriptFile.loadFileAsString());
+}
+
+juce::Result OfflineRenderer::parseScript(const juce::String& scriptText)
+{
+	juce::StringArray lines;
+	lines.addLines(scriptText);
+
+	std::vector<Action> parsed;
+
+	for (int i = 0; i < lines.size(); ++i)
+	{
+		const auto line = lines[i].upToFirstOccurrenceOf("#", false, false).trim();
+		if (line.isEmpty())
+			continue;
+
+		juce::StringArray tokens;
+		tokens.addTokens(line, " \t", "\"");
+		tokens.removeEmptyStrings();
+
+		const auto fail = [&](const juce::String& message)
+		{
+			return juce::Result::fail("script line " + juce::String(i + 1) + ": " + message);
+		};
+
+		if (tokens.size() < 2 || !tokens[0].containsOnly("0123456789.+-eE"))
+			return fail("expected '<seconds> <action> ...'");
+
+		Action action;
+		action.timeSeconds = tokens[0].getDoubleValue();
+		action.name = tokens[1].toLowerCase();
+		action.lineNumber = i + 1;
+
+		if (action.timeSeconds < 0.0)
+			return fail("negative time");
+
+		if (!isKnownAction(action.name))
+			return fail("unknown action '" + action.name + "'");
+
+		int firstArg = 2;
+		if (actionTakesTrack(action.name))
+		{
+			if (tokens.size() < 3 || !tokens[2].containsOnly("0123456789"))
+				return fail("'" + action.name + "' needs a track id");
+
+			action.trackId = tokens[2].getIntValue();
+			if (action.trackId < 1 || action.trackId > options.numTracks)
+				return fail("track " + juce::String(action.trackId) + " out of range 1.." + juce::String(options.numTracks));
+			firstArg = 3;
+		}
+
+		for (int t = firstArg; t < tokens.size(); ++t)
+			action.args.add(tokens[t]);
+
+		if ((action.name == "gain" || action.name == "multiplier") && action.args.isEmpty())
+			return fail("'" + action.name + "' needs a value");
+
+		if (action.name == "impulse" && action.args.isEmpty())
+			return fail("'impulse' needs a file (or off)");
+
+		if (action.name == "fx")
+		{
+			if (action.args.size() < 2)
+				return fail("'fx' needs a parameter and a value");
+
+			const auto param = action.args[0].toLowerCase();
+			if (std::none_of(std::begin(fxParameters), std::end(fxParameters),
+							 [&](const FxParameter& p) { return param == p.name; }))
+				return fail("unknown fx parameter '" + param + "'");
+		}
+
+		parsed.push_back(std::move(action));
+	}
+
+	// 時刻順に並べる（同時刻は書いた順のまま）
+	std::stable_sort(parsed.begin(), parsed.end(),
+					 [](const Action& a, const Action& b) { return a.timeSeconds < b.timeSeconds; });
+
+	actions = std::move(parsed);
+	return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::applyAction(LooperAudio& looper, const Action& action) const
+{
+	const auto& name = action.name;
+	const int id = action.trackId;
+
+	if      (name == "record")     looper.startRecording(id);
+	else if (name == "stop")       looper.stopRecording(id);
+	else if (name == "play")       looper.startPlaying(id);
+	else if (name == "pause")      looper.stopPlaying(id);
+	else if (name == "playall")    looper.startAllPlayback();
+	else if (name == "stopall")    looper.stopAllTracks();
+	else if (name == "clear")      looper.clearTrack(id);
+	else if (name == "allclear")   looper.allClear();
+	else if (name == "undo")       looper.undoLastRecording();
+	else if (name == "redo")       looper.redoLastRecording();
+	else if (name == "gain")       looper.setTrackGain(id, parseValue(action.args[0], 1.0f));
+	else if (name == "multiplier") looper.setTrackLoopMultiplier(id, parseValue(action.args[0], 1.0f));
+	else if (name == "impulse")
+	{
+		// Convolution Reverb の IR。オフラインなのでその場で読む（processBlock の計測には入らない）
+		if (action.args[0].toLowerCase() == "off")
+		{
+			looper.clearTrackReverbImpulse(id);
+			return juce::Result::ok();
+		}
+
+		const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(action.args[0]);
+		juce::AudioBuffer<float> impulse;
+		double impulseSampleRate = 0.0;
+		if (!ImpulseResponseLoader::readFile(file, impulse, impulseSampleRate)
+			|| !looper.setTrackReverbImpulse(id, impulse, impulseSampleRate))
+			return juce::Result::fail("script line " + juce::String(action.lineNumber) + ": cannot load impulse " + file.getFullPathName());
+	}
+	else if (name == "fx")
+	{
+		const auto param = action.args[0].toLowerCase();
+		for (const auto& p : fxParameters)
+		{
+			if (param == p.name)
+			{
+				p.apply(looper, id, parseValue(action.args[1], 0.0f),
+						parseValue(action.args.size() > 2 ? action.args[2] : juce::String(),
+								   param == "compressor" ? 4.0f : 0.5f));
+				return juce::Result::ok();
+			}
+		}
+		return juce::Result::fail("script line " + juce::String(action.lineNumber) + ": unknown fx parameter");
+	}
+
+	return juce::Result::ok();
+}
+
+void OfflineRenderer::mixInputs(juce::AudioBuffer<float>& dest, juce::int64 position, int numSamples) const
+{
+	dest.clear();
+
+	for (const auto& input : inputs)
+	{
+		const juce::int64 inputEnd = input.startSample + input.audio.getNumSamples();
+		const juce::int64 start = juce::jmax(position, input.startSample);
+		const juce::int64 end = juce::jmin(position + numSamples, inputEnd);
+		if (start >= end)
+			continue;
+
+		for (int ch = 0; ch < 2; ++ch)
+			dest.addFrom(ch, (int)(start - position), input.audio, ch, (int)(start - input.startSample), (int)(end - start));
+	}
+}
+
+juce::int64 OfflineRenderer::getRenderLength() const
+{
+	if (options.lengthSeconds > 0.0)
+		return toSamples(options.lengthSeconds);
+
+	juce::int64 end = 0;
+	for (const auto& input : inputs)
+		end = juce::jmax(end, input.startSample + input.audio.getNumSamples());
+	if (!actions.empty())
+		end = juce::jmax(end, toSamples(actions.back().timeSeconds));
+
+	return end + toSamples(options.tailSeconds);
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::render(const juce::File& outputDirectory, Stats& stats)
+{
+	if (options.sampleRate <= 0.0)
+		options.sampleRate = fallbackSampleRate;
+
+	const double sampleRate = options.sampleRate;
+	const int blockSize = options.blockSize;
+	const juce::int64 length = getRenderLength();
+
+	if (!outputDirectory.createDirectory())
+		return juce::Result::fail("cannot create output directory: " + outputDirectory.getFullPathName());
+
+	// アプリと同じ手順で組み立てる（addTrack / 設定はオーディオ開始前）
+	auto looper = std::make_unique<LooperAudio>(sampleRate, (int)(sampleRate * options.loopMemorySeconds));
+	for (int id = 1; id <= options.numTracks; ++id)
+		looper->addTrack(id);
+	looper->setRenderThreadCount(options.renderThreads);
+	looper->setCrossTrackLanes(options.crossTrackLanes);
+
+	std::unique_ptr<juce::AudioBuffer<float>[]> stems;
+	if (options.writeStems)
+	{
+		stems.reset(new juce::AudioBuffer<float>[LooperAudio::maxTracks]);
+		for (int slot = 0; slot < LooperAudio::maxTracks; ++slot)
+			stems[slot].setSize(2, blockSize);
+		looper->setStemOutputs(stems.get());
+	}
+
+	looper->prepareToPlay(blockSize, sampleRate);
+
+	auto mixWriter = createWavWriter(outputDirectory.getChildFile("mix.wav"), sampleRate, options.bitDepth);
+	if (mixWriter == nullptr)
+		return juce::Result::fail("cannot write " + outputDirectory.getChildFile("mix.wav").getFullPathName());
+
+	std::vector<std::unique_ptr<juce::AudioFormatWriter>> stemWriters;
+	if (options.writeStems)
+	{
+		for (int slot = 0; slot < looper->getNumTracks(); ++slot)
+		{
+			const auto file = outputDirectory.getChildFile("track_" + juce::String(looper->getTrackIdAt(slot)) + ".wav");
+			stemWriters.push_back(createWavWriter(file, sampleRate, options.bitDepth));
+			if (stemWriters.back() == nullptr)
+				return juce::Result::fail("cannot write " + file.getFullPathName());
+		}
+	}
+
+	juce::AudioBuffer<float> input (2, blockSize);
+	juce::AudioBuffer<float> output (2, blockSize);
+
+	stats = {};
+	juce::int64 processTicks = 0;
+	juce::int64 position = 0;
+	size_t nextAction = 0;
+
+	while (position < length)
+	{
+		// この位置のアクションを積む（次の processBlock の先頭で適用される）
+		while (nextAction < actions.size() && toSamples(actions[nextAction].timeSeconds) <= position)
+		{
+			const auto result = applyAction(*looper, actions[nextAction++]);
+			if (result.failed())
+				return result;
+		}
+
+		// 次のアクションの位置でブロックを切るので、操作はサンプル単位で正確に入る
+		juce::int64 blockEnd = juce::jmin(position + blockSize, length);
+		if (nextAction < actions.size())
+			blockEnd = juce::jmin(blockEnd, toSamples(actions[nextAction].timeSeconds));
+
+		const int numSamples = (int)(blockEnd - position);
+		input.setSize(2, numSamples, false, false, true);
+		output.setSize(2, numSamples, false, false, true);
+		mixInputs(input, position, numSamples);
+
+		const auto start = juce::Time::getHighResolutionTicks();
+		looper->processBlock(output, input);
+		const auto blockTicks = juce::Time::getHighResolutionTicks() - start;
+		processTicks += blockTicks;
+
+		// 平均のリアルタイム比ではスパイクが見えないので、ブロックごとの締め切りに対する負荷も取っておく
+		stats.worstBlockLoad = juce::jmax(stats.worstBlockLoad,
+		                                  juce::Time::highResolutionTicksToSeconds(blockTicks) * sampleRate / (double)numSamples);
+
+		mixWriter->writeFromAudioSampleBuffer(output, 0, numSamples);
+		for (size_t slot = 0; slot < stemWriters.size(); ++slot)
+			stemWriters[slot]->writeFromAudioSampleBuffer(stems[slot], 0, numSamples);
+
+		position = blockEnd;
+	}
+
+	// 残っている通知を捨てる（リスナーはいない）
+	looper->dispatchPendingNotifications();
+
+	stats.numSamples = length;
+	stats.audioSeconds = (double)length / sampleRate;
+	stats.processSeconds = juce::Time::highResolutionTicksToSeconds(processTicks);
+	stats.realtimeFactor = stats.processSeconds > 0.0 ? stats.audioSeconds / stats.processSeconds : 0.0;
+
+	return juce::Result::ok();
+}
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    サウンドカードなしで LooperAudio を回すオフラインレンダラー
+    - 入力: WAV 等のオーディオファイル（開始時刻つき、ステレオにミックスして入力扱い）
+    - 操作: 時刻つきのアクションスクリプト（録音 / 停止 / 再生 / FX 変更）
+    - 出力: ミックスの WAV とトラックごとのステム
+    processBlock を CPU が回せるだけ速く回し、リアルタイム比を返す。
+    アクションの時刻でブロックを区切るので、操作はサンプル単位で正確に入る。
+
+    スクリプトの書式（1行1アクション、# 以降はコメント）:
+        <秒>  <アクション>  [トラックID]  [値...]
+
+        0.0   record     1
+        4.0   stop       1
+        4.0   play       1
+        4.0   record     2
+        8.0   stop       2
+        8.0   fx         2  reverb      on
+        8.0   fx         2  reverb.mix  0.4
+        8.0   impulse    2  hall.wav
+        12.0  multiplier 3  2
+        16.0  stopall
+
+    アクション: record / stop / play / pause / playall / stopall / clear / allclear /
+              undo / redo / gain <id> <v> / multiplier <id> <v> / fx <id> <パラメータ> <値> [値2] /
+              impulse <id> <ファイル | off>（Reverb を IR の畳み込みにする。パスは作業ディレクトリから、空白なし）
+    fx のパラメータ名は OfflineRenderer.cpp の fxParameters を参照（on / off も使える）
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "LooperAudio.h"
+#include <memory>
+#include <vector>
+
+class OfflineRenderer
+{
+public:
+	struct Options
+	{
+		double sampleRate = 0.0;        // 0 = 最初の入力ファイルに合わせる（入力がなければ 48kHz）
+		                                // 違うレートの入力はこのレートに変換して読む
+		int blockSize = 512;
+		int numTracks = 8;              // トラックID 1..numTracks
+		int loopMemorySeconds = 120;
+		int renderThreads = 0;          // LooperAudio::setRenderThreadCount と同じ
+		bool crossTrackLanes = false;   // LooperAudio::setCrossTrackLanes と同じ
+		double lengthSeconds = 0.0;     // 0 = 入力とスクリプトの終わり + tailSeconds
+		double tailSeconds = 2.0;
+		bool writeStems = true;
+		int bitDepth = 24;
+	};
+
+	struct Action
+	{
+		double timeSeconds = 0.0;
+		juce::String name;
+		int trackId = -1;
+		juce::StringArray args;
+		int lineNumber = 0;
+	};
+
+	struct Stats
+	{
+		juce::int64 numSamples = 0;
+		double audioSeconds = 0.0;
+		double processSeconds = 0.0;    // processBlock だけにかかった時間
+		double realtimeFactor = 0.0;    // audioSeconds / processSeconds
+		double worstBlockLoad = 0.0;    // いちばん重かったブロックの処理時間 / そのブロックの長さ（1 以上 = 実時間なら落ちる）
+	};
+
+	explicit OfflineRenderer(const Options& options);
+
+	// 入力ファイルを startSeconds の位置に置く（複数可、重なった部分は足し合わせる）
+	juce::Result addInputFile(const juce::File& file, double startSeconds = 0.0);
+
+	juce::Result loadScript(const juce::File& scriptFile);
+	juce::Result parseScript(const juce::String& scriptText);
+
+	// outputDirectory に mix.wav と track_<id>.wav を書き出す
+	juce::Result render(const juce::File& outputDirectory, Stats& stats);
+
+	const std::vector<Action>& getActions() const { return actions; }
+	const Options& getOptions() const { return options; } // render 後はサンプルレートが確定している
+
+private:
+	struct Input
+	{
+		juce::AudioBuffer<float> audio; // ステレオ、Options::sampleRate に変換済み
+		juce::int64 startSample = 0;
+	};
+
+	juce::Result applyAction(LooperAudio& looper, const Action& action) const;
+	void mixInputs(juce::AudioBuffer<float>& dest, juce::int64 position, int numSamples) const;
+	juce::int64 toSamples(double seconds) const;
+	juce::int64 getRenderLength() const;
+
+	Options options;
+	juce::AudioFormatManager formatManager;
+	std::vector<Input> inputs;
+	std::vector<Action> actions; // 時刻順（同時刻は書いた順）
+
+	JUCE_DECLARE_NON_COPYABLE (OfflineRenderer)
+};
@@ -1,67 +1,161 @@
 /*
   ==============================================================================
     PitchDetector.h - YIN-based pitch detection for Autotune
+
+    - 差分関数 d(τ) = Σ(x[j] - x[j+τ])² を
+      「窓前半のエネルギー + ずらした区間のエネルギー（累積和） - 2 × 自己相関」に分解し、
+      自己相関を juce::dsp::FFT で求める（O(N²) → O(N log N)）
+    - 検出はホップ（既定 256 サンプル）ごとに1回。ブロックが小さいときは
+      何ブロックかに1回だけ FFT が走り、それ以外は前回の推定値を返す
+    - 入力はブロック単位で push（L/R を渡せばモノラルに畳んでから積む）
   ==============================================================================
 */
 
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
 #include <vector>
+#include <memory>
 #include <cmath>
 
 class PitchDetector
 {
 public:
-    void prepare(double sampleRate, int /*blockSize*/)
+    static constexpr int defaultHopSize = 256;
+
+    // メッセージスレッドで呼ぶ（確保する）
+    void prepare(double sampleRate, int /*blockSize*/, int newHopSize = defaultHopSize)
     {
         sr = sampleRate;
         yinWindowSize = static_cast<int>(sr * 0.025); // 25ms
         yinWindowSize = std::max(256, std::min(yinWindowSize, 2048));
+        hopSize = std::max(1, newHopSize);
+
+        // 相互相関 r(τ) = Σ_{j<W/2} x[j] x[j+τ] は τ < W/2 までしか使わないので、
+        // FFT 長が窓長 W 以上なら循環の折り返しは起きない
+        const int fftOrder = juce::roundToInt(std::ceil(std::log2((double)yinWindowSize)));
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        fftSize = fft->getSize();
 
-        inputBuffer.resize(yinWindowSize * 2, 0.0f);
-        yinBuffer.resize(yinWindowSize, 0.0f);
+        inputBuffer.assign(yinWindowSize * 2, 0.0f);
+        yinBuffer.assign(yinWindowSize, 0.0f);
+        window.assign(yinWindowSize, 0.0f);
+        energyPrefix.assign(yinWindowSize + 1, 0.0);
+        spectrumA.assign(fftSize * 2, 0.0f);
+        spectrumB.assign(fftSize * 2, 0.0f);
+        reset();
+    }
+
+    // 確保済みバッファの中身だけ消す（オーディオスレッドから呼んでよい）
+    void reset()
+    {
+        std::fill(inputBuffer.begin(), inputBuffer.end(), 0.0f);
+        std::fill(yinBuffer.begin(), yinBuffer.end(), 0.0f);
         writePos = 0;
+        samplesUntilDetection = hopOffset % hopSize;
         smoothedPitch = 0.0f;
     }
 
+    // ホップの位相をずらす（トラックごとに変えて、同じブロックで全トラックの FFT が重ならないように）
+    void setHopOffset(int offsetSamples)
+    {
+        hopOffset = std::max(0, offsetSamples);
+        samplesUntilDetection = hopOffset % hopSize;
+    }
+
+    int getHopSize() const noexcept { return hopSize; }
+
     void pushSamples(const float* samples, int numSamples)
     {
-        for (int i = 0; i < numSamples; ++i)
+        const int size = static_cast<int>(inputBuffer.size());
+        samplesUntilDetection -= numSamples;
+
+        // 窓より長いブロックなら最後の1周分だけ積めばよい
+        if (numSamples > size)
+        {
+            samples += numSamples - size;
+            numSamples = size;
+        }
+
+        while (numSamples > 0)
+        {
+            const int n = std::min(numSamples, size - writePos);
+            juce::FloatVectorOperations::copy(inputBuffer.data() + writePos, samples, n);
+            writePos = (writePos + n) % size;
+            samples += n;
+            numSamples -= n;
+        }
+    }
+
+    // L/R の平均を積む
+    void pushSamples(const float* left, const float* right, int numSamples)
+    {
+        const int size = static_cast<int>(inputBuffer.size());
+        samplesUntilDetection -= numSamples;
+
+        if (numSamples > size)
+        {
+            left += numSamples - size;
+            right += numSamples - size;
+            numSamples = size;
+        }
+
+        while (numSamples > 0)
         {
-            inputBuffer[writePos] = samples[i];
-            writePos = (writePos + 1) % static_cast<int>(inputBuffer.size());
+            const int n = std::min(numSamples, size - writePos);
+            float* dest = inputBuffer.data() + writePos;
+            juce::FloatVectorOperations::add(dest, left, right, n);
+            juce::FloatVectorOperations::multiply(dest, 0.5f, n);
+            writePos = (writePos + n) % size;
+            left += n;
+            right += n;
+            numSamples -= n;
         }
     }
 
+    // 前回の検出からホップ分以上積まれていれば検出し直す。いずれにせよ現在の推定値を返す
     float detectPitch()
     {
-        if (sr <= 0) return 0.0f;
+        if (samplesUntilDetection > 0)
+            return smoothedPitch;
 
-        // Extract window from ring buffer
-        std::vector<float> window(yinWindowSize);
-        int readPos = (writePos - yinWindowSize + (int)inputBuffer.size()) % (int)inputBuffer.size();
-        for (int i = 0; i < yinWindowSize; ++i)
-            window[i] = inputBuffer[(readPos + i) % (int)inputBuffer.size()];
+        // ブロックがホップより長くても検出は1回（最新の窓で）
+        samplesUntilDetection += hopSize * (1 + (-samplesUntilDetection) / hopSize);
+        return runDetection();
+    }
 
-        // RMS check
-        float rms = 0.0f;
+private:
+    float runDetection()
+    {
+        if (sr <= 0 || window.empty()) return 0.0f;
+
+        // Extract window from ring buffer (window は prepare で確保済み)
+        const int size = (int)inputBuffer.size();
+        const int readPos = (writePos - yinWindowSize + size) % size;
+        const int firstPart = std::min(yinWindowSize, size - readPos);
+        juce::FloatVectorOperations::copy(window.data(), inputBuffer.data() + readPos, firstPart);
+        juce::FloatVectorOperations::copy(window.data() + firstPart, inputBuffer.data(), yinWindowSize - firstPart);
+
+        // RMS check（ついでに二乗の累積和を作る: energyPrefix[k] = Σ_{j<k} x[j]²）
+        energyPrefix[0] = 0.0;
         for (int i = 0; i < yinWindowSize; ++i)
-            rms += window[i] * window[i];
-        rms = std::sqrt(rms / yinWindowSize);
+            energyPrefix[i + 1] = energyPrefix[i] + (double)window[i] * window[i];
+        const float rms = (float)std::sqrt(energyPrefix[yinWindowSize] / yinWindowSize);
         if (rms < 0.01f) { smoothedPitch *= 0.9f; return smoothedPitch; }
 
         // YIN difference function
-        int halfWin = yinWindowSize / 2;
-        std::fill(yinBuffer.begin(), yinBuffer.end(), 0.0f);
+        // d(τ) = Σ_{j<W} x[j]² + Σ_{j<W} x[j+τ]² - 2 r(τ)   (W = halfWin)
+        const int halfWin = yinWindowSize / 2;
+        computeCorrelation(halfWin);
+
+        // r(0) = Σ_{j<W} x[j]² になるように FFT の倍率を合わせる（エンジンごとの正規化の差を吸収）
+        const float energyHead = (float)energyPrefix[halfWin];
+        const float scale = std::abs(spectrumB[0]) > 1e-12f ? energyHead / spectrumB[0] : 0.0f;
+
         for (int tau = 1; tau < halfWin; ++tau)
         {
-            float sum = 0.0f;
-            for (int j = 0; j < halfWin; ++j)
-            {
-                float d = window[j] - window[j + tau];
-                sum += d * d;
-            }
-            yinBuffer[tau] = sum;
+            const float energyShifted = (float)(energyPrefix[tau + halfWin] - energyPrefix[tau]);
+            yinBuffer[tau] = std::max(0.0f, energyHead + energyShifted - 2.0f * scale * spectrumB[tau]);
         }
 
         // Cumulative mean normalized
@@ -102,10 +196,39 @@ public:
         return smoothedPitch;
     }
 
-private:
+    // spectrumB[τ] に r(τ) = Σ_{j<halfWin} x[j] x[j+τ] を（FFT の倍率のまま）入れる
+    void computeCorrelation(int halfWin)
+    {
+        // A = 窓の前半（残りは 0）、B = 窓全体
+        std::fill(spectrumA.begin(), spectrumA.end(), 0.0f);
+        std::fill(spectrumB.begin(), spectrumB.end(), 0.0f);
+        juce::FloatVectorOperations::copy(spectrumA.data(), window.data(), halfWin);
+        juce::FloatVectorOperations::copy(spectrumB.data(), window.data(), yinWindowSize);
+
+        fft->performRealOnlyForwardTransform(spectrumA.data(), true);
+        fft->performRealOnlyForwardTransform(spectrumB.data(), true);
+
+        // conj(A) * B（インターリーブの複素数）
+        for (int k = 0; k <= fftSize / 2; ++k)
+        {
+            const float ar = spectrumA[2 * k], ai = spectrumA[2 * k + 1];
+            const float br = spectrumB[2 * k], bi = spectrumB[2 * k + 1];
+            spectrumB[2 * k]     = ar * br + ai * bi;
+            spectrumB[2 * k + 1] = ar * bi - ai * br;
+        }
+
+        fft->performRealOnlyInverseTransform(spectrumB.data());
+    }
+
     double sr = 44100.0;
     int yinWindowSize = 1024;
-    std::vector<float> inputBuffer, yinBuffer;
+    int hopSize = defaultHopSize;
+    int hopOffset = 0;
+    int samplesUntilDetection = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int fftSize = 0;
+    std::vector<float> inputBuffer, yinBuffer, window, spectrumA, spectrumB;
+    std::vector<double> energyPrefix; // 差を取るので double で持つ
     int writePos = 0;
     float smoothedPitch = 0.0f;
 };
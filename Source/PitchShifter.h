@@ -1,100 +1,498 @@
 /*
   ==============================================================================
-    PitchShifter.h - Delay-line based pitch shifting for Autotune
+    PitchShifter.h - Block-based pitch shifting for Autotune
+
+    - 有声（周期が分かっている）: ピッチ同期 PSOLA。解析マークを周期 T 間隔で置き、
+      長さ 2T の Hann 窓グレインを T / ratio 間隔で重ね合わせる
+    - 無声 / 周期なし: FFT フェーズボコーダ（ピークのまわりを ratio 倍の位置へ移し、位相はピークに揃える）
+    - どちらも同じ出力リングに「信号 × 窓」と「窓の重み」を足し、読み出すときに
+      重みで割る（重み付き OLA）。モードが切り替わっても音量が揺れない
+    - 遅延は固定（getLatencySamples）。ルーパー側はこの分だけ先読みして揃える
+    - フォルマント保持: PSOLA はグレインをそのまま使い、フェーズボコーダはスペクトル包絡を
+      移動平均で推定して元の包絡に戻す。切ると両方ともグレイン / 包絡ごとずらす
+    - 窓は prepare で事前計算。ブロック単位で処理し、オーディオスレッドでは確保しない
   ==============================================================================
 */
 
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
 #include <vector>
+#include <memory>
 #include <cmath>
 
 class PitchShifter
 {
 public:
-    void prepare(double sampleRate, int /*blockSize*/)
+    enum class Mode
+    {
+        automatic = 0,  // 周期があれば PSOLA、なければフェーズボコーダ
+        psola,          // 周期がなければ 10ms の擬似周期で PSOLA
+        phaseVocoder
+    };
+
+    // メッセージスレッドで呼ぶ（確保する）
+    void prepare(double sampleRate, int maxBlockSize)
+    {
+        sr = sampleRate > 0.0 ? sampleRate : 44100.0;
+        maxBlock = std::max(1, maxBlockSize);
+        maxPeriod = (int)std::ceil(sr / minPitchHz);
+        minPeriod = std::max(8, (int)(sr / maxPitchHz));
+
+        // フェーズボコーダ: 約 21ms のフレーム、4 倍オーバーラップ
+        fftOrder = juce::roundToInt(std::ceil(std::log2(sr * 0.021)));
+        fftSize = 1 << fftOrder;
+        hopSize = fftSize / overlap;
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+
+        // 最悪の遅延（フォルマントを動かすとき）でも収まるリング長
+        int ring = 1;
+        while (ring < computeLatency(false) + fftSize + 4 * maxPeriod + maxBlock)
+            ring <<= 1;
+        ringMask = ring - 1;
+
+        input.setSize(2, ring);
+        output.setSize(2, ring);
+        weight.assign((size_t)ring, 0.0f);
+
+        pvWindow.resize((size_t)fftSize);
+        pvWindowSquared.resize((size_t)fftSize);
+        for (int i = 0; i < fftSize; ++i)
+        {
+            pvWindow[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)fftSize);
+            pvWindowSquared[(size_t)i] = pvWindow[(size_t)i] * pvWindow[(size_t)i];
+        }
+
+        for (int i = 0; i <= windowTableSize; ++i)
+            windowTable[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)windowTableSize);
+
+        const int numBins = fftSize / 2 + 1;
+        fftBuffer.assign((size_t)fftSize * 2, 0.0f);
+        for (auto& state : pvChannels)
+        {
+            state.lastPhase.assign((size_t)numBins, 0.0f);
+            state.sumPhase.assign((size_t)numBins, 0.0f);
+        }
+        analysisMagnitude.assign((size_t)numBins, 0.0f);
+        analysisFrequency.assign((size_t)numBins, 0.0f);
+        synthesisMagnitude.assign((size_t)numBins, 0.0f);
+        envelope.assign((size_t)numBins, 0.0f);
+        synthesisPhase.assign((size_t)numBins, 0.0f);
+        peaks.assign((size_t)numBins, 0);
+
+        // グレインは最長で出力側 ±2T
+        grainWindow.assign((size_t)(4 * maxPeriod + 1), 0.0f);
+        grainSource.assign((size_t)(4 * maxPeriod + 1), 0.0f);
+
+        // 逆変換の倍率はエンジンによって違うので、インパルスを往復させて合わせる
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        fftBuffer[0] = 1.0f;
+        fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+        fft->performRealOnlyInverseTransform(fftBuffer.data());
+        inverseScale = std::abs(fftBuffer[0]) > 1e-9f ? 1.0f / fftBuffer[0] : 1.0f;
+
+        reset();
+    }
+
+    // 確保済みバッファの中身だけ消す（オーディオスレッドから呼んでよい）
+    void reset()
     {
-        sr = sampleRate;
-        // Delay buffer ~50ms for pitch shifting
-        bufferSize = static_cast<int>(sr * 0.05);
-        delayBuffer.resize(bufferSize, 0.0f);
-        writePos = 0;
-        readPos1 = 0.0;
-        readPos2 = bufferSize / 2.0;
-        crossfadePos = 0.0;
-        pitchRatio = 1.0f;
+        input.clear();
+        output.clear();
+        std::fill(weight.begin(), weight.end(), 0.0f);
+
+        latency = computeLatency(preserveFormants);
+        inputCount = 0;
+        nextSynthesisMark = 0.0;
+        analysisMark = -(double)latency;
+        nextFrameTime = hopSize;
+        lastFrameCentre = -1;
+        psolaActive = false;
+        pvFresh = true;
     }
 
-    void setPitchRatio(float ratio)
+    void setPitchRatio(float ratio) { pitchRatio = juce::jlimit(0.5f, 2.0f, ratio); }
+
+    // 入力の基本周期（サンプル数）。0 = 無声 / 不明
+    void setPeriod(float periodSamples) { period = periodSamples; }
+
+    void setMode(Mode newMode) { mode = newMode; }
+
+    // 遅延が変わるので中身は消す（オーディオスレッドから呼んでよい）
+    void setPreserveFormants(bool shouldPreserve)
     {
-        pitchRatio = juce::jlimit(0.5f, 2.0f, ratio);
+        if (preserveFormants == shouldPreserve)
+            return;
+        preserveFormants = shouldPreserve;
+        reset();
     }
 
-    float process(float input)
+    bool getPreserveFormants() const noexcept { return preserveFormants; }
+
+    // 入力から出力までの遅延（サンプル数）
+    int getLatencySamples() const noexcept { return latency; }
+
+    // buffer の先頭 numSamples を置き換える（最大2ch）
+    void process(juce::AudioBuffer<float>& buffer, int numSamples)
     {
-        // Write to delay buffer
-        delayBuffer[writePos] = input;
-        writePos = (writePos + 1) % bufferSize;
-
-        // Two read heads with crossfade for seamless looping
-        float out1 = readInterpolated(readPos1);
-        float out2 = readInterpolated(readPos2);
-
-        // Hann window crossfade
-        double fadeLen = bufferSize / 2.0;
-        double fade1 = 0.5 * (1.0 - std::cos(juce::MathConstants<double>::pi * crossfadePos / fadeLen));
-        double fade2 = 1.0 - fade1;
-
-        float output = static_cast<float>(out1 * fade2 + out2 * fade1);
-
-        // Advance read positions based on pitch ratio
-        double speed = static_cast<double>(pitchRatio);
-        readPos1 += speed;
-        readPos2 += speed;
-        crossfadePos += 1.0;
-
-        // Wrap read positions
-        if (readPos1 >= bufferSize) readPos1 -= bufferSize;
-        if (readPos2 >= bufferSize) readPos2 -= bufferSize;
-        if (crossfadePos >= fadeLen)
+        const int numChannels = std::min(2, buffer.getNumChannels());
+
+        for (int offset = 0; offset < numSamples;)
         {
-            crossfadePos = 0.0;
-            // Reset lagging head to maintain sync
-            if (speed > 1.0)
-                readPos1 = readPos2 + fadeLen;
+            const int n = std::min(maxBlock, numSamples - offset);
+            processChunk(buffer, numChannels, offset, n);
+            offset += n;
+        }
+    }
+
+private:
+    static constexpr double minPitchHz = 70.0;
+    static constexpr double maxPitchHz = 2000.0;
+    static constexpr int overlap = 4;
+    static constexpr int windowTableSize = 1024;
+    static constexpr float minWeight = 0.5f; // 重みがこれより小さいところ（切り替わりの端）は割り切らずにフェードさせる
+
+    struct PhaseState
+    {
+        std::vector<float> lastPhase; // 前フレームの解析位相（入力ビン）
+        std::vector<float> sumPhase;  // 前フレームで合成した位相（出力ビン）
+    };
+
+    // 出力サンプル o の材料は、解析マーク a（≒ o - 遅延）の ±T と、出力側 ±half のグレイン。
+    // グレインは入力が a + T まで届いた時点で足すので、遅延 ≥ half + 1.5T なら読み出しに間に合う
+    int computeLatency(bool preserve) const
+    {
+        const double maxHalf = preserve ? 1.0 : 2.0; // フォルマントを動かすときは出力グレインが最大 2T
+        return std::max(fftSize, (int)std::ceil((maxHalf + 1.5) * maxPeriod) + 2);
+    }
+
+    void processChunk(juce::AudioBuffer<float>& buffer, int numChannels, int offset, int n)
+    {
+        // --- 1. 入力をリングへ ---
+        for (int ch = 0; ch < numChannels; ++ch)
+            writeRing(input.getWritePointer(ch), inputCount, buffer.getReadPointer(ch, offset), n);
+
+        const juce::int64 blockStart = inputCount;
+        inputCount += n;
+
+        const bool voiced = period > 0.0f;
+        const bool usePsola = mode == Mode::psola || (mode == Mode::automatic && voiced);
+
+        // --- 2. フェーズボコーダ（PSOLA 中もフレームの時刻だけは進めておく） ---
+        while (nextFrameTime <= inputCount)
+        {
+            if (!usePsola)
+            {
+                runFrame(nextFrameTime, numChannels);
+                lastFrameCentre = nextFrameTime - fftSize / 2 + latency;
+                pvFresh = false;
+            }
             else
-                readPos2 = readPos1 + fadeLen;
+            {
+                pvFresh = true;
+            }
+            nextFrameTime += hopSize;
+        }
+
+        // --- 3. PSOLA ---
+        if (usePsola)
+        {
+            const double T = juce::jlimit((double)minPeriod, (double)maxPeriod,
+                                          voiced ? (double)period : sr * 0.01);
+
+            if (!psolaActive)
+            {
+                // フェーズボコーダの最後のフレームの中心から引き継ぐ（重みで割るので重なっても平気）
+                nextSynthesisMark = std::max(nextSynthesisMark, (double)lastFrameCentre);
+            }
+            // 読み終えた位置より前には書かない
+            nextSynthesisMark = std::max(nextSynthesisMark, (double)blockStart + 2.0 * T);
+
+            while (true)
+            {
+                const double target = nextSynthesisMark - latency;
+
+                // 解析マークは T 間隔。大きく外れたら（周期が跳んだ / 再開した）target に合わせ直す
+                if (analysisMark < target - 2.0 * T || analysisMark > target + 2.0 * T)
+                    analysisMark = target;
+                while (analysisMark + 0.5 * T < target)
+                    analysisMark += T;
+
+                const auto centre = (juce::int64)std::llround(analysisMark);
+                const int halfIn = (int)std::lround(T);
+                if (centre + halfIn >= inputCount)
+                    break; // 入力がまだ届いていない
 
-            if (readPos1 >= bufferSize) readPos1 -= bufferSize;
-            if (readPos2 >= bufferSize) readPos2 -= bufferSize;
+                addGrain(centre, halfIn, nextSynthesisMark, numChannels);
+                nextSynthesisMark += T / pitchRatio;
+            }
         }
+        psolaActive = usePsola;
 
-        return output;
+        // --- 4. 重みで割って出力し、読んだところは消す ---
+        for (int i = 0; i < n; ++i)
+        {
+            const int idx = (int)((blockStart + i) & ringMask);
+            const float w = weight[(size_t)idx];
+            const float gain = 1.0f / std::max(w, minWeight);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float* out = output.getWritePointer(ch);
+                buffer.setSample(ch, offset + i, out[idx] * gain);
+                out[idx] = 0.0f;
+            }
+            weight[(size_t)idx] = 0.0f;
+        }
     }
 
-    void reset()
+    // ---------------------------------------------------------------- PSOLA
+    void addGrain(juce::int64 centre, int halfIn, double synthesisMark, int numChannels)
+    {
+        // 出力側の半径: フォルマントを動かすならグレインごと ratio で伸縮。
+        // 保持するときは伸縮しないが、上げるときは窓を T / ratio に縮めて重なりを 2 枚に抑える（打ち消し合いを防ぐ）
+        const int shifted = std::max(1, (int)std::lround(halfIn / pitchRatio));
+        const int half = preserveFormants ? std::min(halfIn, shifted) : shifted;
+        const int length = 2 * half + 1;
+        const auto outStart = (juce::int64)std::llround(synthesisMark) - half;
+
+        // 窓（テーブルを線形補間で引く）
+        const float tableStep = (float)windowTableSize / (float)(length - 1);
+        for (int j = 0; j < length; ++j)
+        {
+            const float pos = j * tableStep;
+            const int i0 = std::min((int)pos, windowTableSize - 1);
+            const float frac = pos - (float)i0;
+            grainWindow[(size_t)j] = windowTable[(size_t)i0] + frac * (windowTable[(size_t)i0 + 1] - windowTable[(size_t)i0]);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* in = input.getReadPointer(ch);
+
+            if (preserveFormants)
+            {
+                readRing(in, centre - half, grainSource.data(), length);
+            }
+            else
+            {
+                // 入力 ±T を出力 ±half に伸縮（線形補間）
+                const double step = (double)halfIn / (double)half;
+                for (int j = 0; j < length; ++j)
+                {
+                    const double pos = (double)(centre - halfIn) + j * step;
+                    const auto i0 = (juce::int64)std::floor(pos);
+                    const float frac = (float)(pos - (double)i0);
+                    const float a = in[(size_t)(i0 & ringMask)];
+                    const float b = in[(size_t)((i0 + 1) & ringMask)];
+                    grainSource[(size_t)j] = a + frac * (b - a);
+                }
+            }
+
+            juce::FloatVectorOperations::multiply(grainSource.data(), grainWindow.data(), length);
+            addToRing(output.getWritePointer(ch), outStart, grainSource.data(), length);
+        }
+
+        addToRing(weight.data(), outStart, grainWindow.data(), length);
+    }
+
+    // ------------------------------------------------------- Phase vocoder
+    // 入力 [frameEnd - fftSize, frameEnd) を解析して、出力 [frameEnd - fftSize + latency, ...) に足す
+    void runFrame(juce::int64 frameEnd, int numChannels)
     {
-        std::fill(delayBuffer.begin(), delayBuffer.end(), 0.0f);
-        writePos = 0;
-        readPos1 = 0.0;
-        readPos2 = bufferSize / 2.0;
-        crossfadePos = 0.0;
+        const int numBins = fftSize / 2 + 1;
+        const float expected = juce::MathConstants<float>::twoPi * (float)hopSize / (float)fftSize;
+        const float binsPerRadian = (float)overlap / juce::MathConstants<float>::twoPi;
+        const auto outStart = frameEnd - fftSize + latency;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& state = pvChannels[(size_t)ch];
+
+            // --- 解析 ---
+            std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+            readRing(input.getReadPointer(ch), frameEnd - fftSize, fftBuffer.data(), fftSize);
+            juce::FloatVectorOperations::multiply(fftBuffer.data(), pvWindow.data(), fftSize);
+            fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                const float re = fftBuffer[(size_t)(2 * k)];
+                const float im = fftBuffer[(size_t)(2 * k + 1)];
+                const float phase = std::atan2(im, re);
+
+                float delta = pvFresh ? 0.0f : phase - state.lastPhase[(size_t)k] - (float)k * expected;
+                delta -= juce::MathConstants<float>::twoPi * std::round(delta / juce::MathConstants<float>::twoPi);
+
+                state.lastPhase[(size_t)k] = phase;
+                analysisMagnitude[(size_t)k] = std::sqrt(re * re + im * im);
+                analysisFrequency[(size_t)k] = (float)k + delta * binsPerRadian;
+            }
+
+            if (preserveFormants)
+                estimateEnvelope(numBins);
+
+            // --- ピーク領域ごとにずらす（位相ロック） ---
+            // 入力のピーク p のまわり（隣のピークとの中間まで）を、形を保ったまま round(p * ratio) へ移す。
+            // 位相を積算するのはピークだけで、周りのビンはピークとの位相差を入力のまま保つ
+            // （全ビンを独立に積算したり、ローブを引き伸ばしたりすると打ち消し合って痩せる）
+            std::fill(synthesisMagnitude.begin(), synthesisMagnitude.end(), 0.0f);
+            const int numPeaks = findPeaks(numBins);
+
+            for (int i = 0; i < numPeaks; ++i)
+            {
+                const int p = peaks[(size_t)i];
+                const int lo = i > 0 ? (peaks[(size_t)i - 1] + p) / 2 + 1 : 0;
+                const int hi = i + 1 < numPeaks ? (p + peaks[(size_t)i + 1]) / 2 : numBins - 1;
+                const int q = juce::roundToInt((float)p * pitchRatio);
+                if (q >= numBins)
+                    break;
+
+                // ピークの位相: 前フレームでこのビンに書いた位相 + 真の周波数 × ratio ぶん進める
+                const float peakPhase = pvFresh ? state.lastPhase[(size_t)p]
+                                                : state.sumPhase[(size_t)q] + analysisFrequency[(size_t)p] * pitchRatio * expected;
+
+                for (int k = lo; k <= hi; ++k)
+                {
+                    const int j = k + q - p;
+                    if (j < 0 || j >= numBins)
+                        continue;
+
+                    float magnitude = analysisMagnitude[(size_t)k];
+                    if (preserveFormants)
+                        magnitude *= envelope[(size_t)j] / std::max(envelope[(size_t)k], 1.0e-9f);
+
+                    synthesisMagnitude[(size_t)j] = magnitude;
+                    synthesisPhase[(size_t)j] = peakPhase + state.lastPhase[(size_t)k] - state.lastPhase[(size_t)p];
+                }
+            }
+
+            // --- 合成 ---
+            for (int j = 0; j < numBins; ++j)
+            {
+                auto& phase = state.sumPhase[(size_t)j];
+                phase = synthesisPhase[(size_t)j] - juce::MathConstants<float>::twoPi * std::round(synthesisPhase[(size_t)j] / juce::MathConstants<float>::twoPi);
+
+                fftBuffer[(size_t)(2 * j)]     = synthesisMagnitude[(size_t)j] * std::cos(phase);
+                fftBuffer[(size_t)(2 * j + 1)] = synthesisMagnitude[(size_t)j] * std::sin(phase);
+            }
+
+            fft->performRealOnlyInverseTransform(fftBuffer.data());
+            juce::FloatVectorOperations::multiply(fftBuffer.data(), inverseScale, fftSize);
+            juce::FloatVectorOperations::multiply(fftBuffer.data(), pvWindow.data(), fftSize);
+            addToRing(output.getWritePointer(ch), outStart, fftBuffer.data(), fftSize);
+        }
+
+        // 解析窓 × 合成窓なので重みは窓の二乗
+        addToRing(weight.data(), outStart, pvWindowSquared.data(), fftSize);
     }
 
-private:
-    float readInterpolated(double pos)
+    // analysisMagnitude の極大（±2 ビン）を peaks に並べて、その数を返す
+    int findPeaks(int numBins)
     {
-        int idx0 = static_cast<int>(pos) % bufferSize;
-        int idx1 = (idx0 + 1) % bufferSize;
-        double frac = pos - std::floor(pos);
-        return static_cast<float>(delayBuffer[idx0] * (1.0 - frac) + delayBuffer[idx1] * frac);
+        int count = 0;
+        for (int k = 0; k < numBins; ++k)
+        {
+            const float m = analysisMagnitude[(size_t)k];
+            if (m <= 1.0e-9f)
+                continue;
+
+            bool isPeak = true;
+            for (int d = -2; d <= 2 && isPeak; ++d)
+            {
+                const int n = k + d;
+                if (d != 0 && n >= 0 && n < numBins)
+                    isPeak = d < 0 ? analysisMagnitude[(size_t)n] < m : analysisMagnitude[(size_t)n] <= m;
+            }
+
+            if (isPeak)
+                peaks[(size_t)count++] = k;
+        }
+        return count;
     }
 
+    // 振幅の移動平均（±envelopeRadius ビン）をスペクトル包絡とみなす
+    void estimateEnvelope(int numBins)
+    {
+        const int radius = std::max(2, fftSize / 128);
+        double sum = 0.0;
+        int count = 0;
+
+        for (int k = 0; k < std::min(radius, numBins); ++k)
+        {
+            sum += analysisMagnitude[(size_t)k];
+            ++count;
+        }
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            if (k + radius < numBins) { sum += analysisMagnitude[(size_t)(k + radius)]; ++count; }
+            if (k - radius - 1 >= 0)  { sum -= analysisMagnitude[(size_t)(k - radius - 1)]; --count; }
+            envelope[(size_t)k] = (float)(sum / std::max(1, count));
+        }
+    }
+
+    // ------------------------------------------------------------- リング
+    void writeRing(float* ring, juce::int64 start, const float* src, int n)
+    {
+        const int idx = (int)(start & ringMask);
+        const int first = std::min(n, ringMask + 1 - idx);
+        juce::FloatVectorOperations::copy(ring + idx, src, first);
+        juce::FloatVectorOperations::copy(ring, src + first, n - first);
+    }
+
+    void readRing(const float* ring, juce::int64 start, float* dest, int n) const
+    {
+        const int idx = (int)(start & ringMask);
+        const int first = std::min(n, ringMask + 1 - idx);
+        juce::FloatVectorOperations::copy(dest, ring + idx, first);
+        juce::FloatVectorOperations::copy(dest + first, ring, n - first);
+    }
+
+    void addToRing(float* ring, juce::int64 start, const float* src, int n)
+    {
+        const int idx = (int)(start & ringMask);
+        const int first = std::min(n, ringMask + 1 - idx);
+        juce::FloatVectorOperations::add(ring + idx, src, first);
+        juce::FloatVectorOperations::add(ring, src + first, n - first);
+    }
+
+    // ===== 設定 =====
     double sr = 44100.0;
-    int bufferSize = 2048;
-    std::vector<float> delayBuffer;
-    int writePos = 0;
-    double readPos1 = 0.0, readPos2 = 0.0;
-    double crossfadePos = 0.0;
+    int maxBlock = 512;
+    int maxPeriod = 630;
+    int minPeriod = 22;
+    int fftOrder = 10;
+    int fftSize = 1024;
+    int hopSize = 256;
+    int latency = 0;
+    int ringMask = 0;
+    float inverseScale = 1.0f;
+
+    Mode mode = Mode::automatic;
+    bool preserveFormants = true;
     float pitchRatio = 1.0f;
+    float period = 0.0f;
+
+    // ===== 状態 =====
+    juce::int64 inputCount = 0;      // これまでに受け取ったサンプル数（入力の時刻）
+    double nextSynthesisMark = 0.0;  // 次のグレインの中心（出力の時刻）
+    double analysisMark = 0.0;       // 直近の解析マーク（入力の時刻）
+    juce::int64 nextFrameTime = 0;   // 次のフレームの終端（入力の時刻）
+    juce::int64 lastFrameCentre = -1;
+    bool psolaActive = false;
+    bool pvFresh = true;             // 位相の積算をやり直す（フェーズボコーダ再開時）
+
+    // ===== バッファ（prepare で確保） =====
+    std::unique_ptr<juce::dsp::FFT> fft;
+    juce::AudioBuffer<float> input, output; // 入力の履歴 / 出力の重ね合わせ（どちらもリング）
+    std::vector<float> weight;
+    std::vector<float> pvWindow, pvWindowSquared;
+    std::array<float, windowTableSize + 1> windowTable {};
+    std::vector<float> fftBuffer;
+    std::array<PhaseState, 2> pvChannels;
+    std::vector<float> analysisMagnitude, analysisFrequency, synthesisMagnitude, synthesisPhase, envelope;
+    std::vector<int> peaks;
+    std::vector<float> grainWindow, grainSource;
 };
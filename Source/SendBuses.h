@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    SendBuses.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    全トラック共有の Send / Return バス（Reverb / Delay、オーディオスレッド専用）
+    - トラックは FX 後の音を、センド量だけバスの入力に足す（addSends、スロット順に直列で呼ぶ）
+    - バスの FX はブロックに1回だけ、wet だけを作り、リターン量をかけて出力に足す
+      8トラックに同じ空間をかけても、Reverb / Delay の計算とメモリは1つ分
+    - センド量・リターン量の変化は rampSeconds かけて直線で追いかける（ブロック内は addFromWithRamp）
+    - センドが止まってもバスの残響が消えるまでは回し続け、消えたら止める
+    - トラックのインサート（FXChain の Reverb / Delay）とは別物で、両方使ってよい
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "BlockDelay.h"
+#include <array>
+
+class SendBuses
+{
+public:
+	enum Bus
+	{
+		reverbBus = 0,
+		delayBus,
+		numBuses
+	};
+
+	static constexpr int maxSlots = 64;
+	static constexpr double rampSeconds = 0.02;
+
+	// 共有 Delay の設定（時間は同期しないときだけ使う）
+	struct DelaySettings
+	{
+		float timeSeconds = 0.375f;
+		float feedback = 0.35f;
+		bool sync = false;
+		int division = 1;       // BlockDelay::getDivisionFraction のインデックス（1 = 1/4）
+	};
+
+	// メッセージスレッドで呼ぶ（確保する）
+	void prepare(double newSampleRate, int maxBlockSize)
+	{
+		sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+		maxRampStep = (float)(1.0 / (rampSeconds * sampleRate));
+
+		inputs.setSize(numBuses * 2, juce::jmax(1, maxBlockSize));
+		reverb.prepare({ sampleRate, (juce::uint32)juce::jmax(1, maxBlockSize), 2 });
+		applyReverbParameters();
+		delay.prepare(sampleRate, maxBlockSize, 2.0);
+		reset();
+	}
+
+	// バスの状態を消す（センド量・設定は残す）
+	void reset() noexcept
+	{
+		reverb.reset();
+		delay.reset();
+		inputs.clear();
+		ringing = {};
+		for (auto& s : currentSend)
+			s = {};
+		currentReturn = targetReturn;
+	}
+
+	//==============================================================================
+	// 設定（applyCommand から、オーディオスレッド）
+	void setSendLevel(int slot, Bus bus, float level) noexcept
+	{
+		if (juce::isPositiveAndBelow(slot, maxSlots))
+			targetSend[(size_t)slot][(size_t)bus] = juce::jlimit(0.0f, 1.0f, level);
+	}
+
+	float getSendLevel(int slot, Bus bus) const noexcept
+	{
+		return juce::isPositiveAndBelow(slot, maxSlots) ? targetSend[(size_t)slot][(size_t)bus] : 0.0f;
+	}
+
+	void setReturnLevel(Bus bus, float level) noexcept { targetReturn[(size_t)bus] = juce::jlimit(0.0f, 1.0f, level); }
+
+	void setReverbRoomSize(float size) noexcept    { reverbRoomSize = size; applyReverbParameters(); }
+	void setReverbDamping(float damping) noexcept  { reverbDamping = damping; applyReverbParameters(); }
+
+	DelaySettings& getDelaySettings() noexcept { return delaySettings; }
+	float getMaxDelaySamples() const noexcept { return delay.getMaxDelaySamples(); }
+
+	// トラックを消したとき: センドを 0 にし、途中のランプも捨てる
+	void clearSlot(int slot) noexcept
+	{
+		if (juce::isPositiveAndBelow(slot, maxSlots))
+			targetSend[(size_t)slot] = currentSend[(size_t)slot] = {};
+	}
+
+	//==============================================================================
+	// ブロック処理（オーディオスレッド）
+
+	// ブロックの最初に呼ぶ
+	void beginBlock(int numSamples) noexcept
+	{
+		inputs.setSize(numBuses * 2, numSamples, false, false, true);
+		inputs.clear();
+		senders = {};
+	}
+
+	// スロット順に呼ぶ（合算の順番が決まるので、並列レンダリングでも結果は同じ）
+	void addSends(int slot, const juce::AudioBuffer<float>& track, int numSamples) noexcept
+	{
+		if (!juce::isPositiveAndBelow(slot, maxSlots))
+			return;
+
+		for (int bus = 0; bus < numBuses; ++bus)
+		{
+			float& current = currentSend[(size_t)slot][(size_t)bus];
+			const float target = targetSend[(size_t)slot][(size_t)bus];
+			if (current == 0.0f && target == 0.0f)
+				continue;
+
+			const float end = approach(current, target, numSamples);
+			for (int ch = 0; ch < 2; ++ch)
+				inputs.addFromWithRamp(bus * 2 + ch, 0, track.getReadPointer(ch % track.getNumChannels()),
+				                       numSamples, current, end);
+			current = end;
+			senders[(size_t)bus] |= juce::uint64 { 1 } << slot;
+		}
+	}
+
+	// このブロックでバスに送ったスロット（ビットマスク）。負荷の按分用
+	juce::uint64 getSenders(Bus bus) const noexcept { return senders[(size_t)bus]; }
+
+	// バスの FX を回してリターンを output に足す。センドも残響もなければ何もせず false
+	// delaySamples は Delay バスのときだけ使う（同期の計算は呼び出し側）
+	bool processReturn(Bus bus, juce::AudioBuffer<float>& output, int numSamples, float delaySamples = 0.0f) noexcept
+	{
+		const auto b = (size_t)bus;
+		if (senders[b] == 0 && !ringing[b])
+			return false;
+
+		float* channels[] = { inputs.getWritePointer(bus * 2), inputs.getWritePointer(bus * 2 + 1) };
+		juce::AudioBuffer<float> wet(channels, 2, numSamples);
+
+		if (bus == reverbBus)
+		{
+			juce::dsp::AudioBlock<float> block(wet);
+			juce::dsp::ProcessContextReplacing<float> context(block);
+			reverb.process(context);
+		}
+		else
+		{
+			BlockDelay::Params params;
+			params.delaySamples = delaySamples;
+			params.feedback = delaySettings.feedback;
+			params.mix = 1.0f;
+			delay.process(wet, numSamples, params);
+		}
+
+		// 入力がなく、出力も聞こえなくなったら次のブロックから止める
+		const float magnitude = juce::jmax(wet.getMagnitude(0, 0, numSamples), wet.getMagnitude(1, 0, numSamples));
+		ringing[b] = senders[b] != 0 || magnitude > silenceThreshold;
+
+		const float end = approach(currentReturn[b], targetReturn[b], numSamples);
+		for (int ch = 0; ch < output.getNumChannels(); ++ch)
+			output.addFromWithRamp(ch, 0, wet.getReadPointer(ch % 2), numSamples, currentReturn[b], end);
+		currentReturn[b] = end;
+		return true;
+	}
+
+private:
+	static constexpr float silenceThreshold = 1.0e-5f;   // 約 -100dB
+
+	// current から target へ、numSamples 分だけ近づけた値
+	float approach(float current, float target, int numSamples) const noexcept
+	{
+		const float step = maxRampStep * (float)numSamples;
+		return target > current ? juce::jmin(target, current + step) : juce::jmax(target, current - step);
+	}
+
+	void applyReverbParameters() noexcept
+	{
+		juce::dsp::Reverb::Parameters params;
+		params.roomSize = reverbRoomSize;
+		params.damping = reverbDamping;
+		params.wetLevel = 1.0f;   // バスは wet だけ（dry は各トラックがそのまま出力に足している）
+		params.dryLevel = 0.0f;
+		reverb.setParameters(params);
+	}
+
+	double sampleRate = 44100.0;
+	float maxRampStep = 0.0f;
+
+	juce::AudioBuffer<float> inputs;  // [バス * 2 + ch]
+	std::array<juce::uint64, numBuses> senders {};
+	std::array<bool, numBuses> ringing {};
+
+	std::array<std::array<float, numBuses>, maxSlots> targetSend {};
+	std::array<std::array<float, numBuses>, maxSlots> currentSend {};
+	std::array<float, numBuses> targetReturn { 1.0f, 1.0f };
+	std::array<float, numBuses> currentReturn { 1.0f, 1.0f };
+
+	juce::dsp::Reverb reverb;
+	float reverbRoomSize = 0.7f;
+	float reverbDamping = 0.5f;
+
+	BlockDelay delay;
+	DelaySettings delaySettings;
+};
@@ -58,6 +58,21 @@ public:
                 inputManager.getChannelManager().getSettings(rightIndex).isStereoLinked = linked;
         };
         addAndMakeVisible(linkBtn);
+        
+        // Trigger Band (both channels): Full = 全帯域、それ以外はその帯域の包絡だけで検出
+        bandBox.addItem(BandEnvelopeBank::getBandName(-1), 1);
+        for (int b = 0; b < BandEnvelopeBank::numBands; ++b)
+            bandBox.addItem(BandEnvelopeBank::getBandName(b) + juce::String(" (")
+                            + juce::String((int)BandEnvelopeBank::getBandCentreHz(b)) + "Hz)", b + 2);
+        bandBox.setSelectedId(leftSettings.isBandTrigger() ? leftSettings.triggerBand + 2 : 1, juce::dontSendNotification);
+        bandBox.setTooltip("Trigger band: fire only on energy in this band (uses the calibrated band noise floor)");
+        bandBox.onChange = [this]() {
+            const int band = bandBox.getSelectedId() - 2;
+            inputManager.getChannelManager().getSettings(leftIndex).triggerBand = band;
+            if (rightIndex < inputManager.getNumChannels())
+                inputManager.getChannelManager().getSettings(rightIndex).triggerBand = band;
+        };
+        addAndMakeVisible(bandBox);
     }
     
     void setNames(const juce::String& lName, const juce::String& rName)
@@ -109,16 +124,27 @@ public:
         float level = inputManager.getChannelLevel(chIndex);
         int levelHeight = (int)(meterArea.getHeight() * juce::jlimit(0.0f, 1.0f, level));
         
+        const float threshold = inputManager.getChannelThreshold(chIndex);
         if (levelHeight > 0)
         {
-            auto& settings = inputManager.getChannelManager().getSettings(chIndex);
-            bool isTriggering = level > settings.getEffectiveThreshold();
+            bool isTriggering = threshold > 0.0f && level > threshold;
             
             g.setColour(isTriggering ? ThemeColours::RecordingRed : ThemeColours::NeonCyan);
             g.fillRect(meterArea.getX(), meterArea.getBottom() - levelHeight, 
                        meterArea.getWidth(), levelHeight);
         }
         
+        // 追従中のノイズフロア（グレー）と、いまの閾値（白）
+        auto drawMarker = [&](float value, juce::Colour colour)
+        {
+            if (value <= 0.0f) return;
+            const int markerY = meterArea.getBottom() - (int)(meterArea.getHeight() * juce::jlimit(0.0f, 1.0f, value));
+            g.setColour(colour);
+            g.drawHorizontalLine(markerY, (float)meterArea.getX(), (float)meterArea.getRight());
+        };
+        drawMarker(inputManager.getChannelNoiseFloor(chIndex), juce::Colours::grey);
+        drawMarker(threshold, juce::Colours::white.withAlpha(0.8f));
+        
         g.setColour(juce::Colours::white.withAlpha(0.15f));
         g.drawRect(meterArea, 1);
     }
@@ -135,8 +161,9 @@ public:
         if (hasRightChannel)
             rightActiveBtn.setBounds(halfWidth + 2, btnY, halfWidth - 6, btnHeight);
         
-        // Link button (2ch width)
-        linkBtn.setBounds(4, linkY, getWidth() - 8, btnHeight);
+        // Link button / Band selector (1ch width each)
+        linkBtn.setBounds(4, linkY, halfWidth - 6, btnHeight);
+        bandBox.setBounds(halfWidth + 2, linkY, halfWidth - 6, btnHeight);
     }
 
 private:
@@ -148,6 +175,7 @@ private:
     juce::TextButton leftActiveBtn;
     juce::TextButton rightActiveBtn;
     juce::TextButton linkBtn;
+    juce::ComboBox bandBox;
 };
 
 // =====================================================
@@ -269,6 +297,26 @@ public:
         };
         addAndMakeVisible(useCalibrationButton);
         
+        adaptiveFloorButton.setButtonText("Adaptive Noise Floor");
+        adaptiveFloorButton.setClickingTogglesState(true);
+        adaptiveFloorButton.setToggleState(im.isAdaptiveFloorEnabled(), juce::dontSendNotification);
+        adaptiveFloorButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::PlayingGreen);
+        adaptiveFloorButton.setTooltip("Keep measuring each channel's noise floor between notes (the calibration value is used while it is off)");
+        adaptiveFloorButton.onClick = [this]() {
+            inputManager.setAdaptiveFloorEnabled(adaptiveFloorButton.getToggleState());
+        };
+        addAndMakeVisible(adaptiveFloorButton);
+        
+        perInputRoutingButton.setButtonText("Per-Input Triggers");
+        perInputRoutingButton.setClickingTogglesState(true);
+        perInputRoutingButton.setToggleState(im.isPerInputRouting(), juce::dontSendNotification);
+        perInputRoutingButton.setColour(juce::TextButton::buttonOnColourId, ThemeColours::PlayingGreen);
+        perInputRoutingButton.setTooltip("Each input pair triggers its own tracks, so several players can record at once (choose a track's input on the track)");
+        perInputRoutingButton.onClick = [this]() {
+            inputManager.setPerInputRouting(perInputRoutingButton.getToggleState());
+        };
+        addAndMakeVisible(perInputRoutingButton);
+        
         calibrateButton.setButtonText("Run Calibration (2s)");
         calibrateButton.onClick = [this]() {
             if (!inputManager.isCalibrating()) inputManager.startCalibration();
@@ -347,8 +395,11 @@ public:
         globalControlsHeader.setBounds(area.removeFromTop(30));
         
         auto row1 = area.removeFromTop(35);
-        useCalibrationButton.setBounds(row1.removeFromLeft(180).reduced(3));
-        calibrateButton.setBounds(row1.removeFromLeft(180).reduced(3));
+        const int buttonWidth = juce::jmin(180, row1.getWidth() / 4);
+        useCalibrationButton.setBounds(row1.removeFromLeft(buttonWidth).reduced(3));
+        adaptiveFloorButton.setBounds(row1.removeFromLeft(buttonWidth).reduced(3));
+        calibrateButton.setBounds(row1.removeFromLeft(buttonWidth).reduced(3));
+        perInputRoutingButton.setBounds(row1.removeFromLeft(buttonWidth).reduced(3));
         
         auto row2 = area.removeFromTop(35);
         row2.removeFromLeft(90);
@@ -405,6 +456,8 @@ public:
 private:
     juce::Label globalControlsHeader;
     juce::TextButton useCalibrationButton;
+    juce::TextButton adaptiveFloorButton;
+    juce::TextButton perInputRoutingButton;
     juce::TextButton calibrateButton;
     juce::Slider thresholdSlider;
     juce::Label threshLabel;
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    InputTestRig.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    InputManager のテスト（TestBandTrigger / TestNoiseFloor / TestInputRouting）で共通の土台
+    - 48kHz。ブロックサイズとチャンネル数はテストごとに渡す
+    - run: ブロックを作って analyze に流し、ルートごとのトリガーを集める
+      信号の中身はテストがラムダで書く（fill(block, ブロック先頭の絶対位置, run の先頭からのサンプル数)）
+    - rearm: 無音を流して、プリロールが解けてトリガーが戻るまで待つ
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../InputManager.h"
+
+struct InputTestRig
+{
+	static constexpr double sampleRate = 48000.0;
+	static constexpr int maxRoutes = InputManager::maxRoutes;
+
+	// run の間に出たトリガー
+	struct Triggers
+	{
+		std::array<juce::int64, maxRoutes> first {}; // ルートごとの最初のトリガー位置（-1 = なし）
+		std::array<int, maxRoutes> firstChannel {};  // そのときの検出チャンネル
+		std::array<std::vector<juce::int64>, maxRoutes> onsets; // 発火した（オフ → オン）ブロックのトリガー位置
+
+		Triggers()
+		{
+			first.fill(-1);
+			firstChannel.fill(-1);
+		}
+	};
+
+	InputTestRig(int blockSizeToUse, int numChannelsToUse, juce::int64 startClock = 0)
+		: blockSize(blockSizeToUse), numChannels(numChannelsToUse), clock(startClock), block(numChannelsToUse, blockSizeToUse)
+	{
+		manager.prepare(sampleRate, blockSize);
+		manager.setNumChannels(numChannels);
+	}
+
+	// numSamples 分を blockSize ずつ流す。clock は流した分だけ進む
+	template <typename Fill>
+	Triggers run(int numSamples, Fill&& fill)
+	{
+		Triggers triggers;
+		for (int done = 0; done < numSamples; done += blockSize)
+		{
+			std::array<bool, maxRoutes> wasTriggered {};
+			for (int route = 0; route < maxRoutes; ++route)
+				wasTriggered[(size_t)route] = manager.getRouteTriggerEvent(route).isTriggerd();
+
+			block.clear();
+			fill(block, clock, done);
+			manager.analyze(block, clock);
+			clock += blockSize;
+
+			for (int route = 0; route < maxRoutes; ++route)
+			{
+				const auto& event = manager.getRouteTriggerEvent(route);
+				if (!event.isTriggerd())
+					continue;
+
+				if (triggers.first[(size_t)route] < 0)
+				{
+					triggers.first[(size_t)route] = event.absIndex;
+					triggers.firstChannel[(size_t)route] = event.channel;
+				}
+				if (!wasTriggered[(size_t)route])
+					triggers.onsets[(size_t)route].push_back(event.absIndex);
+			}
+		}
+		return triggers;
+	}
+
+	// 無音を seconds 秒流す（鳴らしたあと、プリロールが解けてトリガーが戻るまで）
+	void rearm(double seconds = 0.8)
+	{
+		run((int)(sampleRate * seconds), [] (juce::AudioBuffer<float>&, juce::int64, int) {});
+	}
+
+	const int blockSize;
+	const int numChannels;
+	InputManager manager;
+	juce::int64 clock;
+	juce::AudioBuffer<float> block;
+};
@@ -0,0 +1,242 @@
+#include <iostream>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../LooperAudio.h"
+#include "../AllocationTripwire.h"
+
+// processBlock がヒープ確保をしないことの確認
+// SAROS_ALLOCATION_TRIPWIRE=1 でビルドすると、オーディオスレッド区間での確保で abort する。
+// Debug 構成でも通ること（オーディオスレッドの経路に DBG を置くと、文字列の確保でここが落ちる）
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 256;
+
+	void runBlocks(LooperAudio& looper, juce::AudioBuffer<float>& output,
+				   const juce::AudioBuffer<float>& input, int numBlocks)
+	{
+		for (int i = 0; i < numBlocks; ++i)
+			looper.processBlock(output, input);
+	}
+
+	bool runScenario(int renderThreads)
+	{
+		std::cout << "  render threads: " << renderThreads << std::endl;
+
+		LooperAudio looper(sampleRate, (int)(sampleRate * 4.0));
+		looper.setRenderThreadCount(renderThreads);
+		looper.prepareToPlay(blockSize, sampleRate);
+		for (int id = 1; id <= 4; ++id)
+			looper.addTrack(id);
+
+		juce::AudioBuffer<float> input(2, blockSize);
+		juce::AudioBuffer<float> output(2, blockSize);
+		for (int ch = 0; ch < 2; ++ch)
+			for (int i = 0; i < blockSize; ++i)
+				input.setSample(ch, i, (i % 64) < 32 ? 0.25f : -0.25f);
+
+		// 1. マスター録音 → 停止（マスター長が決まる）
+		looper.startRecording(1);
+		runBlocks(looper, output, input, 100);
+		looper.stopRecording(1);
+		looper.startPlaying(1);
+		runBlocks(looper, output, input, 4);
+
+		// 2. x2 と /2 のスレーブを録音（バッファ長の付け替えとアラインメント）
+		looper.setTrackLoopMultiplier(2, 2.0f);
+		looper.setTrackLoopMultiplier(3, 0.5f);
+		looper.startRecording(2);
+		looper.startRecording(3);
+		runBlocks(looper, output, input, 250);
+		looper.stopRecording(2);
+		looper.stopRecording(3);
+
+		// 3. 録音中に倍率を変えてから止める（停止時に長さが伸びるケース）
+		looper.setTrackLoopMultiplier(4, 0.5f);
+		looper.startRecording(4);
+		runBlocks(looper, output, input, 10);
+		looper.setTrackLoopMultiplier(4, 1.0f);
+		looper.stopRecording(4);
+		runBlocks(looper, output, input, 4);
+
+		// 4. 重い FX を全部オン
+		for (int id = 1; id <= 4; ++id)
+		{
+			looper.setTrackGranularEnabled(id, true);
+			looper.setTrackGranularDensity(id, 1.0f);
+			looper.setTrackAutotuneEnabled(id, true);
+			looper.setTrackBeatRepeatActive(id, true);
+			looper.setTrackFilterEnabled(id, true);
+			looper.setTrackDelayEnabled(id, true);
+			looper.setTrackReverbEnabled(id, true);
+			looper.setTrackTremoloEnabled(id, true);
+			looper.setTrackSlicerEnabled(id, true);
+			looper.setTrackBitcrusherEnabled(id, true);
+			looper.setTrackFlangerEnabled(id, true);
+			looper.setTrackChorusEnabled(id, true);
+		}
+		looper.setMonitorTrackId(1);
+		runBlocks(looper, output, input, 200);
+
+		// 5. Undo / 全消去 / テスト波形
+		looper.startRecording(2);
+		runBlocks(looper, output, input, 10);
+		looper.stopRecording(2);
+		looper.undoLastRecording();
+		runBlocks(looper, output, input, 4);
+		looper.allClear();
+		runBlocks(looper, output, input, 1);
+
+		// 全消去でページが全部プールに戻っていること
+		if (looper.getLoopMemoryFreeSamples() != looper.getLoopMemoryTotalSamples())
+		{
+			std::cout << "Test Failed: loop pages still claimed after allClear" << std::endl;
+			return false;
+		}
+
+		looper.generateTestWaveformsForVisualTest();
+		runBlocks(looper, output, input, 50);
+		looper.stopAllTracks();
+		runBlocks(looper, output, input, 4);
+
+		looper.dispatchPendingNotifications();
+		return true;
+	}
+
+	// 多段 UNDO / REDO: 履歴はページ表の共有だけで、入れ替えもオーディオスレッドで確保しない
+	bool runUndoRedo()
+	{
+		std::cout << "  multi-level undo / redo" << std::endl;
+
+		LooperAudio looper(sampleRate, (int)(sampleRate * 4.0));
+		looper.prepareToPlay(blockSize, sampleRate);
+		for (int id = 1; id <= 2; ++id)
+			looper.addTrack(id);
+
+		juce::AudioBuffer<float> input(2, blockSize);
+		juce::AudioBuffer<float> output(2, blockSize);
+		input.clear();
+
+		looper.startRecording(1);
+		runBlocks(looper, output, input, 100);
+		looper.stopRecording(1);
+		looper.startPlaying(1);
+		runBlocks(looper, output, input, 4);
+
+		// トラック2に長さの違う録音を3回重ねる
+		int lengths[4] = { looper.getTrackRecordLength(2), 0, 0, 0 };
+		for (int take = 1; take <= 3; ++take)
+		{
+			looper.startRecording(2);
+			runBlocks(looper, output, input, 10 * take);
+			looper.stopRecording(2);
+			runBlocks(looper, output, input, 2);
+			lengths[take] = looper.getTrackRecordLength(2);
+		}
+
+		auto expect = [&](int expected, const char* what)
+		{
+			if (looper.getTrackRecordLength(2) == expected)
+				return true;
+			std::cout << "Test Failed: " << what << " (recordLength " << looper.getTrackRecordLength(2)
+					  << ", expected " << expected << ")" << std::endl;
+			return false;
+		};
+
+		// 3段戻して、2段やり直す
+		for (int i = 0; i < 3; ++i)
+		{
+			looper.undoLastRecording();
+			runBlocks(looper, output, input, 1);
+		}
+		if (!expect(lengths[0], "undo x3")) return false;
+
+		looper.redoLastRecording();
+		looper.redoLastRecording();
+		runBlocks(looper, output, input, 1);
+		if (!expect(lengths[2], "redo x2") || !looper.canRedo()) return false;
+
+		// 新しく録音すると REDO 側は捨てられる
+		looper.startRecording(2);
+		runBlocks(looper, output, input, 5);
+		looper.stopRecording(2);
+		runBlocks(looper, output, input, 1);
+		if (looper.canRedo())
+		{
+			std::cout << "Test Failed: redo history survived a new recording" << std::endl;
+			return false;
+		}
+
+		// 予算0にすると、次の録音で古い履歴は全部捨てられる
+		looper.setUndoMemoryBudget(0);
+		looper.startRecording(2);
+		runBlocks(looper, output, input, 5);
+		looper.stopRecording(2);
+		runBlocks(looper, output, input, 1);
+		if (looper.getUndoMemoryUsage() != 0)
+		{
+			std::cout << "Test Failed: undo history exceeds its memory budget" << std::endl;
+			return false;
+		}
+
+		looper.allClear();
+		runBlocks(looper, output, input, 1);
+		looper.dispatchPendingNotifications();
+		return looper.getLoopMemoryFreeSamples() == looper.getLoopMemoryTotalSamples();
+	}
+
+	// ループ用メモリが尽きたとき: x2 は等倍に落ち、それも無理なら無音で録音が進む（落ちない・確保しない）
+	bool runExhaustedPool()
+	{
+		std::cout << "  exhausted loop memory" << std::endl;
+
+		LooperAudio looper(sampleRate, (int)sampleRate); // 1秒だけ
+		looper.prepareToPlay(blockSize, sampleRate);
+		for (int id = 1; id <= 3; ++id)
+			looper.addTrack(id);
+
+		juce::AudioBuffer<float> input(2, blockSize);
+		juce::AudioBuffer<float> output(2, blockSize);
+		input.clear();
+
+		looper.startRecording(1);
+		runBlocks(looper, output, input, 150);  // 0.8秒
+		looper.stopRecording(1);
+		looper.startPlaying(1);
+
+		looper.setTrackLoopMultiplier(2, 2.0f);
+		looper.startRecording(2);
+		looper.startRecording(3);
+		runBlocks(looper, output, input, 400);
+		looper.stopRecording(2);
+		looper.stopRecording(3);
+		runBlocks(looper, output, input, 10);
+
+		return looper.getLoopMemoryFreeSamples() >= 0;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestAllocationFree..." << std::endl;
+
+   #if ! SAROS_ALLOCATION_TRIPWIRE
+	std::cout << "(built without SAROS_ALLOCATION_TRIPWIRE: allocations are not checked)" << std::endl;
+   #endif
+
+	if (!runScenario(0))
+		return 1;
+
+	// 並列レンダリング（ワーカースレッド上のジョブにも同じ罠がかかる）
+	if (!runScenario(3))
+		return 1;
+
+	if (!runUndoRedo())
+		return 1;
+
+	if (!runExhaustedPool())
+		return 1;
+
+	std::cout << "Test Passed: no allocations inside processBlock." << std::endl;
+	return 0;
+}
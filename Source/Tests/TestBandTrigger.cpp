@@ -0,0 +1,154 @@
+#include <iostream>
+#include <cmath>
+#include "InputTestRig.h"
+
+// 帯域トリガー（BandEnvelopeBank + InputManager）
+// - キャリブレーションで帯域ごとのノイズフロアが入る
+// - Hi-Mid の帯域にしたチャンネルは、大きな 60Hz（キックのかぶり）では発火せず、1.6kHz の音で発火する
+//   同じ 60Hz は全帯域なら発火する（かぶりを拾っていた状況の再現）
+// - ステレオリンクの R の音は L のレーンで検出する
+// - 16ch 全部を帯域トリガーにしても 32 サンプルのブロックで軽いか（時間は表示だけ）
+
+namespace
+{
+	constexpr double sampleRate = InputTestRig::sampleRate;
+	constexpr int blockSize = 32;
+	constexpr int numChannels = MAX_CHANNELS;
+
+	struct Tone
+	{
+		int channel = -1;
+		double frequency = 0.0;
+		float amplitude = 0.0f;
+	};
+
+	// 全チャンネルに小さなノイズ、tone.channel にだけ正弦波。最初のトリガーの位置を返す（-1 = なし）
+	juce::int64 run(InputTestRig& rig, int numSamples, Tone tone, juce::Random& random, int* triggerChannel = nullptr)
+	{
+		const auto triggers = rig.run(numSamples, [&] (juce::AudioBuffer<float>& block, juce::int64, int done)
+		{
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				for (int i = 0; i < blockSize; ++i)
+				{
+					float x = (random.nextFloat() * 2.0f - 1.0f) * 0.002f;
+					if (ch == tone.channel)
+						x += tone.amplitude * (float)std::sin(juce::MathConstants<double>::twoPi * tone.frequency
+						                                      * (double)(done + i) / sampleRate);
+					block.setSample(ch, i, x);
+				}
+			}
+		});
+
+		if (triggerChannel != nullptr && triggers.first[0] >= 0)
+			*triggerChannel = triggers.firstChannel[0];
+		return triggers.first[0];
+	}
+
+	// 鳴らしたあと、ノイズだけでプリロールが解けてトリガーが戻るまで流す
+	void rearm(InputTestRig& rig, juce::Random& random)
+	{
+		run(rig, (int)(sampleRate * 0.8), {}, random);
+	}
+
+	void setBand(InputManager& manager, int band)
+	{
+		for (int ch = 0; ch < numChannels; ++ch)
+			manager.getChannelManager().getSettings(ch).triggerBand = band;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestBandTrigger..." << std::endl;
+	bool passed = true;
+	juce::Random random(7);
+	InputTestRig rig (blockSize, numChannels, 500000);
+	auto& manager = rig.manager;
+	manager.getChannelManager().setGlobalThreshold(0.1f);
+	for (int ch = 0; ch < numChannels; ++ch)
+		manager.getChannelManager().getSettings(ch).isActive = (ch == 4 || ch == 5);
+
+	// 1. キャリブレーション（2秒で自動で止まる）
+	manager.startCalibration();
+	run(rig, (int)(sampleRate * 2.1), {}, random);
+	manager.applyCalibrationResult(); // アプリではメッセージスレッドのタイマーが書く
+	const auto& settings = manager.getChannelManager().getSettings(4);
+	std::cout << "  calibrated: broadband " << settings.calibratedNoiseFloor << ", bands";
+	bool floorsSet = !manager.isCalibrating() && settings.calibratedNoiseFloor > 0.0f;
+	for (float f : settings.calibratedBandFloor)
+	{
+		std::cout << " " << f;
+		floorsSet = floorsSet && f > 0.0f && f < settings.calibratedNoiseFloor;
+	}
+	std::cout << std::endl;
+	passed = passed && floorsSet;
+
+	// 2. 全帯域: 60Hz のかぶりで発火する
+	int channel = -1;
+	const auto broadband = run(rig, 9600, { 4, 60.0, 0.5f }, random, &channel);
+	std::cout << "  broadband, 60Hz bleed: " << (broadband >= 0 ? "triggered" : "quiet") << std::endl;
+	passed = passed && broadband >= 0;
+	rearm(rig, random);
+
+	// 3. Hi-Mid: 同じ 60Hz では発火しない
+	setBand(manager, 2);
+	const auto bleed = run(rig, 9600, { 4, 60.0, 0.5f }, random);
+	std::cout << "  Hi-Mid band, 60Hz bleed: " << (bleed >= 0 ? "triggered" : "quiet") << std::endl;
+	passed = passed && bleed < 0;
+	rearm(rig, random);
+
+	// 4. Hi-Mid: 1.6kHz で発火する（包絡の遅れは数 ms 以内）
+	juce::int64 onset = rig.clock;
+	const auto inBand = run(rig, 9600, { 4, 1600.0, 0.3f }, random, &channel);
+	std::cout << "  Hi-Mid band, 1.6kHz: " << (inBand >= 0 ? "triggered" : "quiet") << " after "
+	          << (inBand - onset) << " samples on ch " << channel << std::endl;
+	passed = passed && inBand >= 0 && inBand - onset < (juce::int64)(sampleRate * 0.005) && channel == 4;
+	rearm(rig, random);
+
+	// 5. ステレオリンクの R（ch 5）の 1.6kHz は L のレーン（ch 4）で
+	onset = rig.clock;
+	const auto linked = run(rig, 9600, { 5, 1600.0, 0.3f }, random, &channel);
+	std::cout << "  Hi-Mid band, 1.6kHz on linked R: " << (linked >= 0 ? "triggered" : "quiet") << " on ch " << channel << std::endl;
+	passed = passed && linked >= 0 && channel == 4;
+	rearm(rig, random);
+
+	// 6. 負荷: 16ch 全部 Hi-Mid / 全帯域で 1 秒分
+	{
+		for (int ch = 0; ch < numChannels; ++ch)
+			manager.getChannelManager().getSettings(ch).isActive = true;
+		manager.setStereoLinked(false);
+
+		juce::AudioBuffer<float> block(numChannels, blockSize);
+		for (int ch = 0; ch < numChannels; ++ch)
+			for (int i = 0; i < blockSize; ++i)
+				block.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.002f);
+
+		auto secondsFor = [&](int band)
+		{
+			setBand(manager, band);
+			const int numBlocks = (int)(sampleRate / blockSize);
+			const auto start = juce::Time::getHighResolutionTicks();
+			for (int b = 0; b < numBlocks; ++b)
+			{
+				manager.analyze(block, rig.clock);
+				rig.clock += blockSize;
+			}
+			return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+		};
+
+		const double full = secondsFor(-1);
+		const double band = secondsFor(2);
+		std::cout << "  1s of 16ch audio in 32-sample blocks: broadband " << full * 1000.0 << " ms, band "
+		          << band * 1000.0 << " ms" << std::endl;
+	}
+
+	if (!passed)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: band triggers ignore out-of-band bleed." << std::endl;
+	return 0;
+}
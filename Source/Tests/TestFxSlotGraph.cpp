@@ -0,0 +1,110 @@
+#include <iostream>
+#include <vector>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "../TrackFxModules.h"
+
+// TrackFxGraph の処理順を見る
+// - スロットに並べた FX が先、残りの ON の FX は FxModuleType の順
+// - モジュールを作っていない / OFF の FX は並ばない（同じ FX を2つのスロットに置いても1回だけ）
+// - 遅延は並んだモジュールの合計
+// モジュールは処理した順に自分の番号を書き残すだけのダミー
+
+namespace
+{
+	class RecordingModule : public FxModule
+	{
+	public:
+		RecordingModule(FxModuleType typeToRecord, std::vector<FxModuleType>& logRef, int latencyToReport)
+			: type(typeToRecord), log(logRef), latency(latencyToReport)
+		{
+		}
+
+		void prepare(double, int) override {}
+		void process(juce::AudioBuffer<float>&, int, const FxContext&) noexcept override { log.push_back(type); }
+		void reset() noexcept override {}
+		int getLatencySamples() const noexcept override { return latency; }
+
+	private:
+		FxModuleType type;
+		std::vector<FxModuleType>& log;
+		int latency;
+	};
+
+	std::vector<FxModuleType> runGraph(const TrackFxGraph& graph, std::vector<FxModuleType>& log)
+	{
+		log.clear();
+		juce::AudioBuffer<float> buffer(2, 16);
+		FxContext context;
+		for (int i = 0; i < graph.getNumNodes(); ++i)
+			graph.getNode(i).module->process(buffer, 16, context);
+		return log;
+	}
+
+	bool expect(const char* name, const std::vector<FxModuleType>& actual, std::vector<FxModuleType> expected)
+	{
+		const bool ok = actual == expected;
+		std::cout << "  " << name << ": ";
+		for (auto type : actual)
+			std::cout << (int)type << " ";
+		std::cout << (ok ? "(ok)" : "(unexpected)") << std::endl;
+		return ok;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestFxSlotGraph..." << std::endl;
+
+	using T = FxModuleType;
+	std::vector<FxModuleType> log;
+	TrackFxParams params;
+	TrackFxGraph graph;
+
+	graph.install(T::filter, std::make_unique<RecordingModule>(T::filter, log, 0));
+	graph.install(T::compressor, std::make_unique<RecordingModule>(T::compressor, log, 64));
+	graph.install(T::delay, std::make_unique<RecordingModule>(T::delay, log, 0));
+	graph.install(T::reverb, std::make_unique<RecordingModule>(T::reverb, log, 0));
+
+	bool passed = true;
+
+	// 何も ON でなければ空
+	graph.compile(params);
+	passed = expect("all off", runGraph(graph, log), {}) && passed;
+
+	// 既定の順（Filter → Compressor → Delay → Reverb）
+	params.filterEnabled = params.compressorEnabled = params.delayEnabled = params.reverbEnabled = true;
+	graph.compile(params);
+	passed = expect("default order", runGraph(graph, log), { T::filter, T::compressor, T::delay, T::reverb }) && passed;
+
+	// スロットで Reverb → Filter を先頭に。同じ FX の2回目と、モジュールのない Chorus は無視
+	graph.setSlot(0, (int)T::reverb);
+	graph.setSlot(1, (int)T::chorus);
+	graph.setSlot(2, (int)T::filter);
+	graph.setSlot(3, (int)T::reverb);
+	params.chorusEnabled = true;
+	graph.compile(params);
+	passed = expect("slot order", runGraph(graph, log), { T::reverb, T::filter, T::compressor, T::delay }) && passed;
+
+	// OFF にしたものは抜ける（スロットに置いたままでも）
+	params.reverbEnabled = false;
+	graph.compile(params);
+	passed = expect("reverb off", runGraph(graph, log), { T::filter, T::compressor, T::delay }) && passed;
+
+	// 遅延は並んでいるモジュールの合計
+	std::cout << "  latency: " << graph.getLatencySamples() << " (filter index " << graph.indexOf(T::filter) << ")" << std::endl;
+	passed = passed && graph.getLatencySamples() == 64 && graph.indexOf(T::filter) == 0 && graph.indexOf(T::reverb) < 0;
+
+	params.compressorEnabled = false;
+	graph.compile(params);
+	passed = passed && graph.getLatencySamples() == 0;
+
+	if (!passed)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: FX graph follows the slot order and skips idle modules." << std::endl;
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cmath>
+#include "InputTestRig.h"
+
+// 入力ペアごとのトリガー（InputManager の perInputRouting）
+// - OFF: どの入力でもルート 0 が発火し、全ペアの先読みが同じ位置から出る（従来どおり）
+// - ON : ch 5 の音はルート 2（ペア 2）だけが発火し、先読みもペア 2 のリングだけに入る
+// - ON : 2人が同じブロックで鳴らすと、それぞれのルートが自分のアタック位置で発火する
+// - ON : 片方のルートが録音中でも、もう片方は鎮火・再アームして次のトリガーを受け付ける
+
+namespace
+{
+	constexpr double sampleRate = InputTestRig::sampleRate;
+	constexpr int blockSize = 64;
+	constexpr int numChannels = 8;
+
+	struct Note
+	{
+		int channel = -1;
+		juce::int64 startAbs = 0; // この絶対位置から鳴らす
+	};
+
+	// ch ごとに違う周波数（先読みの中身でどの入力か分かるように）
+	float sampleAt(int channel, juce::int64 abs)
+	{
+		return 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi * (200.0 + 100.0 * channel) * (double)abs / sampleRate);
+	}
+
+	// numSamples 分を流す。notes の音は startAbs から鳴り続ける。ルートごとの最初のトリガー位置を返す
+	std::array<juce::int64, InputTestRig::maxRoutes> run(InputTestRig& rig, int numSamples, const std::vector<Note>& notes)
+	{
+		return rig.run(numSamples, [&] (juce::AudioBuffer<float>& block, juce::int64 blockStart, int)
+		{
+			for (const auto& note : notes)
+				for (int i = 0; i < blockSize; ++i)
+					if (blockStart + i >= note.startAbs)
+						block.setSample(note.channel, i, sampleAt(note.channel, blockStart + i));
+		}).first;
+	}
+
+	// 先読み（endAbs の手前まで）が ch の入力と同じか（onsetAbs より前は無音）。ペアの中では ch % 2 のチャンネル
+	bool lookbackMatches(const AudioInputBuffer::LookbackView& view, int channel, juce::int64 onsetAbs, juce::int64 endAbs)
+	{
+		if (view.isEmpty())
+			return false;
+		juce::int64 abs = endAbs - view.numSamples;
+		for (int s = 0; s < view.numSpans; ++s)
+		{
+			const auto& span = view.spans[(size_t)s];
+			for (int i = 0; i < span.numSamples; ++i, ++abs)
+			{
+				const float expected = abs >= onsetAbs ? sampleAt(channel, abs) : 0.0f;
+				if (std::abs(span.channels[(size_t)(channel % 2)][i] - expected) > 1.0e-6f)
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestInputRouting..." << std::endl;
+	bool passed = true;
+	InputTestRig rig (blockSize, numChannels, 200000);
+	auto& manager = rig.manager;
+	std::array<juce::int64, InputManager::maxRoutes> firsts {};
+	manager.getChannelManager().setGlobalThreshold(0.1f);
+	manager.setAdaptiveFloorEnabled(false);
+	manager.setStereoLinked(false);
+
+	// 1. OFF: ch 5 の音でルート 0 が発火し、どのペアからも先読みが出る
+	rig.rearm();
+	const juce::int64 onsetOff = rig.clock + 1000;
+	firsts = run(rig, 4800, { { 5, onsetOff } });
+	std::cout << "  routing off: route 0 at " << firsts[0] << ", route 2 at " << firsts[2] << std::endl;
+	passed = passed && firsts[0] >= 0 && firsts[2] < 0 && manager.getRouteForInputPair(2) == 0;
+	passed = passed && !manager.getLookback(0).isEmpty() && lookbackMatches(manager.getLookback(2), 5, onsetOff, rig.clock - blockSize);
+	rig.rearm();
+
+	// 2. ON: ch 5 の音はルート 2 だけ。先読みはペア 2 のリングだけに入る
+	manager.setPerInputRouting(true);
+	rig.rearm();
+	const juce::int64 onset = rig.clock + 1000;
+	firsts = run(rig, 4800, { { 5, onset } });
+	std::cout << "  routing on: route 0 at " << firsts[0] << ", route 2 at " << firsts[2] << " (onset " << onset << ")" << std::endl;
+	passed = passed && firsts[0] < 0 && firsts[2] >= onset && firsts[2] < onset + 16 && manager.getRouteForInputPair(2) == 2;
+	const auto view2 = manager.getLookback(2);
+	std::cout << "  pair 2 lookback: " << view2.numSamples << " samples" << std::endl;
+	passed = passed && lookbackMatches(view2, 5, onset, rig.clock - blockSize) && manager.getLookback(0).isEmpty();
+	rig.rearm();
+
+	// 3. ON: 2人が同じブロックで鳴らす（ch 0 と ch 6、少しずらして）。それぞれのルートが自分の位置で発火する
+	const juce::int64 onsetA = rig.clock + 1000;
+	const juce::int64 onsetB = rig.clock + 1010;
+	firsts = run(rig, 4800, { { 0, onsetA }, { 6, onsetB } });
+	std::cout << "  two players: route 0 at " << firsts[0] << " (onset " << onsetA << "), route 3 at " << firsts[3]
+	          << " (onset " << onsetB << ")" << std::endl;
+	passed = passed && firsts[0] >= onsetA && firsts[0] < onsetA + 16 && firsts[3] >= onsetB && firsts[3] < onsetB + 16;
+	passed = passed && lookbackMatches(manager.getLookback(0), 0, onsetA, rig.clock - blockSize)
+	         && lookbackMatches(manager.getLookback(3), 6, onsetB, rig.clock - blockSize);
+
+	// 4. ON: ルート 0 を録音中にしたまま、ルート 3 は静かになれば再アームして次の音で発火する
+	manager.setRecordingActive(0, true);
+	rig.rearm();
+	const juce::int64 onsetC = rig.clock + 500;
+	firsts = run(rig, 4800, { { 6, onsetC } });
+	std::cout << "  route 3 while route 0 records: " << firsts[3] << " (onset " << onsetC << ")" << std::endl;
+	passed = passed && firsts[3] >= onsetC && firsts[3] < onsetC + 16 && manager.isRecordingActive() && !manager.isRecordingActive(3);
+	manager.setRecordingActive(false);
+
+	if (!passed)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: each input pair triggers its own route." << std::endl;
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "../LaneFilterBank.h"
+
+// LaneFilterBank（8トラック分を SIMD レーンにまとめた SVF）が、トラックごとの
+// juce::dsp::StateVariableTPTFilter と同じ出力になるかを見る
+// トラックごとに cutoff / resonance / type を変え、途中で値を動かしたり、トラックを抜いたりする
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 200;   // chunkSize で割り切れない長さ
+	constexpr int numBlocks = 300;
+
+	using Type = juce::dsp::StateVariableTPTFilterType;
+
+	struct TrackSetting
+	{
+		float cutoff;
+		float resonance;
+		Type type;
+	};
+
+	TrackSetting settingFor(int track, int block)
+	{
+		static const Type types[] = { Type::lowpass, Type::highpass, Type::bandpass };
+		// 100 ブロックごとに cutoff を動かす
+		const float cutoff = 200.0f * (float)(track + 1) * (1.0f + 0.5f * (float)(block / 100));
+		return { cutoff, 0.5f + 0.3f * (float)track, types[track % 3] };
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestLaneFilterBank... (" << LaneFilterBank::laneWidth << " lanes per register)" << std::endl;
+
+	LaneFilterBank bank;
+	bank.prepare(sampleRate);
+
+	std::vector<juce::dsp::StateVariableTPTFilter<float>> reference((size_t)LaneFilterBank::maxTracks);
+	for (auto& filter : reference)
+		filter.prepare({ sampleRate, (juce::uint32)blockSize, 2 });
+
+	juce::Random random(42);
+	juce::AudioBuffer<float> lanes(LaneFilterBank::maxLanes, blockSize);
+	juce::AudioBuffer<float> expected(LaneFilterBank::maxLanes, blockSize);
+	float maxError = 0.0f;
+
+	for (int b = 0; b < numBlocks; ++b)
+	{
+		LaneFilterBank::LanePointers pointers {};
+
+		for (int track = 0; track < LaneFilterBank::maxTracks; ++track)
+		{
+			// トラック 5 は途中で抜ける（レーンは処理されず、ほかのトラックに影響しない）
+			if (track == 5 && b >= 150)
+				continue;
+
+			const auto s = settingFor(track, b);
+			auto& filter = reference[(size_t)track];
+			filter.setCutoffFrequency(s.cutoff);
+			filter.setResonance(s.resonance);
+			filter.setType(s.type);
+			bank.setParameters(track, s.cutoff, s.resonance, s.type);
+
+			for (int ch = 0; ch < 2; ++ch)
+			{
+				const int lane = track * 2 + ch;
+				for (int i = 0; i < blockSize; ++i)
+				{
+					const float x = random.nextFloat() * 2.0f - 1.0f;
+					lanes.setSample(lane, i, x);
+					expected.setSample(lane, i, filter.processSample(ch, x));
+				}
+				pointers[(size_t)lane] = lanes.getWritePointer(lane);
+			}
+			filter.snapToZero();
+		}
+
+		bank.process(pointers, blockSize);
+
+		for (int lane = 0; lane < LaneFilterBank::maxLanes; ++lane)
+			if (pointers[(size_t)lane] != nullptr)
+				for (int i = 0; i < blockSize; ++i)
+					maxError = std::max(maxError, std::abs(lanes.getSample(lane, i) - expected.getSample(lane, i)));
+	}
+
+	std::cout << "  max difference from StateVariableTPTFilter: " << maxError << std::endl;
+
+	if (!(maxError <= 1.0e-5f))
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: lane filters match the per-track filters." << std::endl;
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cmath>
+#include "InputTestRig.h"
+
+// ノイズフロアの追従（NoiseFloorTracker + InputManager）
+// - 静かな部屋: フロアは背景のピーク × マージン
+// - 部屋が大きくなると窓（4秒）のうちに追従して閾値が上がり、誤トリガーが止まる
+// - 静かに戻るとすぐ下がる。窓より短い演奏（バースト）ではフロアは上がらない
+// - 追従後も普通の音ではトリガーが出る
+// - 録音中は学習しない
+
+namespace
+{
+	constexpr double sampleRate = InputTestRig::sampleRate;
+	constexpr int blockSize = 64;
+	constexpr int numChannels = 2;
+
+	struct Result
+	{
+		int numTriggers = 0;
+		int triggersInLastSecond = 0;
+	};
+
+	// 背景ノイズ noise に、period 秒ごとに burstSeconds の音 burst を足して seconds 秒流す
+	Result run(InputTestRig& rig, double seconds, float noise, juce::Random& random,
+	           float burst = 0.0f, double period = 1.0, double burstSeconds = 0.0)
+	{
+		const int numSamples = (int)(seconds * sampleRate);
+		const auto triggers = rig.run(numSamples, [&] (juce::AudioBuffer<float>& block, juce::int64, int done)
+		{
+			for (int i = 0; i < blockSize; ++i)
+			{
+				const double t = (done + i) / sampleRate;
+				const bool inBurst = std::fmod(t, period) < burstSeconds;
+				float x = (random.nextFloat() * 2.0f - 1.0f) * noise;
+				if (inBurst)
+					x += burst * (float)std::sin(juce::MathConstants<double>::twoPi * 440.0 * t);
+				for (int ch = 0; ch < numChannels; ++ch)
+					block.setSample(ch, i, x);
+			}
+		});
+
+		Result result;
+		const juce::int64 lastSecond = rig.clock - (juce::int64)sampleRate;
+		for (const auto onset : triggers.onsets[0])
+		{
+			++result.numTriggers;
+			if (onset >= lastSecond)
+				++result.triggersInLastSecond;
+		}
+		return result;
+	}
+
+	bool near(float value, float expected, float tolerance) { return std::abs(value - expected) <= tolerance; }
+}
+
+int main()
+{
+	std::cout << "Starting TestNoiseFloor..." << std::endl;
+	bool passed = true;
+	juce::Random random(11);
+	InputTestRig rig (blockSize, numChannels);
+	auto& manager = rig.manager;
+	manager.getChannelManager().setGlobalThreshold(0.02f);
+	const float margin = ChannelTriggerSettings::NOISE_FLOOR_MARGIN;
+
+	// 1. 静かな部屋
+	run(rig, 3.0, 0.002f, random);
+	const float quietFloor = manager.getChannelNoiseFloor(0);
+	std::cout << "  quiet room: floor " << quietFloor << ", threshold " << manager.getChannelThreshold(0) << std::endl;
+	passed = passed && near(quietFloor, 0.002f * margin, 0.0005f);
+
+	// 2. 部屋が大きくなる（0.04 > 閾値 0.023）: 最初は誤トリガーするが、追従して止まる
+	const auto loud = run(rig, 6.0, 0.04f, random);
+	const float loudFloor = manager.getChannelNoiseFloor(0);
+	std::cout << "  loud room: floor " << loudFloor << ", threshold " << manager.getChannelThreshold(0) << ", triggers "
+	          << loud.numTriggers << " (" << loud.triggersInLastSecond << " in the last second)" << std::endl;
+	passed = passed && near(loudFloor, 0.04f * margin, 0.01f) && loud.triggersInLastSecond == 0
+	         && near(manager.getChannelThreshold(0), loudFloor + 0.02f, 0.001f);
+
+	// 3. 静かに戻る: 小区間（0.5秒）が2つ終われば下がっている
+	run(rig, 1.1, 0.002f, random);
+	std::cout << "  back to quiet after 1.1s: floor " << manager.getChannelNoiseFloor(0) << std::endl;
+	passed = passed && near(manager.getChannelNoiseFloor(0), 0.002f * margin, 0.0005f);
+
+	// 4. 1秒ごとに 0.3 秒の演奏: フロアは上がらず、トリガーは毎回出る
+	const auto bursts = run(rig, 6.0, 0.002f, random, 0.3f, 1.0, 0.3);
+	std::cout << "  bursts: floor " << manager.getChannelNoiseFloor(0) << ", triggers " << bursts.numTriggers << std::endl;
+	passed = passed && near(manager.getChannelNoiseFloor(0), 0.002f * margin, 0.0005f) && bursts.numTriggers == 6;
+
+	// 5. 録音中は学習しない
+	manager.setRecordingActive(true);
+	run(rig, 6.0, 0.04f, random);
+	std::cout << "  while recording: floor " << manager.getChannelNoiseFloor(0) << std::endl;
+	passed = passed && near(manager.getChannelNoiseFloor(0), 0.002f * margin, 0.0005f);
+	manager.setRecordingActive(false);
+
+	// 6. OFF ならキャリブレーションの値（ここでは未測定なので閾値そのもの）
+	manager.setAdaptiveFloorEnabled(false);
+	run(rig, 0.1, 0.002f, random);
+	std::cout << "  adaptive off: threshold " << manager.getChannelThreshold(0) << std::endl;
+	passed = passed && near(manager.getChannelThreshold(0), 0.02f, 1.0e-6f);
+
+	if (!passed)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: the noise floor follows the room between notes." << std::endl;
+	return 0;
+}
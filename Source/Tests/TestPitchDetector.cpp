@@ -0,0 +1,190 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../PitchDetector.h"
+
+// FFT 版 PitchDetector を、以前の O(N²) の YIN（ここに参照実装として残す）と
+// テストトーンで比べる。64 サンプルブロックで 0.5 秒流したあとの推定値を見る
+
+namespace
+{
+	// 以前の PitchDetector::detectPitch（毎ブロック、差分関数を2重ループで計算）
+	class ReferenceYin
+	{
+	public:
+		explicit ReferenceYin(double sampleRate)
+			: sr(sampleRate)
+		{
+			windowSize = juce::jlimit(256, 2048, (int)(sr * 0.025));
+			input.assign((size_t)windowSize * 2, 0.0f);
+			yin.assign((size_t)windowSize, 0.0f);
+			window.assign((size_t)windowSize, 0.0f);
+		}
+
+		void push(const float* samples, int numSamples)
+		{
+			for (int i = 0; i < numSamples; ++i)
+			{
+				input[(size_t)writePos] = samples[i];
+				writePos = (writePos + 1) % (int)input.size();
+			}
+		}
+
+		float detect()
+		{
+			const int size = (int)input.size();
+			const int readPos = (writePos - windowSize + size) % size;
+			for (int i = 0; i < windowSize; ++i)
+				window[(size_t)i] = input[(size_t)((readPos + i) % size)];
+
+			const int halfWin = windowSize / 2;
+			for (int tau = 1; tau < halfWin; ++tau)
+			{
+				float sum = 0.0f;
+				for (int j = 0; j < halfWin; ++j)
+				{
+					const float d = window[(size_t)j] - window[(size_t)(j + tau)];
+					sum += d * d;
+				}
+				yin[(size_t)tau] = sum;
+			}
+
+			yin[0] = 1.0f;
+			float runSum = 0.0f;
+			for (int tau = 1; tau < halfWin; ++tau)
+			{
+				runSum += yin[(size_t)tau];
+				yin[(size_t)tau] = runSum > 0 ? yin[(size_t)tau] * tau / runSum : 1.0f;
+			}
+
+			int tauEst = -1;
+			for (int tau = 2; tau < halfWin; ++tau)
+			{
+				if (yin[(size_t)tau] < 0.15f)
+				{
+					while (tau + 1 < halfWin && yin[(size_t)tau + 1] < yin[(size_t)tau]) ++tau;
+					tauEst = tau;
+					break;
+				}
+			}
+			if (tauEst < 1)
+				return smoothed *= 0.95f;
+
+			float betterTau = (float)tauEst;
+			if (tauEst < halfWin - 1)
+			{
+				const float s0 = yin[(size_t)tauEst - 1], s1 = yin[(size_t)tauEst], s2 = yin[(size_t)tauEst + 1];
+				const float denom = 2.0f * (2.0f * s1 - s2 - s0);
+				if (std::abs(denom) > 1e-9f) betterTau = tauEst + (s2 - s0) / denom;
+			}
+
+			const float pitch = (float)sr / betterTau;
+			if (pitch < 50.0f || pitch > 2000.0f)
+				return smoothed *= 0.95f;
+
+			smoothed = smoothed * 0.7f + pitch * 0.3f;
+			return smoothed;
+		}
+
+	private:
+		double sr;
+		int windowSize = 0;
+		int writePos = 0;
+		float smoothed = 0.0f;
+		std::vector<float> input, yin, window;
+	};
+
+	float toneSample(bool saw, double freq, double sampleRate, int n)
+	{
+		const double phase = std::fmod(freq * n / sampleRate, 1.0);
+		return saw ? (float)(0.5 * (2.0 * phase - 1.0))
+		           : (float)(0.5 * std::sin(juce::MathConstants<double>::twoPi * phase));
+	}
+
+	bool runTone(bool saw, double freq, double sampleRate)
+	{
+		constexpr int blockSize = 64;
+		const int numBlocks = (int)(0.5 * sampleRate) / blockSize;
+
+		PitchDetector detector;
+		detector.prepare(sampleRate, blockSize);
+		ReferenceYin reference(sampleRate);
+
+		std::vector<float> block(blockSize);
+		float detected = 0.0f, expected = 0.0f;
+		int n = 0;
+
+		for (int b = 0; b < numBlocks; ++b)
+		{
+			for (int i = 0; i < blockSize; ++i)
+				block[(size_t)i] = toneSample(saw, freq, sampleRate, n++);
+
+			detector.pushSamples(block.data(), blockSize);
+			detected = detector.detectPitch();
+
+			reference.push(block.data(), blockSize);
+			expected = reference.detect();
+		}
+
+		// 参照実装との差は 0.5% 以内、真の周波数とは 1% 以内
+		const bool matchesReference = std::abs(detected - expected) <= expected * 0.005f;
+		const bool matchesTone = std::abs(detected - (float)freq) <= (float)freq * 0.01f;
+
+		std::cout << (saw ? "  saw  " : "  sine ") << freq << " Hz @ " << sampleRate
+		          << ": fft " << detected << " / reference " << expected
+		          << ((matchesReference && matchesTone) ? "" : "  <-- FAIL") << std::endl;
+
+		return matchesReference && matchesTone;
+	}
+
+	// ホップごとにしか検出しないこと（ホップの手前では前回値をそのまま返す）
+	bool runHopScheduling()
+	{
+		constexpr double sampleRate = 48000.0;
+		PitchDetector detector;
+		detector.prepare(sampleRate, 64, 256);
+
+		std::vector<float> block(64);
+		int n = 0, changes = 0;
+		float last = 0.0f;
+
+		for (int b = 0; b < 64; ++b)
+		{
+			for (auto& s : block)
+				s = toneSample(false, 220.0, sampleRate, n++);
+
+			detector.pushSamples(block.data(), (int)block.size());
+			const float pitch = detector.detectPitch();
+			if (pitch != last)
+				++changes;
+			last = pitch;
+		}
+
+		// 64 ブロック x 64 サンプル / ホップ 256 = 16 回
+		std::cout << "  hop 256 @ 64-sample blocks: " << changes << " detections in 64 blocks" << std::endl;
+		return changes <= 16;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestPitchDetector..." << std::endl;
+
+	bool ok = true;
+	for (double sampleRate : { 44100.0, 48000.0 })
+		for (bool saw : { false, true })
+			for (double freq : { 82.41, 110.0, 196.0, 220.0, 440.0, 659.25, 880.0 })
+				ok = runTone(saw, freq, sampleRate) && ok;
+
+	ok = runHopScheduling() && ok;
+
+	if (!ok)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: FFT detector matches the reference YIN." << std::endl;
+	return 0;
+}
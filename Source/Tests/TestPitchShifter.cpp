@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../PitchShifter.h"
+
+// PitchShifter（PSOLA / フェーズボコーダ）にサイン波を通して、
+// ずらしたあとの周波数・音量・遅延（ratio 1 で入力を getLatencySamples だけ遅らせたものと一致するか）を見る
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 64;
+	constexpr double toneHz = 220.0;
+
+	// 後半（立ち上がりを除いた部分）の上向きゼロクロスから周波数を求める
+	double measureFrequency(const std::vector<float>& x, int from)
+	{
+		int crossings = 0, first = -1, last = -1;
+		for (int i = from + 1; i < (int)x.size(); ++i)
+		{
+			if (x[(size_t)i - 1] < 0.0f && x[(size_t)i] >= 0.0f)
+			{
+				if (first < 0) first = i;
+				last = i;
+				++crossings;
+			}
+		}
+		return crossings > 1 ? (crossings - 1) * sampleRate / (last - first) : 0.0;
+	}
+
+	bool runTone(PitchShifter::Mode mode, bool preserveFormants, float ratio)
+	{
+		PitchShifter shifter;
+		shifter.prepare(sampleRate, blockSize);
+		shifter.setMode(mode);
+		shifter.setPreserveFormants(preserveFormants);
+		shifter.setPitchRatio(ratio);
+
+		juce::AudioBuffer<float> block(2, blockSize);
+		std::vector<float> input, output;
+		int n = 0;
+
+		for (int b = 0; b < (int)sampleRate / blockSize; ++b)
+		{
+			for (int i = 0; i < blockSize; ++i)
+			{
+				const float s = 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi * toneHz * n++ / sampleRate);
+				block.setSample(0, i, s);
+				block.setSample(1, i, s);
+				input.push_back(s);
+			}
+
+			shifter.setPeriod((float)(sampleRate / toneHz));
+			shifter.process(block, blockSize);
+
+			for (int i = 0; i < blockSize; ++i)
+				output.push_back(block.getSample(0, i));
+		}
+
+		const int from = (int)output.size() / 2;
+		const double frequency = measureFrequency(output, from);
+
+		double sum = 0.0;
+		for (int i = from; i < (int)output.size(); ++i)
+			sum += (double)output[(size_t)i] * output[(size_t)i];
+		const double rms = std::sqrt(sum / (double)(output.size() - (size_t)from));
+
+		// ratio 1 なら遅延を戻せば入力とほぼ一致するはず
+		float maxError = 0.0f;
+		if (ratio == 1.0f)
+		{
+			const int latency = shifter.getLatencySamples();
+			for (int i = from; i < (int)output.size(); ++i)
+				maxError = std::max(maxError, std::abs(output[(size_t)i] - input[(size_t)(i - latency)]));
+		}
+
+		// 周波数は 0.5% 以内、音量は入力（0.354）の半分以上、ratio 1 の誤差は 1e-3 以内
+		const double expected = toneHz * ratio;
+		const bool ok = std::abs(frequency - expected) <= expected * 0.005
+		             && rms >= 0.17
+		             && maxError <= 1.0e-3f;
+
+		const char* modeName = mode == PitchShifter::Mode::phaseVocoder ? "pv   " : "psola";
+		std::cout << "  " << modeName << (preserveFormants ? " formants " : " shifted  ")
+		          << "x" << ratio << ": " << frequency << " Hz (want " << expected << "), rms " << rms
+		          << ", latency " << shifter.getLatencySamples()
+		          << (ok ? "" : "  <-- FAIL") << std::endl;
+		return ok;
+	}
+
+	// 有声 / 無声が細かく切り替わっても（PSOLA ⇔ フェーズボコーダ）暴れないこと
+	bool runModeSwitching()
+	{
+		PitchShifter shifter;
+		shifter.prepare(sampleRate, blockSize);
+		shifter.setPitchRatio(1.3f);
+
+		juce::AudioBuffer<float> block(2, blockSize);
+		double phase = 0.0;
+		float peak = 0.0f;
+		bool finite = true;
+
+		for (int b = 0; b < 1500; ++b)
+		{
+			const double frequency = 110.0 + (b % 500);
+			for (int i = 0; i < blockSize; ++i)
+			{
+				phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+				block.setSample(0, i, 0.5f * (float)std::sin(phase));
+				block.setSample(1, i, -0.5f * (float)std::sin(phase));
+			}
+
+			shifter.setPeriod((b / 40) % 2 == 0 ? (float)(sampleRate / frequency) : 0.0f);
+			shifter.process(block, blockSize);
+
+			for (int i = 0; i < blockSize; ++i)
+			{
+				const float v = block.getSample(0, i);
+				finite = finite && std::isfinite(v);
+				peak = std::max(peak, std::abs(v));
+			}
+		}
+
+		std::cout << "  voiced/unvoiced switching: peak " << peak << std::endl;
+		return finite && peak < 1.0f;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestPitchShifter..." << std::endl;
+
+	bool ok = true;
+	for (auto mode : { PitchShifter::Mode::psola, PitchShifter::Mode::phaseVocoder })
+		for (bool preserveFormants : { true, false })
+			for (float ratio : { 1.0f, 0.8f, 1.5f })
+				ok = runTone(mode, preserveFormants, ratio) && ok;
+
+	ok = runModeSwitching() && ok;
+
+	if (!ok)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: pitch shifter keeps pitch, level and latency." << std::endl;
+	return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../LooperAudio.h"
+
+// スレーブ録音の先読み（startRecordingWithLookback）
+// - 先読みはトリガー位置ではなく、録音を始めるブロックの先頭で終わるように書かれる
+//   （トリガーの absIndex は先読みの途中にある。以前はそこで終わるように書いてずれていた）
+// - 再生すると、先読み + 録音したブロックがつながった入力と1サンプルもずれずに一致する
+// - 先読みが2区間（リングの折り返し）に分かれていても同じ
+
+namespace
+{
+	constexpr double sampleRate = 48000.0;
+	constexpr int blockSize = 64;
+	constexpr int masterLength = 1024; // マスターのループ長（ブロック 16 個）
+	constexpr int preRoll = 200;       // 先読みの長さ
+	constexpr int triggerInPreRoll = 40; // 先読みの先頭からトリガーまで
+
+	// 絶対位置ごとに違う値（ずれると一致しない）。R は符号を反転
+	float sampleAt(juce::int64 abs)
+	{
+		return 0.001f * (float)((abs % 1021) + 1);
+	}
+
+	// 1ブロック流す。playSignal なら入力に sampleAt を入れる。トラック 2（スロット 1）の出力を stemOut に足す
+	void runBlock(LooperAudio& looper, juce::int64& clock, bool playSignal,
+	              juce::AudioBuffer<float>* stems, std::vector<float>* stemOutL = nullptr, std::vector<float>* stemOutR = nullptr)
+	{
+		juce::AudioBuffer<float> input (2, blockSize);
+		juce::AudioBuffer<float> output (2, blockSize);
+		input.clear();
+		if (playSignal)
+			for (int i = 0; i < blockSize; ++i)
+			{
+				input.setSample(0, i, sampleAt(clock + i));
+				input.setSample(1, i, -sampleAt(clock + i));
+			}
+
+		looper.processBlock(output, input);
+		clock += blockSize;
+
+		if (stemOutL != nullptr)
+			for (int i = 0; i < blockSize; ++i)
+			{
+				stemOutL->push_back(stems[1].getSample(0, i));
+				stemOutR->push_back(stems[1].getSample(1, i));
+			}
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestSlavePreRoll..." << std::endl;
+
+	LooperAudio looper (sampleRate, (int)sampleRate * 4);
+	looper.addTrack(1);
+	looper.addTrack(2);
+
+	std::vector<juce::AudioBuffer<float>> stems (LooperAudio::maxTracks);
+	for (auto& stem : stems)
+		stem.setSize(2, blockSize);
+	looper.setStemOutputs(stems.data());
+	looper.prepareToPlay(blockSize, sampleRate);
+
+	juce::int64 clock = 0;
+
+	// 1. マスター（無音）を 1024 サンプル録って再生する
+	looper.startRecording(1);
+	for (int done = 0; done < masterLength; done += blockSize)
+		runBlock(looper, clock, false, stems.data());
+	looper.stopRecording(1);
+	looper.startPlaying(1);
+
+	// ループの途中（5ブロック先）まで進める
+	for (int i = 0; i < 5; ++i)
+		runBlock(looper, clock, false, stems.data());
+
+	// 2. 先読み: [blockStart - preRoll, blockStart) の入力。リングの折り返しを模して2区間に分ける
+	const juce::int64 blockStart = clock;
+	std::vector<float> preL ((size_t)preRoll), preR ((size_t)preRoll);
+	for (int i = 0; i < preRoll; ++i)
+	{
+		preL[(size_t)i] = sampleAt(blockStart - preRoll + i);
+		preR[(size_t)i] = -sampleAt(blockStart - preRoll + i);
+	}
+
+	AudioInputBuffer::LookbackView view;
+	view.numChannels = 2;
+	view.numSamples = preRoll;
+	view.numSpans = 2;
+	view.spans[0].numSamples = 130;
+	view.spans[0].channels[0] = preL.data();
+	view.spans[0].channels[1] = preR.data();
+	view.spans[1].numSamples = preRoll - 130;
+	view.spans[1].channels[0] = preL.data() + 130;
+	view.spans[1].channels[1] = preR.data() + 130;
+
+	// トリガーは先読みの途中（アタックの少し後）
+	juce::TriggerEvent trigger;
+	trigger.fire(blockSize - 1, blockStart - preRoll + triggerInPreRoll, 0);
+
+	// オーディオスレッドと同じく processBlock の直前に呼ぶ
+	looper.startRecordingWithLookback(2, view, trigger);
+
+	// 3. 録音: 先読み分だけ早く1周（masterLength）に達して、自動で再生に移る
+	const int blocksToRecord = (masterLength - preRoll + blockSize - 1) / blockSize;
+	for (int i = 0; i < blocksToRecord; ++i)
+		runBlock(looper, clock, true, stems.data());
+
+	// 4. 入力を止めて2周分再生し、トラック 2 の出力を取る
+	const juce::int64 playStart = clock;
+	std::vector<float> outL, outR;
+	for (int done = 0; done < masterLength * 2; done += blockSize)
+		runBlock(looper, clock, false, stems.data(), &outL, &outR);
+
+	// 録音した区間は [blockStart - preRoll, blockStart - preRoll + masterLength)。
+	// 絶対位置 p の再生は、区間の中でマスターのループ位置が同じサンプル
+	const juce::int64 recordedStart = blockStart - preRoll;
+	int mismatches = 0;
+	int firstMismatch = -1;
+	for (size_t i = 0; i < outL.size(); ++i)
+	{
+		const juce::int64 p = playStart + (juce::int64)i;
+		const juce::int64 q = recordedStart + ((p - recordedStart) % masterLength);
+		if (std::abs(outL[i] - sampleAt(q)) > 1.0e-6f || std::abs(outR[i] + sampleAt(q)) > 1.0e-6f)
+		{
+			if (firstMismatch < 0)
+				firstMismatch = (int)i;
+			++mismatches;
+		}
+	}
+
+	std::cout << "  recorded length: " << looper.getTrackRecordLength(2)
+	          << ", mismatches: " << mismatches << " / " << outL.size() << std::endl;
+
+	if (looper.getTrackRecordLength(2) != masterLength || mismatches > 0)
+	{
+		if (firstMismatch >= 0)
+			std::cout << "  first mismatch at " << (playStart + firstMismatch) << ": got " << outL[(size_t)firstMismatch] << std::endl;
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: slave pre-roll lines up with the recorded block." << std::endl;
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../TriggerDetector.h"
+#include "../InputManager.h"
+
+// 入力のトリガー検出
+// - TriggerDetector: 16ch のどこで閾値を超えても、サンプル単位の絶対位置とチャンネルが出るか
+//   （ブロックをまたぐ / ステレオリンクの R / 無効なチャンネル / モノラルのゲイン）。レベルは素朴な最大値と同じか
+// - InputManager: ゆっくり立ち上がる音で、先読みが勾配で遡ったアタックの始まりからになるか
+
+namespace
+{
+	constexpr int blockSize = 64;
+	constexpr juce::int64 clockOffset = 1000000;  // 絶対位置が 0 始まりでなくても合うか
+
+	struct Spike
+	{
+		int channel;
+		int position;
+		float amplitude;
+	};
+
+	// 全レーン閾値 0.1 で 16ch に spikes を置いて流し、最初のトリガーを返す
+	TriggerDetector::Result runDetector(TriggerDetector& detector, const std::vector<Spike>& spikes, int length,
+	                                    float& maxLevelError)
+	{
+		juce::AudioBuffer<float> signal(MAX_CHANNELS, length);
+		signal.clear();
+		juce::Random random(3);
+		for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+			for (int i = 0; i < length; ++i)
+				signal.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.001f);
+		for (const auto& s : spikes)
+			signal.setSample(s.channel, s.position, s.amplitude);
+
+		std::array<float, MAX_CHANNELS> levels {};
+		TriggerDetector::Result first;
+		for (int start = 0; start < length; start += blockSize)
+		{
+			const int n = std::min(blockSize, length - start);
+			float* channels[MAX_CHANNELS];
+			for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+				channels[ch] = signal.getWritePointer(ch, start);
+			juce::AudioBuffer<float> block(channels, MAX_CHANNELS, n);
+
+			const auto result = detector.process(block, clockOffset + start, levels.data());
+			if (result.triggered && !first.triggered)
+				first = result;
+
+			// レベルは各チャンネルのブロック内の |x| の最大 × ゲイン（ここではゲイン 1 のレーンだけ見る）
+			for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+				if (ch != 5)
+					maxLevelError = std::max(maxLevelError, std::abs(levels[(size_t)ch] - block.getMagnitude(ch, 0, n)));
+		}
+		return first;
+	}
+
+	bool expectTrigger(const char* name, const TriggerDetector::Result& r, bool triggered, juce::int64 absIndex, int channel)
+	{
+		const bool ok = r.triggered == triggered && (!triggered || (r.absIndex == absIndex && r.channel == channel
+		                                                             && r.sampleInBlock == (int)((absIndex - clockOffset) % blockSize)));
+		std::cout << "  " << name << ": triggered " << r.triggered << " at " << r.absIndex << " ch " << r.channel
+		          << (ok ? " (ok)" : " (unexpected)") << std::endl;
+		return ok;
+	}
+}
+
+int main()
+{
+	std::cout << "Starting TestTriggerDetector..." << std::endl;
+	bool passed = true;
+	float maxLevelError = 0.0f;
+
+	auto makeDetector = []
+	{
+		TriggerDetector d;
+		d.prepare(48000.0);
+		d.setLowThreshold(0.05f);
+		for (int lane = 0; lane < MAX_CHANNELS; ++lane)
+			d.setLane(lane, true, 0.1f, 1.0f);
+		return d;
+	};
+
+	// 1. ch 11 の 1234 サンプル目（ブロックの途中）
+	{
+		auto d = makeDetector();
+		const auto r = runDetector(d, { { 11, 1234, 0.5f } }, 4096, maxLevelError);
+		passed = expectTrigger("ch 11 spike", r, true, clockOffset + 1234, 11) && passed;
+	}
+
+	// 2. 低い閾値が先に超えても、トリガーは高い閾値を超えたサンプル
+	{
+		auto d = makeDetector();
+		const auto r = runDetector(d, { { 2, 700, 0.07f }, { 9, 2050, 0.3f } }, 4096, maxLevelError);
+		passed = expectTrigger("pre-roll then spike", r, true, clockOffset + 2050, 9) && passed;
+		passed = passed && d.getPreRollStartAbs() == clockOffset + 700;
+	}
+
+	// 3. ステレオリンク: R（ch 3）の音は L のレーン（ch 2）で検出する
+	{
+		auto d = makeDetector();
+		d.setLane(2, true, 0.1f, 1.0f, 3);
+		d.setLane(3, false, 0.1f, 1.0f);
+		const auto r = runDetector(d, { { 3, 333, 0.5f } }, 1024, maxLevelError);
+		passed = expectTrigger("stereo-linked R", r, true, clockOffset + 333, 2) && passed;
+	}
+
+	// 4. 無効なチャンネルは検出しない（レベルは出る）
+	{
+		auto d = makeDetector();
+		d.setLane(7, false, 0.1f, 1.0f);
+		const auto r = runDetector(d, { { 7, 100, 0.9f } }, 1024, maxLevelError);
+		passed = expectTrigger("inactive channel", r, false, -1, -1) && passed;
+	}
+
+	// 5. モノラルのゲインブースト: 0.08 x 1.41 > 0.1
+	{
+		auto d = makeDetector();
+		d.setLane(5, true, 0.1f, ChannelTriggerSettings::getMonoGainBoostLinear());
+		const auto r = runDetector(d, { { 5, 900, 0.08f } }, 1024, maxLevelError);
+		passed = expectTrigger("mono gain boost", r, true, clockOffset + 900, 5) && passed;
+	}
+
+	std::cout << "  level max difference from naive peak: " << maxLevelError << std::endl;
+	passed = passed && maxLevelError == 0.0f;
+
+	// 6. InputManager: 無音 → 10ms かけて 0 → 0.5 に立ち上がるサイン波
+	//    トリガー（0.2 を超えたところ）から勾配で遡り、先読みは立ち上がりの頭（1ms 以内）から始まる
+	{
+		constexpr double sampleRate = 48000.0;
+		constexpr int rampStart = 4800;
+		constexpr int rampLength = 480;
+		constexpr int length = 9600;
+
+		InputManager manager;
+		manager.prepare(sampleRate, blockSize);
+		SmartRecConfig config;
+		config.userThreshold = 0.2f;
+		config.silenceThreshold = 0.005f;
+		manager.setConfig(config);
+
+		juce::AudioBuffer<float> signal(1, length);
+		for (int i = 0; i < length; ++i)
+		{
+			const float envelope = i < rampStart ? 0.0f : std::min(1.0f, (float)(i - rampStart) / rampLength) * 0.5f;
+			// 周期 48 サンプル（1kHz）の正弦。ピークは 12 サンプル目ごと
+			signal.setSample(0, i, envelope * (float)std::sin(2.0 * juce::MathConstants<double>::pi * (i - rampStart) / 48.0));
+		}
+
+		juce::int64 triggerAbs = -1, attackStart = -1;
+		for (int start = 0; start < length && triggerAbs < 0; start += blockSize)
+		{
+			float* channels[] = { signal.getWritePointer(0, start) };
+			juce::AudioBuffer<float> block(channels, 1, blockSize);
+			manager.analyze(block, clockOffset + start);
+
+			auto& event = manager.getTriggerEvent();
+			if (event.isTriggerd())
+			{
+				triggerAbs = event.absIndex;
+				attackStart = clockOffset + start - manager.getLookback().numSamples; // 先読みは今のブロックの手前まで
+			}
+		}
+
+		// 最初に 0.2 を超えるサンプル（素朴に探す）
+		juce::int64 expectedTrigger = -1;
+		for (int i = 0; i < length && expectedTrigger < 0; ++i)
+			if (std::abs(signal.getSample(0, i)) > 0.2f)
+				expectedTrigger = clockOffset + i;
+
+		const auto attackError = std::abs(attackStart - (clockOffset + rampStart));
+		std::cout << "  slow attack: trigger " << triggerAbs << " (expected " << expectedTrigger << "), attack start "
+		          << attackStart - clockOffset << " (ramp starts at " << rampStart << ")" << std::endl;
+		passed = passed && triggerAbs == expectedTrigger && attackError <= (juce::int64)(sampleRate / 1000.0);
+	}
+
+	if (!passed)
+	{
+		std::cout << "Test Failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test Passed: sample-accurate triggers with absolute timestamps." << std::endl;
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <juce_core/juce_core.h>
+#include "../OfflineRenderer.h"
+
+// ヘッドレスのオフラインレンダー（サウンドカード・GUI なし）
+// 使い方:
+//   SarosOfflineRender --script actions.txt --out renders/ [--input take.wav[@秒]]...
+//                      [--rate 48000] [--block 512] [--tracks 8] [--threads 0] [--lanes]
+//                      [--memory 120] [--length 秒] [--tail 2] [--no-stems]
+// 出力: renders/mix.wav と renders/track_<id>.wav、リアルタイム比といちばん重かったブロックの負荷を標準出力に表示
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "usage: SarosOfflineRender --script <file> --out <dir> [--input <file>[@seconds]]...\n"
+		          << "                          [--rate <hz>] [--block <samples>] [--tracks <n>] [--threads <n>] [--lanes]\n"
+		          << "                          [--memory <seconds>] [--length <seconds>] [--tail <seconds>] [--no-stems]"
+		          << std::endl;
+	}
+
+	juce::File resolve(const juce::String& path)
+	{
+		return juce::File::getCurrentWorkingDirectory().getChildFile(path);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	OfflineRenderer::Options options;
+	juce::StringArray inputArgs;
+	juce::String scriptPath, outPath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const juce::String arg (argv[i]);
+		const bool hasValue = i + 1 < argc;
+		const auto next = [&] { return juce::String(argv[++i]); };
+
+		if      (arg == "--script" && hasValue)  scriptPath = next();
+		else if (arg == "--out" && hasValue)     outPath = next();
+		else if (arg == "--input" && hasValue)   inputArgs.add(next());
+		else if (arg == "--rate" && hasValue)    options.sampleRate = next().getDoubleValue();
+		else if (arg == "--block" && hasValue)   options.blockSize = next().getIntValue();
+		else if (arg == "--tracks" && hasValue)  options.numTracks = next().getIntValue();
+		else if (arg == "--threads" && hasValue) options.renderThreads = next().getIntValue();
+		else if (arg == "--lanes")               options.crossTrackLanes = true;
+		else if (arg == "--memory" && hasValue)  options.loopMemorySeconds = juce::jmax(1, next().getIntValue());
+		else if (arg == "--length" && hasValue)  options.lengthSeconds = next().getDoubleValue();
+		else if (arg == "--tail" && hasValue)    options.tailSeconds = next().getDoubleValue();
+		else if (arg == "--no-stems")            options.writeStems = false;
+		else
+		{
+			std::cerr << "unknown or incomplete option: " << arg << std::endl;
+			printUsage();
+			return 2;
+		}
+	}
+
+	if (scriptPath.isEmpty() || outPath.isEmpty())
+	{
+		printUsage();
+		return 2;
+	}
+
+	OfflineRenderer renderer (options);
+
+	// --input take.wav@4.5 = 4.5 秒の位置から入力
+	for (const auto& inputArg : inputArgs)
+	{
+		const auto path = inputArg.containsChar('@') ? inputArg.upToLastOccurrenceOf("@", false, false) : inputArg;
+		const double start = inputArg.containsChar('@') ? inputArg.fromLastOccurrenceOf("@", false, false).getDoubleValue() : 0.0;
+
+		if (const auto result = renderer.addInputFile(resolve(path), start); result.failed())
+		{
+			std::cerr << result.getErrorMessage() << std::endl;
+			return 1;
+		}
+	}
+
+	if (const auto result = renderer.loadScript(resolve(scriptPath)); result.failed())
+	{
+		std::cerr << result.getErrorMessage() << std::endl;
+		return 1;
+	}
+
+	OfflineRenderer::Stats stats;
+	if (const auto result = renderer.render(resolve(outPath), stats); result.failed())
+	{
+		std::cerr << result.getErrorMessage() << std::endl;
+		return 1;
+	}
+
+	std::cout << "rendered " << stats.audioSeconds << " s (" << stats.numSamples << " samples, "
+	          << renderer.getActions().size() << " actions) in " << stats.processSeconds << " s"
+	          << "  realtime x" << stats.realtimeFactor << std::endl;
+	const auto& used = renderer.getOptions();
+	std::cout << "worst block " << juce::roundToInt(stats.worstBlockLoad * 100.0) << "% of its deadline"
+	          << "  (rate " << used.sampleRate << ", block " << used.blockSize << ", tracks " << used.numTracks
+	          << ", threads " << used.renderThreads << (used.crossTrackLanes ? ", lanes" : "") << ")" << std::endl;
+	return 0;
+}
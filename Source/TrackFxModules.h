@@ -0,0 +1,682 @@
+/*
+  ==============================================================================
+
+    TrackFxModules.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック FX のパラメータ・モジュール・処理順（トラック1本につき1組）
+    - TrackFxParams: 全 FX のパラメータと ON / OFF。小さいので常に持つ（applyCommand が書く）
+    - 各モジュール: DSP の状態（ディレイライン・残響・FFT バッファなど）だけを持つ。
+      初めて ON にしたときにメッセージスレッドで作って prepare し、以後は LooperAudio が消えるまで残す
+    - TrackFxGraph: 作ったモジュールと、スロットの並びから組み立てた処理順（フラットな配列）。
+      ON / OFF やスロットが変わったときだけ compile し直し、ブロックごとには並んだものを順に回すだけ
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "FxModule.h"
+#include "GranularEngine.h"
+#include "PitchDetector.h"
+#include "PitchShifter.h"
+#include "BlockCompressor.h"
+#include "BlockBitcrusher.h"
+#include "BlockDelay.h"
+#include "LfoGenerator.h"
+#include "ConvolutionReverb.h"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+struct TrackFxParams
+{
+	float filterCutoff = 20000.0f;
+	float filterRes = 0.707f;
+	int   filterType = 0; // 0=LPF, 1=HPF
+	bool  filterEnabled = false;
+
+	float compressorThreshold = 0.0f; // dB
+	float compressorRatio = 1.0f;     // 1.0 = 素通し
+	bool  compressorEnabled = false;
+	bool  compressorLookahead = false; // 音声を BlockCompressor::lookaheadMs 遅らせる（先読みで揃える）
+
+	float reverbMix = 0.0f;
+	float reverbDamping = 0.5f;
+	float reverbRoomSize = 0.5f;
+	bool  reverbEnabled = false;
+
+	float delayMix = 0.0f;
+	float delayFeedback = 0.0f;
+	float delayTime = 0.5f; // sec
+	bool  delayEnabled = false;
+	bool  delaySync = false;      // マスターループ（1小節）の音符長に合わせる
+	int   delayDivision = 1;      // BlockDelay::getDivisionFraction のインデックス（1 = 1/4）
+	bool  delayPingPong = false;
+
+	// Flanger (using Chorus with short delay)
+	bool  flangerEnabled = false;
+	bool  flangerSync = false;
+	float flangerRate = 0.5f;
+	float flangerDepth = 0.5f;
+	float flangerFeedback = 0.0f;
+
+	// Chorus (using Chorus with longer delay for thickening)
+	bool  chorusEnabled = false;
+	bool  chorusSync = false;
+	float chorusRate = 0.3f;
+	float chorusDepth = 0.5f;
+	float chorusMix = 0.5f;
+
+	// Tremolo (LFO-based volume modulation)
+	bool  tremoloEnabled = false;
+	bool  tremoloSync = false;
+	float tremoloRate = 4.0f;    // Hz
+	float tremoloDepth = 0.5f;   // 0.0-1.0
+	int   tremoloShape = 0;      // 0=Sine, 1=Square, 2=Triangle
+
+	// Slicer / Trance Gate (rhythmic volume gate)
+	bool  slicerEnabled = false;
+	bool  slicerSync = false;
+	float slicerRate = 4.0f;     // Hz (gate frequency)
+	float slicerDepth = 1.0f;    // 0.0-1.0 (gate depth, 1.0 = full cut)
+	float slicerDuty = 0.5f;     // 0.0-1.0 (gate open ratio)
+	int   slicerShape = 0;       // 0=Square, 1=Smooth
+
+	// Bitcrusher
+	bool  bitcrusherEnabled = false;
+	float bitcrusherDepth = 0.0f; // Bits Reduction: 0.0(24bit) -> 1.0(4bit)
+	float bitcrusherRate = 0.0f;  // Downsampling: 0.0(1/1) -> 1.0(1/41)
+
+	// Granular Cloud（グレインの管理と描画は GranularEngine）
+	struct GranularParams
+	{
+		bool enabled = false;
+		GranularEngine::Params grain; // sizeMs / density / jitter / pitch / pitchRandom
+		float mix = 0.5f;             // Dry/Wet
+		float feedback = 0.0f;        // Feedback (optional)
+	} granular;
+
+	// Autotune (Pitch Correction)
+	struct AutotuneParams
+	{
+		bool enabled = false;
+		int key = 0;            // 0=C, 1=C#, 2=D, ... 11=B
+		int scale = 0;          // 0=Chromatic, 1=Major, 2=Minor
+		float amount = 1.0f;    // 0.0=No correction, 1.0=Hard tune
+		float speed = 0.1f;     // Correction speed (0=instant, 1=slow glide)
+		bool preserveFormants = true;
+	} autotune;
+
+	// モジュールを作るときの設定（LooperAudio がメッセージスレッドで書く）
+	juce::uint32 granularSeed = 1;  // Granular の乱数（トラックIDで固定 → 並列/シリアルで同じ結果）
+	int autotuneHop = PitchDetector::defaultHopSize;
+	int autotuneHopOffset = 0;      // スロットごとにずらして FFT が同じブロックに集まらないようにする
+
+	bool isEnabled(FxModuleType type) const noexcept
+	{
+		switch (type)
+		{
+			case FxModuleType::granular:   return granular.enabled;
+			case FxModuleType::autotune:   return autotune.enabled;
+			case FxModuleType::filter:     return filterEnabled;
+			case FxModuleType::compressor: return compressorEnabled;
+			case FxModuleType::flanger:    return flangerEnabled;
+			case FxModuleType::chorus:     return chorusEnabled;
+			case FxModuleType::tremolo:    return tremoloEnabled;
+			case FxModuleType::slicer:     return slicerEnabled;
+			case FxModuleType::bitcrusher: return bitcrusherEnabled;
+			case FxModuleType::delay:      return delayEnabled;
+			case FxModuleType::reverb:     return reverbEnabled;
+			default:                       return false;
+		}
+	}
+};
+
+//==============================================================================
+// モジュール
+
+// Granular Cloud: ループからグレインを鳴らし、dry / wet で混ぜる
+class GranularModule : public FxModule
+{
+public:
+	explicit GranularModule(const TrackFxParams& p) : params(p) { engine.setSeed(p.granularSeed); }
+
+	void prepare(double sampleRate, int maxBlockSize) override
+	{
+		engine.prepare(sampleRate);
+		cloud.setSize(2, juce::jmax(1, maxBlockSize));
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext& context) noexcept override
+	{
+		if (context.loop == nullptr)
+			return;
+
+		cloud.setSize(2, numSamples, false, false, true);
+		cloud.clear();
+		engine.process(*context.loop, context.loopLength, context.blockStart, params.granular.grain, cloud, numSamples);
+
+		// 単純なリニアフェード
+		buffer.applyGain(0, numSamples, 1.0f - params.granular.mix);
+		for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+			buffer.addFrom(ch, 0, cloud, ch % 2, 0, numSamples, params.granular.mix);
+	}
+
+	void reset() noexcept override { engine.reset(); }
+
+private:
+	const TrackFxParams& params;
+	GranularEngine engine;
+	juce::AudioBuffer<float> cloud;
+};
+
+// Autotune: ホップごとにピッチを検出し、スケールの最寄りの音へ PSOLA / フェーズボコーダで寄せる
+class AutotuneModule : public FxModule
+{
+public:
+	explicit AutotuneModule(const TrackFxParams& p) : params(p) {}
+
+	void prepare(double newSampleRate, int maxBlockSize) override
+	{
+		sampleRate = newSampleRate;
+		detector.prepare(sampleRate, maxBlockSize, params.autotuneHop);
+		detector.setHopOffset(params.autotuneHopOffset);
+		shifter.prepare(sampleRate, maxBlockSize);
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext&) noexcept override
+	{
+		// Scale definitions (semitones from root)
+		static const int chromaticScale[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+		static const int majorScale[] = {0, 2, 4, 5, 7, 9, 11};
+		static const int minorScale[] = {0, 2, 3, 5, 7, 8, 10};
+		const auto& at = params.autotune;
+		const int* scale = chromaticScale;
+		int scaleSize = 12;
+		if (at.scale == 1) { scale = majorScale; scaleSize = 7; }
+		else if (at.scale == 2) { scale = minorScale; scaleSize = 7; }
+
+		// Push mono signal to pitch detector（ブロック単位で積む）
+		if (buffer.getNumChannels() > 1)
+			detector.pushSamples(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+		else
+			detector.pushSamples(buffer.getReadPointer(0), numSamples);
+
+		// Detect pitch（ホップに達したブロックだけ検出し、それ以外は前回の推定値）
+		const float detectedFreq = detector.detectPitch();
+		currentPitch = detectedFreq;
+		const bool voiced = detectedFreq > 50.0f && detectedFreq < 2000.0f;
+
+		if (voiced)
+		{
+			// Convert frequency to MIDI note
+			const float midiNote = 12.0f * std::log2(detectedFreq / 440.0f) + 69.0f;
+			const int noteNum = static_cast<int>(std::round(midiNote)) % 12;
+			const int octave = static_cast<int>(std::round(midiNote)) / 12;
+
+			// Find nearest note in scale relative to key
+			const int relNote = (noteNum - at.key + 12) % 12;
+			int nearestScaleNote = 0;
+			int minDist = 12;
+			for (int s = 0; s < scaleSize; ++s)
+			{
+				int dist = std::abs(relNote - scale[s]);
+				if (dist > 6) dist = 12 - dist;
+				if (dist < minDist)
+				{
+					minDist = dist;
+					nearestScaleNote = scale[s];
+				}
+			}
+
+			// Target MIDI note
+			const int targetNote = (nearestScaleNote + at.key) % 12 + octave * 12;
+			const float targetFreq = 440.0f * std::pow(2.0f, (targetNote - 69.0f) / 12.0f);
+			targetPitch = targetFreq;
+
+			// Apply amount and speed smoothing
+			const float targetRatio = targetFreq / detectedFreq;
+			const float correctedRatio = 1.0f + (targetRatio - 1.0f) * at.amount;
+			const float smoothFactor = 0.99f - at.speed * 0.98f; // speed 0=instant, 1=slow
+			smoothedRatio = smoothedRatio * smoothFactor + correctedRatio * (1.0f - smoothFactor);
+		}
+		else
+		{
+			// No pitch detected, gradually return to unity
+			smoothedRatio = smoothedRatio * 0.99f + 1.0f * 0.01f;
+		}
+
+		// Apply pitch shift（周期が分かれば PSOLA、なければフェーズボコーダ）
+		shifter.setPitchRatio(smoothedRatio);
+		shifter.setPeriod(voiced ? (float)(sampleRate / detectedFreq) : 0.0f);
+		shifter.process(buffer, numSamples);
+	}
+
+	void reset() noexcept override
+	{
+		detector.reset();
+		shifter.reset();
+		currentPitch = 0.0f;
+		targetPitch = 0.0f;
+		smoothedRatio = 1.0f;
+	}
+
+	// フォルマント保持の ON / OFF で遅延が変わる（ルーパーは処理順を組み直して先読み量を更新する）
+	void parametersChanged() noexcept override { shifter.setPreserveFormants(params.autotune.preserveFormants); }
+
+	int getLatencySamples() const noexcept override { return shifter.getLatencySamples(); }
+
+private:
+	const TrackFxParams& params;
+	double sampleRate = 44100.0;
+	PitchDetector detector;
+	PitchShifter shifter;   // ステレオ
+
+	float currentPitch = 0.0f;
+	float targetPitch = 0.0f;
+	float smoothedRatio = 1.0f;
+};
+
+class FilterModule : public FxModule
+{
+public:
+	explicit FilterModule(const TrackFxParams& p) : params(p) {}
+
+	void prepare(double sampleRate, int maxBlockSize) override
+	{
+		filter.prepare({ sampleRate, (juce::uint32)juce::jmax(1, maxBlockSize), 2 });
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext&) noexcept override
+	{
+		auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, (size_t)numSamples);
+		filter.process(juce::dsp::ProcessContextReplacing<float>(block));
+	}
+
+	void reset() noexcept override { filter.reset(); }
+
+	void parametersChanged() noexcept override
+	{
+		filter.setType(params.filterType == 1 ? juce::dsp::StateVariableTPTFilterType::highpass
+		                                      : juce::dsp::StateVariableTPTFilterType::lowpass);
+		filter.setCutoffFrequency(params.filterCutoff);
+		filter.setResonance(params.filterRes);
+	}
+
+private:
+	const TrackFxParams& params;
+	juce::dsp::StateVariableTPTFilter<float> filter;
+};
+
+// Compressor（ステレオリンク。ゲインリダクションはメーター用に残る）
+class CompressorModule : public FxModule
+{
+public:
+	explicit CompressorModule(const TrackFxParams& p) : params(p) {}
+
+	void prepare(double sampleRate, int maxBlockSize) override { compressor.prepare(sampleRate, maxBlockSize); }
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext&) noexcept override
+	{
+		BlockCompressor::Params cp;
+		cp.thresholdDb = params.compressorThreshold;
+		cp.ratio = params.compressorRatio;
+		cp.lookahead = params.compressorLookahead;
+		compressor.process(buffer, numSamples, cp);
+	}
+
+	void reset() noexcept override { compressor.reset(); }
+
+	int getLatencySamples() const noexcept override
+	{
+		return params.compressorLookahead ? compressor.getLookaheadSamples() : 0;
+	}
+
+	// どのスレッドから読んでもよい
+	float getGainReductionDb() const noexcept { return compressor.getGainReductionDb(); }
+
+private:
+	const TrackFxParams& params;
+	BlockCompressor compressor;
+};
+
+// Flanger / Chorus（juce::dsp::Chorus の中心遅延違い）。同期中はループの頭で LFO を戻す
+class ModulationModule : public FxModule
+{
+public:
+	enum class Kind { flanger, chorus };
+
+	ModulationModule(const TrackFxParams& p, Kind k) : params(p), kind(k) {}
+
+	void prepare(double sampleRate, int maxBlockSize) override
+	{
+		chorus.prepare({ sampleRate, (juce::uint32)juce::jmax(1, maxBlockSize), 2 });
+		chorus.setCentreDelay(kind == Kind::flanger ? 1.5f : 10.0f); // 1.5ms for Flanger / 10ms for Chorus
+		if (kind == Kind::flanger)
+			chorus.setMix(0.5f);
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext& context) noexcept override
+	{
+		const bool sync = kind == Kind::flanger ? params.flangerSync : params.chorusSync;
+		const float rate = kind == Kind::flanger ? params.flangerRate : params.chorusRate;
+
+		if (sync && context.loopRestarts)
+			chorus.reset();
+		chorus.setRate(sync ? (float)context.syncedModRate : rate);
+
+		auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, (size_t)numSamples);
+		chorus.process(juce::dsp::ProcessContextReplacing<float>(block));
+	}
+
+	void reset() noexcept override { chorus.reset(); }
+
+	void parametersChanged() noexcept override
+	{
+		if (kind == Kind::flanger)
+		{
+			chorus.setDepth(params.flangerDepth);
+			chorus.setFeedback(params.flangerFeedback);
+		}
+		else
+		{
+			chorus.setDepth(params.chorusDepth);
+			chorus.setMix(params.chorusMix);
+		}
+	}
+
+private:
+	const TrackFxParams& params;
+	const Kind kind;
+	juce::dsp::Chorus<float> chorus;
+};
+
+// Tremolo / Slicer: ブロック分のゲインをウェーブテーブルから作ってまとめて掛ける
+// 同期中はブロック先頭の再生位置から位相を決める（マスターループ1周 = cyclesPerMasterLoop 周）
+class GainLfoModule : public FxModule
+{
+public:
+	enum class Kind { tremolo, slicer };
+
+	GainLfoModule(const TrackFxParams& p, Kind k) : params(p), kind(k) {}
+
+	void prepare(double newSampleRate, int) override { sampleRate = newSampleRate; }
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext& context) noexcept override
+	{
+		const bool tremolo = kind == Kind::tremolo;
+		const bool sync = tremolo ? params.tremoloSync : params.slicerSync;
+		const double rate = sync ? context.syncedModRate : (double)(tremolo ? params.tremoloRate : params.slicerRate);
+
+		if (sync && context.masterLoopLength > 0)
+		{
+			const double cyclesPerMasterLoop = context.syncedModRate * (double)context.masterLoopLength / sampleRate;
+			phase = LfoGenerator::phaseAtLoopPosition(context.blockStart, context.masterLoopLength, cyclesPerMasterLoop);
+		}
+
+		if (tremolo)
+		{
+			const auto shape = params.tremoloShape == 1 ? LfoGenerator::Shape::square
+			                 : params.tremoloShape == 2 ? LfoGenerator::Shape::triangle
+			                                            : LfoGenerator::Shape::sine;
+			phase = LfoGenerator::process(buffer, numSamples, shape, phase, rate / sampleRate, 0.5f, params.tremoloDepth);
+		}
+		else
+		{
+			const auto shape = params.slicerShape == 0 ? LfoGenerator::Shape::gate : LfoGenerator::Shape::smoothGate;
+			phase = LfoGenerator::process(buffer, numSamples, shape, phase, rate / sampleRate, params.slicerDuty, params.slicerDepth);
+		}
+	}
+
+	void reset() noexcept override { phase = 0.0; }
+
+private:
+	const TrackFxParams& params;
+	const Kind kind;
+	double sampleRate = 44100.0;
+	double phase = 0.0;
+};
+
+// Bitcrusher（量子化 + サンプル & ホールド）
+class BitcrusherModule : public FxModule
+{
+public:
+	explicit BitcrusherModule(const TrackFxParams& p) : params(p) {}
+
+	void prepare(double, int) override { bitcrusher.reset(); }
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext&) noexcept override
+	{
+		BlockBitcrusher::Params bp;
+		bp.depth = params.bitcrusherDepth;
+		bp.rate = params.bitcrusherRate;
+		bitcrusher.process(buffer, numSamples, bp);
+	}
+
+	void reset() noexcept override { bitcrusher.reset(); }
+
+private:
+	const TrackFxParams& params;
+	BlockBitcrusher bitcrusher;
+};
+
+// Delay（mix が 0 の間は素通し）
+class DelayModule : public FxModule
+{
+public:
+	explicit DelayModule(const TrackFxParams& p) : params(p) {}
+
+	void prepare(double newSampleRate, int maxBlockSize) override
+	{
+		sampleRate = newSampleRate;
+		delay.prepare(sampleRate, maxBlockSize, 2.0);
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext& context) noexcept override
+	{
+		if (params.delayMix <= 0.0f)
+			return;
+
+		BlockDelay::Params dp;
+		dp.delaySamples = (params.delaySync && context.masterLoopLength > 0)
+			? BlockDelay::getSyncedDelaySamples(context.masterLoopLength, params.delayDivision, delay.getMaxDelaySamples())
+			: params.delayTime * (float)sampleRate;
+		dp.feedback = params.delayFeedback;
+		dp.mix = params.delayMix;
+		dp.pingPong = params.delayPingPong;
+		delay.process(buffer, numSamples, dp);
+	}
+
+	void reset() noexcept override { delay.reset(); }
+
+	// フィードバックで -60dB まで減るまでの長さ
+	int getTailSamples() const noexcept override
+	{
+		const float delaySamples = params.delaySync ? delay.getMaxDelaySamples() : params.delayTime * (float)sampleRate;
+		const float feedback = juce::jlimit(0.0f, 0.99f, params.delayFeedback);
+		const float repeats = feedback > 0.0f ? std::ceil(std::log(0.001f) / std::log(feedback)) : 1.0f;
+		return (int)(delaySamples * repeats);
+	}
+
+private:
+	const TrackFxParams& params;
+	double sampleRate = 44100.0;
+	BlockDelay delay;
+};
+
+// Reverb: IR を読み込んだトラックは畳み込み（ConvolutionReverb はトラックが持つ）、なければ juce::dsp::Reverb
+class ReverbModule : public FxModule
+{
+public:
+	ReverbModule(const TrackFxParams& p, ConvolutionReverb& convolutionRef) : params(p), convolution(convolutionRef) {}
+
+	void prepare(double newSampleRate, int maxBlockSize) override
+	{
+		sampleRate = newSampleRate;
+		reverb.prepare({ sampleRate, (juce::uint32)juce::jmax(1, maxBlockSize), 2 });
+	}
+
+	void process(juce::AudioBuffer<float>& buffer, int numSamples, const FxContext&) noexcept override
+	{
+		if (convolution.process(buffer, numSamples, params.reverbMix))
+			return;
+
+		auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, (size_t)numSamples);
+		reverb.process(juce::dsp::ProcessContextReplacing<float>(block));
+	}
+
+	void reset() noexcept override
+	{
+		reverb.reset();
+		convolution.reset();
+	}
+
+	void parametersChanged() noexcept override
+	{
+		auto p = reverb.getParameters();
+		p.dryLevel = 1.0f - (params.reverbMix * 0.5f);
+		p.wetLevel = params.reverbMix;
+		p.damping = params.reverbDamping;
+		p.roomSize = params.reverbRoomSize;
+		reverb.setParameters(p);
+	}
+
+	// Freeverb の一番長いコム（44.1kHz で 1617 サンプル）が -60dB まで減るまで
+	int getTailSamples() const noexcept override
+	{
+		const float feedback = params.reverbRoomSize * 0.28f + 0.7f;
+		const float repeats = 3.0f / -std::log10(feedback);
+		return (int)(repeats * 1617.0f * (float)(sampleRate / 44100.0));
+	}
+
+private:
+	const TrackFxParams& params;
+	ConvolutionReverb& convolution;
+	double sampleRate = 44100.0;
+	juce::dsp::Reverb reverb;
+};
+
+//==============================================================================
+// トラックの処理順
+// スロット（FXPanel の4つ）に並べた FX をその順で先に処理し、ON になっている残りの FX を
+// FxModuleType の順（従来の固定順）で後ろに付ける。モジュールがない / OFF の FX は並ばない
+class TrackFxGraph
+{
+public:
+	static constexpr int numSlots = 4;
+	static constexpr int numTypes = (int)FxModuleType::numTypes;
+
+	struct Node
+	{
+		FxModuleType type = FxModuleType::filter;
+		FxModule* module = nullptr;
+	};
+
+	//==============================================================================
+	// メッセージスレッド
+
+	bool hasModule(FxModuleType type) const noexcept { return owned[(size_t)type] != nullptr; }
+
+	// 作って prepare したモジュールを渡す。オーディオスレッドからは次の compile 以降に見える
+	void install(FxModuleType type, std::unique_ptr<FxModule> module)
+	{
+		jassert(owned[(size_t)type] == nullptr);
+		auto* raw = module.get();
+		owned[(size_t)type] = std::move(module);
+		published[(size_t)type].store(raw, std::memory_order_release);
+	}
+
+	// オーディオ停止中に（prepareToPlay）
+	void prepareModules(double sampleRate, int maxBlockSize)
+	{
+		for (auto& module : owned)
+			if (module != nullptr)
+				module->prepare(sampleRate, maxBlockSize);
+	}
+
+	//==============================================================================
+	// オーディオスレッド（getModule はどのスレッドから呼んでもよい）
+
+	FxModule* getModule(FxModuleType type) const noexcept
+	{
+		return published[(size_t)type].load(std::memory_order_acquire);
+	}
+
+	// type = FxModuleType の番号、-1 = 空き / モジュールでない FX
+	void setSlot(int slotIndex, int type) noexcept
+	{
+		if (juce::isPositiveAndBelow(slotIndex, numSlots))
+			slotTypes[(size_t)slotIndex] = juce::isPositiveAndBelow(type, numTypes) ? type : -1;
+	}
+
+	void resetModules() noexcept
+	{
+		for (int t = 0; t < numTypes; ++t)
+			if (auto* module = getModule((FxModuleType)t))
+				module->reset();
+	}
+
+	// 処理順を組み直す（確保しない）
+	void compile(const TrackFxParams& params) noexcept
+	{
+		std::array<bool, numTypes> added {};
+		numNodes = 0;
+
+		auto add = [&](int t)
+		{
+			if (t < 0 || added[(size_t)t])
+				return;
+			const auto type = (FxModuleType)t;
+			auto* module = getModule(type);
+			if (module == nullptr || !params.isEnabled(type))
+				return;
+			added[(size_t)t] = true;
+			nodes[(size_t)numNodes++] = { type, module };
+		};
+
+		for (int t : slotTypes)
+			add(t);
+		for (int t = 0; t < numTypes; ++t)
+			add(t);
+	}
+
+	int getNumNodes() const noexcept { return numNodes; }
+	const Node& getNode(int index) const noexcept { return nodes[(size_t)index]; }
+
+	int indexOf(FxModuleType type) const noexcept
+	{
+		for (int i = 0; i < numNodes; ++i)
+			if (nodes[(size_t)i].type == type)
+				return i;
+		return -1;
+	}
+
+	// 並んだモジュールの遅延の合計（ルーパーはこの分だけ先読みする）
+	int getLatencySamples() const noexcept
+	{
+		int latency = 0;
+		for (int i = 0; i < numNodes; ++i)
+			latency += nodes[(size_t)i].module->getLatencySamples();
+		return latency;
+	}
+
+	int getTailSamples() const noexcept
+	{
+		int tail = 0;
+		for (int i = 0; i < numNodes; ++i)
+			tail += nodes[(size_t)i].module->getTailSamples();
+		return tail;
+	}
+
+private:
+	std::array<std::unique_ptr<FxModule>, numTypes> owned;     // メッセージスレッドだけが触る
+	std::array<std::atomic<FxModule*>, numTypes> published {};  // owned の中身（作ったら変わらない）
+
+	std::array<int, numSlots> slotTypes { -1, -1, -1, -1 };
+	std::array<Node, numTypes> nodes {};
+	int numNodes = 0;
+};
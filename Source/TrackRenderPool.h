@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    TrackRenderPool.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    トラック単位のレンダリングを並列に回すためのワーカープール（オプトイン）
+    - ワーカーはリアルタイム優先度で起動し、コアに固定する
+    - ジョブの受け渡しは atomic 1語（世代 / 件数 / 次インデックス）の CAS だけ
+    - オーディオスレッド自身もジョブを取るので、ワーカーが0人でも必ず終わる
+    - 定常状態ではワーカーはスピンして待つ（syscall なし）。しばらく仕事が
+      無いときだけ WaitableEvent で眠り、次のブロックで起こされる
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include "AllocationTripwire.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #include <immintrin.h>
+#elif defined(_M_ARM64)
+ #include <intrin.h>
+#endif
+
+class TrackRenderPool
+{
+public:
+	using JobFunction = void (*)(void* context, int jobIndex);
+
+	static constexpr int maxWorkers = 31;   // affinity mask が 32bit なので
+	static constexpr int maxJobs = 0xffff;
+
+	TrackRenderPool() = default;
+	~TrackRenderPool() { stop(); }
+
+	// メッセージスレッド専用（オーディオ停止中に呼ぶ）
+	// blockSize / sampleRate はワーカーの優先度設定（処理時間の目安）に使う
+	void start(int numWorkersToStart, int blockSize, double sampleRate)
+	{
+		stop();
+
+		// スピン待ちなので、コア数を超えて起動すると逆に遅くなる（オーディオスレッドの分を残す）
+		const int numCpus = juce::SystemStats::getNumCpus();
+		numWorkersToStart = juce::jlimit(0, juce::jmin(maxWorkers, numCpus - 1), numWorkersToStart);
+
+		const auto options = juce::Thread::RealtimeOptions{}
+			.withPriority(10)
+			.withApproximateAudioProcessingTime(juce::jmax(1, blockSize), sampleRate);
+
+		for (int i = 0; i < numWorkersToStart; ++i)
+		{
+			auto worker = std::make_unique<Worker>(*this, i);
+
+			// コア0はオーディオスレッド（とOS）に残し、ワーカーは1番から順に固定する
+			const int core = i + 1;
+			if (core < numCpus && core < 32)
+				worker->setAffinityMask((juce::uint32)1 << core);
+
+			if (!worker->startRealtimeThread(options))
+			{
+				DBG("⚠️ TrackRenderPool: realtime thread start failed, falling back to normal priority");
+				worker->startThread(juce::Thread::Priority::highest);
+			}
+
+			workers.push_back(std::move(worker));
+		}
+	}
+
+	void stop()
+	{
+		for (auto& w : workers)
+		{
+			w->signalThreadShouldExit();
+			w->wakeUp.signal();
+		}
+
+		for (auto& w : workers)
+			w->stopThread(1000);
+
+		workers.clear();
+	}
+
+	int getNumWorkers() const noexcept { return (int)workers.size(); }
+
+	// オーディオスレッド専用: numJobs 件を並列に実行して、全部終わるまで待つ
+	// fn は複数スレッドから同時に呼ばれる。jobIndex ごとに触るデータは重ならないこと
+	void run(JobFunction fn, void* context, int numJobs) noexcept
+	{
+		jassert(numJobs <= maxJobs);
+		if (numJobs <= 0)
+			return;
+
+		if (workers.empty() || numJobs == 1)
+		{
+			for (int i = 0; i < numJobs; ++i)
+				fn(context, i);
+			return;
+		}
+
+		jobFunction.store(fn, std::memory_order_relaxed);
+		jobContext.store(context, std::memory_order_relaxed);
+		remaining.store(numJobs, std::memory_order_relaxed);
+
+		generation = (generation + 1) & 0xffffffffu;
+		work.store(pack(generation, (juce::uint64)numJobs, 0));
+
+		// 眠っているワーカーだけ起こす（定常状態ではここは通らない）
+		for (auto& w : workers)
+			if (w->parked.load())
+				w->wakeUp.signal();
+
+		// 自分でも取れるだけ取る
+		while (tryRunOne()) {}
+
+		// 他のワーカーが持っていったジョブの完了待ち
+		while (remaining.load(std::memory_order_acquire) > 0)
+			cpuRelax();
+	}
+
+	// ラムダ等を関数ポインタ + context に落とす（確保なし）
+	template <typename Function>
+	void parallelFor(int numJobs, Function& function) noexcept
+	{
+		run([](void* ctx, int jobIndex) { (*static_cast<Function*>(ctx))(jobIndex); },
+			&function, numJobs);
+	}
+
+	static inline void cpuRelax() noexcept
+	{
+	   #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+		_mm_pause();
+	   #elif defined(_M_ARM64)
+		__yield();
+	   #elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__ ("yield");
+	   #endif
+	}
+
+private:
+	// work = [generation:32][numJobs:16][nextIndex:16]
+	static constexpr juce::uint64 pack(juce::uint64 gen, juce::uint64 count, juce::uint64 next) noexcept
+	{
+		return (gen << 32) | (count << 16) | next;
+	}
+
+	bool hasWork() const noexcept
+	{
+		const auto w = work.load();
+		return (w & 0xffff) < ((w >> 16) & 0xffff);
+	}
+
+	// 1件取って実行する。取れなければ false
+	bool tryRunOne() noexcept
+	{
+		auto w = work.load(std::memory_order_acquire);
+
+		while (true)
+		{
+			const auto next = w & 0xffff;
+			const auto count = (w >> 16) & 0xffff;
+			if (next >= count)
+				return false;
+
+			if (work.compare_exchange_weak(w, w + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				// CAS が通った = この世代はまだ完了していないので、fn / context は差し替わっていない
+				const auto fn = jobFunction.load(std::memory_order_relaxed);
+				{
+					allocation_tripwire::ScopedAudioThread noAllocations;
+					fn(jobContext.load(std::memory_order_relaxed), (int)next);
+				}
+				remaining.fetch_sub(1, std::memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	class Worker : public juce::Thread
+	{
+	public:
+		Worker(TrackRenderPool& p, int index)
+			: juce::Thread("SAROS Render " + juce::String(index)), pool(p) {}
+
+		void run() override
+		{
+			auto lastWork = juce::Time::getMillisecondCounterHiRes();
+			int spins = 0;
+
+			while (!threadShouldExit())
+			{
+				if (pool.tryRunOne())
+				{
+					spins = 0;
+					lastWork = juce::Time::getMillisecondCounterHiRes();
+					continue;
+				}
+
+				cpuRelax();
+
+				// 時計を見るのはたまにだけ
+				if (++spins < 4096)
+					continue;
+				spins = 0;
+
+				if (juce::Time::getMillisecondCounterHiRes() - lastWork < parkAfterMs)
+					continue;
+
+				// オーディオが止まっている（またはシリアル経路しか使われていない）ので眠る。
+				// parked を立ててから仕事を再確認するので、run() 側の signal を取りこぼさない
+				parked.store(true);
+				if (!pool.hasWork() && !threadShouldExit())
+					wakeUp.wait(100.0);
+				parked.store(false);
+
+				lastWork = juce::Time::getMillisecondCounterHiRes();
+			}
+		}
+
+		std::atomic<bool> parked { false };
+		juce::WaitableEvent wakeUp;
+
+	private:
+		static constexpr double parkAfterMs = 50.0;
+		TrackRenderPool& pool;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::atomic<juce::uint64> work { 0 };
+	std::atomic<JobFunction> jobFunction { nullptr };
+	std::atomic<void*> jobContext { nullptr };
+	std::atomic<int> remaining { 0 };
+	juce::uint64 generation = 0; // オーディオスレッドだけが触る
+
+	JUCE_DECLARE_NON_COPYABLE (TrackRenderPool)
+};
@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    TriggerDetector.h
+    Created: 16 Oct 2026
+    Author:  mt sh
+
+    入力のトリガー検出（最大 MAX_CHANNELS、オーディオスレッド専用）
+    - ブロックを chunkSize サンプルずつに区切り、1回なめるだけでレベル・低い閾値（プリロール）・
+      高い閾値（トリガー）を全部出す
+      区間ピークはチャンネルごとに FloatVectorOperations::findMinAndMax、そのあとのゲイン・
+      ステレオリンク・閾値の比較・グループごとの最大も 16 レーンの配列に FloatVectorOperations で
+      まとめてかける（レーン方向の SIMD。ステレオリンクの相手を並べ替えるところだけスカラー）
+    - 閾値を超えた区間だけサンプル単位で見直すので、位置はサンプル単位で正確
+    - 位置は呼び出し側が渡すブロック先頭の絶対サンプル位置（64bit）からの通し番号
+    - 無効なレーンは閾値を無限大にするだけ（ループからは外さない）
+    - レーンはグループ（InputManager の入力ルート = 入力ペア）に分けられる。プリロールとトリガーは
+      グループごとに独立（全レーンがグループ 0 なら従来どおり1つ）。区間ピークの計算は全レーン1パスのまま
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ChannelTriggerSettings.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+class TriggerDetector
+{
+public:
+	static constexpr int numLanes = MAX_CHANNELS;
+	static constexpr int chunkSize = 16;
+	static constexpr int maxGroups = numLanes / 2; // 入力ペアごと
+	static constexpr double preRollTimeoutSeconds = 0.5; // 低い閾値を下回ったままこれだけ続いたらプリロールを解く
+
+	struct Result
+	{
+		bool triggered = false;     // このブロックで高い閾値を超えた（1ブロックに最初の1回だけ）
+		int sampleInBlock = -1;
+		int channel = -1;           // 超えたレーン（ステレオリンクは L のレーン）
+		juce::int64 absIndex = -1;  // 超えたサンプルの絶対位置
+		float maxLevel = 0.0f;      // 有効なレーンの検出レベルの最大（鎮火判定用）
+	};
+
+	struct GroupState
+	{
+		bool inPreRoll = false;
+		juce::int64 preRollStartAbs = -1;
+		juce::int64 quietSamples = 0;
+	};
+
+	TriggerDetector() { clearLanes(); }
+
+	void prepare(double sampleRate)
+	{
+		preRollTimeout = (juce::int64)(sampleRate * preRollTimeoutSeconds);
+		resetPreRoll();
+	}
+
+	//==============================================================================
+	// レーン（= 入力チャンネル）の設定
+	// gain はレベルと検出の両方にかかる。partner はステレオリンクの相手（L のレーンに R を渡す。-1 = なし）
+	// group はプリロールとトリガーを共有するまとまり（0..maxGroups-1）
+	void setLane(int lane, bool active, float threshold, float gain, int partner = -1, int group = 0) noexcept
+	{
+		jassert(juce::isPositiveAndBelow(lane, numLanes));
+		const auto l = (size_t)lane;
+		laneThreshold[l] = active ? threshold : std::numeric_limits<float>::max();
+		laneGain[l] = gain;
+		laneActive[l] = active ? 1.0f : 0.0f;
+		lanePartner[l] = juce::isPositiveAndBelow(partner, numLanes) ? partner : lane;
+		laneGroup[l] = juce::jlimit(0, maxGroups - 1, group);
+
+		for (size_t g = 0; g < (size_t)maxGroups; ++g)
+			groupMask[g][l] = laneGroup[l] == (int)g ? 1.0f : 0.0f;
+	}
+
+	// 全レーンを無効・ゲイン 1 に戻す
+	void clearLanes() noexcept
+	{
+		for (int lane = 0; lane < numLanes; ++lane)
+			setLane(lane, false, 1.0f, 1.0f);
+	}
+
+	// プリロールの閾値（全レーン共通）
+	void setLowThreshold(float threshold) noexcept { lowThreshold = threshold; }
+
+	//==============================================================================
+	// プリロール: 低い閾値を超えてから、静かな状態が preRollTimeoutSeconds 続くまで（グループごと）
+	// トリガー（高い閾値）はプリロール中にだけ立つ
+	bool isInPreRoll(int group = 0) const noexcept { return groups[(size_t)group].inPreRoll; }
+	juce::int64 getPreRollStartAbs(int group = 0) const noexcept { return groups[(size_t)group].preRollStartAbs; }
+
+	void resetPreRoll(int group) noexcept { groups[(size_t)group] = {}; }
+
+	void resetPreRoll() noexcept
+	{
+		for (int g = 0; g < maxGroups; ++g)
+			resetPreRoll(g);
+	}
+
+	//==============================================================================
+	// levels: チャンネルごとのブロックのピーク × gain（numLanes 個。入力にないチャンネルは 0）
+	// 戻り値はグループをまたいで最初のトリガー（maxLevel は全グループの最大）。グループごとは getGroupResult
+	Result process(const juce::AudioBuffer<float>& input, juce::int64 blockStartAbs, float* levels) noexcept
+	{
+		const int numChannels = juce::jmin(input.getNumChannels(), numLanes);
+		const int numSamples = input.getNumSamples();
+		const float* const* channels = input.getArrayOfReadPointers();
+
+		std::fill(levels, levels + numLanes, 0.0f);
+		peak.fill(0.0f);
+		results.fill({});
+
+		// 使っているグループだけ進める（ルーティングなしならグループ 0 だけ）
+		int numGroups = 1;
+		for (size_t l = 0; l < (size_t)numLanes; ++l)
+			numGroups = juce::jmax(numGroups, laneGroup[l] + 1);
+
+		for (int start = 0; start < numSamples; start += chunkSize)
+		{
+			const int n = juce::jmin(chunkSize, numSamples - start);
+
+			// 1. チャンネルごとの区間ピーク（サンプルを読むのはここだけ）
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				const auto range = juce::FloatVectorOperations::findMinAndMax(channels[ch] + start, n);
+				peak[(size_t)ch] = juce::jmax(-range.getStart(), range.getEnd());
+			}
+
+			// 2. 16 レーンまとめて: ゲイン → レベル → ステレオリンク → 無効なレーンを 0 に → 閾値との差
+			using FVO = juce::FloatVectorOperations;
+			FVO::multiply(scaled.data(), peak.data(), laneGain.data(), numLanes);
+			FVO::max(levels, levels, scaled.data(), numLanes);
+
+			for (size_t l = 0; l < (size_t)numLanes; ++l)
+				partnerScaled[l] = scaled[(size_t)lanePartner[l]];
+
+			FVO::max(detect.data(), scaled.data(), partnerScaled.data(), numLanes);
+			FVO::multiply(detect.data(), laneActive.data(), numLanes);
+			FVO::copy(overshoot.data(), detect.data(), numLanes);
+			FVO::subtract(overshoot.data(), laneThreshold.data(), numLanes); // > 0 = 高い閾値を超えた
+
+			// 3. グループごとに 16 レーンをマスクして最大を取る
+			for (int g = 0; g < numGroups; ++g)
+			{
+				const float* mask = groupMask[(size_t)g].data();
+				FVO::multiply(masked.data(), detect.data(), mask, numLanes);
+				groupMax[(size_t)g] = FVO::findMaximum(masked.data(), numLanes);
+				FVO::multiply(masked.data(), overshoot.data(), mask, numLanes);
+				groupOverHigh[(size_t)g] = FVO::findMaximum(masked.data(), numLanes);
+				processGroup(g, channels, numChannels, start, n, blockStartAbs);
+			}
+		}
+
+		Result first;
+		for (const auto& r : results)
+		{
+			if (r.triggered && (!first.triggered || r.absIndex < first.absIndex))
+			{
+				const float maxLevel = first.maxLevel;
+				first = r;
+				first.maxLevel = maxLevel;
+			}
+			first.maxLevel = juce::jmax(first.maxLevel, r.maxLevel);
+		}
+		return first;
+	}
+
+	// 直前の process でのグループごとの結果
+	const Result& getGroupResult(int group) const noexcept { return results[(size_t)group]; }
+
+private:
+	struct Crossing
+	{
+		int offset = 0;
+		int lane = 0;
+	};
+
+	// グループ g の区間 [start, start + n) ぶんのプリロールとトリガー
+	void processGroup(int g, const float* const* channels, int numChannels, int start, int n,
+	                  juce::int64 blockStartAbs) noexcept
+	{
+		auto& state = groups[(size_t)g];
+		auto& result = results[(size_t)g];
+		const float chunkMax = groupMax[(size_t)g];
+		result.maxLevel = juce::jmax(result.maxLevel, chunkMax);
+
+		// 4. プリロール（低い閾値）。超えた区間だけサンプル単位で位置を探す
+		if (chunkMax > lowThreshold)
+		{
+			if (!state.inPreRoll)
+			{
+				state.inPreRoll = true;
+				state.preRollStartAbs = blockStartAbs + start + findFirstCrossing(channels, numChannels, start, n, true, g).offset;
+			}
+			state.quietSamples = 0;
+		}
+		else if (state.inPreRoll && (state.quietSamples += n) > preRollTimeout)
+		{
+			resetPreRoll(g);
+		}
+
+		// 5. トリガー（高い閾値）
+		if (groupOverHigh[(size_t)g] > 0.0f && !result.triggered)
+		{
+			const auto crossing = findFirstCrossing(channels, numChannels, start, n, false, g);
+			result.triggered = true;
+			result.sampleInBlock = start + crossing.offset;
+			result.channel = crossing.lane;
+			result.absIndex = blockStartAbs + result.sampleInBlock;
+
+			// 高い閾値が低い閾値より下のときは、ここからプリロールにする
+			if (!state.inPreRoll)
+			{
+				state.inPreRoll = true;
+				state.preRollStartAbs = result.absIndex;
+				state.quietSamples = 0;
+			}
+		}
+	}
+
+	// 区間 [start, start + n) で最初に閾値を超えたサンプルとレーン（low = プリロールの閾値で見る）
+	// グループ group のレーンだけ見る。区間ピークで超えたことが分かっているときだけ呼ぶ
+	Crossing findFirstCrossing(const float* const* channels, int numChannels, int start, int n, bool low,
+	                           int group) const noexcept
+	{
+		for (int i = start; i < start + n; ++i)
+		{
+			for (int lane = 0; lane < numChannels; ++lane)
+			{
+				const auto l = (size_t)lane;
+				if (laneGroup[l] != group)
+					continue;
+				const int partner = lanePartner[l] < numChannels ? lanePartner[l] : lane;
+				const float detectLevel = juce::jmax(std::abs(channels[lane][i]) * laneGain[l],
+				                                     std::abs(channels[partner][i]) * laneGain[(size_t)partner]) * laneActive[l];
+				if (detectLevel > (low ? lowThreshold : laneThreshold[l]))
+					return { i - start, lane };
+			}
+		}
+		jassertfalse;
+		return { 0, 0 };
+	}
+
+	std::array<float, numLanes> laneThreshold {};
+	std::array<float, numLanes> laneGain {};
+	std::array<float, numLanes> laneActive {};
+	std::array<int, numLanes> lanePartner {};
+	std::array<int, numLanes> laneGroup {};
+	std::array<std::array<float, numLanes>, maxGroups> groupMask {}; // グループのレーンだけ 1
+	float lowThreshold = 0.005f;
+
+	// 区間ごとの作業用（レーン順）
+	std::array<float, numLanes> peak {};
+	std::array<float, numLanes> scaled {};
+	std::array<float, numLanes> partnerScaled {};
+	std::array<float, numLanes> detect {};
+	std::array<float, numLanes> overshoot {};
+	std::array<float, numLanes> masked {};
+	std::array<float, maxGroups> groupMax {};
+	std::array<float, maxGroups> groupOverHigh {}; // グループの閾値との差の最大（> 0 = 超えた）
+
+	std::array<GroupState, maxGroups> groups {};
+	std::array<Result, maxGroups> results {};
+	juce::int64 preRollTimeout = 24000;
+};
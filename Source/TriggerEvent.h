@@ -10,6 +10,7 @@
 
 #pragma once
 #include <atomic>
+#include <cstdint>
 
 // ===============================================
 // トリガーイベント情報
@@ -19,7 +20,7 @@ namespace juce {
 	struct TriggerEvent
 	{
 		std::atomic<bool> triggerd {false};
-		long absIndex = -1; //リングバッファ上の絶対位置
+		std::int64_t absIndex = -1; //絶対サンプル位置（ルーパーの currentSamplePosition と同じ時計）
 		int sampleInBlock = -1;
 		int channel = 0; //検知チャンネル
 
@@ -31,10 +32,11 @@ namespace juce {
 		}
 
 		//トリガー発火
-		void fire(int sample = -1,long abs = -1) noexcept
+		void fire(int sample = -1, std::int64_t abs = -1, int ch = 0) noexcept
 		{
 			sampleInBlock = sample;
 			absIndex = abs;
+			channel = ch;
 			triggerd.store(true);
 			//DBG("Trigger is Fire🔥");
 		}